@@ -23,8 +23,11 @@
 
 #include <map>
 #include <mutex>
+#include <set>
+#include <string>
 
 #include <crawler/peer.hpp>
+#include <crawler/time_series.hpp>
 
 namespace crawler {
 
@@ -38,6 +41,22 @@ namespace crawler {
     {
         public:
         
+            /**
+             * The maximum number of probes in flight.
+             */
+            enum { max_probes_in_flight = 256 };
+        
+            /**
+             * The interval (in seconds) between probes of a peer.
+             */
+            enum { probe_interval = 300 };
+        
+            /**
+             * Every full_post_interval posts contain all peers, the others
+             * contain only the peers changed or removed since the last post.
+             */
+            enum { full_post_interval = 10 };
+        
             /**
              * Constructor
              * @param owner The stack_impl.
@@ -74,11 +93,43 @@ namespace crawler {
              */
             void tick_probe(const boost::system::error_code & ec);
         
+            /**
+             * Probes a peer.
+             * @param key The key.
+             * @param p The peer.
+             */
+            void probe(const std::string & key, const peer & p);
+        
             /**
              * The peers.
              */
             std::map<std::string, peer> m_peers;
         
+            /**
+             * The keys of the peers changed since the last post.
+             */
+            std::set<std::string> m_peers_changed;
+        
+            /**
+             * The keys of the peers removed since the last post.
+             */
+            std::set<std::string> m_peers_removed;
+        
+            /**
+             * The keys of the peers being probed.
+             */
+            std::set<std::string> m_probes_in_flight;
+        
+            /**
+             * The key of the last peer probed, probes continue after it.
+             */
+            std::string m_probe_cursor;
+        
+            /**
+             * The number of posts.
+             */
+            std::uint32_t m_posts;
+        
         protected:
         
             /**
@@ -91,6 +142,11 @@ namespace crawler {
              */
             std::mutex mutex_peers_;
         
+            /**
+             * The time_series of peer samples.
+             */
+            time_series time_series_;
+        
             /**
              * The timer.
              */
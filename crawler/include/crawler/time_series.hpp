@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2013-2015 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of Vanilacoin.
+ *
+ * Vanilacoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CRAWLER_TIME_SERIES_HPP
+#define CRAWLER_TIME_SERIES_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include <crawler/peer.hpp>
+
+namespace crawler {
+
+    /**
+     * Implements an append-only time-series file of peer samples.
+     * Each record is a fixed length little-endian encoding of:
+     * timestamp (4 bytes), address (16 bytes, IPv4 addresses are IPv6
+     * mapped), port (2 bytes), rtt (4 bytes), udp bps inbound (4 bytes),
+     * udp bps outbound (4 bytes) and height (4 bytes).
+     * When the file reaches max_length it is rotated to path.1 ... path.N.
+     */
+    class time_series
+    {
+        public:
+        
+            /**
+             * The record length.
+             */
+            enum { record_length = 38 };
+        
+            /**
+             * The maximum length of a file before it is rotated.
+             */
+            enum { max_length = 64 * 1024 * 1024 };
+        
+            /**
+             * The number of rotated files kept.
+             */
+            enum { max_rotations = 4 };
+        
+            /**
+             * Constructor
+             * @param path The path.
+             */
+            explicit time_series(const std::string & path);
+        
+            /**
+             * Opens the file for appending.
+             */
+            bool open();
+        
+            /**
+             * Closes the file.
+             */
+            void close();
+        
+            /**
+             * Appends a sample of the peer.
+             * @param timestamp The timestamp.
+             * @param p The peer.
+             */
+            void append(const std::time_t & timestamp, const peer & p);
+        
+            /**
+             * Flushes the file.
+             */
+            void flush();
+        
+        private:
+        
+            /**
+             * Rotates the files.
+             */
+            void rotate();
+        
+            /**
+             * The path.
+             */
+            std::string m_path;
+        
+            /**
+             * The length of the current file.
+             */
+            std::size_t m_length;
+        
+        protected:
+        
+            /**
+             * The std::ofstream.
+             */
+            std::ofstream ofstream_;
+        
+            /**
+             * The std::mutex.
+             */
+            std::mutex mutex_;
+    };
+    
+} // namespace crawler
+
+#endif // CRAWLER_TIME_SERIES_HPP
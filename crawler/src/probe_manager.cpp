@@ -20,7 +20,6 @@
 
 #include <sstream>
 
-#include <boost/algorithm/string.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
 
@@ -33,7 +32,9 @@
 using namespace crawler;
 
 probe_manager::probe_manager(stack_impl & owner)
-    : stack_impl_(owner)
+    : m_posts(0)
+    , stack_impl_(owner)
+    , time_series_("peers.tsdb")
     , timer_(owner.io_service())
     , timer_post_(owner.io_service())
     , timer_probe_(owner.io_service())
@@ -45,6 +46,14 @@ void probe_manager::start()
 {
     auto self(shared_from_this());
     
+    /**
+     * Open the time_series.
+     */
+    if (time_series_.open() == false)
+    {
+        log_error("Probe manager failed to open time series.");
+    }
+    
     /**
      * Start the timer.
      */
@@ -78,6 +87,8 @@ void probe_manager::stop()
     timer_.cancel();
     timer_post_.cancel();
     timer_probe_.cancel();
+    
+    time_series_.close();
 }
 
 void probe_manager::tick(const boost::system::error_code & ec)
@@ -91,78 +102,69 @@ void probe_manager::tick(const boost::system::error_code & ec)
         auto self(shared_from_this());
         
         auto snodes =
-            stack_impl_.get_database_stack()->storage_nodes()
+            stack_impl_.get_database_stack()->storage_node_records()
         ;
         
         log_info(
             "Probe manager has " << snodes.size() << " snodes."
         );
         
+        std::lock_guard<std::mutex> l1(mutex_peers_);
+        
         for (auto & i : snodes)
         {
-            if (i.count("endpoint") > 0)
+            boost::system::error_code ec_address;
+            
+            auto address = boost::asio::ip::address::from_string(
+                i.address, ec_address
+            );
+            
+            if (ec_address)
             {
-                auto uptime = std::atoll(i["uptime"].c_str());
-                auto last_update = std::atoll(i["last_update"].c_str());
-                auto endpoint = i["endpoint"];
-                auto rtt = std::atoi(i["rtt"].c_str());
-                auto stats_udp_bps_inbound =
-                    std::atoi(i["stats_udp_bps_inbound"].c_str())
-                ;
-                auto stats_udp_bps_outbound =
-                    std::atoi(i["stats_udp_bps_outbound"].c_str())
-                ;
+                continue;
+            }
 
-                std::vector<std::string> parts;
+            boost::asio::ip::udp::endpoint ep(address, i.port);
+            
+            auto endpoint = i.address + ":" + std::to_string(i.port);
+            
+            peer p(
+                ep, i.uptime, i.last_update, i.rtt, i.stats_udp_bps_inbound,
+                i.stats_udp_bps_outbound
+            );
+            
+            auto it = m_peers.find(endpoint);
+            
+            if (it != m_peers.end())
+            {
+                const auto & p_old = it->second;
                 
-                boost::split(parts, endpoint, boost::is_any_of(":"));
+                p.set_version(p_old.version());
+                p.set_protocol(p_old.protocol());
+                p.set_useragent(p_old.useragent());
+                p.set_height(p_old.height());
+                p.set_time_last_seen(std::time(0));
+                p.set_is_tcp_open(p_old.is_tcp_open());
+                p.set_last_probed(p_old.last_probed());
                 
-                if (parts.size() != 2)
+                if (
+                    p.rtt() != p_old.rtt() ||
+                    p.udp_bps_inbound() != p_old.udp_bps_inbound() ||
+                    p.udp_bps_outbound() != p_old.udp_bps_outbound() ||
+                    p.uptime() != p_old.uptime()
+                    )
                 {
-                    continue;
+                    m_peers_changed.insert(endpoint);
                 }
-
-                auto address = parts[0];
-                auto port = std::atoi(parts[1].c_str());
                 
-                std::lock_guard<std::mutex> l1(mutex_peers_);
+                it->second = p;
+            }
+            else
+            {
+                m_peers[endpoint] = p;
                 
-                if (m_peers.count(endpoint) > 0)
-                {
-                    boost::asio::ip::udp::endpoint ep(
-                        boost::asio::ip::address::from_string(address),
-                        port
-                    );
-                    
-                    peer p(
-                        ep, uptime, last_update, rtt, stats_udp_bps_inbound,
-                        stats_udp_bps_outbound
-                    );
-                    
-                    p.set_version(m_peers[endpoint].version());
-                    p.set_protocol(m_peers[endpoint].protocol());
-                    p.set_useragent(m_peers[endpoint].useragent());
-                    p.set_height(m_peers[endpoint].height());
-                    p.set_time_last_seen(std::time(0));
-                    p.set_is_tcp_open(m_peers[endpoint].is_tcp_open());
-                    p.set_last_probed(m_peers[endpoint].last_probed());
-                    
-                    m_peers[endpoint] = p;
-                }
-                else
-                {
-                    boost::asio::ip::udp::endpoint ep(
-                        boost::asio::ip::address::from_string(address),
-                        port
-                    );
-                    
-                    peer p(
-                        ep, uptime, last_update, rtt, stats_udp_bps_inbound,
-                        stats_udp_bps_outbound
-                    );
-                    
-                    m_peers[endpoint] = p;
-                }
+                m_peers_changed.insert(endpoint);
+                m_peers_removed.erase(endpoint);
             }
         }
         
@@ -178,6 +180,9 @@ void probe_manager::tick(const boost::system::error_code & ec)
              */
             if (std::time(0) - it->second.time_last_seen() > 1 * 60 * 60)
             {
+                m_peers_changed.erase(it->first);
+                m_peers_removed.insert(it->first);
+                
                 it = m_peers.erase(it);
             }
             else
@@ -211,29 +216,31 @@ void probe_manager::tick_post(const boost::system::error_code & ec)
         
         boost::property_tree::ptree pt_children;
         
-        std::lock_guard<std::mutex> l1(mutex_peers_);
+        boost::property_tree::ptree pt_removed;
+        
+        auto now = std::time(0);
+        
+        auto is_full = m_posts++ % full_post_interval == 0;
+        
+        std::unique_lock<std::mutex> l1(mutex_peers_);
         
         /**
-         * Encode the peers into JSON format.
+         * Encode a peer into JSON format.
          */
-        for (auto & i : m_peers)
+        auto encode = [&pt_children, &now](const peer & p)
         {
             boost::property_tree::ptree pt_child;
             
-            const auto & p = i.second;
-           
-            boost::asio::ip::udp::endpoint m_udp_endpoint;
-
             pt_child.put("endpoint", p.udp_endpoint());
             pt_child.put("version", p.version());
             pt_child.put("protocol", p.protocol());
             pt_child.put("useragent", p.useragent());
             pt_child.put("height", p.height());
-            pt_child.put("uptime", std::time(0) - p.uptime());
+            pt_child.put("uptime", now - p.uptime());
             pt_child.put("last_update", p.last_update());
             pt_child.put(
                 "last_probed",
-                p.last_probed() == 0 ? - 1 : std::time(0) - p.last_probed()
+                p.last_probed() == 0 ? - 1 : now - p.last_probed()
             );
             pt_child.put("rtt", p.rtt());
             pt_child.put("udp_bps_inbound", p.udp_bps_inbound());
@@ -245,10 +252,65 @@ void probe_manager::tick_post(const boost::system::error_code & ec)
             );
         
             pt_children.push_back(std::make_pair("", pt_child));
+        };
+        
+        if (is_full)
+        {
+            for (auto & i : m_peers)
+            {
+                encode(i.second);
+            }
+        }
+        else
+        {
+            for (auto & i : m_peers_changed)
+            {
+                auto it = m_peers.find(i);
+                
+                if (it != m_peers.end())
+                {
+                    encode(it->second);
+                }
+            }
+            
+            for (auto & i : m_peers_removed)
+            {
+                boost::property_tree::ptree pt_child;
+                
+                pt_child.put("", i);
+                
+                pt_removed.push_back(std::make_pair("", pt_child));
+            }
+        }
+        
+        /**
+         * Append the changed peers to the time_series.
+         */
+        for (auto & i : m_peers_changed)
+        {
+            auto it = m_peers.find(i);
+            
+            if (it != m_peers.end())
+            {
+                time_series_.append(now, it->second);
+            }
         }
         
+        time_series_.flush();
+        
+        m_peers_changed.clear();
+        m_peers_removed.clear();
+        
+        l1.unlock();
+        
+        pt.put("full", is_full ? "true" : "false");
         pt.add_child("peers", pt_children);
         
+        if (is_full == false)
+        {
+            pt.add_child("removed", pt_removed);
+        }
+        
         /**
          * The std::stringstream.
          */
@@ -310,160 +372,198 @@ void probe_manager::tick_probe(const boost::system::error_code & ec)
     {
         auto self(shared_from_this());
 
-        std::lock_guard<std::mutex> l1(mutex_peers_);
+        std::vector< std::pair<std::string, peer> > probes;
+        
+        std::unique_lock<std::mutex> l1(mutex_peers_);
         
-        auto index = 0;
+        auto now = std::time(0);
         
         /**
-         * Encode the peers into JSON format.
+         * Fill the in-flight window continuing after the last peer probed
+         * so all peers get their turn.
          */
-        for (auto & i : m_peers)
+        auto it = m_peers.upper_bound(m_probe_cursor);
+        
+        for (
+            std::size_t i = 0; i < m_peers.size() &&
+            m_probes_in_flight.size() < max_probes_in_flight; i++, ++it
+            )
         {
-            if (std::time(0) - i.second.last_probed() > 300)
+            if (it == m_peers.end())
             {
-                auto url =
-                    "https://" + i.first.substr(0, i.first.find(":")) + "/"
-                ;
-
-                std::shared_ptr<http_transport> t =
-                    std::make_shared<http_transport>(
-                    stack_impl_.io_service(), url)
-                ;
-
-                auto ep = i.second.udp_endpoint();
-                
-                t->start(
-                    [this, i](
-                    boost::system::error_code ec,
-                    std::shared_ptr<http_transport> t)
-                {
-                    auto key = i.first;
-
-                    if (ec)
-                    {
-                        /**
-                         * Since we are not checking the error we do not know
-                         * if it is the remote peer's fault, therefore we wait
-                         * up to 20 minutes before setting them to TCP closed.
-                         */
-                        if (std::time(0) - i.second.last_probed() > 1200)
-                        {
-                            /**
-                             * Update firewall status.
-                             */
-                            m_peers[key].set_is_tcp_open(false);
-                        }
-                    }
-                    else
-                    {
-                        /**
-                         * Set the last probed.
-                         */
-                        m_peers[key].set_last_probed(std::time(0));
+                it = m_peers.begin();
+            }
+            
+            if (
+                now - it->second.last_probed() > probe_interval &&
+                m_probes_in_flight.count(it->first) == 0
+                )
+            {
+                m_probes_in_flight.insert(it->first);
                 
-                        try
-                        {
-                            boost::property_tree::ptree pt;
-                            
-                            std::stringstream ss;
-                        
-                            ss << t->response_body();
-                            
-                            read_json(ss, pt);
-                            
-                            try
-                            {
-                                /**
-                                 * Get the version.
-                                 */
-                                auto version =
-                                    pt.get_child("version").get<
-                                    std::string> ("")
-                                ;
-                                
-                                m_peers[key].set_version(version);
-                            }
-                            catch (...)
-                            {
-                                // ...
-                            }
-                            
-                            try
-                            {
-                                /**
-                                 * Get the protocol.
-                                 */
-                                auto protocol =
-                                    pt.get_child("protocol").get<
-                                    std::string> ("")
-                                ;
-                                
-                                m_peers[key].set_protocol(std::stoi(protocol));
-                            }
-                            catch (...)
-                            {
-                                // ...
-                            }
-                            
-                            try
-                            {
-                                /**
-                                 * Get the useragent.
-                                 */
-                                auto useragent =
-                                    pt.get_child("useragent").get<
-                                    std::string> ("")
-                                ;
-                                
-                                m_peers[key].set_useragent(useragent);
-                            }
-                            catch (...)
-                            {
-                                // ...
-                            }
-                            
-                            try
-                            {
-                                /**
-                                 * Get the height.
-                                 */
-                                auto height =
-                                    pt.get_child("height").get<std::string> ("")
-                                ;
-
-                                m_peers[key].set_height(std::stoi(height));
-                            }
-                            catch (...)
-                            {
-                                // ...
-                            }
-                        }
-                        catch (std::exception & e)
-                        {
-                            // ...
-                        }
-
-                        /**
-                         * Update firewall status.
-                         */
-                        m_peers[key].set_is_tcp_open(true);
-                    }
-                }, ep.port());
+                probes.push_back(*it);
                 
-                if (++index >= 24)
-                {
-                    break;
-                }
+                m_probe_cursor = it->first;
             }
         }
+        
+        l1.unlock();
+        
+        for (auto & i : probes)
+        {
+            probe(i.first, i.second);
+        }
 
         /**
          * Start the timer.
          */
-        timer_probe_.expires_from_now(std::chrono::seconds(8));
+        timer_probe_.expires_from_now(std::chrono::seconds(1));
         timer_probe_.async_wait(stack_impl_.strand().wrap(
             std::bind(&probe_manager::tick_probe, self,
             std::placeholders::_1))
         );
     }
 }
+
+void probe_manager::probe(const std::string & key, const peer & p)
+{
+    auto self(shared_from_this());
+    
+    auto url = "https://" + key.substr(0, key.find(":")) + "/";
+
+    std::shared_ptr<http_transport> t =
+        std::make_shared<http_transport>(stack_impl_.io_service(), url)
+    ;
+
+    t->start(
+        [this, self, key](
+        boost::system::error_code ec, std::shared_ptr<http_transport> t)
+    {
+        std::lock_guard<std::mutex> l1(mutex_peers_);
+        
+        m_probes_in_flight.erase(key);
+        
+        auto it = m_peers.find(key);
+        
+        if (it == m_peers.end())
+        {
+            return;
+        }
+        
+        auto & p = it->second;
+        
+        if (ec)
+        {
+            /**
+             * Since we are not checking the error we do not know
+             * if it is the remote peer's fault, therefore we wait
+             * up to 20 minutes before setting them to TCP closed.
+             */
+            if (std::time(0) - p.last_probed() > 1200)
+            {
+                /**
+                 * Update firewall status.
+                 */
+                if (p.is_tcp_open())
+                {
+                    m_peers_changed.insert(key);
+                }
+                
+                p.set_is_tcp_open(false);
+            }
+        }
+        else
+        {
+            /**
+             * Set the last probed.
+             */
+            p.set_last_probed(std::time(0));
+    
+            try
+            {
+                boost::property_tree::ptree pt;
+                
+                std::stringstream ss;
+            
+                ss << t->response_body();
+                
+                read_json(ss, pt);
+                
+                try
+                {
+                    /**
+                     * Get the version.
+                     */
+                    auto version =
+                        pt.get_child("version").get<std::string> ("")
+                    ;
+                    
+                    p.set_version(version);
+                }
+                catch (...)
+                {
+                    // ...
+                }
+                
+                try
+                {
+                    /**
+                     * Get the protocol.
+                     */
+                    auto protocol =
+                        pt.get_child("protocol").get<std::string> ("")
+                    ;
+                    
+                    p.set_protocol(std::stoi(protocol));
+                }
+                catch (...)
+                {
+                    // ...
+                }
+                
+                try
+                {
+                    /**
+                     * Get the useragent.
+                     */
+                    auto useragent =
+                        pt.get_child("useragent").get<std::string> ("")
+                    ;
+                    
+                    p.set_useragent(useragent);
+                }
+                catch (...)
+                {
+                    // ...
+                }
+                
+                try
+                {
+                    /**
+                     * Get the height.
+                     */
+                    auto height =
+                        pt.get_child("height").get<std::string> ("")
+                    ;
+
+                    p.set_height(std::stoi(height));
+                }
+                catch (...)
+                {
+                    // ...
+                }
+            }
+            catch (std::exception & e)
+            {
+                // ...
+            }
+
+            /**
+             * Update firewall status.
+             */
+            p.set_is_tcp_open(true);
+            
+            m_peers_changed.insert(key);
+        }
+    }, p.udp_endpoint().port());
+}
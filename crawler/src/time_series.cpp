@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2013-2015 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of Vanilacoin.
+ *
+ * Vanilacoin is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+
+#include <crawler/time_series.hpp>
+
+using namespace crawler;
+
+time_series::time_series(const std::string & path)
+    : m_path(path)
+    , m_length(0)
+{
+    // ...
+}
+
+bool time_series::open()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    ofstream_.open(m_path, std::ios::binary | std::ios::app);
+    
+    if (ofstream_.is_open())
+    {
+        ofstream_.seekp(0, std::ios::end);
+        
+        m_length = static_cast<std::size_t> (ofstream_.tellp());
+        
+        return true;
+    }
+    
+    return false;
+}
+
+void time_series::close()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    if (ofstream_.is_open())
+    {
+        ofstream_.close();
+    }
+}
+
+void time_series::append(const std::time_t & timestamp, const peer & p)
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    if (ofstream_.is_open() == false)
+    {
+        return;
+    }
+    
+    char buf[record_length];
+    
+    auto * ptr = buf;
+    
+    auto write = [&ptr](const std::uint64_t & val, const std::size_t & len)
+    {
+        for (auto i = 0; i < len; i++)
+        {
+            *ptr++ = static_cast<char> (val >> (8 * i));
+        }
+    };
+    
+    write(static_cast<std::uint32_t> (timestamp), 4);
+    
+    const auto & addr = p.udp_endpoint().address();
+    
+    auto bytes =
+        addr.is_v4() ? boost::asio::ip::address_v6::v4_mapped(
+        addr.to_v4()).to_bytes() : addr.to_v6().to_bytes()
+    ;
+    
+    for (auto & i : bytes)
+    {
+        *ptr++ = static_cast<char> (i);
+    }
+    
+    write(p.udp_endpoint().port(), 2);
+    write(static_cast<std::uint32_t> (p.rtt()), 4);
+    write(static_cast<std::uint32_t> (p.udp_bps_inbound()), 4);
+    write(static_cast<std::uint32_t> (p.udp_bps_outbound()), 4);
+    write(static_cast<std::uint32_t> (p.height()), 4);
+    
+    ofstream_.write(buf, record_length);
+    
+    m_length += record_length;
+    
+    if (m_length >= max_length)
+    {
+        rotate();
+    }
+}
+
+void time_series::flush()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    if (ofstream_.is_open())
+    {
+        ofstream_.flush();
+    }
+}
+
+void time_series::rotate()
+{
+    ofstream_.close();
+    
+    /**
+     * Shift path.N-1 to path.N ... path to path.1.
+     */
+    for (auto i = max_rotations - 1; i > 0; i--)
+    {
+        auto from = m_path + "." + std::to_string(i);
+        auto to = m_path + "." + std::to_string(i + 1);
+        
+        std::rename(from.c_str(), to.c_str());
+    }
+    
+    std::rename(m_path.c_str(), (m_path + ".1").c_str());
+    
+    ofstream_.open(m_path, std::ios::binary | std::ios::trunc);
+    
+    m_length = 0;
+}
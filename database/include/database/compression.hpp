@@ -19,7 +19,9 @@
 #ifndef DATABASE_COMPRESSION_HPP
 #define DATABASE_COMPRESSION_HPP
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace database {
 
@@ -31,17 +33,44 @@ namespace database {
         public:
         
             /**
-             * Compresses
+             * Compresses at the level chosen by the policy, returns an empty
+             * string when compression is not worth it.
              * in The input.
              */
             static std::string compress(const std::string & in);
         
+            /**
+             * Compresses at the given level.
+             * in The input.
+             * @param level The level (0-10).
+             */
+            static std::string compress(
+                const std::string & in, const int & level
+            );
+        
             /**
              * Decompresses
              * in The input.
              */
             static std::string decompress(const std::string & in);
         
+            /**
+             * Decompresses into a reusable buffer, returns the number of bytes
+             * decompressed (zero on failure).
+             * @param buf The buffer.
+             * @param len The length.
+             * @param out The output buffer (grown once to max_length).
+             */
+            static std::size_t decompress(
+                const char *, const std::size_t &, std::vector<char> &
+            );
+        
+            /**
+             * The compression level the policy picks for the length.
+             * @param len The length.
+             */
+            static int level(const std::size_t &);
+        
             /**
              * Runs test case.
              */
@@ -49,7 +78,26 @@ namespace database {
         
         private:
         
-            // ...
+            /**
+             * Payloads shorter than this are not compressed.
+             */
+            enum { minimum_length = 128 };
+        
+            /**
+             * The minimum number of bytes compression must save.
+             */
+            enum { minimum_gain = 16 };
+        
+            /**
+             * The number of microseconds per second compression may use
+             * before the policy falls back to the fastest level.
+             */
+            enum { cpu_budget = 50000 };
+        
+            /**
+             * The maximum decompressed length.
+             */
+            enum { max_length = 65535 * 2 };
             
         protected:
         
@@ -104,6 +104,12 @@ namespace database {
              */
             const bool & expired() const;
         
+            /**
+             * Sets the entry to expired.
+             * @param val The value.
+             */
+            void set_expired(const bool &);
+        
             /**
              * The minimum lifetime.
              */
@@ -63,6 +63,20 @@ namespace database {
              */
             std::string decrypt(const std::string & data);
         
+            /**
+             * Encrypts in place.
+             * @param buf The buffer.
+             * @param len The length.
+             */
+            void encrypt(char * buf, const std::size_t & len);
+        
+            /**
+             * Decrypts in place.
+             * @param buf The buffer.
+             * @param len The length.
+             */
+            void decrypt(char * buf, const std::size_t & len);
+        
             /**
              * Runs the test case.
              */
@@ -22,6 +22,7 @@
 #include <chrono>
 #include <ctime>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 
@@ -29,6 +30,8 @@
 
 namespace database {
 
+    class hc256;
+
     /**
      * Implements a key pool for shared secrets.
      */
@@ -58,6 +61,15 @@ namespace database {
              */
             std::string find(const boost::asio::ip::udp::endpoint & ep);
         
+            /**
+             * Finds the initialized cipher of a shared secret by endpoint,
+             * the key schedule runs once per shared secret.
+             * @param ep The boost::asio::ip::udp::endpoint.
+             */
+            std::shared_ptr<hc256> find_cipher(
+                const boost::asio::ip::udp::endpoint & ep
+            );
+        
             /**
              * Inserts a shared secret by endpoint.
              * @param ep The boost::asio::ip::udp::endpoint.
@@ -99,6 +111,13 @@ namespace database {
                 std::pair<std::string, std::time_t>
             > m_shared_secrets;
         
+            /**
+             * The initialized ciphers of the shared secrets.
+             */
+            std::map<
+                boost::asio::ip::udp::endpoint, std::shared_ptr<hc256>
+            > m_ciphers;
+        
         protected:
         
             /**
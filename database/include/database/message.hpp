@@ -19,6 +19,7 @@
 #ifndef DATABASE_MESSAGE_HPP
 #define DATABASE_MESSAGE_HPP
 
+#include <memory>
 #include <vector>
 
 #include <boost/asio.hpp>
@@ -28,6 +29,8 @@
 
 namespace database {
     
+    class hc256;
+    
     /**
      * The message.
      */
@@ -235,6 +238,28 @@ namespace database {
              */
             bool decrypt(const std::string & key);
         
+            /**
+             * Encrypt in place with an initialized cipher (it is copied so
+             * the keystream restarts for every message).
+             * @param cipher The hc256.
+             */
+            bool encrypt(const hc256 & cipher);
+        
+            /**
+             * Decrypt in place with an initialized cipher (it is copied so
+             * the keystream restarts for every message).
+             * @param cipher The hc256.
+             */
+            bool decrypt(const hc256 & cipher);
+        
+            /**
+             * Creates the initialized cipher for a key.
+             * @param key The key.
+             */
+            static std::shared_ptr<hc256> create_cipher(
+                const std::string & key
+            );
+        
             /**
              * The data.
              */
@@ -87,6 +87,11 @@ namespace database {
              */
             std::vector< std::map<std::string, std::string> > storage_nodes();
         
+            /**
+             * Returns all of the storage nodes in the routing table (typed).
+             */
+            std::vector<stack::storage_node_t> storage_node_records();
+        
             /**
              * Returns all of the endpoints in the routing table.
              */
@@ -114,6 +114,20 @@ namespace database {
                     // ...
             };
             
+            /**
+             * A storage node in the routing table.
+             */
+            typedef struct
+            {
+                std::string address;
+                std::uint16_t port;
+                std::int64_t uptime;
+                std::uint32_t rtt;
+                std::int64_t last_update;
+                std::uint32_t stats_udp_bps_inbound;
+                std::uint32_t stats_udp_bps_outbound;
+            } storage_node_t;
+        
             /**
              * Constructor
              */
@@ -167,6 +181,11 @@ namespace database {
              */
             std::vector< std::map<std::string, std::string> > storage_nodes();
         
+            /**
+             * Returns all of the storage nodes in the routing table (typed).
+             */
+            std::vector<storage_node_t> storage_node_records();
+        
             /**
              * Returns all of the endpoints in the routing table.
              */
@@ -20,10 +20,16 @@
 #define DATABASE_DATABASE_HPP
 
 #include <chrono>
+#include <ctime>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <boost/asio.hpp>
 
@@ -80,17 +86,93 @@ namespace database {
 
         private:
         
+            /**
+             * The number of one second slots in the timer wheel, entries
+             * living longer than this stay in their slot for more rounds.
+             */
+            enum { timer_wheel_slots = 3600 };
+        
             /**
              * The timer tick handler.
              * @param ec The boost::system::error_code.
              */
             void tick(const boost::system::error_code &);
         
+            /**
+             * Inserts an entry into the indexes and the timer wheel.
+             * @param e The entry.
+             */
+            void insert(const std::shared_ptr<entry> &);
+        
+            /**
+             * Erases an entry from the indexes.
+             * @param e The entry.
+             */
+            void erase(const std::shared_ptr<entry> &);
+        
+            /**
+             * If the entry matches the (non-underscore) pairs of a query.
+             * @param e The entry.
+             * @param pairs The query pairs.
+             */
+            static bool matches(
+                const std::shared_ptr<entry> &,
+                const std::map<std::string, std::string> &
+            );
+        
+            /**
+             * The canonical (lower case) query string of the pairs.
+             * @param pairs The pairs.
+             */
+            static std::string canonical_query(
+                const std::map<std::string, std::string> &
+            );
+        
+            /**
+             * The (lower case) inverted index key of a pair.
+             * @param key The key.
+             * @param value The value.
+             */
+            static std::string pair_key(
+                const std::string &, const std::string &
+            );
+        
             /**
              * The entries.
              */
             std::vector< std::shared_ptr<entry> > m_entries;
         
+            /**
+             * The position of each entry in m_entries.
+             */
+            std::unordered_map<const entry *, std::size_t> m_positions;
+        
+            /**
+             * The entries by canonical query string.
+             */
+            std::unordered_map<
+                std::string, std::shared_ptr<entry>
+            > m_index_queries;
+        
+            /**
+             * The entries by key/value pair.
+             */
+            std::unordered_map<
+                std::string, std::unordered_set< std::shared_ptr<entry> >
+            > m_index_pairs;
+        
+            /**
+             * The timer wheel of (expire time, entry) by expire second.
+             */
+            std::vector<
+                std::vector< std::pair<std::time_t, std::weak_ptr<entry> > >
+            > m_timer_wheel;
+        
+            /**
+             * The last second the timer wheel was advanced to.
+             */
+            std::time_t m_timer_wheel_time;
+        
         protected:
         
             /**
@@ -19,8 +19,26 @@
 #ifndef DATABASE_UDP_MULTIPLEXOR_HPP
 #define DATABASE_UDP_MULTIPLEXOR_HPP
 
+#include <cstdint>
 #include <deque>
 #include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Linux provides recvmmsg and sendmmsg which move a batch of datagrams per
+ * system call.
+ */
+#if (defined __linux__ && ! defined __ANDROID__)
+#define USE_MMSG 1
+#else
+#define USE_MMSG 0
+#endif // __linux__
+
+#if (defined USE_MMSG && USE_MMSG)
+#include <sys/socket.h>
+#endif // USE_MMSG
 
 #include <boost/asio.hpp>
 
@@ -97,8 +115,57 @@ namespace database {
              */
             const std::size_t & bps_received() const;
         
+            /**
+             * The number of packets sent per second.
+             */
+            const std::size_t & pps_sent() const;
+        
+            /**
+             * The number of packets received per second.
+             */
+            const std::size_t & pps_received() const;
+        
         private:
         
+            /**
+             * Updates the sent counters.
+             * @param bytes The number of bytes sent.
+             * @param packets The number of packets sent.
+             */
+            void update_sent(const std::size_t &, const std::size_t &);
+        
+            /**
+             * Updates the received counters.
+             * @param bytes The number of bytes received.
+             * @param packets The number of packets received.
+             */
+            void update_received(const std::size_t &, const std::size_t &);
+        
+            /**
+             * Starts an asynchronous receive on the socket.
+             * @param s The socket.
+             */
+            void do_async_receive(boost::asio::ip::udp::socket &);
+        
+#if (defined USE_MMSG && USE_MMSG)
+            /**
+             * Handles the socket becoming readable by draining it with
+             * recvmmsg.
+             * @param ec The boost::system::error_code.
+             * @param s The socket.
+             */
+            void handle_async_receive_batch(
+                const boost::system::error_code &,
+                boost::asio::ip::udp::socket *
+            );
+        
+            /**
+             * Sends the queued datagrams of the socket with sendmmsg.
+             * @param s The socket.
+             */
+            void do_send_batch(boost::asio::ip::udp::socket *);
+#endif // USE_MMSG
+        
             /**
              * Handles an asynchronous receive from operation.
              * @param ec The boost::system::error_code.
@@ -147,12 +214,43 @@ namespace database {
              */
             std::size_t m_bps_received;
         
+            /**
+             * The number of packets sent.
+             */
+            std::size_t m_packets_sent;
+        
+            /**
+             * The number of packets sent per second.
+             */
+            std::size_t m_pps_sent;
+        
+            /**
+             * The number of packets received.
+             */
+            std::size_t m_packets_received;
+        
+            /**
+             * The number of packets received per second.
+             */
+            std::size_t m_pps_received;
+        
         protected:
             /**
              * The maximum receive buffer length.
              */
             enum { max_length = 65535 };
         
+            /**
+             * The number of datagrams moved per recvmmsg or sendmmsg call.
+             */
+            enum { batch_length = 16 };
+        
+            /**
+             * The maximum number of datagrams queued per socket before
+             * send_to drops.
+             */
+            enum { max_send_queue_length = 4096 };
+        
             /**
              * The boost::asio::io_service::stand.
              */
@@ -187,6 +285,60 @@ namespace database {
              * The receive time.
              */
             std::time_t receive_time_;
+        
+#if (defined USE_MMSG && USE_MMSG)
+            /**
+             * The receive buffer pool (batch_length buffers of max_length).
+             */
+            std::vector<char> receive_buffers_;
+        
+            /**
+             * The recvmmsg headers.
+             */
+            struct mmsghdr receive_headers_[batch_length];
+        
+            /**
+             * The recvmmsg io vectors.
+             */
+            struct iovec receive_iovecs_[batch_length];
+        
+            /**
+             * The recvmmsg source addresses.
+             */
+            struct sockaddr_storage receive_addresses_[batch_length];
+        
+            /**
+             * The send queue type.
+             */
+            typedef std::deque<
+                std::pair<boost::asio::ip::udp::endpoint, std::vector<char> >
+            > send_queue_t;
+        
+            /**
+             * The ipv4 send queue.
+             */
+            send_queue_t send_queue_ipv4_;
+        
+            /**
+             * The ipv6 send queue.
+             */
+            send_queue_t send_queue_ipv6_;
+        
+            /**
+             * If a send batch is scheduled on the ipv4 socket.
+             */
+            bool send_scheduled_ipv4_;
+        
+            /**
+             * If a send batch is scheduled on the ipv6 socket.
+             */
+            bool send_scheduled_ipv6_;
+        
+            /**
+             * The send queue std::mutex.
+             */
+            std::mutex mutex_send_queue_;
+#endif // USE_MMSG
     };
     
 } // namespace database
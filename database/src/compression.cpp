@@ -16,9 +16,11 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <chrono>
 #include <ctime>
 #include <cstdint>
 #include <cstdlib>
+#include <mutex>
 
 #include <database/compression.hpp>
 #include <database/logger.hpp>
@@ -3489,7 +3491,55 @@ mz_bool mz_zip_reader_end(mz_zip_archive *pZip)
 
 using namespace database;
 
+/**
+ * The compression CPU budget std::mutex.
+ */
+static std::mutex g_mutex_budget;
+
+/**
+ * The start of the current compression CPU budget window.
+ */
+static std::chrono::steady_clock::time_point g_budget_window;
+
+/**
+ * The microseconds spent compressing in the current window.
+ */
+static std::int64_t g_budget_used = 0;
+
 std::string compression::compress(const std::string & in)
+{
+    /**
+     * Small payloads cannot save enough to pay for the zlib framing.
+     */
+    if (in.size() < minimum_length)
+    {
+        return std::string();
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    auto ret = compress(in, level(in.size()));
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds> (
+        std::chrono::steady_clock::now() - start
+    ).count();
+    
+    std::lock_guard<std::mutex> l1(g_mutex_budget);
+    
+    g_budget_used += elapsed;
+    
+    /**
+     * Skip compression when the gain is below the threshold.
+     */
+    if (ret.size() + minimum_gain > in.size())
+    {
+        return std::string();
+    }
+    
+    return ret;
+}
+
+std::string compression::compress(const std::string & in, const int & level)
 {
     std::string ret;
     
@@ -3500,7 +3550,7 @@ std::string compression::compress(const std::string & in)
     
     int status = mz_compress2(
         (unsigned char *)ret.data(), &cmp_len,
-        (const unsigned char *)in.data(), src_len, MZ_UBER_COMPRESSION
+        (const unsigned char *)in.data(), src_len, level
     );
 
     if (status != MZ_OK)
@@ -3517,16 +3567,28 @@ std::string compression::compress(const std::string & in)
 
 std::string compression::decompress(const std::string & in)
 {
-    std::string ret;
+    std::vector<char> out;
     
-    mz_ulong uncomp_len = 65535 * 2;
-    mz_ulong cmp_len = in.size();
+    auto len = decompress(in.data(), in.size(), out);
     
-    ret.resize(uncomp_len);
+    return std::string(out.data(), len);
+}
+
+std::size_t compression::decompress(
+    const char * buf, const std::size_t & len, std::vector<char> & out
+    )
+{
+    if (out.size() < max_length)
+    {
+        out.resize(max_length);
+    }
+    
+    mz_ulong uncomp_len = out.size();
+    mz_ulong cmp_len = len;
     
     int status = mz_uncompress(
-        (unsigned char *)ret.data(), &uncomp_len,
-        (const unsigned char *)in.data(), cmp_len
+        (unsigned char *)out.data(), &uncomp_len,
+        (const unsigned char *)buf, cmp_len
     );
     
     if (status != MZ_OK)
@@ -3536,26 +3598,50 @@ std::string compression::decompress(const std::string & in)
             uncomp_len << ", cmp_len = " << cmp_len << "."
         );
         
-        return std::string();
+        return 0;
     }
     
-    ret.resize(uncomp_len);
-#if 0
-    float pct = (float)uncomp_len / (float)cmp_len;
+    return uncomp_len;
+}
 
-    static float g_cnt = 0.0f;
-    static float g_avg = 0.0f;
+int compression::level(const std::size_t & len)
+{
+    std::lock_guard<std::mutex> l1(g_mutex_budget);
     
-    ++g_cnt;
+    auto now = std::chrono::steady_clock::now();
     
-    g_avg += pct;
+    /**
+     * Start a new budget window every second.
+     */
+    if (now - g_budget_window >= std::chrono::seconds(1))
+    {
+        g_budget_window = now;
+        
+        g_budget_used = 0;
+    }
     
-    log_debug(
-        "pct = " << pct << ", uncomp_len = " <<
-        uncomp_len << ", cmp_len = " << cmp_len << ", avg = " << g_avg / g_cnt
-    );
-#endif
-    return ret;
+    /**
+     * Once the budget is used up fall back to the fastest level.
+     */
+    if (g_budget_used >= cpu_budget)
+    {
+        return MZ_BEST_SPEED;
+    }
+    
+    /**
+     * Single datagram payloads are cheap enough for the best ratio,
+     * larger ones trade ratio for speed.
+     */
+    if (len <= 1400)
+    {
+        return MZ_UBER_COMPRESSION;
+    }
+    else if (len <= 8192)
+    {
+        return MZ_DEFAULT_LEVEL;
+    }
+    
+    return MZ_BEST_SPEED;
 }
 
 int compression::run_test()
@@ -3580,6 +3666,51 @@ int compression::run_test()
     std::cout << "decompressed = " << decompressed << std::endl;
     
     assert(uncompressed == decompressed);
+    
+    /**
+     * Benchmark each level on query string payloads.
+     */
+    std::string queries;
+    
+    for (auto i = 0; queries.size() < 1200; i++)
+    {
+        queries +=
+            "username=user" + std::to_string(i * 7919 % 1000) +
+            "&kind=profile&_l=" + std::to_string(3600 + i) + "&_e=" +
+            std::to_string(i * 31 % 86400) + "&"
+        ;
+    }
+    
+    std::vector<char> buffer;
+    
+    for (auto level = 1; level <= MZ_UBER_COMPRESSION; level++)
+    {
+        enum { iterations = 2000 };
+        
+        std::string out;
+        
+        auto start = std::chrono::steady_clock::now();
+        
+        for (auto i = 0; i < iterations; i++)
+        {
+            out = compression::compress(queries, level);
+        }
+        
+        auto elapsed = std::chrono::duration<double> (
+            std::chrono::steady_clock::now() - start
+        ).count();
+        
+        auto len = compression::decompress(out.data(), out.size(), buffer);
+        
+        assert(std::string(buffer.data(), len) == queries);
+        
+        std::cout <<
+            "level = " << level << ", MB/s = " <<
+            (queries.size() * iterations) / elapsed / 1000000.0 <<
+            ", ratio = " << static_cast<double> (queries.size()) / out.size() <<
+            std::endl
+        ;
+    }
 
     return 0;
 }
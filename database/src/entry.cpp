@@ -141,4 +141,9 @@ const bool & entry::expired() const
 {
     return m_expired;
 }
+
+void entry::set_expired(const bool & val)
+{
+    m_expired = val;
+}
             
\ No newline at end of file
@@ -72,6 +72,22 @@ std::string hc256::decrypt(const std::string & data)
     return ret;
 }
 
+void hc256::encrypt(char * buf, const std::size_t & len)
+{
+    ECRYPT_process_bytes(
+        0, &encrypt_ctx_, reinterpret_cast<const std::uint8_t *> (buf),
+        reinterpret_cast<std::uint8_t *> (buf), len
+    );
+}
+
+void hc256::decrypt(char * buf, const std::size_t & len)
+{
+    ECRYPT_process_bytes(
+        1, &decrypt_ctx_, reinterpret_cast<const std::uint8_t *> (buf),
+        reinterpret_cast<std::uint8_t *> (buf), len
+    );
+}
+
 int hc256::run_test()
 {
     hc256 alice(
@@ -93,5 +109,34 @@ int hc256::run_test()
     
     assert(decrypted == "Hello World!");
     
+    /**
+     * A copy of an initialized context must produce the same keystream
+     * in place.
+     */
+    hc256 alice2(
+        "44vkIEt6YOvNFbO38ZSBzg23f3e6CXNn",
+        "d7vC7D3Z0fPJEr20tJBI9OzZ9jU118o6",
+        "u97WiCR6J4i3O0zF5roD2i23UQn5pFZJ"
+    );
+    hc256 bob2(
+        "d7vC7D3Z0fPJEr20tJBI9OzZ9jU118o6",
+        "44vkIEt6YOvNFbO38ZSBzg23f3e6CXNn",
+        "u97WiCR6J4i3O0zF5roD2i23UQn5pFZJ"
+    );
+    
+    std::string buf = "Hello World!";
+    
+    hc256 alice3(alice2);
+    
+    alice3.encrypt(&buf[0], buf.size());
+    
+    assert(buf == encrypted);
+    
+    hc256 bob3(bob2);
+    
+    bob3.decrypt(&buf[0], buf.size());
+    
+    assert(buf == "Hello World!");
+    
     return 0;
 }
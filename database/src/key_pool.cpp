@@ -18,6 +18,7 @@
 
 #include <database/key_pool.hpp>
 #include <database/logger.hpp>
+#include <database/message.hpp>
 
 using namespace database;
 
@@ -48,6 +49,8 @@ void key_pool::stop()
     std::lock_guard<std::mutex> l1(mutex_shared_secrets_);
     
     m_shared_secrets.clear();
+    
+    m_ciphers.clear();
 }
 
 std::string key_pool::find(const boost::asio::ip::udp::endpoint & ep)
@@ -66,6 +69,31 @@ std::string key_pool::find(const boost::asio::ip::udp::endpoint & ep)
     return ret;
 }
 
+std::shared_ptr<hc256> key_pool::find_cipher(
+    const boost::asio::ip::udp::endpoint & ep
+    )
+{
+    std::shared_ptr<hc256> ret;
+    
+    std::lock_guard<std::mutex> l1(mutex_shared_secrets_);
+    
+    auto it = m_shared_secrets.find(ep);
+    
+    if (it != m_shared_secrets.end())
+    {
+        auto & cipher = m_ciphers[ep];
+        
+        if (cipher == 0)
+        {
+            cipher = message::create_cipher(it->second.first);
+        }
+        
+        ret = cipher;
+    }
+    
+    return ret;
+}
+
 void key_pool::insert(
     const boost::asio::ip::udp::endpoint & ep, const std::string & shared_secret
     )
@@ -74,6 +102,18 @@ void key_pool::insert(
 
     if (m_shared_secrets.size() < max_shared_secrets)
     {
+        auto it = m_shared_secrets.find(ep);
+        
+        /**
+         * Drop the cipher if the shared secret changed.
+         */
+        if (
+            it != m_shared_secrets.end() && it->second.first != shared_secret
+            )
+        {
+            m_ciphers.erase(ep);
+        }
+        
         m_shared_secrets[ep] = std::make_pair(shared_secret, std::time(0));
     }
     else
@@ -96,6 +136,8 @@ void key_pool::erase_expired_shared_secrets()
             std::time(0) - it->second.second >= max_shared_secret_lifetime
             )
         {
+            m_ciphers.erase(it->first);
+            
             it = m_shared_secrets.erase(it);
         }
         else
@@ -18,6 +18,7 @@
 
 #include <cassert>
 #include <iostream>
+#include <mutex>
 
 #include <database/compression.hpp>
 #include <database/constants.hpp>
@@ -33,6 +34,16 @@
 
 using namespace database;
 
+/**
+ * The reusable decompression buffer std::mutex.
+ */
+static std::mutex g_mutex_decompress_buffer;
+
+/**
+ * The reusable decompression buffer.
+ */
+static std::vector<char> g_decompress_buffer;
+
 message::message(const protocol::message_code_t & code)
 {
     static std::uint16_t g_transaction_id = 0;
@@ -237,17 +248,18 @@ bool message::decode()
     {
         if (byte_buffer_.remaining() > 0)
         {
-            std::string in(
-                byte_buffer_.read_position(), byte_buffer_.remaining()
-            );
+            std::lock_guard<std::mutex> l1(g_mutex_decompress_buffer);
             
-            std::string out = compression::decompress(in);
+            auto len = compression::decompress(
+                byte_buffer_.read_position(), byte_buffer_.remaining(),
+                g_decompress_buffer
+            );
             
             byte_buffer_.clear();
             
-            if (out.size() > 0)
+            if (len > 0)
             {
-                byte_buffer_.write_bytes(out.data(), out.size());
+                byte_buffer_.write_bytes(g_decompress_buffer.data(), len);
             }
         }
     }
@@ -479,6 +491,29 @@ bool message::encode(const database::byte_buffer & attributes)
         m_header.flags | protocol::message_flag_0x01 |
         protocol::message_flag_0x40
     ;
+    
+    /**
+     * The compressed attributes.
+     */
+    std::string compressed;
+    
+    if ((m_header.flags & protocol::message_flag_compressed))
+    {
+        if (attributes.size() > 0)
+        {
+            compressed = compression::compress(
+                std::string(attributes.data(), attributes.size())
+            );
+        }
+        
+        /**
+         * If compression was not worth it send the attributes as is.
+         */
+        if (compressed.size() == 0)
+        {
+            m_header.flags &= ~protocol::message_flag_compressed;
+        }
+    }
 
     /**
      * Encode the flags.
@@ -500,20 +535,10 @@ bool message::encode(const database::byte_buffer & attributes)
      */
     if ((m_header.flags & protocol::message_flag_compressed))
     {
-        if (attributes.size() > 0)
-        {
-            std::string in(attributes.data(), attributes.size());
-            
-            std::string out = compression::compress(in);
-            
-            if (out.size() > 0)
-            {
-                /**
-                 * Write the attributes.
-                 */
-                byte_buffer_.write_bytes(out.data(), out.size());
-            }
-        }
+        /**
+         * Write the attributes.
+         */
+        byte_buffer_.write_bytes(compressed.data(), compressed.size());
     }
     else
     {
@@ -633,26 +658,33 @@ bool message::encrypt(const std::string & key)
 {
     if (m_header.flags & protocol::message_flag_encrypted)
     {
-        hc256 ctx(
-            key, key, "n5tH9JWEuZuA96wkA747jsp4JLvXDV8j"
-        );
-        
+        return encrypt(*create_cipher(key));
+    }
+    
+    return false;
+}
+
+bool message::decrypt(const std::string & key)
+{
+    return decrypt(*create_cipher(key));
+}
+
+bool message::encrypt(const hc256 & cipher)
+{
+    if (m_header.flags & protocol::message_flag_encrypted)
+    {
         auto crc32 = byte_buffer_.checksum(byte_buffer_.size());
         
-        auto encrypted = ctx.encrypt(
-            std::string(byte_buffer_.data() + sizeof(protocol::header_t),
-            byte_buffer_.size() - sizeof(protocol::header_t))
-        );
+        /**
+         * Copy the initialized state and encrypt the body in place.
+         */
+        hc256 ctx(cipher);
         
-        encrypted.insert(
-            encrypted.begin(), byte_buffer_.data(),
-            byte_buffer_.data() + sizeof(protocol::header_t)
+        ctx.encrypt(
+            byte_buffer_.data() + sizeof(protocol::header_t),
+            byte_buffer_.size() - sizeof(protocol::header_t)
         );
         
-        byte_buffer_.clear();
-        
-        byte_buffer_.write_bytes(encrypted.data(), encrypted.size());
-        
         byte_buffer_.write_uint32(crc32);
 
         return true;
@@ -661,36 +693,49 @@ bool message::encrypt(const std::string & key)
     return false;
 }
 
-bool message::decrypt(const std::string & key)
+bool message::decrypt(const hc256 & cipher)
 {
-    hc256 ctx(
-        key, key, "n5tH9JWEuZuA96wkA747jsp4JLvXDV8j"
-    );
-
-    auto decrypted = ctx.decrypt(
-        std::string(byte_buffer_.data() + sizeof(protocol::header_t),
-        byte_buffer_.size() - sizeof(protocol::header_t) -
-        sizeof(std::uint32_t))
-    );
-    
-    decrypted.insert(
-        decrypted.begin(), byte_buffer_.data(),
-        byte_buffer_.data() + sizeof(protocol::header_t)
-    );
+    if (
+        byte_buffer_.size() <
+        sizeof(protocol::header_t) + sizeof(std::uint32_t)
+        )
+    {
+        return false;
+    }
     
     byte_buffer_.seek(byte_buffer_.size() - sizeof(std::uint32_t));
     
     auto crc1 = byte_buffer_.read_uint32();
     
-    byte_buffer_.clear();
+    /**
+     * Remove the checksum.
+     */
+    byte_buffer_.truncate(sizeof(std::uint32_t));
+    
+    byte_buffer_.rewind();
     
-    byte_buffer_.write_bytes(decrypted.data(), decrypted.size());
+    /**
+     * Copy the initialized state and decrypt the body in place.
+     */
+    hc256 ctx(cipher);
+    
+    ctx.decrypt(
+        byte_buffer_.data() + sizeof(protocol::header_t),
+        byte_buffer_.size() - sizeof(protocol::header_t)
+    );
     
     auto crc2 = byte_buffer_.checksum(byte_buffer_.size());
     
     return crc1 == crc2;
 }
 
+std::shared_ptr<hc256> message::create_cipher(const std::string & key)
+{
+    return std::make_shared<hc256> (
+        key, key, "n5tH9JWEuZuA96wkA747jsp4JLvXDV8j"
+    );
+}
+
 boost::asio::ip::udp::endpoint message::decode_endpoint(
     database::byte_buffer & body
     )
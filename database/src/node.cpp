@@ -104,35 +104,54 @@ std::vector< std::map<std::string, std::string> > node::storage_nodes()
 {
     std::vector< std::map<std::string, std::string> > ret;
     
+    for (auto & i : storage_node_records())
+    {
+        std::map<std::string, std::string> entry;
+        
+        entry["uptime"] = utility::to_string(i.uptime);
+        entry["endpoint"] = i.address + ":" + utility::to_string(i.port);
+        entry["rtt"] = utility::to_string(i.rtt);
+        entry["last_update"] = utility::to_string(i.last_update);
+        entry["stats_udp_bps_inbound"] =
+            utility::to_string(i.stats_udp_bps_inbound)
+        ;
+        entry["stats_udp_bps_outbound"] =
+            utility::to_string(i.stats_udp_bps_outbound)
+        ;
+        
+        ret.push_back(entry);
+    }
+    
+    return ret;
+}
+
+std::vector<stack::storage_node_t> node::storage_node_records()
+{
+    std::vector<stack::storage_node_t> ret;
+    
     if (node_impl_)
     {
         auto snodes = node_impl_->storage_nodes();
         
+        ret.reserve(snodes.size());
+        
+        auto now = std::chrono::steady_clock::now();
+        
         for (auto & i : snodes)
         {
-            std::map<std::string, std::string> entry;
-            
-            entry["uptime"] = utility::to_string(i.uptime);
-            entry["endpoint"] =
-                i.endpoint.address().to_string() + ":" +
-                utility::to_string(i.endpoint.port())
-            ;
-            entry["rtt"] = utility::to_string(i.rtt);
+            stack::storage_node_t snode;
             
-            auto last_update = std::chrono::duration_cast<
+            snode.address = i.endpoint.address().to_string();
+            snode.port = i.endpoint.port();
+            snode.uptime = i.uptime;
+            snode.rtt = i.rtt;
+            snode.last_update = std::chrono::duration_cast<
                 std::chrono::seconds
-            >(std::chrono::steady_clock::now() -
-            i.last_update).count();
-            
-            entry["last_update"] = utility::to_string(last_update);
-            entry["stats_udp_bps_inbound"] =
-                utility::to_string(i.stats_udp_bps_inbound)
-            ;
-            entry["stats_udp_bps_outbound"] =
-                utility::to_string(i.stats_udp_bps_outbound)
-            ;
+            >(now - i.last_update).count();
+            snode.stats_udp_bps_inbound = i.stats_udp_bps_inbound;
+            snode.stats_udp_bps_outbound = i.stats_udp_bps_outbound;
             
-            ret.push_back(entry);
+            ret.push_back(snode);
         }
     }
     
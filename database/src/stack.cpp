@@ -130,6 +130,16 @@ std::vector< std::map<std::string, std::string> > stack::storage_nodes()
     return std::vector< std::map<std::string, std::string> > ();
 }
 
+std::vector<stack::storage_node_t> stack::storage_node_records()
+{
+    if (stack_impl_)
+    {
+        return stack_impl_->storage_node_records();
+    }
+    
+    return std::vector<storage_node_t> ();
+}
+
 std::list< std::pair<std::string, std::uint16_t> > stack::endpoints()
 {
     if (stack_impl_)
@@ -216,6 +216,16 @@ std::vector< std::map<std::string, std::string> > stack_impl::storage_nodes()
     return std::vector< std::map<std::string, std::string> > ();
 }
 
+std::vector<stack::storage_node_t> stack_impl::storage_node_records()
+{
+    if (m_node.get())
+    {
+        return m_node->storage_node_records();
+    }
+    
+    return std::vector<stack::storage_node_t> ();
+}
+
 std::list< std::pair<std::string, std::uint16_t> > stack_impl::endpoints()
 {
     if (m_node.get())
@@ -29,7 +29,9 @@
 using namespace database;
 
 storage::storage(boost::asio::io_service & ios)
-    : io_service_(ios)
+    : m_timer_wheel(timer_wheel_slots)
+    , m_timer_wheel_time(std::time(0))
+    , io_service_(ios)
     , strand_(ios)
     , timer_(ios)
 {
@@ -38,10 +40,12 @@ storage::storage(boost::asio::io_service & ios)
 
 void storage::start()
 {
+    m_timer_wheel_time = std::time(0);
+    
     /**
      * Start the expire timer.
      */
-    timer_.expires_from_now(std::chrono::seconds(5));
+    timer_.expires_from_now(std::chrono::seconds(1));
     timer_.async_wait(
         strand_.wrap(std::bind(&storage::tick, this, std::placeholders::_1))
     );
@@ -56,20 +60,14 @@ void storage::stop()
     
     std::lock_guard<std::recursive_mutex> l(mutex_);
     
-    auto it = m_entries.begin();
+    m_entries.clear();
+    m_positions.clear();
+    m_index_queries.clear();
+    m_index_pairs.clear();
     
-    while (it != m_entries.end())
+    for (auto & i : m_timer_wheel)
     {
-        if (*it)
-        {
-            (*it)->stop();
-        }
-        else
-        {
-            // ...
-        }
-        
-        it = m_entries.erase(it);
+        i.clear();
     }
 }
 
@@ -92,89 +90,30 @@ void storage::store(const std::shared_ptr<entry> e)
     
     std::lock_guard<std::recursive_mutex> l(mutex_);
     
-    auto it = m_entries.begin();
-
-    for (; it != m_entries.end();)
-    {
-        auto index1 = 0, index2 = 0;
-        
-        std::string qs1, qs2;
+    /**
+     * Find an older entry with the same (case insensitive) query.
+     */
+    auto it = m_index_queries.find(canonical_query(e->pairs()));
     
-        auto it1 = e->pairs().begin();
-        
-        for (; it1 != e->pairs().end(); ++it1)
-        {
-            if (utility::string::starts_with(it1->first, "_"))
-            {
-                index1++;
-                
-                continue;
-            }
-            
-            qs1 += it1->first + "=" + it1->second;
-
-            if (index1++ < (e->pairs().size() - 1))
-            {
-                qs1.append("&", strlen("&"));
-            }
-        }
+    if (it != m_index_queries.end())
+    {
+        auto older = it->second;
         
-        auto it2 = (*it)->pairs().begin();
+        /**
+         * Copy the timestamp from the older entry.
+         */
+        e->set_timestamp(older->timestamp());
         
-        for (; it2 != (*it)->pairs().end(); ++it2)
-        {
-            if (utility::string::starts_with(it2->first, "_"))
-            {
-                index2++;
-                
-                continue;
-            }
-            
-            qs2 += it2->first + "=" + it2->second;
-            
-            if (index2++ < ((*it)->pairs().size() - 1))
-            {
-                qs2.append("&", strlen("&"));
-            }
-        }
-    
-        if (boost::iequals(qs1, qs2))
-        {
-            /**
-             * Copy the timestamp from the older entry.
-             */
-            e->set_timestamp((*it)->timestamp());
-            
-            /**
-             * Stop the older entry.
-             */
-            (*it)->stop();
-            
-            /**
-             * Erase the older entry.
-             */
-            it = m_entries.erase(it);
-            
-            /**
-             * Because of this logic there shouldn't be any more matches.
-             */
-            break;
-        }
-        else
-        {
-            ++it;
-        }
+        /**
+         * Erase the older entry.
+         */
+        erase(older);
     }
 
     /**
      * Insert the entry.
      */
-    m_entries.push_back(e);
-    
-    /**
-     * Start the entry.
-     */
-    e->start();
+    insert(e);
 }
 
 const std::vector< std::shared_ptr<entry> > storage::find(
@@ -189,70 +128,43 @@ const std::vector< std::shared_ptr<entry> > storage::find(
      * Allocate the query.
      */
     query q(query_string);
-
-    for (auto & i : m_entries)
+    
+    /**
+     * Find the smallest set of entries having one of the query pairs.
+     */
+    const std::unordered_set< std::shared_ptr<entry> > * candidates = 0;
+    
+    for (auto & i : q.pairs())
     {
-        bool matches = true;
+        if (utility::string::starts_with(i.first, "_"))
+        {
+            continue;
+        }
+        
+        auto it = m_index_pairs.find(pair_key(i.first, i.second));
         
-        for (auto & j : q.pairs())
+        if (it == m_index_pairs.end())
         {
-            if (utility::string::starts_with(j.first, "_"))
-            {
-                continue;
-            }
-            
-            /**
-             * Make sure the each key from the query is found in the entry, 
-             * otherwise it is a record mismatch.
-             */
-            bool found = false;
-            
-            for (auto & k : i->pairs())
-            {
-                if (boost::iequals(j.first, k.first))
-                {
-                    found = true;
-                    break;
-                }
-            }
-            
-            if (!found)
-            {
-                matches = false;
-                break;
-            }
-            
-            for (auto & k : i->pairs())
-            {
-                if (utility::string::starts_with(k.first, "_"))
-                {
-                    continue;
-                }
-
-                if (boost::iequals(j.first, k.first))
-                {
-                    log_debug(j.second << ":" << k.second);
-                    
-                    if (boost::iequals(j.second, k.second))
-                    {
-                        // ...
-                    }
-                    else
-                    {
-                        matches = false;
-                    }
-                    
-                    log_debug("matches = " << matches);
-                }
-                
-                if (!matches)
-                {
-                    break;
-                }
-            }
+            return ret;
         }
         
-        if (matches)
+        if (candidates == 0 || it->second.size() < candidates->size())
+        {
+            candidates = &it->second;
+        }
+    }
+    
+    /**
+     * A query without pairs matches every entry.
+     */
+    if (candidates == 0)
+    {
+        return m_entries;
+    }
+    
+    for (auto & i : *candidates)
+    {
+        if (matches(i, q.pairs()))
         {
             log_debug("Insert result = " << i->query_string());
             
@@ -273,32 +185,55 @@ void storage::tick(const boost::system::error_code & ec)
     {
         std::lock_guard<std::recursive_mutex> l(mutex_);
 
-        auto it = m_entries.begin();
+        auto now = std::time(0);
+        
+        /**
+         * Advance the timer wheel (at most one round) up to now.
+         */
+        if (now - m_timer_wheel_time > timer_wheel_slots)
+        {
+            m_timer_wheel_time = now - timer_wheel_slots;
+        }
         
-        while (it != m_entries.end())
+        while (m_timer_wheel_time < now)
         {
-            if (*it && (*it)->expired())
+            ++m_timer_wheel_time;
+            
+            auto & slot = m_timer_wheel[
+                m_timer_wheel_time % timer_wheel_slots
+            ];
+            
+            auto it = slot.begin();
+            
+            while (it != slot.end())
             {
-                log_debug("Entry " << (*it)->query_string() << " expired.");
-                
-                (*it)->stop();
+                auto e = it->second.lock();
                 
-                it = m_entries.erase(it);
-            }
-            else if (*it)
-            {
-                ++it;
-            }
-            else
-            {
-                it = m_entries.erase(it);
+                if (e == 0 || m_positions.count(e.get()) == 0)
+                {
+                    it = slot.erase(it);
+                }
+                else if (it->first <= now)
+                {
+                    log_debug("Entry " << e->query_string() << " expired.");
+                    
+                    e->set_expired(true);
+                    
+                    erase(e);
+                    
+                    it = slot.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
             }
         }
     
         /**
          * Start the expire timer.
          */
-        timer_.expires_from_now(std::chrono::seconds(5));
+        timer_.expires_from_now(std::chrono::seconds(1));
         timer_.async_wait(
             strand_.wrap(std::bind(&storage::tick, this,
             std::placeholders::_1))
@@ -311,6 +246,149 @@ const std::vector< std::shared_ptr<entry> > & storage::entries() const
     return m_entries;
 }
 
+void storage::insert(const std::shared_ptr<entry> & e)
+{
+    m_positions[e.get()] = m_entries.size();
+    
+    m_entries.push_back(e);
+    
+    m_index_queries[canonical_query(e->pairs())] = e;
+    
+    for (auto & i : e->pairs())
+    {
+        m_index_pairs[pair_key(i.first, i.second)].insert(e);
+    }
+    
+    /**
+     * Schedule the expiration.
+     */
+    auto expires = std::time(0) + e->expires();
+    
+    m_timer_wheel[expires % timer_wheel_slots].push_back(
+        std::make_pair(expires, e)
+    );
+}
+
+void storage::erase(const std::shared_ptr<entry> & e)
+{
+    auto it = m_positions.find(e.get());
+    
+    if (it != m_positions.end())
+    {
+        /**
+         * Move the last entry into the position being erased.
+         */
+        auto position = it->second;
+        
+        m_positions.erase(it);
+        
+        if (position + 1 < m_entries.size())
+        {
+            m_entries[position] = m_entries.back();
+            
+            m_positions[m_entries[position].get()] = position;
+        }
+        
+        m_entries.pop_back();
+        
+        auto it2 = m_index_queries.find(canonical_query(e->pairs()));
+        
+        if (it2 != m_index_queries.end() && it2->second == e)
+        {
+            m_index_queries.erase(it2);
+        }
+        
+        for (auto & i : e->pairs())
+        {
+            auto it3 = m_index_pairs.find(pair_key(i.first, i.second));
+            
+            if (it3 != m_index_pairs.end())
+            {
+                it3->second.erase(e);
+                
+                if (it3->second.size() == 0)
+                {
+                    m_index_pairs.erase(it3);
+                }
+            }
+        }
+    }
+}
+
+bool storage::matches(
+    const std::shared_ptr<entry> & e,
+    const std::map<std::string, std::string> & pairs
+    )
+{
+    for (auto & j : pairs)
+    {
+        if (utility::string::starts_with(j.first, "_"))
+        {
+            continue;
+        }
+        
+        /**
+         * Make sure the each key from the query is found in the entry, 
+         * otherwise it is a record mismatch.
+         */
+        bool found = false;
+        
+        for (auto & k : e->pairs())
+        {
+            if (boost::iequals(j.first, k.first))
+            {
+                found = true;
+                
+                /**
+                 * Every matching key must have a matching value.
+                 */
+                if (boost::iequals(j.second, k.second) == false)
+                {
+                    return false;
+                }
+            }
+        }
+        
+        if (found == false)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+std::string storage::canonical_query(
+    const std::map<std::string, std::string> & pairs
+    )
+{
+    std::string ret;
+    
+    for (auto & i : pairs)
+    {
+        if (utility::string::starts_with(i.first, "_"))
+        {
+            continue;
+        }
+        
+        if (ret.size() > 0)
+        {
+            ret += "&";
+        }
+        
+        ret += i.first + "=" + i.second;
+    }
+    
+    return boost::to_lower_copy(ret);
+}
+
+std::string storage::pair_key(
+    const std::string & key, const std::string & value
+    )
+{
+    return boost::to_lower_copy(key + "=" + value);
+}
+
 int storage::run_test()
 {
     std::vector<std::string> pairs1;
@@ -340,6 +418,22 @@ int storage::run_test()
         std::cerr << i.first << std::endl;
         std::cerr << i.second << std::endl;
     }
+    
+    boost::asio::io_service ios;
+    
+    auto s = std::make_shared<storage> (ios);
+    
+    s->store(std::make_shared<entry> (ios, s, "username=john&age=36&_l=60"));
+    s->store(std::make_shared<entry> (ios, s, "username=jane&age=36&_l=60"));
+    s->store(std::make_shared<entry> (ios, s, "USERNAME=John&Age=36&_l=60"));
+    
+    assert(s->entries().size() == 2);
+    assert(s->find("age=36").size() == 2);
+    assert(s->find("username=JOHN").size() == 1);
+    assert(s->find("username=john&age=35").size() == 0);
+    assert(s->find("city=paris").size() == 0);
+    
+    s->stop();
 
     return 0;
 }
@@ -74,11 +74,11 @@ bool udp_handler::on_async_receive_from(
                 message msg(buf, len);
                 
                 /**
-                 * Get the shared secret.
+                 * Get the cipher of the shared secret.
                  */
-                auto shared_secret = n->get_key_pool()->find(ep);
+                auto cipher = n->get_key_pool()->find_cipher(ep);
 
-                if (shared_secret.size() > 0 && msg.decrypt(shared_secret))
+                if (cipher && msg.decrypt(*cipher))
                 {
                     on_data(ep, msg.data(), msg.size());
                 }
@@ -224,9 +224,9 @@ void udp_handler::send_message(
                     if (auto n = node_impl_.lock())
                     {
                         /**
-                         * Get the shared secret.
+                         * Get the cipher of the shared secret.
                          */
-                        auto shared_secret = n->get_key_pool()->find(ep);
+                        auto cipher = n->get_key_pool()->find_cipher(ep);
                         
                         /**
                          * If we do not have a shared secret then send a
@@ -236,8 +236,7 @@ void udp_handler::send_message(
                          * will respond with a protocol::message_code_ping.
                          */
                         if (
-                            shared_secret.size() > 0 &&
-                            msg->encrypt(shared_secret)
+                            cipher && msg->encrypt(*cipher)
                             )
                         {
 #if 1 // Test to see what size certain packets are.
@@ -16,6 +16,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
@@ -30,13 +32,31 @@ udp_multiplexor::udp_multiplexor(boost::asio::io_service & ios)
     , m_bps_sent(0)
     , m_bytes_received(0)
     , m_bps_received(0)
+    , m_packets_sent(0)
+    , m_pps_sent(0)
+    , m_packets_received(0)
+    , m_pps_received(0)
     , strand_(ios)
     , socket_ipv4_(ios)
     , socket_ipv6_(ios)
     , send_time_(std::time(0))
     , receive_time_(std::time(0))
+#if (defined USE_MMSG && USE_MMSG)
+    , receive_buffers_(batch_length * max_length)
+    , send_scheduled_ipv4_(false)
+    , send_scheduled_ipv6_(false)
+#endif // USE_MMSG
 {
-    // ...
+#if (defined USE_MMSG && USE_MMSG)
+    /**
+     * Point each recvmmsg header at its buffer in the pool.
+     */
+    for (auto i = 0; i < batch_length; i++)
+    {
+        receive_iovecs_[i].iov_base = &receive_buffers_[i * max_length];
+        receive_iovecs_[i].iov_len = max_length;
+    }
+#endif // USE_MMSG
 }
 
 void udp_multiplexor::open(const std::uint16_t & port)
@@ -88,13 +108,9 @@ void udp_multiplexor::open(const std::uint16_t & port)
     socket_ipv4_.bind(ipv4_endpoint);
     
     /**
-     * Start an asynchronous receive from on the ipv4 socket.
+     * Start an asynchronous receive on the ipv4 socket.
      */
-    socket_ipv4_.async_receive_from(
-        boost::asio::buffer(receive_buffer_), remote_endpoint_, strand_.wrap(
-        std::bind(&udp_multiplexor::handle_async_receive_from,
-        shared_from_this(), std::placeholders::_1, std::placeholders::_2))
-    );
+    do_async_receive(socket_ipv4_);
     
     /**
      * Allocate the ipv6 endpoint.
@@ -136,13 +152,9 @@ void udp_multiplexor::open(const std::uint16_t & port)
     socket_ipv6_.bind(ipv6_endpoint);
     
     /**
-     * Start an asynchronous receive from on the ipv6 socket.
+     * Start an asynchronous receive on the ipv6 socket.
      */
-    socket_ipv6_.async_receive_from(
-        boost::asio::buffer(receive_buffer_), remote_endpoint_, strand_.wrap(
-        std::bind(&udp_multiplexor::handle_async_receive_from,
-        shared_from_this(), std::placeholders::_1, std::placeholders::_2))
-    );
+    do_async_receive(socket_ipv6_);
     
     /**
      * Set the local endpoint.
@@ -182,6 +194,16 @@ void udp_multiplexor::close()
     {
         socket_ipv6_.close();
     }
+    
+#if (defined USE_MMSG && USE_MMSG)
+    std::lock_guard<std::mutex> l1(mutex_send_queue_);
+    
+    /**
+     * Drop the queued datagrams.
+     */
+    send_queue_ipv4_.clear();
+    send_queue_ipv6_.clear();
+#endif // USE_MMSG
 }
 
 void udp_multiplexor::send_to(
@@ -196,25 +218,47 @@ void udp_multiplexor::send_to(
      */
     if (len < 65535)
     {
-        m_bytes_sent += len;
-
-        auto uptime = std::time(0) - send_time_;
+#if (defined USE_MMSG && USE_MMSG)
+        auto ipv4 = ep.protocol() == boost::asio::ip::udp::v4();
         
-        if (uptime > 0)
-        {
-            m_bps_sent = m_bytes_sent / uptime;
+        auto & s = ipv4 ? socket_ipv4_ : socket_ipv6_;
         
-            log_none("m_bps_sent = " << m_bps_sent);
+        if (s.is_open())
+        {
+            std::lock_guard<std::mutex> l1(mutex_send_queue_);
+            
+            auto & queue = ipv4 ? send_queue_ipv4_ : send_queue_ipv6_;
             
-            if (uptime > 1)
+            auto & scheduled =
+                ipv4 ? send_scheduled_ipv4_ : send_scheduled_ipv6_
+            ;
+            
+            if (queue.size() >= max_send_queue_length)
             {
-                send_time_ = std::time(0);
+                log_debug("UDP send queue is full, dropping datagram.");
                 
-                uptime = std::time(0) - send_time_;
+                return;
+            }
+            
+            /**
+             * Queue the datagram, everything queued before the batch runs
+             * is flushed with as few sendmmsg calls as possible.
+             */
+            queue.push_back(
+                std::make_pair(ep, std::vector<char> (buf, buf + len))
+            );
+            
+            if (scheduled == false)
+            {
+                scheduled = true;
                 
-                m_bytes_sent = 0;
+                strand_.post(std::bind(
+                    &udp_multiplexor::do_send_batch, shared_from_this(), &s)
+                );
             }
         }
+#else
+        update_sent(len, 1);
         
         if (ep.protocol() == boost::asio::ip::udp::v4())
         {
@@ -286,6 +330,7 @@ void udp_multiplexor::send_to(
                 }
             }
         }
+#endif // USE_MMSG
     }
 }
 
@@ -322,17 +367,55 @@ const std::size_t & udp_multiplexor::bps_received() const
     return m_bps_received;
 }
 
-void udp_multiplexor::handle_async_receive_from(
-    const boost::system::error_code & ec, const std::size_t & len
+const std::size_t & udp_multiplexor::pps_sent() const
+{
+    return m_pps_sent;
+}
+
+const std::size_t & udp_multiplexor::pps_received() const
+{
+    return m_pps_received;
+}
+
+void udp_multiplexor::update_sent(
+    const std::size_t & bytes, const std::size_t & packets
     )
 {
-    m_bytes_received += len;
+    m_bytes_sent += bytes;
+    m_packets_sent += packets;
+    
+    auto uptime = std::time(0) - send_time_;
+    
+    if (uptime > 0)
+    {
+        m_bps_sent = m_bytes_sent / uptime;
+        m_pps_sent = m_packets_sent / uptime;
+    
+        log_none("m_bps_sent = " << m_bps_sent);
+        
+        if (uptime > 1)
+        {
+            send_time_ = std::time(0);
+            
+            m_bytes_sent = 0;
+            m_packets_sent = 0;
+        }
+    }
+}
 
+void udp_multiplexor::update_received(
+    const std::size_t & bytes, const std::size_t & packets
+    )
+{
+    m_bytes_received += bytes;
+    m_packets_received += packets;
+    
     auto uptime = std::time(0) - receive_time_;
     
     if (uptime > 0)
     {
         m_bps_received = m_bytes_received / uptime;
+        m_pps_received = m_packets_received / uptime;
     
         log_none("m_bps_received = " << m_bps_received);
         
@@ -340,11 +423,36 @@ void udp_multiplexor::handle_async_receive_from(
         {
             receive_time_ = std::time(0);
             
-            uptime = std::time(0) - receive_time_;
-            
             m_bytes_received = 0;
+            m_packets_received = 0;
         }
     }
+}
+
+void udp_multiplexor::do_async_receive(boost::asio::ip::udp::socket & s)
+{
+#if (defined USE_MMSG && USE_MMSG)
+    /**
+     * Wait for the socket to become readable and then drain it in batches.
+     */
+    s.async_receive(boost::asio::null_buffers(), strand_.wrap(
+        std::bind(&udp_multiplexor::handle_async_receive_batch,
+        shared_from_this(), std::placeholders::_1, &s))
+    );
+#else
+    s.async_receive_from(
+        boost::asio::buffer(receive_buffer_), remote_endpoint_, strand_.wrap(
+        std::bind(&udp_multiplexor::handle_async_receive_from,
+        shared_from_this(), std::placeholders::_1, std::placeholders::_2))
+    );
+#endif // USE_MMSG
+}
+
+void udp_multiplexor::handle_async_receive_from(
+    const boost::system::error_code & ec, const std::size_t & len
+    )
+{
+    update_received(len, ec ? 0 : 1);
 
     if (ec == boost::asio::error::operation_aborted)
     {
@@ -367,27 +475,16 @@ void udp_multiplexor::handle_async_receive_from(
         if (remote_endpoint_.protocol() == boost::asio::ip::udp::v4())
         {
             /**
-             * Start an asynchronous receive from on the ipv4 socket.
+             * Start an asynchronous receive on the ipv4 socket.
              */
-            socket_ipv4_.async_receive_from(
-                boost::asio::buffer(receive_buffer_), remote_endpoint_,
-                strand_.wrap(std::bind(
-                &udp_multiplexor::handle_async_receive_from,
-                shared_from_this(), std::placeholders::_1,
-                std::placeholders::_2))
-            );
+            do_async_receive(socket_ipv4_);
         }
         else
         {
             /**
-             * Start an asynchronous receive from on the ipv6 socket.
+             * Start an asynchronous receive on the ipv6 socket.
              */
-            socket_ipv6_.async_receive_from(
-                boost::asio::buffer(receive_buffer_), remote_endpoint_,
-                strand_.wrap(std::bind(
-                &udp_multiplexor::handle_async_receive_from, shared_from_this(),
-                std::placeholders::_1, std::placeholders::_2))
-            );
+            do_async_receive(socket_ipv6_);
         }
 #endif // __IPHONE_OS_VERSION_MAX_ALLOWED
     }
@@ -408,26 +505,259 @@ void udp_multiplexor::handle_async_receive_from(
         if (remote_endpoint_.protocol() == boost::asio::ip::udp::v4())
         {
             /**
-             * Start an asynchronous receive from on the ipv4 socket.
+             * Start an asynchronous receive on the ipv4 socket.
              */
-            socket_ipv4_.async_receive_from(
-                boost::asio::buffer(receive_buffer_), remote_endpoint_,
-                strand_.wrap(std::bind(
-                &udp_multiplexor::handle_async_receive_from, shared_from_this(),
-                std::placeholders::_1, std::placeholders::_2))
-            );
+            do_async_receive(socket_ipv4_);
         }
         else
         {
             /**
-             * Start an asynchronous receive from on the ipv6 socket.
+             * Start an asynchronous receive on the ipv6 socket.
+             */
+            do_async_receive(socket_ipv6_);
+        }
+    }
+}
+
+#if (defined USE_MMSG && USE_MMSG)
+void udp_multiplexor::handle_async_receive_batch(
+    const boost::system::error_code & ec, boost::asio::ip::udp::socket * s
+    )
+{
+    if (ec == boost::asio::error::operation_aborted)
+    {
+        return;
+    }
+    else if (ec == boost::asio::error::bad_descriptor)
+    {
+        return;
+    }
+    else if (ec)
+    {
+        log_debug("UDP receive failed, message = " << ec.message() << ".");
+    }
+    else
+    {
+        /**
+         * Drain at most four batches before yielding to the other socket.
+         */
+        for (auto batches = 0; batches < 4 && s->is_open(); batches++)
+        {
+            for (auto i = 0; i < batch_length; i++)
+            {
+                std::memset(&receive_headers_[i], 0, sizeof(struct mmsghdr));
+                
+                receive_headers_[i].msg_hdr.msg_iov = &receive_iovecs_[i];
+                receive_headers_[i].msg_hdr.msg_iovlen = 1;
+                receive_headers_[i].msg_hdr.msg_name = &receive_addresses_[i];
+                receive_headers_[i].msg_hdr.msg_namelen =
+                    sizeof(struct sockaddr_storage)
+                ;
+            }
+            
+            auto count = recvmmsg(
+                s->native_handle(), receive_headers_, batch_length,
+                MSG_DONTWAIT, 0
+            );
+            
+            if (count < 0)
+            {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                {
+                    log_debug(
+                        "UDP recvmmsg failed, message = " <<
+                        std::strerror(errno) << "."
+                    );
+                }
+                
+                break;
+            }
+            
+            std::size_t bytes = 0;
+            
+            for (auto i = 0; i < count; i++)
+            {
+                auto len = static_cast<std::size_t> (
+                    receive_headers_[i].msg_len
+                );
+                
+                bytes += len;
+                
+                /**
+                 * Drop truncated datagrams, like the per-datagram path we
+                 * should never receive a message larger than 65535.
+                 */
+                if (receive_headers_[i].msg_hdr.msg_flags & MSG_TRUNC)
+                {
+                    continue;
+                }
+                
+                boost::asio::ip::udp::endpoint ep;
+                
+                auto namelen = receive_headers_[i].msg_hdr.msg_namelen;
+                
+                if (namelen > ep.capacity())
+                {
+                    continue;
+                }
+                
+                std::memcpy(ep.data(), &receive_addresses_[i], namelen);
+                
+                ep.resize(namelen);
+                
+                if (m_on_async_receive_from && (len > 0 && len < 65535))
+                {
+                    m_on_async_receive_from(
+                        ep, &receive_buffers_[i * max_length], len
+                    );
+                }
+            }
+            
+            update_received(bytes, count);
+            
+            /**
+             * A short batch means the socket has been drained.
              */
-            socket_ipv6_.async_receive_from(
-                boost::asio::buffer(receive_buffer_), remote_endpoint_,
-                strand_.wrap(std::bind(
-                &udp_multiplexor::handle_async_receive_from, shared_from_this(),
-                std::placeholders::_1, std::placeholders::_2))
+            if (count < batch_length)
+            {
+                break;
+            }
+        }
+    }
+    
+    if (s->is_open())
+    {
+        /**
+         * Start an asynchronous receive on the socket.
+         */
+        do_async_receive(*s);
+    }
+}
+
+void udp_multiplexor::do_send_batch(boost::asio::ip::udp::socket * s)
+{
+    auto ipv4 = s == &socket_ipv4_;
+    
+    auto & queue = ipv4 ? send_queue_ipv4_ : send_queue_ipv6_;
+    
+    auto & scheduled = ipv4 ? send_scheduled_ipv4_ : send_scheduled_ipv6_;
+    
+    /**
+     * Take up to batch_length datagrams from the queue.
+     */
+    send_queue_t batch;
+    
+    {
+        std::lock_guard<std::mutex> l1(mutex_send_queue_);
+        
+        if (s->is_open() == false)
+        {
+            queue.clear();
+        }
+        
+        while (queue.size() > 0 && batch.size() < batch_length)
+        {
+            batch.push_back(std::move(queue.front()));
+            
+            queue.pop_front();
+        }
+        
+        if (batch.size() == 0)
+        {
+            scheduled = false;
+            
+            return;
+        }
+    }
+    
+    struct mmsghdr headers[batch_length];
+    struct iovec iovecs[batch_length];
+    
+    std::memset(headers, 0, sizeof(headers));
+    
+    for (auto i = 0; i < batch.size(); i++)
+    {
+        iovecs[i].iov_base = batch[i].second.data();
+        iovecs[i].iov_len = batch[i].second.size();
+        
+        headers[i].msg_hdr.msg_iov = &iovecs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+        headers[i].msg_hdr.msg_name = batch[i].first.data();
+        headers[i].msg_hdr.msg_namelen = batch[i].first.size();
+    }
+    
+    std::size_t offset = 0;
+    
+    while (offset < batch.size())
+    {
+        auto count = sendmmsg(
+            s->native_handle(), &headers[offset], batch.size() - offset,
+            MSG_DONTWAIT
+        );
+        
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                std::lock_guard<std::mutex> l1(mutex_send_queue_);
+                
+                /**
+                 * Put the unsent datagrams back in order.
+                 */
+                for (auto i = batch.size(); i > offset; i--)
+                {
+                    queue.push_front(std::move(batch[i - 1]));
+                }
+                
+                /**
+                 * Resume when the socket becomes writable.
+                 */
+                auto self(shared_from_this());
+                
+                s->async_send(boost::asio::null_buffers(), strand_.wrap(
+                    [this, self, s](const boost::system::error_code & ec,
+                    const std::size_t &)
+                {
+                    do_send_batch(s);
+                }));
+                
+                return;
+            }
+            
+            log_debug(
+                "UDP v" << (ipv4 ? 4 : 6) << " sendmmsg failed " <<
+                std::strerror(errno) << "."
             );
+            
+            /**
+             * Drop the datagram that failed and continue with the rest.
+             */
+            offset++;
+        }
+        else
+        {
+            std::size_t bytes = 0;
+            
+            for (auto i = offset; i < offset + count; i++)
+            {
+                bytes += headers[i].msg_len;
+            }
+            
+            update_sent(bytes, count);
+            
+            offset += count;
         }
     }
+    
+    /**
+     * Post the next batch (if any) so receives are not starved.
+     */
+    strand_.post(
+        std::bind(&udp_multiplexor::do_send_batch, shared_from_this(), s)
+    );
 }
+#endif // USE_MMSG
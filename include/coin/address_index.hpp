@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_ADDRESS_INDEX_HPP
+#define COIN_ADDRESS_INDEX_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <coin/data_buffer.hpp>
+#include <coin/point_out.hpp>
+#include <coin/sha256.hpp>
+
+namespace coin {
+
+    class block;
+    class block_undo;
+    class db_tx;
+    class script;
+    class transaction;
+
+    /**
+     * Implements an (optional) address index database record. Every output
+     * and every spending input is recorded under the hash of the
+     * script_public_key it pays to ordered by height so that the
+     * transactions touching an address can be paged by height range. The
+     * unspent outputs of each script are kept in a separate set of records.
+     */
+    class address_index : public data_buffer
+    {
+        public:
+
+            /**
+             * The entry types.
+             */
+            typedef enum type_s
+            {
+                type_output,
+                type_input,
+            } type_t;
+
+            /**
+             * An entry as returned by a query.
+             */
+            typedef struct
+            {
+                std::int32_t height;
+                sha256 hash_tx;
+                std::uint32_t n;
+                type_t type;
+                std::int64_t value;
+                point_out link;
+                std::int32_t link_height;
+            } entry_t;
+
+            /**
+             * An unspent output as returned by a query.
+             */
+            typedef struct
+            {
+                std::int32_t height;
+                sha256 hash_tx;
+                std::uint32_t n;
+                std::int64_t value;
+            } unspent_t;
+
+            /**
+             * Constructor
+             */
+            address_index();
+
+            /**
+             * Constructor
+             * @param value The value.
+             * @param height The height.
+             */
+            address_index(
+                const std::int64_t & value, const std::int32_t & height
+            );
+
+            /**
+             * Encodes
+             */
+            void encode();
+
+            /**
+             * Encodes
+             * @param buffer The data_buffer.
+             */
+            void encode(data_buffer & buffer);
+
+            /**
+             * Decodes
+             */
+            void decode();
+
+            /**
+             * Decodes
+             * @param buffer The data_buffer.
+             */
+            void decode(data_buffer & buffer);
+
+            /**
+             * Sets null.
+             */
+            void set_null();
+
+            /**
+             * The value (negative for inputs).
+             */
+            const std::int64_t & value() const;
+
+            /**
+             * The height of the block containing the transaction.
+             */
+            const std::int32_t & height() const;
+
+            /**
+             * Sets the link.
+             * @param val The point_out.
+             * @param height The height of the linked transaction.
+             */
+            void set_link(const point_out & val, const std::int32_t & height);
+
+            /**
+             * For an output the input that spends it (null while unspent),
+             * for an input the previous output it spends.
+             */
+            const point_out & link() const;
+
+            /**
+             * The height of the linked transaction (-1 if unknown).
+             */
+            const std::int32_t & link_height() const;
+
+            /**
+             * Gets the hash used to index a script_public_key.
+             * @param script_public_key The script.
+             */
+            static sha256 get_script_hash(const script & script_public_key);
+
+            /**
+             * Indexes the transactions of a block being connected.
+             * @param tx_db The db_tx.
+             * @param blk The block.
+             * @param undo The block_undo holding the spent outputs.
+             * @param height The height of the block.
+             */
+            static bool connect_block(
+                db_tx & tx_db, block & blk, const block_undo & undo,
+                const std::int32_t & height
+            );
+
+            /**
+             * Removes the entries of a block being disconnected.
+             * @param tx_db The db_tx.
+             * @param blk The block.
+             * @param undo The block_undo (if any) holding the spent outputs.
+             * @param height The height of the block.
+             */
+            static bool disconnect_block(
+                db_tx & tx_db, block & blk, const block_undo * undo,
+                const std::int32_t & height
+            );
+
+            /**
+             * Gets the entries of a script within a height range.
+             * @param tx_db The db_tx.
+             * @param script_hash The script hash.
+             * @param height_start The first height.
+             * @param height_end The last height.
+             * @param entries The entries (out).
+             */
+            static bool get_entries(
+                db_tx & tx_db, const sha256 & script_hash,
+                const std::int32_t & height_start,
+                const std::int32_t & height_end,
+                std::vector<entry_t> & entries
+            );
+
+            /**
+             * Gets the unspent outputs of a script within a height range.
+             * @param tx_db The db_tx.
+             * @param script_hash The script hash.
+             * @param height_start The first height.
+             * @param height_end The last height.
+             * @param unspent The unspent outputs (out).
+             */
+            static bool get_unspent(
+                db_tx & tx_db, const sha256 & script_hash,
+                const std::int32_t & height_start,
+                const std::int32_t & height_end,
+                std::vector<unspent_t> & unspent
+            );
+
+        private:
+
+            /**
+             * Creates the key of an entry.
+             * @param script_hash The script hash.
+             * @param height The height.
+             * @param hash_tx The transaction hash.
+             * @param n The output or input index.
+             * @param type The type_t.
+             */
+            static data_buffer create_key(
+                const sha256 & script_hash, const std::int32_t & height,
+                const sha256 & hash_tx, const std::uint32_t & n,
+                const type_t & type
+            );
+
+            /**
+             * Creates the key of an unspent output.
+             * @param script_hash The script hash.
+             * @param hash_tx The transaction hash.
+             * @param n The output index.
+             */
+            static data_buffer create_key_unspent(
+                const sha256 & script_hash, const sha256 & hash_tx,
+                const std::uint32_t & n
+            );
+
+            /**
+             * Writes a key prefix followed by the script hash.
+             * @param buffer The data_buffer.
+             * @param prefix The prefix.
+             * @param script_hash The script hash.
+             */
+            static void write_key_prefix(
+                data_buffer & buffer, const std::string & prefix,
+                const sha256 & script_hash
+            );
+
+            /**
+             * The value.
+             */
+            std::int64_t m_value;
+
+            /**
+             * The height.
+             */
+            std::int32_t m_height;
+
+            /**
+             * The link.
+             */
+            point_out m_link;
+
+            /**
+             * The link height.
+             */
+            std::int32_t m_link_height;
+
+        protected:
+
+            // ...
+    };
+
+} // namespace coin
+
+#endif // COIN_ADDRESS_INDEX_HPP
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_BENCHMARK_HPP
+#define COIN_BENCHMARK_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace coin {
+
+    /**
+     * Implements repeatable micro and macro benchmarks of the chain
+     * processing hot paths. Results are emitted as one JSON object per
+     * line so they can be collected and compared across releases.
+     */
+    class benchmark
+    {
+        public:
+        
+            /**
+             * A benchmark result.
+             */
+            typedef struct
+            {
+                std::string name;
+                std::uint64_t iterations;
+                double seconds;
+                std::uint64_t bytes_per_iteration;
+                std::uint64_t allocations;
+            } result_t;
+        
+            /**
+             * Constructor
+             * @param filter Only benchmarks whose name contains the filter
+             * are run.
+             * @param min_seconds The minimum duration of each benchmark.
+             * @param chain_blocks The number of regtest blocks generated by
+             * the chain macro benchmark (zero disables it).
+             */
+            explicit benchmark(
+                const std::string & filter = std::string(),
+                const double & min_seconds = 1.0,
+                const std::uint32_t & chain_blocks = 200
+            );
+        
+            /**
+             * Runs all (matching) benchmarks writing each result to
+             * stdout as it completes.
+             */
+            std::vector<result_t> run();
+        
+            /**
+             * The JSON representation of a result.
+             * @param result The result_t.
+             */
+            static std::string to_json(const result_t & result);
+        
+        private:
+        
+            /**
+             * Runs f in doubling batches until the minimum duration has
+             * elapsed.
+             * @param name The name.
+             * @param bytes_per_iteration The bytes processed per iteration.
+             * @param f The function.
+             */
+            void measure(
+                const std::string & name,
+                const std::uint64_t & bytes_per_iteration,
+                const std::function<void ()> & f
+            );
+        
+            /**
+             * Runs f exactly once for each index in [0, iterations), used
+             * for operations whose first run differs from repeated runs.
+             * @param name The name.
+             * @param iterations The number of iterations.
+             * @param f The function.
+             */
+            void measure_once(
+                const std::string & name, const std::uint64_t & iterations,
+                const std::function<void (const std::uint64_t &)> & f
+            );
+        
+            /**
+             * If true the named benchmark matches the filter.
+             * @param name The name.
+             */
+            bool is_selected(const std::string & name) const;
+        
+            /**
+             * Records and prints a result.
+             * @param result The result_t.
+             */
+            void report(const result_t & result);
+        
+            /**
+             * The benchmarks.
+             */
+            void bench_hash();
+            void bench_data_buffer();
+            void bench_transaction();
+            void bench_block();
+            void bench_key();
+            void bench_script();
+            void bench_signature_cache();
+            void bench_chain();
+        
+            /**
+             * The filter.
+             */
+            std::string m_filter;
+        
+            /**
+             * The minimum duration of each benchmark.
+             */
+            double m_min_seconds;
+        
+            /**
+             * The number of blocks generated by the chain benchmark.
+             */
+            std::uint32_t m_chain_blocks;
+        
+            /**
+             * The results.
+             */
+            std::vector<result_t> m_results;
+        
+        protected:
+        
+            // ...
+    };
+    
+} // namespace coin
+
+#endif // COIN_BENCHMARK_HPP
@@ -123,7 +123,8 @@ namespace coin {
             sha256 get_hash() const;
     
             /**
-             * Get the sha256 (genesis) hash.
+             * Get the sha256 (genesis) hash (of the regression test chain
+             * when operating on one).
              */
             static sha256 get_hash_genesis();
         
@@ -132,6 +133,11 @@ namespace coin {
              */
             static sha256 get_hash_genesis_test_net();
         
+            /**
+             * Get the sha256 (genesis) hash for the regression test chain.
+             */
+            static sha256 get_hash_genesis_regtest();
+        
             /**
              * The block header.
              */
@@ -238,6 +244,16 @@ namespace coin {
                 const bool & check_merkle_root = true
             );
         
+            /**
+             * Performs the expensive context-free checks of check_block
+             * (transaction checks, duplicate transactions, sig-op counting,
+             * merkle root and, after the last checkpoint, block signature)
+             * so they can run on a worker thread ahead of process_block. On
+             * success check_block skips them, on failure check_block repeats
+             * them to report the error and Denial-of-Service score.
+             */
+            bool precheck();
+        
             /**
              * Accepts a block into the main chain.
              * @param connection_manager The tcp_connection_manager used for
@@ -269,6 +285,19 @@ namespace coin {
                 const std::uint32_t & block_position,
                 const bool & read_transactions = true
             );
+        
+            /**
+             * Reads the (encoded) bytes of a block from disk without
+             * decoding them.
+             * @param index The block_index.
+             * @param buffer The buffer (out).
+             * @param offset The offset into the buffer to read to, the bytes
+             * before it are left for the caller (e.g. a message header).
+             */
+            static bool read_raw_from_disk(
+                const block_index * index, std::vector<char> & buffer,
+                const std::size_t & offset = 0
+            );
 
             /**
              * Writes to disk.
@@ -412,6 +441,22 @@ namespace coin {
              */
             mutable std::vector<sha256> m_merkle_tree;
         
+            /**
+             * The hash of the block when it passed precheck.
+             */
+            sha256 m_hash_prechecked;
+        
+            /**
+             * The number of (legacy) sig-ops counted by precheck.
+             */
+            std::size_t m_sig_ops_prechecked;
+        
+            /**
+             * If true precheck verified the block signature (it is skipped
+             * before the last blockchain checkpoint).
+             */
+            bool m_is_signature_prechecked;
+        
         protected:
 
             /**
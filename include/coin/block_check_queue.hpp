@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_BLOCK_CHECK_QUEUE_HPP
+#define COIN_BLOCK_CHECK_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace coin {
+
+    class block;
+    
+    /**
+     * Implements a block_check_queue singleton that performs the
+     * context-free checks (block::precheck) of incoming and imported blocks
+     * on worker threads so that only the contextual checks and the state
+     * mutation remain serialized on the strand.
+     */
+    class block_check_queue
+    {
+        public:
+        
+            /**
+             * Constructor
+             */
+            block_check_queue();
+        
+            /**
+             * The singleton accessor.
+             */
+            static block_check_queue & instance();
+        
+            /**
+             * Starts
+             */
+            void start();
+        
+            /**
+             * Stops
+             */
+            void stop();
+        
+            /**
+             * Inserts a block into the queue, once it (and every block
+             * inserted before it) has been checked the function is posted
+             * onto the strand. If the queue is not started the function is
+             * dispatched onto the strand immediately.
+             * @param blk The block.
+             * @param f The function.
+             */
+            void insert(
+                const std::shared_ptr<block> & blk,
+                const std::function<void ()> & f
+            );
+        
+            /**
+             * Checks the blocks on the worker threads and waits for them
+             * to complete.
+             * @param blocks The blocks.
+             */
+            void check(const std::vector< std::shared_ptr<block> > & blocks);
+        
+        private:
+        
+            /**
+             * A job.
+             */
+            typedef struct
+            {
+                std::shared_ptr<block> blk;
+                std::function<void ()> f;
+                bool is_done;
+            } job_t;
+        
+            /**
+             * The main loop.
+             */
+            void loop();
+        
+            /**
+             * Posts the functions of the completed jobs at the front of
+             * jobs_ onto the strand.
+             * @note The mutex_ must be locked.
+             */
+            void drain();
+        
+        protected:
+        
+            /**
+             * The state.
+             */
+            enum
+            {
+                state_stopped,
+                state_starting,
+                state_started,
+                state_stopping
+            } state_;
+        
+            /**
+             * The std::thread's.
+             */
+            std::vector< std::shared_ptr<std::thread> > threads_;
+        
+            /**
+             * The std::mutex.
+             */
+            std::mutex mutex_;
+        
+            /**
+             * Blocks worker threads when no work is available.
+             */
+            std::condition_variable condition_variable_worker_;
+        
+            /**
+             * Blocks check until its jobs are done.
+             */
+            std::condition_variable condition_variable_done_;
+        
+            /**
+             * The jobs waiting to be checked.
+             */
+            std::deque< std::shared_ptr<job_t> > queue_;
+        
+            /**
+             * The jobs (with a function) in insertion order.
+             */
+            std::deque< std::shared_ptr<job_t> > jobs_;
+    };
+    
+} // namespace coin
+
+#endif // COIN_BLOCK_CHECK_QUEUE_HPP
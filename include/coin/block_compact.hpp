@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_BLOCK_COMPACT_HPP
+#define COIN_BLOCK_COMPACT_HPP
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <coin/block.hpp>
+#include <coin/data_buffer.hpp>
+#include <coin/sha256.hpp>
+#include <coin/transaction.hpp>
+
+namespace coin {
+
+    /**
+     * Implements a compact block. A compact block carries the block header,
+     * signature and a short (48-bit) identifier of each transaction. The
+     * coinbase (and coinstake) are prefilled, the receiver reconstructs the
+     * remaining transactions from its transaction_pool and requests any
+     * that are missing with getblocktxn.
+     */
+    class block_compact
+    {
+        public:
+        
+            /**
+             * The length of a short transaction identifier.
+             */
+            enum { short_id_length = 6 };
+        
+            /**
+             * Constructor
+             */
+            block_compact();
+        
+            /**
+             * Constructor
+             * @param blk The block.
+             */
+            block_compact(block & blk);
+        
+            /**
+             * Encodes
+             * @param buffer The data_buffer.
+             */
+            void encode(data_buffer & buffer);
+        
+            /**
+             * Decodes
+             * @param buffer The data_buffer.
+             */
+            bool decode(data_buffer & buffer);
+        
+            /**
+             * The block header.
+             */
+            const block::header_t & block_header() const;
+        
+            /**
+             * The hash of the block header.
+             */
+            const sha256 & get_hash() const;
+        
+            /**
+             * The number of transactions in the block.
+             */
+            std::size_t transaction_count() const;
+        
+            /**
+             * Calculates the short identifier of a transaction.
+             * @param hash_tx The hash of the transaction.
+             */
+            std::uint64_t get_short_id(const sha256 & hash_tx) const;
+        
+            /**
+             * Reconstructs the transactions of the block from the prefilled
+             * transactions and the transaction_pool. Transactions that are
+             * not found or whose short identifiers collide are left in
+             * indexes_missing.
+             * @return False if the short identifiers of the block are not
+             * unique.
+             */
+            bool reconstruct();
+        
+            /**
+             * The indexes of the transactions that could not be
+             * reconstructed.
+             */
+            const std::vector<std::uint32_t> & indexes_missing() const;
+        
+            /**
+             * Fills in the missing transactions (as received in blocktxn).
+             * @param transactions The transactions in the order of
+             * indexes_missing.
+             */
+            bool fill_missing(
+                const std::vector< std::shared_ptr<transaction> > &
+                transactions
+            );
+        
+            /**
+             * Creates the block once all of its transactions are known.
+             * @param blk The block (out).
+             * @return False if the transactions do not match the merkle root.
+             */
+            bool create_block(block & blk);
+        
+            /**
+             * Runs test case.
+             */
+            static int run_test();
+        
+        private:
+        
+            /**
+             * Reconstructs the transactions of the block from the prefilled
+             * transactions and the given transactions.
+             * @param transactions The (hash, transaction) pairs.
+             */
+            template<typename T>
+            bool reconstruct(const T & transactions);
+        
+            /**
+             * Calculates the key used for the short identifiers.
+             */
+            void calculate_key();
+        
+            /**
+             * The block header.
+             */
+            block::header_t m_block_header;
+        
+            /**
+             * The block signature.
+             */
+            std::vector<std::uint8_t> m_signature;
+        
+            /**
+             * The nonce used for the short identifiers.
+             */
+            std::uint64_t m_nonce;
+        
+            /**
+             * The short identifiers of the transactions that are not
+             * prefilled.
+             */
+            std::vector<std::uint64_t> m_short_ids;
+        
+            /**
+             * The prefilled transactions and their indexes in the block.
+             */
+            std::vector<
+                std::pair<std::uint32_t, transaction>
+            > m_transactions_prefilled;
+        
+            /**
+             * The hash of the block header.
+             */
+            sha256 m_hash;
+        
+            /**
+             * The key used for the short identifiers.
+             */
+            sha256 m_key;
+        
+            /**
+             * The (reconstructed) transactions of the block.
+             */
+            std::vector<transaction> m_transactions;
+        
+            /**
+             * The indexes of the transactions that could not be
+             * reconstructed.
+             */
+            std::vector<std::uint32_t> m_indexes_missing;
+        
+        protected:
+        
+            // ...
+    };
+
+} // namespace coin
+
+#endif // COIN_BLOCK_COMPACT_HPP
@@ -23,7 +23,8 @@
 
 #include <cstdint>
 
-#include <coin/big_number.hpp>
+#include <coin/sha256.hpp>
+#include <coin/uint256.hpp>
 #include <coin/point_out.hpp>
 #include <coin/sha256.hpp>
 
@@ -126,12 +127,12 @@ namespace coin {
              * Sets the trust score of the chain (ppcoin).
              * @param val The value.
              */
-            void set_chain_trust(const big_number & val);
+            void set_chain_trust(const uint256 & val);
         
             /**
              * The trust score of the chain (ppcoin).
              */
-            const big_number & chain_trust() const;
+            const uint256 & chain_trust() const;
         
             /**
              * Sets the height.
@@ -246,7 +247,7 @@ namespace coin {
             /**
              * Gets the block trust.
              */
-            big_number get_block_trust();
+            uint256 get_block_trust();
         
             /**
              * The median timespan.
@@ -332,7 +333,7 @@ namespace coin {
             /**
              * The trust score of the chain (ppcoin).
              */
-            big_number m_chain_trust;
+            uint256 m_chain_trust;
         
             /**
              * The height.
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_BLOCK_UNDO_HPP
+#define COIN_BLOCK_UNDO_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <coin/data_buffer.hpp>
+#include <coin/point_out.hpp>
+#include <coin/transaction_out.hpp>
+
+namespace coin {
+
+    /**
+     * Implements a block undo database record. It is written when a block
+     * is connected and holds the outputs spent by the inputs of each of its
+     * transactions along with the point_out's they spent from previous
+     * transactions so that the block can be disconnected without looking
+     * up each previous transaction.
+     */
+    class block_undo : public data_buffer
+    {
+        public:
+        
+            /**
+             * Constructor
+             */
+            block_undo();
+        
+            /**
+             * Encodes
+             */
+            void encode();
+        
+            /**
+             * Encodes
+             * @param buffer The data_buffer.
+             */
+            void encode(data_buffer & buffer);
+        
+            /**
+             * Decodes
+             */
+            void decode();
+        
+            /**
+             * Decodes
+             * @param buffer The data_buffer.
+             */
+            void decode(data_buffer & buffer);
+        
+            /**
+             * Sets null.
+             */
+            void set_null();
+        
+            /**
+             * The outputs spent by the inputs of each transaction in block
+             * order (empty for the coinbase).
+             */
+            std::vector< std::vector<transaction_out> > & spent_outputs();
+        
+            /**
+             * The outputs spent by the inputs of each transaction in block
+             * order (empty for the coinbase).
+             */
+            const std::vector<
+                std::vector<transaction_out>
+            > & spent_outputs() const;
+        
+            /**
+             * The point_out's of previous transactions (not created by the
+             * block) that the block spends, their spent positions are
+             * nulled when the block is disconnected.
+             */
+            std::vector<point_out> & spent_points();
+        
+            /**
+             * The point_out's of previous transactions (not created by the
+             * block) that the block spends.
+             */
+            const std::vector<point_out> & spent_points() const;
+        
+        private:
+        
+            /**
+             * The spent outputs.
+             */
+            std::vector< std::vector<transaction_out> > m_spent_outputs;
+        
+            /**
+             * The spent point_out's.
+             */
+            std::vector<point_out> m_spent_points;
+        
+        protected:
+        
+            // ...
+    };
+    
+} // namespace coin
+
+#endif // COIN_BLOCK_UNDO_HPP
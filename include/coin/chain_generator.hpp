@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_CHAIN_GENERATOR_HPP
+#define COIN_CHAIN_GENERATOR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <coin/script.hpp>
+
+namespace coin {
+
+    class block;
+    class stack_impl;
+    class wallet;
+    
+    /**
+     * Implements a synthetic chain generator for offline load testing. On a
+     * regression test chain (regtest=1) it creates blocks with
+     * block::create_new filled with wallet transactions, solves them with
+     * mining::scan_hash_blake256 at the trivial proof-of-work limit and
+     * processes them so they are written to the blk000x.dat files.
+     */
+    class chain_generator
+    {
+        public:
+        
+            /**
+             * The number of keys the generated outputs pay to.
+             */
+            enum { key_ring_size = 64 };
+        
+            /**
+             * Constructor
+             * @param owner The stack_impl.
+             * @param blocks The number of blocks to generate.
+             * @param transactions The number of transactions per block.
+             * @param outputs The number of outputs per transaction.
+             * @param script_type The output script type (p2pkh or p2pk).
+             */
+            chain_generator(
+                stack_impl & owner, const std::uint32_t & blocks,
+                const std::uint32_t & transactions,
+                const std::uint32_t & outputs, const std::string & script_type
+            );
+        
+            /**
+             * Generates the blocks (on the calling thread, blocks are
+             * processed on the strand).
+             */
+            bool run();
+        
+        private:
+        
+            /**
+             * Creates and commits (to the transaction pool) the transactions
+             * for the next block.
+             * @param w The wallet.
+             */
+            std::uint32_t create_transactions(const std::shared_ptr<wallet> & w);
+        
+            /**
+             * Solves the block at it's (trivial) target.
+             * @param blk The block.
+             */
+            bool mine(const std::shared_ptr<block> & blk);
+        
+            /**
+             * Processes the block on the strand and waits for the result.
+             * @param blk The block.
+             */
+            bool process_block(const std::shared_ptr<block> & blk);
+        
+            /**
+             * The number of blocks to generate.
+             */
+            std::uint32_t m_blocks;
+        
+            /**
+             * The number of transactions per block.
+             */
+            std::uint32_t m_transactions;
+        
+            /**
+             * The number of outputs per transaction.
+             */
+            std::uint32_t m_outputs;
+        
+            /**
+             * The output script type.
+             */
+            std::string m_script_type;
+        
+            /**
+             * The scripts the generated outputs pay to.
+             */
+            std::vector<script> m_scripts;
+        
+            /**
+             * The index of the next script.
+             */
+            std::size_t m_script_index;
+        
+        protected:
+        
+            /**
+             * The stack_impl.
+             */
+            stack_impl & stack_impl_;
+    };
+    
+} // namespace coin
+
+#endif // COIN_CHAIN_GENERATOR_HPP
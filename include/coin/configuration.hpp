@@ -88,6 +88,18 @@ namespace coin {
              */
             const std::size_t & network_tcp_inbound_maximum() const;
         
+            /**
+             * Sets the number of TCP (network) io threads.
+             * @param val The value (zero selects the number from the
+             * hardware concurrency).
+             */
+            void set_network_tcp_threads(const std::size_t & val);
+        
+            /**
+             * The number of TCP (network) io threads.
+             */
+            const std::size_t & network_tcp_threads() const;
+        
             /**
              * If true network UDP support is enabled.
              * @param val the value.
@@ -287,6 +299,43 @@ namespace coin {
              */
             const bool & db_private() const;
         
+            /**
+             * Sets if the (optional) address index is maintained.
+             * @param val The value.
+             */
+            void set_address_index(const bool & val);
+        
+            /**
+             * If true the (optional) address index is maintained.
+             */
+            const bool & address_index() const;
+        
+            /**
+             * Sets if the transaction indexes of fully spent transactions
+             * are pruned.
+             * @param val The value.
+             */
+            void set_prune_transaction_index(const bool & val);
+        
+            /**
+             * If true the transaction indexes of fully spent transactions
+             * are pruned.
+             */
+            const bool & prune_transaction_index() const;
+        
+            /**
+             * Sets if the transaction indexes are written in the compact
+             * encoding (older versions can not read it).
+             * @param val The value.
+             */
+            void set_compact_transaction_index(const bool & val);
+        
+            /**
+             * If true the transaction indexes are written in the compact
+             * encoding.
+             */
+            const bool & compact_transaction_index() const;
+        
         private:
         
             /** 
@@ -304,6 +353,11 @@ namespace coin {
              */
             std::size_t m_network_tcp_inbound_maximum;
         
+            /**
+             * The number of TCP (network) io threads.
+             */
+            std::size_t m_network_tcp_threads;
+        
             /**
              * If true network UDP support is enabled.
              */
@@ -377,6 +431,23 @@ namespace coin {
              */
             bool m_db_private;
         
+            /**
+             * If true the (optional) address index is maintained.
+             */
+            bool m_address_index;
+        
+            /**
+             * If true the transaction indexes of fully spent transactions
+             * are pruned.
+             */
+            bool m_prune_transaction_index;
+        
+            /**
+             * If true the transaction indexes are written in the compact
+             * encoding.
+             */
+            bool m_compact_transaction_index;
+        
         protected:
         
             /**
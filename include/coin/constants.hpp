@@ -134,6 +134,12 @@ namespace constants {
      */
     static big_number proof_of_work_limit_ceiling(~sha256(0) >> 24);
     
+    /**
+     * The proof of work limit on a regression test chain (any hash with
+     * the leading bit clear).
+     */
+    static big_number proof_of_work_limit_regtest(~sha256(0) >> 1);
+    
     /**
      * The proof of stake limit.
      */
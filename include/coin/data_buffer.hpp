@@ -26,9 +26,11 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <vector>
 
 #include <boost/asio.hpp>
@@ -89,20 +91,30 @@ namespace coin {
                 m_read_ptr = m_data.size() > 0 ? &m_data[0] : 0;
 			}
         
+            /**
+             * Move constructor
+             * @param other The other data_buffer.
+             */
+            data_buffer(data_buffer && other) noexcept
+                : m_data(std::move(other.m_data))
+                , m_read_ptr(0)
+                , file_(std::move(other.file_))
+                , file_offset_(other.file_offset_)
+            {
+                m_read_ptr = m_data.size() > 0 ? &m_data[0] : 0;
+                
+                other.m_read_ptr = 0;
+            }
+        
             /**
              * Constructor
-             * @param len The length.
+             * @param len The length (zero filled).
              */
 			data_buffer(const std::size_t & len)
 			    : m_read_ptr(0)
                 , file_offset_(0)
 			{
-                m_data.reserve(len);
-                
-			    for (std::size_t i = 0; i < len; i++)
-			    {
-			        write_byte(0);   
-			    }
+                resize(len);
 			}
             
             /**
@@ -140,6 +152,51 @@ namespace coin {
                 
                 return ret;
 			}
+        
+            /**
+             * Returns a non-owning view of the next len bytes and advances
+             * the read pointer. The view is valid until the buffer is
+             * modified (or, for file backed buffers, until the next view is
+             * read on the same thread).
+             * @param len The length.
+             */
+            const char * read_view(const std::size_t & len)
+            {
+                if (len == 0)
+                {
+                    return m_read_ptr;
+                }
+                
+                if (file_)
+                {
+                    static thread_local std::vector<char> g_view;
+                    
+                    g_view.resize(len);
+                    
+                    read(&g_view[0], len);
+                    
+                    return &g_view[0];
+                }
+                
+                if (remaining() < len)
+                {
+                    throw std::runtime_error(
+                        "buffer underrun, len = " + std::to_string(len) +
+                        ", remaining = " + std::to_string(remaining())
+                    );
+                }
+                
+                if (m_read_ptr == 0)
+                {
+                    m_read_ptr = &m_data[0];
+                }
+                
+                auto ret = m_read_ptr;
+                
+                m_read_ptr += len;
+                
+                return ret;
+            }
             
 			std::uint8_t read_uint8()
 			{
@@ -267,22 +324,56 @@ namespace coin {
 
 			void reserve(const std::size_t & len)
 			{
-                m_data.reserve(len);
+                if (len > m_data.capacity())
+                {
+                    allocations_()++;
+                    
+                    rebase([&]() { m_data.reserve(len); });
+                }
 			}
         
 			void resize(const std::size_t & len)
 			{
-                m_data.resize(len);
+                if (len > m_data.capacity())
+                {
+                    allocations_()++;
+                }
+                
+                rebase([&]() { m_data.resize(len); });
 			}
 
+            /**
+             * Clears the buffer, the capacity is retained for reuse up to
+             * max_retained_capacity.
+             */
 			void clear()
 			{
-                std::vector<char> empty;
-                
-                m_data.swap(empty);
+                if (m_data.capacity() > max_retained_capacity)
+                {
+                    std::vector<char> empty;
+                    
+                    m_data.swap(empty);
+                }
+                else
+                {
+                    m_data.clear();
+                }
 
 			    m_read_ptr = 0;
 			}
+        
+            /**
+             * The maximum capacity retained by clear.
+             */
+            enum { max_retained_capacity = 1024 * 1024 };
+        
+            /**
+             * The number of (data_buffer) heap allocations since startup.
+             */
+            static std::uint64_t allocations()
+            {
+                return allocations_();
+            }
 
 			std::size_t remaining() const
 			{
@@ -327,10 +418,18 @@ namespace coin {
 
 			void write(void * data, const std::size_t & len)
 			{
-                m_data.insert(
-                    m_data.end(), reinterpret_cast<char *>(data),
-                    reinterpret_cast<char *>(data) + len
-                );
+                if (m_data.size() + len > m_data.capacity())
+                {
+                    allocations_()++;
+                }
+                
+                rebase([&]()
+                {
+                    m_data.insert(
+                        m_data.end(), reinterpret_cast<char *>(data),
+                        reinterpret_cast<char *>(data) + len
+                    );
+                });
 			}
         
             /**
@@ -653,8 +752,15 @@ namespace coin {
              */
             data_buffer & operator = (const data_buffer & other)
             {
+                if (this == &other)
+                {
+                    return *this;
+                }
+                
                 clear();
                 
+                reserve(other.size());
+                
 			    write_bytes(other.data(), other.size());
                 
                 m_read_ptr = m_data.size() > 0 ? &m_data[0] : 0;
@@ -665,8 +771,149 @@ namespace coin {
                 return *this;
             }
         
+            /**
+             * operator = (move)
+             */
+            data_buffer & operator = (data_buffer && other) noexcept
+            {
+                if (this == &other)
+                {
+                    return *this;
+                }
+                
+                m_data = std::move(other.m_data);
+                
+                m_read_ptr = m_data.size() > 0 ? &m_data[0] : 0;
+                
+                file_offset_ = other.file_offset_;
+                file_ = std::move(other.file_);
+                
+                other.m_read_ptr = 0;
+                
+                return *this;
+            }
+        
+            /**
+             * Implements a buffer borrowed from a thread-local pool for the
+             * duration of a scope. Pooled buffers keep their capacity so hot
+             * encoders do not allocate on every call.
+             */
+            class pooled
+            {
+                public:
+                
+                    /**
+                     * Constructor
+                     */
+                    pooled()
+                    {
+                        auto & buffers = pool();
+                        
+                        if (buffers.size() > 0)
+                        {
+                            m_buffer = std::move(buffers.back());
+                            
+                            buffers.pop_back();
+                        }
+                        else
+                        {
+                            m_buffer.reset(new data_buffer());
+                        }
+                    }
+                
+                    /**
+                     * Destructor
+                     */
+                    ~pooled()
+                    {
+                        auto & buffers = pool();
+                        
+                        if (buffers.size() < max_pooled)
+                        {
+                            m_buffer->clear();
+                            
+                            buffers.push_back(std::move(m_buffer));
+                        }
+                    }
+                
+                    /**
+                     * operator *
+                     */
+                    data_buffer & operator * ()
+                    {
+                        return *m_buffer;
+                    }
+                
+                    /**
+                     * operator ->
+                     */
+                    data_buffer * operator -> ()
+                    {
+                        return m_buffer.get();
+                    }
+                
+                private:
+                
+                    /**
+                     * The maximum number of buffers pooled per thread.
+                     */
+                    enum { max_pooled = 8 };
+                
+                    /**
+                     * The buffers of the calling thread.
+                     */
+                    static std::vector< std::unique_ptr<data_buffer> > & pool()
+                    {
+                        static thread_local std::vector<
+                            std::unique_ptr<data_buffer>
+                        > g_buffers;
+                        
+                        return g_buffers;
+                    }
+                
+                    /**
+                     * The buffer.
+                     */
+                    std::unique_ptr<data_buffer> m_buffer;
+                
+                protected:
+                
+                    // ...
+            };
+        
         private:
         
+            /**
+             * Performs an operation that may reallocate the data keeping
+             * the read pointer at the same offset.
+             * @param f The function.
+             */
+            template<class T>
+            void rebase(const T & f)
+            {
+                auto offset = m_read_ptr ? m_read_ptr - m_data.data() : -1;
+                
+                f();
+                
+                if (offset >= 0)
+                {
+                    m_read_ptr =
+                        m_data.size() > 0 ? m_data.data() +
+                        std::min<std::size_t> (offset, m_data.size()) : 0
+                    ;
+                }
+            }
+        
+            /**
+             * The allocation counter.
+             */
+            static std::atomic<std::uint64_t> & allocations_()
+            {
+                static std::atomic<std::uint64_t> g_allocations(0);
+                
+                return g_allocations;
+            }
+        
             /**
              * The data.
              */
@@ -33,6 +33,7 @@
 #include <coin/key_pool.hpp>
 #include <coin/key_wallet_master.hpp>
 #include <coin/logger.hpp>
+#include <coin/metrics.hpp>
 #include <coin/ripemd160.hpp>
 
 namespace coin {
@@ -119,7 +120,7 @@ namespace coin {
                 
                 dbt_value.set_flags(DB_DBT_MALLOC);
                 
-                auto ret = m_Db->get(m_DbTxn, &dbt_key, &dbt_value, 0);
+                auto ret = db_get(m_DbTxn, &dbt_key, &dbt_value, 0);
                 
                 std::memset(dbt_key.get_data(), 0, dbt_key.get_size());
                 
@@ -179,7 +180,7 @@ namespace coin {
                 
                 dbt_value.set_flags(DB_DBT_MALLOC);
                 
-                auto ret = m_Db->get(m_DbTxn, &dbt_key, &dbt_value, 0);
+                auto ret = db_get(m_DbTxn, &dbt_key, &dbt_value, 0);
                 
                 std::memset(dbt_key.get_data(), 0, dbt_key.get_size());
                 
@@ -238,7 +239,7 @@ namespace coin {
                 
                 dbt_value.set_flags(DB_DBT_MALLOC);
                 
-                auto ret = m_Db->get(m_DbTxn, &dbt_key, &dbt_value, 0);
+                auto ret = db_get(m_DbTxn, &dbt_key, &dbt_value, 0);
                 
                 std::memset(dbt_key.get_data(), 0, dbt_key.get_size());
                 
@@ -320,7 +321,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -380,7 +381,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -440,7 +441,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -500,7 +501,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -562,7 +563,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -628,7 +629,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -686,7 +687,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -745,7 +746,7 @@ namespace coin {
                     static_cast<std::uint32_t> (value_data.size())
                 );
 
-                auto ret = m_Db->put(
+                auto ret = db_put(
                     m_DbTxn, &dat_key, &dat_value, overwrite ?
                     0 : DB_NOOVERWRITE
                 );
@@ -886,6 +887,53 @@ namespace coin {
             friend class db_tx;
             friend class db_wallet;
         
+            /**
+             * Performs a Db::get recording its latency.
+             * @param txn The DbTxn.
+             * @param key The key.
+             * @param value The value.
+             * @param flags The flags.
+             */
+            int db_get(
+                DbTxn * txn, Dbt * key, Dbt * value,
+                const std::uint32_t & flags
+                )
+            {
+                static auto & histogram =
+                    metrics::instance().get_histogram("db_read")
+                ;
+                
+                metrics::scoped_timer timer_metrics(histogram);
+                
+                return m_Db->get(txn, key, value, flags);
+            }
+        
+            /**
+             * Performs a Db::put recording its latency and length.
+             * @param txn The DbTxn.
+             * @param key The key.
+             * @param value The value.
+             * @param flags The flags.
+             */
+            int db_put(
+                DbTxn * txn, Dbt * key, Dbt * value,
+                const std::uint32_t & flags
+                )
+            {
+                static auto & histogram =
+                    metrics::instance().get_histogram("db_write")
+                ;
+                static auto & bytes =
+                    metrics::instance().get_counter("db_write_bytes")
+                ;
+                
+                bytes.add(key->get_size() + value->get_size());
+                
+                metrics::scoped_timer timer_metrics(histogram);
+                
+                return m_Db->put(txn, key, value, flags);
+            }
+        
             /**
              * If true the database is read-only.
              */
@@ -23,6 +23,9 @@
 
 #include <db_cxx.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -47,6 +50,35 @@ namespace coin {
              */
             enum { default_cache_size = 25 };
         
+            /**
+             * The number of log bytes written since the last checkpoint
+             * that triggers a checkpoint.
+             */
+            enum { checkpoint_log_bytes = 4 * 1024 * 1024 };
+        
+            /**
+             * The maximum interval in seconds between checkpoints (when
+             * there is any log activity).
+             */
+            enum { checkpoint_interval_max = 120 };
+        
+            /**
+             * The maintenance statistics.
+             */
+            typedef struct
+            {
+                std::uint64_t checkpoints;
+                std::uint32_t checkpoint_duration_last;
+                std::uint32_t checkpoint_duration_max;
+                std::uint32_t checkpoint_interval;
+                std::uint64_t log_bytes;
+                std::uint64_t log_bytes_checkpoint;
+                std::uint64_t cache_hits;
+                std::uint64_t cache_misses;
+                std::uint64_t cache_bytes;
+                std::uint64_t cache_pages_evicted;
+            } maintenance_stats_t;
+        
             /**
              * Constructor
              */
@@ -138,8 +170,52 @@ namespace coin {
              */
             DbTxn * txn_begin(int flags = DB_TXN_WRITE_NOSYNC);
         
+            /**
+             * Starts the maintenance thread.
+             */
+            void start_maintenance();
+        
+            /**
+             * Stops the maintenance thread.
+             */
+            void stop_maintenance();
+        
+            /**
+             * Requests a checkpoint once either threshold is reached (both
+             * zero forces one). If the maintenance thread is running the
+             * checkpoint is left to it, otherwise it is performed on the
+             * calling thread.
+             * @param kbytes The log volume in kilobytes that requires a
+             * checkpoint.
+             * @param minutes The minutes since the last checkpoint that
+             * requires a checkpoint.
+             */
+            void request_checkpoint(
+                const std::uint32_t & kbytes, const std::uint32_t & minutes
+            );
+        
+            /**
+             * The maintenance statistics.
+             */
+            maintenance_stats_t maintenance_stats();
+        
         private:
         
+            /**
+             * The maintenance thread loop.
+             */
+            void do_maintenance();
+        
+            /**
+             * Performs a checkpoint and removes unneeded logs.
+             */
+            void checkpoint();
+        
+            /**
+             * Updates the log and cache statistics.
+             */
+            void update_stats();
+        
             /**
              * The DbEnv.
              */
@@ -160,6 +236,11 @@ namespace coin {
              */
             static std::recursive_mutex g_mutex_DbEnv;
         
+            /**
+             * The maintenance statistics.
+             */
+            maintenance_stats_t m_maintenance_stats;
+        
         protected:
         
             /**
@@ -180,6 +261,36 @@ namespace coin {
              * m_Dbs std::recursive_mutex.
              */
             std::recursive_mutex mutex_m_Dbs_;
+        
+            /**
+             * The maintenance thread.
+             */
+            std::thread thread_maintenance_;
+        
+            /**
+             * If true the maintenance thread should exit.
+             */
+            std::atomic<bool> maintenance_stop_;
+        
+            /**
+             * If true a checkpoint check has been requested.
+             */
+            bool maintenance_requested_;
+        
+            /**
+             * The maintenance std::mutex.
+             */
+            std::mutex mutex_maintenance_;
+        
+            /**
+             * The maintenance std::condition_variable.
+             */
+            std::condition_variable condition_maintenance_;
+        
+            /**
+             * m_maintenance_stats std::mutex.
+             */
+            std::mutex mutex_maintenance_stats_;
     };
     
 } // namespace coin
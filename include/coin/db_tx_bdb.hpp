@@ -22,10 +22,14 @@
 #define COIN_DB_TX_BDB_HPP
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 
+#include <coin/address_index.hpp>
 #include <coin/big_number.hpp>
+#include <coin/block_undo.hpp>
 #include <coin/db.hpp>
 #include <coin/db_tx.hpp>
 #include <coin/sha256.hpp>
@@ -131,6 +135,82 @@ namespace coin {
              */
             bool erase_transaction_index(const transaction & tx) const;
         
+            /**
+             * Erases a transaction index.
+             * @param hash The sha256 hash.
+             */
+            bool erase_transaction_index(const sha256 & hash) const;
+
+            /**
+             * Re-encodes a batch of the transaction indexes that are still
+             * in the legacy encoding, the progress is kept in the database.
+             * @param limit The maximum number of records visited.
+             * @param finished Set to true once all records are compact.
+             */
+            bool compact_transaction_indexes(
+                const std::size_t & limit, bool & finished
+            );
+        
+            /**
+             * Reads a block_undo.
+             * @param hash The hash of the block.
+             * @param value The block_undo.
+             */
+            bool read_block_undo(const sha256 & hash, block_undo & value);
+        
+            /**
+             * Writes a block_undo.
+             * @param hash The hash of the block.
+             * @param value The block_undo.
+             */
+            bool write_block_undo(const sha256 & hash, block_undo & value);
+        
+            /**
+             * Erases a block_undo.
+             * @param hash The hash of the block.
+             */
+            bool erase_block_undo(const sha256 & hash);
+
+            /**
+             * Reads an address_index.
+             * @param key The key.
+             * @param value The address_index.
+             */
+            bool read_address_index(
+                const data_buffer & key, address_index & value
+            );
+
+            /**
+             * Writes an address_index.
+             * @param key The key.
+             * @param value The address_index.
+             */
+            bool write_address_index(
+                const data_buffer & key, address_index & value
+            );
+
+            /**
+             * Erases an address_index.
+             * @param key The key.
+             */
+            bool erase_address_index(const data_buffer & key);
+
+            /**
+             * Reads the address_index records whose keys begin with the
+             * first prefix_length bytes of key_start in key order.
+             * @param key_start The key to start at.
+             * @param prefix_length The length of the prefix to match.
+             * @param key_end If not empty the cursor stops at the first key
+             * whose leading bytes are greater than it.
+             * @param records The records (out).
+             */
+            bool read_address_indexes(
+                const data_buffer & key_start,
+                const std::size_t & prefix_length,
+                const data_buffer & key_end,
+                std::vector< std::pair<data_buffer, address_index> > & records
+            );
+        
             /**
              * Writes the hash of the best chain.
              * @param hash The sha256 hash.
@@ -21,6 +21,7 @@
 #ifndef COIN_GLOBALS_HPP
 #define COIN_GLOBALS_HPP
 
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <map>
@@ -94,6 +95,16 @@ namespace coin {
                 return m_strand;
             }
         
+            /**
+             * The boost::asio::io_service of the TCP (network) transport
+             * layer, it is run by a pool of threads and each tcp_transport
+             * (and the tcp_acceptor) uses its own boost::asio::strand.
+             */
+            boost::asio::io_service & io_service_network()
+            {
+                return m_io_service_network;
+            }
+        
             /**
              * Sets the state.
              * @param val The state_t.
@@ -148,6 +159,23 @@ namespace coin {
                 return m_is_client_spv;
             }
         
+            /**
+             * Set if we are operating on an isolated regression test chain.
+             */
+            void set_regtest(const bool & val)
+            {
+                m_is_regtest = val;
+            }
+        
+            /**
+             * If true we are operating on an isolated regression test chain
+             * (trivial Proof-of-Work, no checkpoints and no peers).
+             */
+            const bool & is_regtest() const
+            {
+                return m_is_regtest;
+            }
+        
             /**
              * If true ZeroTime is enabled.
              */
@@ -161,7 +189,10 @@ namespace coin {
              */
             const bool is_incentive_enabled() const
             {
-                return m_operation_mode == protocol::operation_mode_peer;
+                return
+                    m_operation_mode == protocol::operation_mode_peer &&
+                    m_is_regtest == false
+                ;
             }
         
             /**
@@ -169,7 +200,10 @@ namespace coin {
              */
             const bool is_chainblender_enabled() const
             {
-                return m_operation_mode == protocol::operation_mode_peer;
+                return
+                    m_operation_mode == protocol::operation_mode_peer &&
+                    m_is_regtest == false
+                ;
             }
         
             /**
@@ -204,7 +238,7 @@ namespace coin {
             /**
              * The best block height.
              */
-            const std::int32_t & best_block_height() const
+            std::int32_t best_block_height() const
             {
                 return m_best_block_height;
             }
@@ -365,24 +399,6 @@ namespace coin {
                 return m_peer_block_counts;
             }
         
-            /**
-             * The relay inventory_vector's.
-             */
-            std::map<inventory_vector, data_buffer> & relay_invs()
-            {
-                return m_relay_invs;
-            }
-        
-            /**
-             * The relay inventory_vector expirations.
-             */
-            std::deque<
-                std::pair<std::int64_t, inventory_vector>
-                > & relay_inv_expirations()
-            {
-                return m_relay_inv_expirations;
-            }
-        
             /**
              * Sets the transaction feed.
              * @param val The value.
@@ -657,6 +673,43 @@ namespace coin {
              */
             const bool & db_private() const;
         
+            /**
+             * Sets if the (optional) address index is maintained.
+             * @param val The value.
+             */
+            void set_address_index(const bool & val);
+        
+            /**
+             * If true the (optional) address index is maintained.
+             */
+            const bool & address_index() const;
+        
+            /**
+             * Sets if the transaction indexes of fully spent transactions
+             * are pruned.
+             * @param val The value.
+             */
+            void set_prune_transaction_index(const bool & val);
+        
+            /**
+             * If true the transaction indexes of fully spent transactions
+             * are pruned.
+             */
+            const bool & prune_transaction_index() const;
+        
+            /**
+             * Sets if the transaction indexes are written in the compact
+             * encoding (older versions can not read it).
+             * @param val The value.
+             */
+            void set_compact_transaction_index(const bool & val);
+        
+            /**
+             * If true the transaction indexes are written in the compact
+             * encoding.
+             */
+            const bool & compact_transaction_index() const;
+        
             /**
              * Resets the (SPV) transaction_bloom_filter to the current
              * current environment.
@@ -680,6 +733,12 @@ namespace coin {
              */
             boost::asio::strand m_strand;
         
+            /**
+             * The boost::asio::io_service of the TCP (network) transport
+             * layer.
+             */
+            boost::asio::io_service m_io_service_network;
+        
             /**
              * The state.
              */
@@ -700,15 +759,21 @@ namespace coin {
              */
             bool m_is_client_spv;
         
+            /**
+             * If true we are operating on an isolated regression test chain.
+             */
+            bool m_is_regtest;
+        
             /**
              * The version nonce (used to detect connections to ourselves).
              */
             std::uint64_t m_version_nonce;
         
             /**
-             * The best block height.
+             * The best block height (also read by the block_check_queue
+             * threads).
              */
-            std::int32_t m_best_block_height;
+            std::atomic<std::int32_t> m_best_block_height;
         
             /**
              * The block indexes.
@@ -781,18 +846,6 @@ namespace coin {
              */
             median_filter<std::uint32_t> m_peer_block_counts;
         
-            /**
-             * The relay inventory_vector's.
-             */
-            std::map<inventory_vector, data_buffer> m_relay_invs;
-        
-            /**
-             * The relay inventory_vector expirations.
-             */
-            std::deque<
-                std::pair<std::int64_t, inventory_vector>
-            > m_relay_inv_expirations;
-        
             /**
              * The transaction fee.
              */
@@ -911,6 +964,23 @@ namespace coin {
              */
             bool m_db_private;
         
+            /**
+             * If true the (optional) address index is maintained.
+             */
+            bool m_address_index;
+        
+            /**
+             * If true the transaction indexes of fully spent transactions
+             * are pruned.
+             */
+            bool m_prune_transaction_index;
+        
+            /**
+             * If true the transaction indexes are written in the compact
+             * encoding.
+             */
+            bool m_compact_transaction_index;
+        
         protected:
         
             // ...
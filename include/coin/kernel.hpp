@@ -24,6 +24,9 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <coin/sha256.hpp>
 
@@ -39,6 +42,18 @@ namespace coin {
     {
         public:
 
+            /**
+             * A candidate block for the stake modifier selection.
+             */
+            typedef struct
+            {
+                std::int64_t time;
+                sha256 hash;
+                const block_index * index;
+                sha256 hash_selection;
+                bool selected;
+            } stake_candidate_t;
+        
             /**
              * Constructor
              */
@@ -131,17 +146,14 @@ namespace coin {
              * Selects a block from the candidate blocks whic are sorted by
              * timestamp, excluding the already selected blocks, and with
              * timestamp up to the given interval.
-             * @param sorted_by_timestamp The hashes sorted by to timestamp.
-             * @param selected_blocks The selected blocks.
+             * @param sorted_by_timestamp The candidates sorted by timestamp
+             * with their selection hashes computed.
              * @param selection_interval_stop The selection interval stop.
-             * @param previous_stake_modifier The previous stake modifier.
              * @param index_selected The selected index.
              */
             static bool select_block_from_candidates(
-                std::vector<std::pair<std::int64_t, sha256> > & sorted_by_timestamp,
-                std::map<sha256, block_index *> & selected_blocks,
+                std::vector<stake_candidate_t> & sorted_by_timestamp,
                 const std::int64_t & selection_interval_stop,
-                const std::uint64_t & previous_stake_modifier,
                 const block_index ** index_selected
             );
 
@@ -235,6 +247,56 @@ namespace coin {
              */
             enum { modifier_interval_ratio = 3 };
         
+            /**
+             * Gets the candidate blocks for the stake modifier selection
+             * (in chain order) by sliding the window of the previous
+             * computation forward.
+             * @param index_previous The previous block index.
+             * @param selection_interval_start The selection interval start.
+             */
+            std::vector<const block_index *> get_stake_modifier_candidates(
+                const block_index * index_previous,
+                const std::int64_t & selection_interval_start
+            );
+        
+            /**
+             * The maximum number of cached kernel stake modifiers.
+             */
+            enum { kernel_stake_modifiers_length = 16384 };
+        
+            /**
+             * The candidate blocks (in chain order) of the last stake
+             * modifier computation.
+             */
+            std::vector<const block_index *> m_stake_modifier_candidates;
+        
+            /**
+             * The last block of the candidate window.
+             */
+            const block_index * m_stake_modifier_candidates_tip;
+        
+            /**
+             * The selection interval start of the candidate window.
+             */
+            std::int64_t m_stake_modifier_candidates_start;
+        
+            /**
+             * The std::mutex for the candidate window.
+             */
+            std::mutex mutex_stake_modifier_candidates_;
+        
+            /**
+             * The blocks holding the kernel stake modifier by block from.
+             */
+            std::unordered_map<
+                const block_index *, const block_index *
+            > m_kernel_stake_modifiers;
+        
+            /**
+             * The std::mutex for the kernel stake modifiers.
+             */
+            std::mutex mutex_kernel_stake_modifiers_;
+        
         protected:
         
             // ...
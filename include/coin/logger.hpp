@@ -17,7 +17,7 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
- 
+
 #ifndef COIN_LOGGER_HPP
 #define COIN_LOGGER_HPP
 
@@ -30,20 +30,29 @@
 #include <windows.h>
 #endif // (defined _WIN32 || defined WIN32) || (defined _WIN64 || defined WIN64)
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
 #include <iostream>
 #include <fstream>
 #include <memory>
 #include <mutex>
 #include <sstream>
-
-#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <coin/filesystem.hpp>
 
 namespace coin {
 
     /**
-     * Implements a logger.
+     * Implements a logger. Lines are pushed onto a lock-free
+     * multi-producer queue and written in batches by a background thread,
+     * error lines are written before returning.
      */
     class logger
     {
@@ -58,6 +67,18 @@ namespace coin {
 				severity_warning,
                 severity_test,
 			} severity_t;
+        
+            /**
+             * The maximum length of debug.log before it is rotated to
+             * debug.log.1.
+             */
+            enum { max_length = 10 * 1000000 };
+        
+            /**
+             * The maximum number of queued lines, further (non-error) lines
+             * are dropped and counted until the writer catches up.
+             */
+            enum { queue_maximum = 64 * 1024 };
 			
             /**
              * Singleton accessor.
@@ -68,6 +89,14 @@ namespace coin {
                 
 			    return g_logger;
 			}
+        
+            /**
+             * Destructor
+             */
+            ~logger()
+            {
+                stop();
+            }
             
             /**
              * operator <<
@@ -92,82 +121,480 @@ namespace coin {
              */
 			void log(std::stringstream & val)
 			{
-                std::lock_guard<std::recursive_mutex> l1(mutex_);
+                log(severity_none, 0, val.str());
+			}
+        
+            /**
+             * Queues a line for the background writer.
+             * @param val The severity.
+             * @param function The function name.
+             * @param message The message.
+             */
+            void log(
+                const severity_t & val, const char * function,
+                const std::string & message
+                )
+            {
+                if (
+                    val != severity_error &&
+                    m_queued.load(std::memory_order_relaxed) >= queue_maximum
+                    )
+                {
+                    m_dropped++;
+                    
+                    return;
+                }
                 
-			    static const bool use_file = true;
-
-			    if (use_file)
-			    {
-                    static std::string path =
-                        filesystem::data_path() + "debug.log"
-                    ;
+                auto * e = new entry_t();
+                
+                e->severity = val;
+                e->function = function;
+                e->message = message;
+                e->structured = m_structured;
+                e->time = e->structured ? std::time(0) : 0;
+                e->written = false;
+                
+                m_queued++;
+                
+                push(e);
+                
+                /**
+                 * Error lines (and the lines queued before them) are written
+                 * before returning so they are not lost if the process then
+                 * crashes or aborts, the writer leaves them to be deleted
+                 * here.
+                 */
+                if (val == severity_error)
+                {
+                    while (e->written == false)
+                    {
+                        drain();
+                        
+                        if (e->written == false)
+                        {
+                            /**
+                             * A line queued ahead is still being pushed.
+                             */
+                            std::this_thread::yield();
+                        }
+                    }
+                    
+                    delete e;
+                }
+                else if (m_pending.exchange(true) == false)
+                {
+                    condition_.notify_one();
+                }
+            }
+        
+            /**
+             * If true the severity is logged, checked before formatting.
+             * @param val The severity.
+             */
+            bool is_enabled(const severity_t & val) const
+            {
+                return (m_severities.load(std::memory_order_relaxed) &
+                    (1U << val)) != 0
+                ;
+            }
+        
+            /**
+             * Enables or disables a severity at runtime.
+             * @param val The severity.
+             * @param flag The flag.
+             */
+            void set_enabled(const severity_t & val, const bool & flag)
+            {
+                if (flag)
+                {
+                    m_severities |= 1U << val;
+                }
+                else
+                {
+                    m_severities &= ~(1U << val);
+                }
+            }
+        
+            /**
+             * Sets structured (one JSON object per line) output.
+             * @param val The value.
+             */
+            void set_structured(const bool & val)
+            {
+                m_structured = val;
+            }
+        
+            /**
+             * Formats a structured key/value field.
+             * @param key The key.
+             * @param val The value.
+             */
+            template <class T>
+            static std::string kv(const std::string & key, const T & val)
+            {
+                std::stringstream ss;
+                
+                ss << " " << key << "=" << val;
+                
+                return ss.str();
+            }
+        
+            /**
+             * Stops the background writer after writing all queued lines.
+             */
+            void stop()
+            {
+                if (m_stop.exchange(true) == false)
+                {
+                    condition_.notify_one();
                     
-                    if (ofstream_.is_open() == false)
+                    if (thread_.joinable())
                     {
-                        ofstream_.open(
-                            path, std::fstream::out | std::fstream::app
-                        );
+                        thread_.join();
+                    }
+                }
+            }
+        
+        private:
+        
+            /**
+             * Constructor
+             */
+            logger()
+                : m_severities(0xffffffff)
+                , m_structured(false)
+                , m_pending(false)
+                , m_stop(false)
+                , m_queued(0)
+                , m_dropped(0)
+                , m_length(0)
+                , queue_head_(&queue_stub_)
+                , queue_tail_(&queue_stub_)
+            {
+                queue_stub_.next = 0;
+                
+                thread_ = std::thread(&logger::loop, this);
+            }
+        
+            /**
+             * A queued line.
+             */
+            typedef struct entry_s
+            {
+                std::atomic<entry_s *> next;
+                severity_t severity;
+                const char * function;
+                std::string message;
+                bool structured;
+                std::time_t time;
+                std::atomic<bool> written;
+            } entry_t;
+        
+            /**
+             * Pushes an entry (any thread).
+             * @param e The entry_t.
+             */
+            void push(entry_t * e)
+            {
+                e->next.store(0, std::memory_order_relaxed);
+                
+                auto * previous = queue_head_.exchange(
+                    e, std::memory_order_acq_rel
+                );
+                
+                previous->next.store(e, std::memory_order_release);
+            }
+        
+            /**
+             * Pops an entry (with mutex_write_ held).
+             */
+            entry_t * pop()
+            {
+                auto * tail = queue_tail_;
+                auto * next = tail->next.load(std::memory_order_acquire);
+                
+                if (tail == &queue_stub_)
+                {
+                    if (next == 0)
+                    {
+                        return 0;
                     }
                     
-                    if (ofstream_.is_open() == true)
+                    queue_tail_ = next;
+                    tail = next;
+                    next = next->next.load(std::memory_order_acquire);
+                }
+                
+                if (next)
+                {
+                    queue_tail_ = next;
+                    
+                    return tail;
+                }
+                
+                /**
+                 * A producer is between its exchange and its store.
+                 */
+                if (tail != queue_head_.load(std::memory_order_acquire))
+                {
+                    return 0;
+                }
+                
+                push(&queue_stub_);
+                
+                next = tail->next.load(std::memory_order_acquire);
+                
+                if (next)
+                {
+                    queue_tail_ = next;
+                    
+                    return tail;
+                }
+                
+                return 0;
+            }
+        
+            /**
+             * Formats an entry as a line.
+             * @param e The entry_t.
+             */
+            std::string format(const entry_t & e) const
+            {
+                static const char * names[] =
+                {
+                    "UNKNOWN", "DEBUG", "ERROR", "INFO", "WARNING", "TEST"
+                };
+                
+                std::string ret;
+                
+                if (e.function == 0)
+                {
+                    ret = e.message;
+                }
+                else if (e.structured)
+                {
+                    ret = "{\"time\":" + std::to_string(e.time) +
+                        ",\"severity\":\"" + names[e.severity] +
+                        "\",\"function\":\"" + e.function +
+                        "\",\"message\":\""
+                    ;
+                    
+                    for (auto & i : e.message)
                     {
-                        /**
-                         * Limit size.
-                         */
-                        if (ofstream_.tellp() > 10 * 1000000)
+                        if (i == '"' || i == '\\')
+                        {
+                            ret += '\\';
+                            ret += i;
+                        }
+                        else if (static_cast<unsigned char> (i) < 0x20)
                         {
-                            ofstream_.close();
+                            char buf[8];
                             
-                            ofstream_.open(path, std::fstream::out);
+                            std::snprintf(
+                                buf, sizeof(buf), "\\u%04x",
+                                static_cast<unsigned char> (i)
+                            );
+                            
+                            ret += buf;
                         }
+                        else
+                        {
+                            ret += i;
+                        }
+                    }
+                    
+                    ret += "\"}";
+                }
+                else
+                {
+                    ret =
+                        std::string("[") + names[e.severity] + "] - " +
+                        e.function + ": " + e.message
+                    ;
+                }
+                
+                return ret;
+            }
+        
+            /**
+             * The background writer.
+             */
+            void loop()
+            {
+                while (true)
+                {
+                    auto is_stopping = m_stop.load();
+                    
+                    if (is_stopping == false)
+                    {
+                        std::unique_lock<std::mutex> l1(mutex_);
                         
-                        ofstream_ << val.str() << std::endl;
-                        
-                        ofstream_.flush();
+                        condition_.wait_for(
+                            l1, std::chrono::milliseconds(100),
+                            [this] { return m_pending || m_stop; }
+                        );
+                    }
+                    
+                    m_pending = false;
+                    
+                    drain();
+                    
+                    if (is_stopping)
+                    {
+                        break;
+                    }
+                }
+            }
+        
+            /**
+             * Writes all queued lines as a batch (called by the background
+             * writer and synchronously for error lines).
+             */
+            void drain()
+            {
+                std::lock_guard<std::mutex> l1(mutex_write_);
+                
+                batch_.clear();
+                
+                auto dropped = m_dropped.exchange(0);
+                
+                if (dropped > 0)
+                {
+                    batch_ +=
+                        "[WARNING] - logger: dropped " +
+                        std::to_string(dropped) + " lines.\n"
+                    ;
+                }
+                
+                while (auto * e = pop())
+                {
+                    m_queued--;
+                    
+                    auto line = format(*e);
+                    
+                    if (e->severity == severity_error)
+                    {
+                        errors_.push_back(e);
+                    }
+                    else
+                    {
+                        delete e;
                     }
-			    }
-
-			    static bool use_cout = true;
-
-			    if (use_cout)
-			    {
 #if (defined _WIN32 || defined WIN32) || (defined _WIN64 || defined WIN64)
-#if defined(_UNICODE)
-			        DWORD len = MultiByteToWideChar(
-			            CP_ACP, 0, val.str().c_str(), -1, NULL, 0
-			        );
-
-			        std::unique_ptr<wchar_t> buf(new wchar_t[len]);
-
-			        MultiByteToWideChar(
-			            CP_ACP, 0, val.str().c_str(), -1, buf.get(), len
-			        );
-
-			        OutputDebugString(buf.get());
-			        OutputDebugString(L"\n");
-
-			        std::cerr << val.str() << std::endl;
-#else
-			        OutputDebugString(val.str().c_str());
-			        OutputDebugString(L"\n");
-
-			        std::cerr << val.str() << std::endl;
-#endif // _UNICODE
-#else // Not Windows.
-#if (defined __ANDROID__)
-					__android_log_print(
-                        ANDROID_LOG_DEBUG, "logger", val.str().c_str()
+                    OutputDebugStringA(line.c_str());
+                    OutputDebugStringA("\n");
+#elif (defined __ANDROID__)
+                    __android_log_print(
+                        ANDROID_LOG_DEBUG, "logger", "%s", line.c_str()
                     );
+#endif // (defined _WIN32 || defined WIN32) || (defined _WIN64 || defined WIN64)
+                    batch_ += line;
+                    batch_ += '\n';
+                }
+                
+                if (batch_.size() > 0)
+                {
+                    write(batch_);
+                }
+                
+                /**
+                 * Let the error lines' producers return.
+                 */
+                for (auto & i : errors_)
+                {
+                    i->written = true;
+                }
+                
+                errors_.clear();
+            }
+        
+            /**
+             * Writes a batch of lines.
+             * @param val The lines.
+             */
+            void write(const std::string & val)
+            {
+                static const std::string path =
+                    filesystem::data_path() + "debug.log"
+                ;
+                
+                if (ofstream_.is_open() == false)
+                {
+                    ofstream_.open(
+                        path, std::fstream::out | std::fstream::app
+                    );
+                    
+                    if (ofstream_.is_open() == true)
+                    {
+                        m_length = static_cast<std::size_t> (
+                            ofstream_.tellp()
+                        );
+                    }
+                }
+                
+                if (ofstream_.is_open() == true)
+                {
+                    /**
+                     * Limit size.
+                     */
+                    if (m_length > max_length)
+                    {
+                        ofstream_.close();
+                        
+                        std::rename(path.c_str(), (path + ".1").c_str());
+                        
+                        ofstream_.open(path, std::fstream::out);
+                        
+                        m_length = 0;
+                    }
+                    
+                    ofstream_.write(val.data(), val.size());
+                    
+                    ofstream_.flush();
+                    
+                    m_length += val.size();
+                }
+#if (defined __ANDROID__)
+                // ...
 #else
-			        std::cerr << val.str() << std::endl;
-#endif
-#endif // defined _WIN32 || defined WIN32) || (defined _WIN64 || defined WIN64
-			    }
-			}
-            
-        private:
+                std::cerr.write(val.data(), val.size());
+#endif // __ANDROID__
+            }
+        
+            /**
+             * The enabled severities (bitmask).
+             */
+            std::atomic<std::uint32_t> m_severities;
         
-			// ...
+            /**
+             * If true lines are written as JSON objects.
+             */
+            std::atomic<bool> m_structured;
+        
+            /**
+             * If true lines are queued.
+             */
+            std::atomic<bool> m_pending;
+        
+            /**
+             * If true the background writer is stopping.
+             */
+            std::atomic<bool> m_stop;
+        
+            /**
+             * The number of queued lines.
+             */
+            std::atomic<std::size_t> m_queued;
+        
+            /**
+             * The number of lines dropped because the queue was full.
+             */
+            std::atomic<std::size_t> m_dropped;
+        
+            /**
+             * The length of debug.log.
+             */
+            std::size_t m_length;
             
         protected:
         
@@ -177,38 +604,59 @@ namespace coin {
             std::ofstream ofstream_;
         
             /**
-             * The std::recursive_mutex.
+             * The std::mutex.
+             */
+            std::mutex mutex_;
+        
+            /**
+             * The std::condition_variable.
+             */
+            std::condition_variable condition_;
+        
+            /**
+             * The std::mutex held while popping and writing lines.
+             */
+            std::mutex mutex_write_;
+        
+            /**
+             * The batch of lines being written.
+             */
+            std::string batch_;
+        
+            /**
+             * The error lines of the batch being written.
+             */
+            std::vector<entry_t *> errors_;
+        
+            /**
+             * The stub entry of the queue.
+             */
+            entry_t queue_stub_;
+        
+            /**
+             * The head of the queue (producers).
              */
-            std::recursive_mutex mutex_;
+            std::atomic<entry_t *> queue_head_;
+        
+            /**
+             * The tail of the queue (background writer).
+             */
+            entry_t * queue_tail_;
+        
+            /**
+             * The background writer thread.
+             */
+            std::thread thread_;
     };
     
     #define log_xx(severity, strm) \
     { \
-        std::stringstream __ss; \
-        switch (severity) \
+        if (coin::logger::instance().is_enabled(severity)) \
         { \
-            case coin::logger::severity_debug: \
-                __ss << "[DEBUG] - "; \
-            break; \
-            case coin::logger::severity_error: \
-                __ss << "[ERROR] - "; \
-            break; \
-            case coin::logger::severity_info: \
-                __ss << "[INFO] - "; \
-            break; \
-            case coin::logger::severity_warning: \
-                __ss << "[WARNING] - "; \
-            break; \
-            case coin::logger::severity_test: \
-                __ss << "[TEST] - "; \
-            break; \
-            default: \
-                __ss << "[UNKNOWN] - "; \
+            std::stringstream __ss; \
+            __ss << strm; \
+            coin::logger::instance().log(severity, __FUNCTION__, __ss.str()); \
         } \
-		__ss << __FUNCTION__ << ": "; \
-        __ss << strm; \
-        coin::logger::instance() << __ss.str(); \
-        __ss.str(std::string()); \
     } \
 	
 #define log_none(strm) /** */
@@ -225,5 +673,3 @@ namespace coin {
 } // namespace coin
 
 #endif // COIN_LOGGER_HPP
-
-        
\ No newline at end of file
@@ -88,6 +88,29 @@ namespace coin {
              */
             static const std::uint32_t header_magic();
         
+            /**
+             * Encodes a message header for a payload that is already
+             * encoded.
+             * @param buf The buffer of (at least) header_length bytes.
+             * @param command The command.
+             * @param length The length of the payload.
+             * @param checksum The checksum of the payload.
+             */
+            static void encode_header(
+                char * buf, const std::string & command,
+                const std::uint32_t & length, const std::uint32_t & checksum
+            );
+        
+            /**
+             * Decodes the payload length from an encoded message header.
+             * @param buf The buffer of (at least) header_length bytes.
+             * @param length The length of the payload (out).
+             * @return False if the header magic is invalid.
+             */
+            static bool decode_header_length(
+                const char * buf, std::uint32_t & length
+            );
+        
             /**
              * The header length.
              */
@@ -196,6 +219,21 @@ namespace coin {
              */
             protocol::merkleblock_t & protocol_merkleblock();
         
+            /**
+             * The protocol cmpctblock.
+             */
+            protocol::cmpctblock_t & protocol_cmpctblock();
+        
+            /**
+             * The protocol getblocktxn.
+             */
+            protocol::getblocktxn_t & protocol_getblocktxn();
+        
+            /**
+             * The protocol blocktxn.
+             */
+            protocol::blocktxn_t & protocol_blocktxn();
+        
             /**
              * The protocol ztlock structure.
              */
@@ -353,6 +391,21 @@ namespace coin {
              */
             protocol::merkleblock_t m_protocol_merkleblock;
         
+            /**
+             * The protocol cmpctblock.
+             */
+            protocol::cmpctblock_t m_protocol_cmpctblock;
+        
+            /**
+             * The protocol getblocktxn.
+             */
+            protocol::getblocktxn_t m_protocol_getblocktxn;
+        
+            /**
+             * The protocol blocktxn.
+             */
+            protocol::blocktxn_t m_protocol_blocktxn;
+        
             /**
              * The protocol ztlock structure.
              */
@@ -495,6 +548,21 @@ namespace coin {
              */
             data_buffer create_merkleblock();
         
+            /**
+             * Creates a cmpctblock.
+             */
+            data_buffer create_cmpctblock();
+        
+            /**
+             * Creates a getblocktxn.
+             */
+            data_buffer create_getblocktxn();
+        
+            /**
+             * Creates a blocktxn.
+             */
+            data_buffer create_blocktxn();
+        
             /**
              * Creates a tx.
              */
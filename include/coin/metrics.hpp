@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_METRICS_HPP
+#define COIN_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace coin {
+
+    /**
+     * Implements a registry of counters and latency histograms. Values are
+     * spread over cache line sized shards chosen by thread so that hot
+     * paths on different threads do not contend.
+     */
+    class metrics
+    {
+        public:
+        
+            /**
+             * The number of shards.
+             */
+            enum { shards = 16 };
+        
+            /**
+             * The number of histogram buckets, bucket i counts latencies
+             * below 2^i microseconds, the last bucket counts the rest.
+             */
+            enum { buckets = 24 };
+        
+            /**
+             * Implements a counter.
+             */
+            class counter
+            {
+                public:
+                
+                    /**
+                     * Constructor
+                     */
+                    counter()
+                    {
+                        for (auto & i : m_shards)
+                        {
+                            i.value = 0;
+                        }
+                    }
+                
+                    /**
+                     * Adds to the counter.
+                     * @param val The value.
+                     */
+                    void add(const std::uint64_t & val = 1)
+                    {
+                        m_shards[shard()].value.fetch_add(
+                            val, std::memory_order_relaxed
+                        );
+                    }
+                
+                    /**
+                     * The value.
+                     */
+                    std::uint64_t value() const
+                    {
+                        std::uint64_t ret = 0;
+                        
+                        for (auto & i : m_shards)
+                        {
+                            ret += i.value.load(std::memory_order_relaxed);
+                        }
+                        
+                        return ret;
+                    }
+                
+                private:
+                
+                    /**
+                     * A shard padded to a cache line.
+                     */
+                    typedef struct
+                    {
+                        std::atomic<std::uint64_t> value;
+                        char padding[64 - sizeof(std::uint64_t)];
+                    } shard_t;
+                
+                    /**
+                     * The shards.
+                     */
+                    shard_t m_shards[shards];
+                
+                protected:
+                
+                    // ...
+            };
+        
+            /**
+             * A snapshot of a histogram.
+             */
+            typedef struct
+            {
+                std::uint64_t counts[buckets];
+                std::uint64_t count;
+                std::uint64_t sum;
+            } histogram_snapshot_t;
+        
+            /**
+             * Implements a fixed bucket latency histogram (microseconds).
+             */
+            class histogram
+            {
+                public:
+                
+                    /**
+                     * Constructor
+                     */
+                    histogram()
+                    {
+                        for (auto & i : m_shards)
+                        {
+                            for (auto & j : i.counts)
+                            {
+                                j = 0;
+                            }
+                            
+                            i.sum = 0;
+                        }
+                    }
+                
+                    /**
+                     * Records an observation.
+                     * @param microseconds The latency in microseconds.
+                     */
+                    void observe(const std::uint64_t & microseconds)
+                    {
+                        std::size_t bucket = 0;
+                        
+                        auto val = microseconds;
+                        
+                        while (val > 0 && bucket < buckets - 1)
+                        {
+                            val >>= 1;
+                            
+                            bucket++;
+                        }
+                        
+                        auto & s = m_shards[shard()];
+                        
+                        s.counts[bucket].fetch_add(
+                            1, std::memory_order_relaxed
+                        );
+                        s.sum.fetch_add(
+                            microseconds, std::memory_order_relaxed
+                        );
+                    }
+                
+                    /**
+                     * Takes a snapshot.
+                     */
+                    histogram_snapshot_t snapshot() const
+                    {
+                        histogram_snapshot_t ret;
+                        
+                        ret.count = 0;
+                        ret.sum = 0;
+                        
+                        for (auto i = 0; i < buckets; i++)
+                        {
+                            ret.counts[i] = 0;
+                            
+                            for (auto & j : m_shards)
+                            {
+                                ret.counts[i] += j.counts[i].load(
+                                    std::memory_order_relaxed
+                                );
+                            }
+                            
+                            ret.count += ret.counts[i];
+                        }
+                        
+                        for (auto & i : m_shards)
+                        {
+                            ret.sum += i.sum.load(std::memory_order_relaxed);
+                        }
+                        
+                        return ret;
+                    }
+                
+                private:
+                
+                    /**
+                     * A shard.
+                     */
+                    typedef struct
+                    {
+                        std::atomic<std::uint64_t> counts[buckets];
+                        std::atomic<std::uint64_t> sum;
+                        char padding[64 - sizeof(std::uint64_t)];
+                    } shard_t;
+                
+                    /**
+                     * The shards.
+                     */
+                    shard_t m_shards[shards];
+                
+                protected:
+                
+                    // ...
+            };
+        
+            /**
+             * Records the lifetime of the scope into a histogram.
+             */
+            class scoped_timer
+            {
+                public:
+                
+                    /**
+                     * Constructor
+                     * @param h The histogram.
+                     */
+                    explicit scoped_timer(histogram & h)
+                        : histogram_(h)
+                        , time_start_(std::chrono::steady_clock::now())
+                    {
+                        // ...
+                    }
+                
+                    /**
+                     * Destructor
+                     */
+                    ~scoped_timer()
+                    {
+                        histogram_.observe(
+                            std::chrono::duration_cast<
+                            std::chrono::microseconds> (
+                            std::chrono::steady_clock::now() - time_start_
+                            ).count()
+                        );
+                    }
+                
+                private:
+                
+                    // ...
+                
+                protected:
+                
+                    /**
+                     * The histogram.
+                     */
+                    histogram & histogram_;
+                
+                    /**
+                     * The start time.
+                     */
+                    std::chrono::steady_clock::time_point time_start_;
+            };
+        
+            /**
+             * The singleton accessor.
+             */
+            static metrics & instance();
+        
+            /**
+             * Gets (creating if needed) a counter, the reference remains
+             * valid for the lifetime of the process.
+             * @param name The name.
+             */
+            counter & get_counter(const std::string & name);
+        
+            /**
+             * Gets (creating if needed) a histogram, the reference remains
+             * valid for the lifetime of the process.
+             * @param name The name.
+             */
+            histogram & get_histogram(const std::string & name);
+        
+            /**
+             * The values of all counters by name.
+             */
+            std::map<std::string, std::uint64_t> counters();
+        
+            /**
+             * The snapshots of all histograms by name.
+             */
+            std::map<std::string, histogram_snapshot_t> histograms();
+        
+            /**
+             * Formats all metrics in the Prometheus text exposition format.
+             */
+            std::string to_prometheus();
+        
+        private:
+        
+            /**
+             * The shard of the calling thread.
+             */
+            static std::size_t shard()
+            {
+                return
+                    std::hash<std::thread::id>()(std::this_thread::get_id()) %
+                    shards
+                ;
+            }
+        
+            /**
+             * The counters.
+             */
+            std::map<std::string, std::unique_ptr<counter> > m_counters;
+        
+            /**
+             * The histograms.
+             */
+            std::map<std::string, std::unique_ptr<histogram> > m_histograms;
+        
+        protected:
+        
+            /**
+             * The std::mutex.
+             */
+            std::mutex mutex_;
+    };
+    
+} // namespace coin
+
+#endif // COIN_METRICS_HPP
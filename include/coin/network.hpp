@@ -71,6 +71,12 @@ namespace coin {
              * The maximum number of inbound TCP connections.
              */
             enum { tcp_inbound_maximum = 128 };
+        
+            /**
+             * The maximum number of TCP (network) io threads, zero selects
+             * the number from the hardware concurrency.
+             */
+            enum { tcp_threads_maximum = 16 };
     
             /**
              * rfc1123 time.
@@ -36,6 +36,7 @@ namespace coin {
 
 class alert;
 class block;
+class block_compact;
 class block_merkle;
 class block_locator;
 class chainblender_broadcast;
@@ -71,6 +72,11 @@ namespace protocol {
          */
         enum { default_tcp_port = 9194 };
     
+        /**
+         * The default peer port of a regression test chain.
+         */
+        enum { default_tcp_port_regtest = 19194 };
+    
         /**
          * The default rpc port.
          */
@@ -101,6 +107,12 @@ namespace protocol {
             operation_mode_0x80 = 0x80,
         } operation_mode_t;
         
+        /**
+         * The (version) service bit advertising support for compact block
+         * relay (cmpctblock, getblocktxn and blocktxn).
+         */
+        enum { service_compact_blocks = operation_mode_0x02 };
+        
         /**
          * Ihe ipv4 mapped prefix.
          */
@@ -806,6 +818,32 @@ namespace protocol {
             std::shared_ptr<block_merkle> merkleblock;
         } merkleblock_t;
     
+        /**
+         * The cmpctblock structure.
+         */
+        typedef struct
+        {
+            std::shared_ptr<block_compact> cmpctblock;
+        } cmpctblock_t;
+    
+        /**
+         * The getblocktxn structure.
+         */
+        typedef struct
+        {
+            sha256 hash_block;
+            std::vector<std::uint32_t> indexes;
+        } getblocktxn_t;
+    
+        /**
+         * The blocktxn structure.
+         */
+        typedef struct
+        {
+            sha256 hash_block;
+            std::vector< std::shared_ptr<transaction> > transactions;
+        } blocktxn_t;
+    
         /**
          * The ztlock structure.
          */
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_RELAY_CACHE_HPP
+#define COIN_RELAY_CACHE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <coin/inventory_vector.hpp>
+
+namespace coin {
+
+    class data_buffer;
+    
+    /**
+     * Implements a time-expiring cache of relayed messages. Each message is
+     * encoded once and shared (read-only) by every tcp_connection that
+     * pushes it or serves it in response to a getdata. It is ok for this to
+     * be a singleton even in the presence of multiple instances in the same
+     * memory space.
+     */
+    class relay_cache
+    {
+        public:
+        
+            /**
+             * The number of seconds a relayed message is kept.
+             */
+            enum { expiration_interval = 15 * 60 };
+        
+            /**
+             * Constructor
+             */
+            relay_cache();
+        
+            /**
+             * The singleton accessor.
+             */
+            static relay_cache & instance();
+        
+            /**
+             * Inserts a relayed message, the original serialized payload is
+             * kept if one already exists so newer versions are preserved.
+             * @param inv The inventory_vector.
+             * @param buffer The (serialized) payload.
+             * @return The encoded message.
+             */
+            std::shared_ptr<const std::vector<char> > insert(
+                const inventory_vector & inv, const data_buffer & buffer
+            );
+        
+            /**
+             * Finds an encoded message.
+             * @param inv The inventory_vector.
+             * @return The encoded message or nullptr if not found.
+             */
+            std::shared_ptr<const std::vector<char> > find(
+                const inventory_vector & inv
+            );
+        
+            /**
+             * Clears all relayed messages.
+             */
+            void clear();
+        
+            /**
+             * The number of relayed messages.
+             */
+            std::size_t size();
+        
+            /**
+             * The number of relayed message expirations.
+             */
+            std::size_t expirations_size();
+        
+        private:
+        
+            /**
+             * Expires old relayed messages.
+             */
+            void expire();
+        
+            /**
+             * The encoded messages.
+             */
+            std::map<
+                inventory_vector, std::shared_ptr<const std::vector<char> >
+            > m_messages;
+        
+            /**
+             * The relayed message expirations.
+             */
+            std::deque<
+                std::pair<std::int64_t, inventory_vector>
+            > m_expirations;
+        
+        protected:
+        
+            /**
+             * The std::mutex.
+             */
+            std::mutex mutex_;
+    };
+    
+} // namespace coin
+
+#endif // COIN_RELAY_CACHE_HPP
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_ROLLING_BLOOM_FILTER_HPP
+#define COIN_ROLLING_BLOOM_FILTER_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace coin {
+
+    /**
+     * Implements a rolling bloom filter. The filter remembers (at least) the
+     * most recent elements inserted into it using a fixed amount of memory,
+     * older elements are forgotten a generation at a time. Each bit
+     * position is a two bit generation number spread across a pair of
+     * 64-bit words, a generation of zero means the bit is not set.
+     */
+    class rolling_bloom_filter
+    {
+        public:
+        
+            /**
+             * The maximum hash funcs.
+             */
+            enum { max_hash_funcs = 50 };
+        
+            /**
+             * Constructor
+             * @param elements The (minimum) number of elements remembered.
+             * @param fprate The (false positive) fprate.
+             */
+            rolling_bloom_filter(
+                const std::uint32_t & elements, const double & fprate
+            );
+        
+            /**
+             * Inserts into the filter.
+             * @param buf The buffer.
+             * @param len The length.
+             */
+            void insert(const std::uint8_t * buf, const std::size_t & len);
+        
+            /**
+             * Inserts into the filter.
+             * @param data The data.
+             */
+            void insert(const std::vector<std::uint8_t> & data);
+        
+            /**
+             * Checks if the filter contains the data.
+             * @param buf The buffer.
+             * @param len The length.
+             */
+            bool contains(
+                const std::uint8_t * buf, const std::size_t & len
+            ) const;
+        
+            /**
+             * Checks if the filter contains the data.
+             * @param data The data.
+             */
+            bool contains(const std::vector<std::uint8_t> & data) const;
+        
+            /**
+             * Clears the filter and chooses a new tweak.
+             */
+            void reset();
+        
+            /**
+             * The number of bytes used by the filter.
+             */
+            std::size_t size() const;
+        
+            /**
+             * Runs test case.
+             */
+            static int run_test();
+        
+        private:
+        
+            /**
+             * Performs murmur3 hash over the data given hashes.
+             * @param hashes The number of hashes.
+             * @param buf The buffer.
+             * @param len The length.
+             */
+            std::uint32_t hash(
+                const std::uint32_t & hashes, const std::uint8_t * buf,
+                const std::size_t & len
+            ) const;
+        
+            /**
+             * The number of elements per generation.
+             */
+            std::uint32_t m_elements_per_generation;
+        
+            /**
+             * The number of elements inserted into the current generation.
+             */
+            std::uint32_t m_elements_this_generation;
+        
+            /**
+             * The current generation (1, 2 or 3).
+             */
+            std::uint32_t m_generation;
+        
+            /**
+             * The number of hash funcs.
+             */
+            std::uint32_t m_hash_funcs;
+        
+            /**
+             * The tweak.
+             */
+            std::uint32_t m_tweak;
+        
+            /**
+             * The data.
+             */
+            std::vector<std::uint64_t> m_data;
+        
+        protected:
+        
+            // ...
+    };
+    
+} // namespace coin
+
+#endif // COIN_ROLLING_BLOOM_FILTER_HPP
@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <map>
 #include <string>
+#include <vector>
 
 #include <boost/asio.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -40,8 +41,10 @@
 
 namespace coin {
 
+    class rpc_json_writer;
     class stack_impl;
     class rpc_transport;
+    class script;
     
     /**
      * Implements an RPC connection.
@@ -102,6 +105,12 @@ namespace coin {
                 boost::property_tree::ptree result;
                 boost::property_tree::ptree error;
                 std::string id;
+                
+                /**
+                 * The result already encoded by rpc_json_writer, if not
+                 * empty it is sent in place of result.
+                 */
+                std::string result_json;
             } json_rpc_response_t;
         
             /**
@@ -317,6 +326,28 @@ namespace coin {
                 const std::vector<json_rpc_response_t> & responses
             );
         
+            /**
+             * Writes a JSON-RPC response object.
+             * @param writer The rpc_json_writer.
+             * @param response The json_rpc_response_t.
+             */
+            void write_json_rpc_response(
+                rpc_json_writer & writer, const json_rpc_response_t & response
+            );
+        
+            /**
+             * Writes an HTTP response with the given JSON body to the
+             * transport.
+             * @param body The body.
+             * @param close_after_writes If true the transport is closed after
+             * the response is written.
+             * @param content_type The Content-Type header value.
+             */
+            bool send_http_response(
+                const std::string & body, const bool & close_after_writes,
+                const std::string & content_type = "application/json"
+            );
+        
             /**
              * Performs a backupwallet operation.
              * @param request The json_rpc_request_t.
@@ -414,6 +445,30 @@ namespace coin {
                 const json_rpc_request_t & request
             );
         
+            /**
+             * Encodes getaddressbalance data into JSON format.
+             * @param request The json_rpc_request_t.
+             */
+            json_rpc_response_t json_getaddressbalance(
+                const json_rpc_request_t & request
+            );
+        
+            /**
+             * Encodes getaddresstxids data into JSON format.
+             * @param request The json_rpc_request_t.
+             */
+            json_rpc_response_t json_getaddresstxids(
+                const json_rpc_request_t & request
+            );
+        
+            /**
+             * Encodes getaddressutxos data into JSON format.
+             * @param request The json_rpc_request_t.
+             */
+            json_rpc_response_t json_getaddressutxos(
+                const json_rpc_request_t & request
+            );
+        
             /**
              * Encodes getbalance data into JSON format.
              * @param request The json_rpc_request_t.
@@ -480,6 +535,14 @@ namespace coin {
              */
             boost::property_tree::ptree json_getinfo();
         
+            /**
+             * Encodes the metrics registry into JSON format.
+             * @param request The json_rpc_request_t.
+             */
+            json_rpc_response_t json_getmetrics(
+                const json_rpc_request_t & request
+            );
+        
             /**
              * Encodes getmininginfo data into JSON format.
              * @param request The json_rpc_request_t.
@@ -657,46 +720,68 @@ namespace coin {
             );
         
             /**
-             * Encodes a transaction_wallet into a boost::property_tree::ptree.
-             * @param wtx The transaction_wallet.
+             * Encodes a list of received addresses/accounts.
+             * @param minimim_depth The minimum depth in the main chain.
+             * @param include_empty If true includes empty.
+             * @param by_accounts If true list is by accounts.
              */
-            boost::property_tree::ptree transaction_wallet_to_ptree(
-                const transaction_wallet & wtx
+            boost::property_tree::ptree received_to_ptree(
+                const std::int32_t & minimim_depth, const bool & include_empty,
+                const bool & by_accounts
             );
-
+        
             /**
-             * Encodes a transaction into a boost::property_tree::ptree.
+             * Encodes a transaction_wallet into the current object of the
+             * rpc_json_writer.
+             * @param writer The rpc_json_writer.
              * @param wtx The transaction_wallet.
+             */
+            void transaction_wallet_to_json(
+                rpc_json_writer & writer, const transaction_wallet & wtx
+            );
+        
+            /**
+             * Encodes a transaction into the current object of the
+             * rpc_json_writer.
+             * @param writer The rpc_json_writer.
+             * @param tx The transaction.
              * @param hash_block The hash of the block.
              */
-            boost::property_tree::ptree transaction_to_ptree(
-                const transaction & tx, const sha256 & hash_block
+            void transaction_to_json(
+                rpc_json_writer & writer, const transaction & tx,
+                const sha256 & hash_block
             );
-    
+        
             /**
              * Encodes transactions in the given account and at the minimum
-             * depth into a boost::property_tree::ptree.
+             * depth, each entry as a JSON object.
+             * @param entries The encoded entries (out).
              * @param wtx The transaction_wallet.
              * @param account The account.
              * @param minimim_depth The minimum depth in the main chain.
              * @param include_transactions It true transactions will be
              * included.
              */
-            boost::property_tree::ptree transactions_to_ptree(
+            void transactions_to_json(
+                std::vector<std::string> & entries,
                 const transaction_wallet & wtx, const std::string & account,
                 const std::uint32_t & minimim_depth,
                 const bool & include_transactions
             );
-
+        
             /**
-             * Encodes a list of received addresses/accounts.
-             * @param minimim_depth The minimum depth in the main chain.
-             * @param include_empty If true includes empty.
-             * @param by_accounts If true list is by accounts.
+             * Parses the address and (optional) height range parameters of
+             * the address index methods.
+             * @param request The json_rpc_request_t.
+             * @param script_public_key The script of the address (out).
+             * @param height_start The first height (out).
+             * @param height_end The last height (out).
+             * @param error The error object (out).
              */
-            boost::property_tree::ptree received_to_ptree(
-                const std::int32_t & minimim_depth, const bool & include_empty,
-                const bool & by_accounts
+            bool parse_address_index_params(
+                const json_rpc_request_t & request, script & script_public_key,
+                std::int32_t & height_start, std::int32_t & height_end,
+                boost::property_tree::ptree & error
             );
         
             /**
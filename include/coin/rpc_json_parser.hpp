@@ -21,6 +21,7 @@
 #ifndef COIN_RPC_JSON_PARSER_HPP
 #define COIN_RPC_JSON_PARSER_HPP
 
+#include <sstream>
 #include <string>
 
 #include <boost/property_tree/ptree.hpp>
@@ -64,7 +65,25 @@ namespace coin {
                     stream, pt, std::string(), pretty
                 );
             }
-    
+
+            /**
+             * Writes a (possibly scalar) ptree as a JSON value without a
+             * trailing newline so it can be embedded by rpc_json_writer.
+             * @param pt The ptree.
+             */
+            template<class Ptree>
+            static std::basic_string<typename Ptree::key_type::value_type>
+                write_json_value(const Ptree & pt)
+            {
+                std::basic_stringstream<
+                    typename Ptree::key_type::value_type
+                > stream;
+
+                write_json_helper(stream, pt, 0, false);
+
+                return stream.str();
+            }
+
         private:
         
             // ...
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_RPC_JSON_WRITER_HPP
+#define COIN_RPC_JSON_WRITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace coin {
+
+    /**
+     * Implements a streaming JSON writer that encodes directly into a
+     * caller owned buffer. Unlike boost::property_tree it does not allocate
+     * a node per field, numbers are written in their native type and
+     * hexadecimal encoding is performed in place.
+     */
+    class rpc_json_writer
+    {
+        public:
+
+            /**
+             * Constructor
+             * @param buffer The buffer to append to.
+             */
+            explicit rpc_json_writer(std::string & buffer);
+
+            /**
+             * Begins an object (as an array element or top-level value).
+             */
+            void begin_object();
+
+            /**
+             * Begins an object member that is an object.
+             * @param key The key.
+             */
+            void begin_object(const char * key);
+
+            /**
+             * Ends an object.
+             */
+            void end_object();
+
+            /**
+             * Begins an array (as an array element or top-level value).
+             */
+            void begin_array();
+
+            /**
+             * Begins an object member that is an array.
+             * @param key The key.
+             */
+            void begin_array(const char * key);
+
+            /**
+             * Ends an array.
+             */
+            void end_array();
+
+            /**
+             * Writes a string value.
+             * @param val The value.
+             */
+            void write_string(const std::string & val);
+
+            /**
+             * Writes a string member.
+             * @param key The key.
+             * @param val The value.
+             */
+            void write_string(const char * key, const std::string & val);
+
+            /**
+             * Writes a signed number member.
+             * @param key The key.
+             * @param val The value.
+             */
+            void write_number(const char * key, const std::int64_t & val);
+
+            /**
+             * Writes an unsigned number member.
+             * @param key The key.
+             * @param val The value.
+             */
+            void write_number(const char * key, const std::uint64_t & val);
+
+            /**
+             * Writes a signed 32-bit number member.
+             * @param key The key.
+             * @param val The value.
+             */
+            void write_number(const char * key, const std::int32_t & val);
+
+            /**
+             * Writes an unsigned 32-bit number member.
+             * @param key The key.
+             * @param val The value.
+             */
+            void write_number(const char * key, const std::uint32_t & val);
+
+            /**
+             * Writes a floating point number member.
+             * @param key The key.
+             * @param val The value.
+             */
+            void write_number(const char * key, const double & val);
+
+            /**
+             * Writes a boolean member.
+             * @param key The key.
+             * @param val The value.
+             */
+            void write_bool(const char * key, const bool & val);
+
+            /**
+             * Writes bytes as a hexidecimal string value.
+             * @param begin The beginning of the bytes.
+             * @param end The end of the bytes.
+             */
+            template<typename T>
+            void write_hex(const T begin, const T end)
+            {
+                write_separator();
+
+                write_hex_internal(begin, end);
+            }
+
+            /**
+             * Writes bytes as a hexidecimal string member.
+             * @param key The key.
+             * @param begin The beginning of the bytes.
+             * @param end The end of the bytes.
+             */
+            template<typename T>
+            void write_hex(const char * key, const T begin, const T end)
+            {
+                write_key(key);
+
+                write_hex_internal(begin, end);
+            }
+
+            /**
+             * Writes an already encoded JSON value.
+             * @param json The JSON.
+             */
+            void write_raw(const std::string & json);
+
+            /**
+             * Writes an already encoded JSON member.
+             * @param key The key.
+             * @param json The JSON.
+             */
+            void write_raw(const char * key, const std::string & json);
+
+        private:
+
+            /**
+             * Writes a comma if the current scope already has a value.
+             */
+            void write_separator();
+
+            /**
+             * Writes a (separated) key.
+             * @param key The key.
+             */
+            void write_key(const char * key);
+
+            /**
+             * Writes an escaped and quoted string.
+             * @param val The value.
+             * @param len The length.
+             */
+            void write_escaped(const char * val, const std::size_t & len);
+
+            /**
+             * Writes bytes as a quoted hexidecimal string.
+             * @param begin The beginning of the bytes.
+             * @param end The end of the bytes.
+             */
+            template<typename T>
+            void write_hex_internal(const T begin, const T end)
+            {
+                static const char hexmap[16] =
+                {
+                    '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+                    'a', 'b', 'c', 'd', 'e', 'f'
+                };
+
+                auto offset = m_buffer.size();
+
+                /**
+                 * Resize once and encode into the buffer in place.
+                 */
+                m_buffer.resize(offset + ((end - begin) * 2) + 2);
+
+                m_buffer[offset++] = '"';
+
+                for (auto it = begin; it < end; ++it)
+                {
+                    auto val = static_cast<std::uint8_t> (*it);
+
+                    m_buffer[offset++] = hexmap[val >> 4];
+                    m_buffer[offset++] = hexmap[val & 15];
+                }
+
+                m_buffer[offset] = '"';
+            }
+
+            /**
+             * The buffer.
+             */
+            std::string & m_buffer;
+
+            /**
+             * If true (per scope) the next value must be preceded by a comma.
+             */
+            std::vector<bool> m_needs_separator;
+
+        protected:
+
+            // ...
+    };
+
+} // namespace coin
+
+#endif // COIN_RPC_JSON_WRITER_HPP
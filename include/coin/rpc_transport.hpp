@@ -25,6 +25,7 @@
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <vector>
 
 #if (defined __IPHONE_OS_VERSION_MAX_ALLOWED)
 #import <CFNetwork/CFSocketStream.h>
@@ -102,6 +103,13 @@ namespace coin {
              */
             void write(const char *, const std::size_t &);
         
+            /**
+             * Performs a write operation taking ownership of the buffer so
+             * that no further copies are made.
+             * @param buffer The buffer.
+             */
+            void write(std::vector<char> && buffer);
+        
             /**
              * The state.
              */
@@ -61,6 +61,11 @@ namespace coin {
                 sha256 hash, const std::vector<std::uint8_t>& signature,
                 const std::vector<std::uint8_t>& public_key
             );
+        
+            /**
+             * Removes all valid signatures.
+             */
+            void clear();
     
         private:
         
@@ -37,6 +37,7 @@
 #include <coin/db_wallet.hpp>
 #include <coin/point_out.hpp>
 #include <coin/sha256.hpp>
+#include <coin/uint256.hpp>
 
 namespace coin {
 
@@ -388,7 +389,7 @@ namespace coin {
             /**
              * The best chain trust.
              */
-            static big_number & get_best_chain_trust();
+            static uint256 & get_best_chain_trust();
         
             /**
              * The best invalid trust.
@@ -495,6 +496,12 @@ namespace coin {
              */
             void on_database_env();
         
+            /**
+             * Called periodically to re-encode the transaction indexes that
+             * are still in the legacy encoding.
+             */
+            void on_transaction_index_compact();
+        
             /**
              * The local endpoint.
              */
@@ -598,7 +605,7 @@ namespace coin {
             /**
              * The best chain trust.
              */
-            static big_number g_best_chain_trust;
+            static uint256 g_best_chain_trust;
         
             /**
              * The best invalid trust.
@@ -660,6 +667,11 @@ namespace coin {
              * The main loop.
              */
             void loop();
+        
+            /**
+             * The network loop (one per network thread).
+             */
+            void loop_network();
 
             /**
              * Checks for centrally hosted bootstrap peers.
@@ -682,6 +694,21 @@ namespace coin {
              */
             std::vector< std::shared_ptr<std::thread> > threads_;
         
+            /**
+             * The network boost::asio::io_service::work.
+             */
+            std::shared_ptr<boost::asio::io_service::work> work_network_;
+        
+            /**
+             * The network threads.
+             */
+            std::vector< std::shared_ptr<std::thread> > threads_network_;
+        
+            /**
+             * The chain_generator thread.
+             */
+            std::shared_ptr<std::thread> thread_chain_generator_;
+        
             /**
              * The std::recursive_mutex.
              */
@@ -715,6 +742,13 @@ namespace coin {
                 std::chrono::steady_clock
             > timer_database_env_;
         
+            /**
+             * The transaction index compaction timer.
+             */
+            boost::asio::basic_waitable_timer<
+                std::chrono::steady_clock
+            > timer_transaction_index_compact_;
+        
             /**
              * The (SPV) block_merkle's save timer.
              */
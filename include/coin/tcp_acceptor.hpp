@@ -42,12 +42,12 @@ namespace coin {
         
             /**
              * Constructor
-             * @param ios The boost::asio::io_service.
-             * @param s The boost::asio::strand.
+             * @param ios The boost::asio::io_service (usually
+             * globals::io_service_network).
+             * @note The accept handler is called on the acceptor's own
+             * boost::asio::strand.
              */
-            explicit tcp_acceptor(
-                boost::asio::io_service & ios, boost::asio::strand & s
-            );
+            explicit tcp_acceptor(boost::asio::io_service & ios);
         
             /**
              * Opens the tcp connector given port.
@@ -76,11 +76,8 @@ namespace coin {
             /**
              * Runs the test case.
              * @param ios The boost::asio::io_service.
-             * @param s The boost::asio::strand.
              */
-            static int run_test(
-                boost::asio::io_service & ios, boost::asio::strand & s
-            );
+            static int run_test(boost::asio::io_service & ios);
 
         private:
         
@@ -119,7 +116,7 @@ namespace coin {
             /**
              * The boost::asio::strand.
              */
-            boost::asio::strand & strand_;
+            boost::asio::strand strand_;
         
             /**
              * The boost::asio::ip::tcp::acceptor.
@@ -23,6 +23,7 @@
 
 #include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -32,6 +33,7 @@
 
 #include <coin/inventory_vector.hpp>
 #include <coin/protocol.hpp>
+#include <coin/rolling_bloom_filter.hpp>
 #include <coin/sha256.hpp>
 #include <coin/transaction_bloom_filter.hpp>
 
@@ -39,6 +41,7 @@ namespace coin {
     
     class alert;
     class block;
+    class block_compact;
     class block_index;
     class block_locator;
     class block_merkle;
@@ -111,6 +114,28 @@ namespace coin {
              */
             void stop_after(const std::uint32_t & interval);
         
+            /**
+             * The read statistics.
+             */
+            typedef struct
+            {
+                std::uint64_t reads;
+                std::uint64_t messages;
+            } read_statistics_t;
+        
+            /**
+             * The read statistics of all connections, the number of reads
+             * per message is reads / messages.
+             */
+            static read_statistics_t read_statistics();
+        
+            /**
+             * Updates the maximum length of a message read from the network
+             * (twice block::get_maximum_size_median220), it is called when
+             * the best block changes.
+             */
+            static void update_message_length_maximum();
+        
             /**
              * Sends a raw buffer.
              * @param buf The buffer.
@@ -118,6 +143,12 @@ namespace coin {
              */
             void send(const char * buf, const std::size_t & len);
         
+            /**
+             * Sends a shared (immutable) buffer without copying it.
+             * @param buffer The buffer.
+             */
+            void send(const std::shared_ptr<const std::vector<char> > & buffer);
+        
             /**
              * Sends an addr message.
              * @param local_address_only If true only the local address will
@@ -171,6 +202,16 @@ namespace coin {
                 const inventory_vector inv, const data_buffer buffer
             );
         
+            /**
+             * Sends a (relayed) encoded message from the relay_cache.
+             * @param inv The inventory_vector.
+             * @param buffer The encoded message.
+             */
+            void send_relayed_inv_message(
+                const inventory_vector & inv,
+                const std::shared_ptr<const std::vector<char> > & buffer
+            );
+        
             /**
              * Sends a getdata message by appending the inventory_vector to
              * the queue.
@@ -192,6 +233,17 @@ namespace coin {
              */
             void send_block_message(const block blk);
         
+            /**
+             * Sends an (encoded) cmpctblock message unless the remote node
+             * already knows of the block.
+             * @param hash_block The hash of the block.
+             * @param buffer The encoded message.
+             */
+            void send_cmpctblock_message(
+                const sha256 & hash_block,
+                const std::shared_ptr<const std::vector<char> > & buffer
+            );
+        
             /**
              * Sends a filterload message.
              * @param filter The transaction_bloom_filter.
@@ -252,6 +304,11 @@ namespace coin {
              */
             const std::uint64_t & protocol_version_services() const;
         
+            /**
+             * If true the remote node supports compact block relay.
+             */
+            bool is_compact_blocks_supported() const;
+        
             /**
              * The (remote) protocol version timestamp.
              */
@@ -615,12 +672,24 @@ namespace coin {
             );
         
             /**
-             * Sends a (relayed) encoded inv given command.
-             * @param command The command.
-             * @param
+             * Sends a (relayed) encoded message or queues its
+             * inventory_vector for the next inv announcement.
+             * @param inv The inventory_vector.
+             * @param buffer The encoded message.
              */
             void do_send_relayed_inv_message(
-                const inventory_vector & inv, const data_buffer & buffer
+                const inventory_vector & inv,
+                const std::shared_ptr<const std::vector<char> > & buffer
+            );
+        
+            /**
+             * The inv announcement timer handler, sends the queued
+             * inventory_vector's the remote node has not seen in a single
+             * inv message.
+             * @param ec The boost::system::error_code.
+             */
+            void do_send_inventory_announcements(
+                const boost::system::error_code & ec
             );
         
             /**
@@ -629,6 +698,34 @@ namespace coin {
              */
             void do_send_block_message(const block & blk);
         
+            /**
+             * Sends a block message using the encoded block as stored on
+             * disk (without decoding and re-encoding it).
+             * @param index The block_index.
+             */
+            bool do_send_block_message_raw(const block_index * index);
+        
+            /**
+             * Creates the block of a (fully reconstructed) block_compact and
+             * processes it, falling back to requesting the full block.
+             * @param cmpctblock The block_compact.
+             */
+            void do_process_block_compact(
+                const std::shared_ptr<block_compact> & cmpctblock
+            );
+        
+            /**
+             * Defers getdata inventory until the write queue drains.
+             * @param inventory The inventory_vector's.
+             */
+            void defer_getdata(const std::vector<inventory_vector> & inventory);
+        
+            /**
+             * The deferred getdata timer handler.
+             * @param ec The boost::system::error_code.
+             */
+            void do_getdata_deferred(const boost::system::error_code & ec);
+        
             /**
              * Sends getheaders if needed.
              * @param ec The boost::system::error_code.
@@ -655,9 +752,16 @@ namespace coin {
             /**
              * Inserts a seen inventor_vector object.
              * @param inv The inventory_vector.
+             * @return True if the inventory_vector was not seen before.
              */
             bool insert_inventory_vector_seen(const inventory_vector & inv);
         
+            /**
+             * Checks if an inventory_vector object has (probably) been seen.
+             * @param inv The inventory_vector.
+             */
+            bool is_inventory_vector_seen(const inventory_vector & inv) const;
+        
             /**
              * The identifier.
              */
@@ -830,7 +934,7 @@ namespace coin {
             /**
              * The read queue.
              */
-            std::deque<char> read_queue_;
+            std::vector<char> read_queue_;
         
             /**
              * The ping timer.
@@ -961,14 +1065,16 @@ namespace coin {
             > timer_spv_getblocks_timeout_;
 
             /**
-             * The seen inventory_vector object set.
+             * The number of (most recently) seen inventory_vector objects
+             * remembered.
              */
-            std::set<inventory_vector> inventory_vectors_seen_set_;
+            enum { inventory_vectors_seen_elements = 5000 };
         
             /**
-             * The seen inventory_vector object set.
+             * The seen inventory_vector object filter, its memory use is
+             * fixed (about 53 KiB at a false positive rate of 0.000001).
              */
-            std::deque<inventory_vector> inventory_vectors_seen_queue_;
+            rolling_bloom_filter inventory_vectors_seen_;
         
             /**
              * The isync timer.
@@ -981,6 +1087,66 @@ namespace coin {
              * If true we sent an isync message.
              */
             bool did_send_isync_;
+        
+            /**
+             * The number of deferred getdata inventory_vector's after which
+             * the peer is penalized for not reading the responses.
+             */
+            enum { getdata_deferred_maximum = protocol::max_inv_size * 4 };
+        
+            /**
+             * The getdata inventory_vector's deferred while the write queue
+             * is full.
+             */
+            std::vector<inventory_vector> getdata_deferred_;
+        
+            /**
+             * The deferred getdata timer.
+             */
+            boost::asio::basic_waitable_timer<
+                std::chrono::steady_clock
+            > timer_getdata_deferred_;
+        
+            /**
+             * The number of reads since the last complete message.
+             */
+            std::uint32_t reads_message_;
+        
+            /**
+             * The maximum number of block_compact's waiting on a blocktxn
+             * message.
+             */
+            enum { blocks_compact_pending_maximum = 3 };
+        
+            /**
+             * The block_compact's waiting on a blocktxn message by hash.
+             */
+            std::map<
+                sha256, std::shared_ptr<block_compact>
+            > blocks_compact_pending_;
+        
+            /**
+             * The inventory_vector's queued for the next inv announcement.
+             */
+            std::vector<inventory_vector> inventory_announcements_;
+        
+            /**
+             * The inv announcement timer.
+             */
+            boost::asio::basic_waitable_timer<
+                std::chrono::steady_clock
+            > timer_inventory_announcements_;
+        
+            /**
+             * The inv announcement interval range in milliseconds, the
+             * interval is randomized so the origin of a transaction cannot
+             * be inferred from its announcement timing.
+             */
+            enum
+            {
+                interval_inventory_announcements_min = 100,
+                interval_inventory_announcements_max = 500,
+            };
     };
     
 } // namespace coin
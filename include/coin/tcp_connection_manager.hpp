@@ -25,6 +25,7 @@
 #include <memory>
 #include <mutex>
 #include <set>
+#include <vector>
 
 #include <boost/asio.hpp>
 
@@ -32,6 +33,7 @@
 
 namespace coin {
 
+    class inventory_vector;
     class message;
     class stack_impl;
     class tcp_connection;
@@ -71,7 +73,8 @@ namespace coin {
             void handle_accept(std::shared_ptr<tcp_transport> transport);
         
             /**
-             * Broadcasts a message to all connected peers.
+             * Broadcasts a message to all connected peers, the message is
+             * copied once into a buffer shared by all of them.
              * @param buf The buffer.
              * @param len The length.
              */
@@ -87,6 +90,20 @@ namespace coin {
                 const char * buf, const std::size_t & len
             );
         
+            /**
+             * Relays an (encoded) message to all connected peers, peers that
+             * have not seen it are either sent the message or have its
+             * inventory_vector queued for the next inv announcement.
+             * @param inv The inventory_vector.
+             * @param buffer The encoded message.
+             * @param bip0037 If true skip bip0037 peers with relay = false.
+             */
+            void relay_inv(
+                const inventory_vector & inv,
+                const std::shared_ptr<const std::vector<char> > & buffer,
+                const bool & bip0037
+            );
+        
             /**
              * The tcp connections.
              */
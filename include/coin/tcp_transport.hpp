@@ -23,9 +23,11 @@
 
 #define USE_TLS 1
 
+#include <atomic>
 #include <cstdint>
 #include <deque>
 #include <memory>
+#include <vector>
 
 #if (defined __IPHONE_OS_VERSION_MAX_ALLOWED)
 #import <CFNetwork/CFSocketStream.h>
@@ -56,16 +58,46 @@ namespace coin {
                 state_connected,
             } state_t;
 
+            /**
+             * The maximum number of queued buffers sent by a single
+             * (gathering) write operation.
+             */
+            enum { write_coalesce_max = 64 };
+        
+            /**
+             * The number of queued bytes at which the write queue is
+             * considered full and callers should stop queueing bulk data.
+             */
+            enum { write_queue_bytes_full = 4 * 1024 * 1024 };
+        
+            /**
+             * The number of queued bytes at which the transport is closed.
+             */
+            enum { write_queue_bytes_max = 64 * 1024 * 1024 };
+        
+            /**
+             * The minimum (and initial) size of the read buffer.
+             */
+            enum { read_buffer_length_min = 1024 };
+        
+            /**
+             * The maximum size of the read buffer.
+             */
+            enum { read_buffer_length_max = 256 * 1024 };
+
             /**
              * Constructor
-             * @param ios The boost::asio::io_service.
-             * @param s The boost::asio::strand.
+             * @param ios The boost::asio::io_service (usually
+             * globals::io_service_network).
              * @pram use_static_ssl_context If true the connection is most
              * likely incoming and will use a staticially allocated 
              * boost::asio::ssl::context.
+             * @note The handlers run on the transport's own
+             * boost::asio::strand so the handlers of different transports
+             * may run concurrently.
              */
             tcp_transport(
-                boost::asio::io_service & ios, boost::asio::strand & s,
+                boost::asio::io_service & ios,
                 const bool & use_static_ssl_context = true
             );
         
@@ -94,6 +126,13 @@ namespace coin {
              */
             void stop();
         
+            /**
+             * Stops the transport then calls f on its boost::asio::strand
+             * (after any read callback in progress has returned).
+             * @param f The std::function.
+             */
+            void stop(const std::function<void ()> & f);
+        
             /**
              * Sets the on read handler.
              * @param f the std::function.
@@ -110,10 +149,38 @@ namespace coin {
              */
             void write(const char *, const std::size_t &);
         
+            /**
+             * Performs a write operation without copying the buffer, the
+             * same buffer may be queued on any number of transports.
+             * @param buffer The (immutable) buffer.
+             */
+            void write(
+                const std::shared_ptr<const std::vector<char> > & buffer
+            );
+        
+            /**
+             * The number of bytes queued for writing.
+             */
+            std::size_t write_queue_bytes() const;
+        
+            /**
+             * If true the write queue has reached write_queue_bytes_full.
+             */
+            bool is_write_queue_full() const;
+        
+            /**
+             * Sets the number of bytes the reader expects next (the remainder
+             * of a partially received message), the next read is sized
+             * toward it (up to read_buffer_length_max) and does not complete
+             * until it has arrived.
+             * @param val The value.
+             */
+            void set_read_hint(const std::size_t & val);
+        
             /**
              * The state.
              */
-            state_t & state();
+            state_t state() const;
         
             /**
              * Sets the identifier.
@@ -172,6 +239,23 @@ namespace coin {
         
         private:
         
+            /**
+             * Starts the transport (outgoing) on the boost::asio::strand.
+             */
+            void do_start(
+                const std::string & hostname, const std::uint16_t & port
+            );
+        
+            /**
+             * Starts the transport (incoming) on the boost::asio::strand.
+             */
+            void do_start();
+        
+            /**
+             * Stops the transport on the boost::asio::strand.
+             */
+            void do_stop();
+        
             /**
              * do_connect
              */
@@ -188,9 +272,10 @@ namespace coin {
             void do_read();
         
             /**
-             * do_write
+             * Writes (up to write_coalesce_max of) the queued buffers with a
+             * single gathering write operation.
              */
-            void do_write(const char * buf, const std::size_t & len);
+            void do_write();
         
             /**
              * The identifier.
@@ -198,9 +283,9 @@ namespace coin {
             std::string m_identifier;
         
             /**
-             * The state.
+             * The state (read from threads other than the strand's).
              */
-            state_t m_state;
+            std::atomic<state_t> m_state;
 #if (defined USE_TLS && USE_TLS)
             /**
              * The boost::asio::ssl::context.
@@ -223,7 +308,7 @@ namespace coin {
              * If true the conneciton will close as soon as it's write queue is
              * exhausted.
              */
-            bool m_close_after_writes;
+            std::atomic<bool> m_close_after_writes;
         
             /**
              * The read timeout.
@@ -244,6 +329,21 @@ namespace coin {
              * The time of the last write.
              */
             std::time_t m_time_last_write;
+        
+            /**
+             * The number of bytes queued for writing.
+             */
+            std::atomic<std::size_t> m_write_queue_bytes;
+        
+            /**
+             * The number of queued buffers being written.
+             */
+            std::size_t m_write_queue_in_progress;
+        
+            /**
+             * The number of bytes the reader expects next.
+             */
+            std::size_t m_read_hint;
     
             /**
              * The completion handler.
@@ -275,7 +375,7 @@ namespace coin {
             /**
              * The boost::asio::strand.
              */
-            boost::asio::strand & strand_;
+            boost::asio::strand strand_;
 
             /**
              * The connect timeout timer.
@@ -301,12 +401,14 @@ namespace coin {
             /**
              * The write queue.
              */
-            std::deque< std::vector<char> > write_queue_;
+            std::deque<
+                std::shared_ptr<const std::vector<char> >
+            > write_queue_;
         
             /**
              * The read buffer.
              */
-            char read_buffer_[1024];
+            std::vector<char> read_buffer_;
         
 #if (defined __IPHONE_OS_VERSION_MAX_ALLOWED)
             /**
@@ -21,6 +21,7 @@
 #ifndef COIN_TIME_HPP
 #define COIN_TIME_HPP
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <set>
@@ -72,6 +73,16 @@ namespace coin {
                 > (std::time(0)) + m_time_offset;
             }
         
+            /**
+             * Advances the adjusted time (only used on a regression test
+             * chain which generates blocks faster than the clock).
+             * @param seconds The number of seconds.
+             */
+            void advance(const std::uint64_t & seconds)
+            {
+                m_time_offset += seconds;
+            }
+        
             /**
              * Adds a peer's timestamp.
              * @param addr The protocol::network_address_t.
@@ -165,7 +176,7 @@ namespace coin {
             /**
              * The time offset.
              */
-            std::uint64_t m_time_offset;
+            std::atomic<std::uint64_t> m_time_offset;
         
         protected:
         
@@ -38,6 +38,15 @@ namespace coin {
     {
         public:
         
+            /**
+             * The version flag of the compact encoding where positions are
+             * variable length and only the spent outputs have a position.
+             * It is only written when database.compact_transaction_index is
+             * enabled, older versions misdecode it so once records are
+             * converted downgrading is not supported.
+             */
+            enum { version_flag_compact = 0x80000000 };
+        
             /**
              * Constructor
              */
@@ -85,6 +94,17 @@ namespace coin {
              */
             bool is_null();
     
+            /**
+             * If true all of the outputs have been spent.
+             */
+            bool is_spent() const;
+        
+            /**
+             * If true the (encoded) version is of the compact encoding.
+             * @param version The version.
+             */
+            static bool is_encoding_compact(const std::uint32_t & version);
+        
             /**
              * Gets the depth in the main chain.
              */
@@ -122,9 +142,32 @@ namespace coin {
             {
                 return !(lhs == rhs);
             }
+        
+            /**
+             * Runs test case.
+             */
+            static int run_test();
     
         private:
         
+            /**
+             * Encodes a transaction_position using variable length integers.
+             * @param buffer The data_buffer.
+             * @param position The transaction_position.
+             */
+            static void encode_position(
+                data_buffer & buffer, const transaction_position & position
+            );
+        
+            /**
+             * Decodes a transaction_position using variable length integers.
+             * @param buffer The data_buffer.
+             * @param position The transaction_position.
+             */
+            static void decode_position(
+                data_buffer & buffer, transaction_position & position
+            );
+        
             /**
              * The transaction position.
              */
@@ -0,0 +1,592 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COIN_UINT256_HPP
+#define COIN_UINT256_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <coin/sha256.hpp>
+
+namespace coin {
+
+    class big_number;
+    
+    /**
+     * Implements a fixed width unsigned 256-bit integer for the consensus
+     * arithmetic (proof-of-work targets, chain trust and kernel hashes)
+     * without the heap allocations of big_number. Arithmetic wraps modulo
+     * 2^256.
+     */
+    class uint256
+    {
+        public:
+        
+            /**
+             * The number of 32-bit words.
+             */
+            enum { words = 8 };
+        
+            /**
+             * Constructor
+             */
+            constexpr uint256()
+                : m_words{0, 0, 0, 0, 0, 0, 0, 0}
+            {
+                // ...
+            }
+        
+            /**
+             * Constructor
+             * @param val The value.
+             */
+            constexpr uint256(const std::uint64_t val)
+                : m_words{
+                    static_cast<std::uint32_t> (val),
+                    static_cast<std::uint32_t> (val >> 32), 0, 0, 0, 0, 0, 0
+                }
+            {
+                // ...
+            }
+        
+            /**
+             * Constructor
+             * @param val The sha256 (interpreted as sha256 compares it).
+             */
+            explicit uint256(const sha256 & val)
+            {
+                std::memcpy(m_words, val.digest(), sizeof(m_words));
+            }
+        
+            /**
+             * Constructor
+             * @param val The big_number (truncated to 256 bits).
+             */
+            explicit uint256(const big_number & val);
+        
+            /**
+             * Gets the sha256 representation.
+             */
+            sha256 get_sha256() const
+            {
+                sha256 ret;
+                
+                std::memcpy(ret.digest(), m_words, sizeof(m_words));
+                
+                return ret;
+            }
+        
+            /**
+             * Sets the value from the compact representation used for
+             * proof-of-work and proof-of-stake targets.
+             * @param val The compact value.
+             * @param negative Set to true if the sign bit is set.
+             * @param overflow Set to true if the value exceeds 256 bits.
+             */
+            uint256 & set_compact(
+                const std::uint32_t & val, bool * negative = 0,
+                bool * overflow = 0
+                )
+            {
+                auto size = static_cast<int> (val >> 24);
+                
+                std::uint32_t word = val & 0x007fffff;
+                
+                if (size <= 3)
+                {
+                    word >>= 8 * (3 - size);
+                    
+                    *this = word;
+                }
+                else
+                {
+                    *this = word;
+                    
+                    *this <<= 8 * (size - 3);
+                }
+                
+                if (negative)
+                {
+                    *negative = word != 0 && (val & 0x00800000) != 0;
+                }
+                
+                if (overflow)
+                {
+                    *overflow =
+                        word != 0 && ((size > 34) ||
+                        (word > 0xff && size > 33) ||
+                        (word > 0xffff && size > 32))
+                    ;
+                }
+                
+                return *this;
+            }
+        
+            /**
+             * Gets the compact representation.
+             */
+            std::uint32_t get_compact() const
+            {
+                auto size = (bits() + 7) / 8;
+                
+                std::uint32_t ret = 0;
+                
+                if (size <= 3)
+                {
+                    ret = static_cast<std::uint32_t> (
+                        get_low64() << 8 * (3 - size)
+                    );
+                }
+                else
+                {
+                    ret = static_cast<std::uint32_t> (
+                        (*this >> 8 * (size - 3)).get_low64()
+                    );
+                }
+                
+                /**
+                 * If the sign bit is set divide the mantissa by 256 and
+                 * increase the exponent.
+                 */
+                if (ret & 0x00800000)
+                {
+                    ret >>= 8;
+                    
+                    size++;
+                }
+                
+                return ret | static_cast<std::uint32_t> (size) << 24;
+            }
+        
+            /**
+             * The number of significant bits.
+             */
+            std::uint32_t bits() const
+            {
+                for (auto i = words - 1; i >= 0; i--)
+                {
+                    if (m_words[i])
+                    {
+                        for (auto j = 31; j > 0; j--)
+                        {
+                            if (m_words[i] & 1U << j)
+                            {
+                                return 32 * i + j + 1;
+                            }
+                        }
+                        
+                        return 32 * i + 1;
+                    }
+                }
+                
+                return 0;
+            }
+        
+            /**
+             * The low 64 bits.
+             */
+            std::uint64_t get_low64() const
+            {
+                return
+                    m_words[0] | static_cast<std::uint64_t> (m_words[1]) << 32
+                ;
+            }
+        
+            /**
+             * The decimal std::string representation.
+             */
+            std::string to_string() const
+            {
+                std::string ret;
+                
+                uint256 val = *this;
+                
+                do
+                {
+                    /**
+                     * Divide by ten in place keeping the remainder.
+                     */
+                    std::uint64_t remainder = 0;
+                    
+                    for (auto i = words - 1; i >= 0; i--)
+                    {
+                        auto n = remainder << 32 | val.m_words[i];
+                        
+                        val.m_words[i] = static_cast<std::uint32_t> (n / 10);
+                        
+                        remainder = n % 10;
+                    }
+                    
+                    ret += static_cast<char> ('0' + remainder);
+                }
+                while (val != 0);
+                
+                std::reverse(ret.begin(), ret.end());
+                
+                return ret;
+            }
+        
+            /**
+             * operator ~
+             */
+            const uint256 operator ~ () const
+            {
+                uint256 ret;
+                
+                for (auto i = 0; i < words; i++)
+                {
+                    ret.m_words[i] = ~m_words[i];
+                }
+                
+                return ret;
+            }
+        
+            /**
+             * operator -
+             */
+            const uint256 operator - () const
+            {
+                uint256 ret = ~*this;
+                
+                ++ret;
+                
+                return ret;
+            }
+        
+            /**
+             * operator ++
+             */
+            uint256 & operator ++ ()
+            {
+                for (auto i = 0; i < words && ++m_words[i] == 0; i++)
+                {
+                    // ...
+                }
+                
+                return *this;
+            }
+        
+            /**
+             * operator +=
+             */
+            uint256 & operator += (const uint256 & b)
+            {
+                std::uint64_t carry = 0;
+                
+                for (auto i = 0; i < words; i++)
+                {
+                    std::uint64_t n = carry + m_words[i] + b.m_words[i];
+                    
+                    m_words[i] = static_cast<std::uint32_t> (n);
+                    
+                    carry = n >> 32;
+                }
+                
+                return *this;
+            }
+        
+            /**
+             * operator -=
+             */
+            uint256 & operator -= (const uint256 & b)
+            {
+                *this += -b;
+                
+                return *this;
+            }
+        
+            /**
+             * operator *=
+             */
+            uint256 & operator *= (const uint256 & b)
+            {
+                uint256 a;
+                
+                for (auto j = 0; j < words; j++)
+                {
+                    std::uint64_t carry = 0;
+                    
+                    for (auto i = 0; i + j < words; i++)
+                    {
+                        std::uint64_t n =
+                            carry + a.m_words[i + j] +
+                            static_cast<std::uint64_t> (m_words[j]) *
+                            b.m_words[i]
+                        ;
+                        
+                        a.m_words[i + j] = static_cast<std::uint32_t> (n);
+                        
+                        carry = n >> 32;
+                    }
+                }
+                
+                *this = a;
+                
+                return *this;
+            }
+        
+            /**
+             * operator /=
+             */
+            uint256 & operator /= (const uint256 & b)
+            {
+                uint256 div = b;
+                uint256 num = *this;
+                
+                *this = 0;
+                
+                auto num_bits = static_cast<int> (num.bits());
+                auto div_bits = static_cast<int> (div.bits());
+                
+                if (div_bits == 0)
+                {
+                    throw std::runtime_error("uint256 division by zero");
+                }
+                
+                if (div_bits > num_bits)
+                {
+                    return *this;
+                }
+                
+                auto shift = num_bits - div_bits;
+                
+                /**
+                 * Align the divisor with the numerator and subtract bit by
+                 * bit.
+                 */
+                div <<= shift;
+                
+                while (shift >= 0)
+                {
+                    if (num >= div)
+                    {
+                        num -= div;
+                        
+                        m_words[shift / 32] |= 1U << (shift & 31);
+                    }
+                    
+                    div >>= 1;
+                    
+                    shift--;
+                }
+                
+                return *this;
+            }
+        
+            /**
+             * operator <<=
+             */
+            uint256 & operator <<= (const std::uint32_t & shift)
+            {
+                uint256 a = *this;
+                
+                *this = 0;
+                
+                auto k = static_cast<int> (shift / 32);
+                
+                shift_bits(a, shift % 32, k, true);
+                
+                return *this;
+            }
+        
+            /**
+             * operator >>=
+             */
+            uint256 & operator >>= (const std::uint32_t & shift)
+            {
+                uint256 a = *this;
+                
+                *this = 0;
+                
+                auto k = static_cast<int> (shift / 32);
+                
+                shift_bits(a, shift % 32, k, false);
+                
+                return *this;
+            }
+        
+            friend inline const uint256 operator + (
+                uint256 a, const uint256 & b
+                )
+            {
+                return a += b;
+            }
+        
+            friend inline const uint256 operator - (
+                uint256 a, const uint256 & b
+                )
+            {
+                return a -= b;
+            }
+        
+            friend inline const uint256 operator * (
+                uint256 a, const uint256 & b
+                )
+            {
+                return a *= b;
+            }
+        
+            friend inline const uint256 operator / (
+                uint256 a, const uint256 & b
+                )
+            {
+                return a /= b;
+            }
+        
+            friend inline const uint256 operator << (
+                uint256 a, const std::uint32_t & shift
+                )
+            {
+                return a <<= shift;
+            }
+        
+            friend inline const uint256 operator >> (
+                uint256 a, const std::uint32_t & shift
+                )
+            {
+                return a >>= shift;
+            }
+        
+            /**
+             * Compares two values.
+             * @param a The uint256.
+             * @param b The uint256.
+             * @return -1, 0 or 1.
+             */
+            static int compare(const uint256 & a, const uint256 & b)
+            {
+                for (auto i = words - 1; i >= 0; i--)
+                {
+                    if (a.m_words[i] < b.m_words[i])
+                    {
+                        return -1;
+                    }
+                    else if (a.m_words[i] > b.m_words[i])
+                    {
+                        return 1;
+                    }
+                }
+                
+                return 0;
+            }
+        
+            friend inline bool operator == (
+                const uint256 & a, const uint256 & b
+                )
+            {
+                return compare(a, b) == 0;
+            }
+        
+            friend inline bool operator != (
+                const uint256 & a, const uint256 & b
+                )
+            {
+                return compare(a, b) != 0;
+            }
+        
+            friend inline bool operator < (const uint256 & a, const uint256 & b)
+            {
+                return compare(a, b) < 0;
+            }
+        
+            friend inline bool operator > (const uint256 & a, const uint256 & b)
+            {
+                return compare(a, b) > 0;
+            }
+        
+            friend inline bool operator <= (
+                const uint256 & a, const uint256 & b
+                )
+            {
+                return compare(a, b) <= 0;
+            }
+        
+            friend inline bool operator >= (
+                const uint256 & a, const uint256 & b
+                )
+            {
+                return compare(a, b) >= 0;
+            }
+        
+            /**
+             * Runs test case (cross checked against big_number).
+             */
+            static int run_test();
+        
+        private:
+        
+            /**
+             * Shifts the words of a into this.
+             * @param a The uint256.
+             * @param bits The bits to shift within a word.
+             * @param k The number of whole words to shift.
+             * @param left If true shifts left otherwise right.
+             */
+            void shift_bits(
+                const uint256 & a, const std::uint32_t & bits, const int & k,
+                const bool & left
+                )
+            {
+                for (auto i = 0; i < words; i++)
+                {
+                    if (left)
+                    {
+                        if (i + k + 1 < words && bits != 0)
+                        {
+                            m_words[i + k + 1] |= a.m_words[i] >> (32 - bits);
+                        }
+                        
+                        if (i + k < words)
+                        {
+                            m_words[i + k] |= a.m_words[i] << bits;
+                        }
+                    }
+                    else
+                    {
+                        if (i - k - 1 >= 0 && bits != 0)
+                        {
+                            m_words[i - k - 1] |= a.m_words[i] << (32 - bits);
+                        }
+                        
+                        if (i - k >= 0)
+                        {
+                            m_words[i - k] |= a.m_words[i] >> bits;
+                        }
+                    }
+                }
+            }
+        
+            /**
+             * The words (least significant first).
+             */
+            std::uint32_t m_words[words];
+        
+        protected:
+        
+            // ...
+    };
+    
+} // namespace coin
+
+#endif // COIN_UINT256_HPP
@@ -33,17 +33,23 @@ LOCAL_SRC_FILES := \
 	../src/accounting_entry.cpp \
 	../src/address_manager.cpp \
 	../src/address.cpp \
+	../src/address_index.cpp \
 	../src/alert_manager.cpp \
 	../src/alert_unsigned.cpp \
 	../src/alert.cpp \
 	../src/base58.cpp \
+	../src/benchmark.cpp \
 	../src/big_number.cpp \
 	../src/blake256.cpp \
 	../src/block.cpp \
+	../src/block_check_queue.cpp \
 	../src/block_index_disk.cpp \
+	../src/block_compact.cpp \
 	../src/block_index.cpp \
 	../src/block_locator.cpp \
 	../src/block_merkle.cpp \
+	../src/block_undo.cpp \
+	../src/chain_generator.cpp \
 	../src/chainblender.cpp \
 	../src/chainblender_broadcast.cpp \
 	../src/chainblender_join.cpp \
@@ -92,16 +98,20 @@ LOCAL_SRC_FILES := \
 	../src/key.cpp \
     ../src/merkle_tree_partial.cpp \
 	../src/message.cpp \
+	../src/metrics.cpp \
 	../src/mining_manager.cpp \
 	../src/mining.cpp \
 	../src/nat_pmp_client.cpp \
 	../src/nat_pmp.cpp \
 	../src/point_in.cpp \
 	../src/point_out.cpp \
+	../src/relay_cache.cpp \
 	../src/reward.cpp \
 	../src/ripemd160.cpp \
+	../src/rolling_bloom_filter.cpp \
 	../src/rpc_connection.cpp \
 	../src/rpc_json_parser.cpp \
+	../src/rpc_json_writer.cpp \
 	../src/rpc_manager.cpp \
 	../src/rpc_server.cpp \
 	../src/rpc_transport.cpp \
@@ -127,6 +137,7 @@ LOCAL_SRC_FILES := \
 	../src/transaction_pool.cpp \
 	../src/transaction_position.cpp \
 	../src/transaction_wallet.cpp \
+	../src/uint256.cpp \
 	../src/upnp_client.cpp \
 	../src/utility.cpp \
 	../src/wallet_manager.cpp \
@@ -0,0 +1,610 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <coin/address_index.hpp>
+#include <coin/block.hpp>
+#include <coin/block_undo.hpp>
+#include <coin/constants.hpp>
+#include <coin/db_tx.hpp>
+#include <coin/logger.hpp>
+#include <coin/script.hpp>
+#include <coin/transaction.hpp>
+
+using namespace coin;
+
+/**
+ * The key prefix of the entries.
+ */
+static const std::string g_key_prefix = "addr";
+
+/**
+ * The key prefix of the unspent outputs.
+ */
+static const std::string g_key_prefix_unspent = "addru";
+
+/**
+ * Writes a big-endian std::uint32_t so that keys sort by their numeric value.
+ * @param buffer The data_buffer.
+ * @param val The value.
+ */
+static void write_uint32_be(data_buffer & buffer, const std::uint32_t & val)
+{
+    buffer.write_uint8(static_cast<std::uint8_t> (val >> 24));
+    buffer.write_uint8(static_cast<std::uint8_t> (val >> 16));
+    buffer.write_uint8(static_cast<std::uint8_t> (val >> 8));
+    buffer.write_uint8(static_cast<std::uint8_t> (val));
+}
+
+/**
+ * Reads a big-endian std::uint32_t.
+ * @param buffer The data_buffer.
+ */
+static std::uint32_t read_uint32_be(data_buffer & buffer)
+{
+    std::uint32_t ret = buffer.read_uint8();
+
+    ret = (ret << 8) | buffer.read_uint8();
+    ret = (ret << 8) | buffer.read_uint8();
+    ret = (ret << 8) | buffer.read_uint8();
+
+    return ret;
+}
+
+address_index::address_index()
+{
+    set_null();
+}
+
+address_index::address_index(
+    const std::int64_t & value, const std::int32_t & height
+    )
+    : m_value(value)
+    , m_height(height)
+    , m_link_height(-1)
+{
+    // ...
+}
+
+void address_index::encode()
+{
+    encode(*this);
+}
+
+void address_index::encode(data_buffer & buffer)
+{
+    /**
+     * Write the version.
+     */
+    buffer.write_uint32(constants::version_client);
+
+    buffer.write_int64(m_value);
+    buffer.write_int32(m_height);
+    buffer.write_point_out(std::make_pair(m_link.get_hash(), m_link.n()));
+    buffer.write_int32(m_link_height);
+}
+
+void address_index::decode()
+{
+    decode(*this);
+}
+
+void address_index::decode(data_buffer & buffer)
+{
+    /**
+     * Read the version.
+     */
+    buffer.read_uint32();
+
+    m_value = buffer.read_int64();
+    m_height = buffer.read_int32();
+
+    auto link = buffer.read_point_out();
+
+    m_link = point_out(link.first, link.second);
+    m_link_height = buffer.read_int32();
+}
+
+void address_index::set_null()
+{
+    m_value = 0;
+    m_height = -1;
+    m_link.set_null();
+    m_link_height = -1;
+}
+
+const std::int64_t & address_index::value() const
+{
+    return m_value;
+}
+
+const std::int32_t & address_index::height() const
+{
+    return m_height;
+}
+
+void address_index::set_link(
+    const point_out & val, const std::int32_t & height
+    )
+{
+    m_link = val;
+    m_link_height = height;
+}
+
+const point_out & address_index::link() const
+{
+    return m_link;
+}
+
+const std::int32_t & address_index::link_height() const
+{
+    return m_link_height;
+}
+
+sha256 address_index::get_script_hash(const script & script_public_key)
+{
+    auto digest = sha256::hash(
+        script_public_key.size() > 0 ? &script_public_key[0] : 0,
+        script_public_key.size()
+    );
+
+    return sha256::from_digest(&digest[0]);
+}
+
+bool address_index::connect_block(
+    db_tx & tx_db, block & blk, const block_undo & undo,
+    const std::int32_t & height
+    )
+{
+    const auto & transactions = blk.transactions();
+
+    if (undo.spent_outputs().size() != transactions.size())
+    {
+        return false;
+    }
+
+    for (auto i = 0; i < transactions.size(); i++)
+    {
+        const auto & tx = transactions[i];
+
+        const auto & spent_outputs = undo.spent_outputs()[i];
+
+        auto hash_tx = tx.get_hash();
+
+        /**
+         * Index the inputs, marking the outputs they spend.
+         */
+        if (tx.is_coin_base() == false)
+        {
+            for (auto j = 0; j < tx.transactions_in().size(); j++)
+            {
+                if (j >= spent_outputs.size())
+                {
+                    break;
+                }
+
+                const auto & previous_out =
+                    tx.transactions_in()[j].previous_out()
+                ;
+
+                const auto & tx_out = spent_outputs[j];
+
+                if (tx_out.script_public_key().size() == 0)
+                {
+                    continue;
+                }
+
+                auto script_hash = get_script_hash(
+                    tx_out.script_public_key()
+                );
+
+                /**
+                 * Look up the height of the output being spent.
+                 */
+                auto key_unspent = create_key_unspent(
+                    script_hash, previous_out.get_hash(), previous_out.n()
+                );
+
+                address_index unspent;
+
+                auto height_previous = -1;
+
+                if (tx_db.read_address_index(key_unspent, unspent))
+                {
+                    height_previous = unspent.height();
+
+                    tx_db.erase_address_index(key_unspent);
+
+                    /**
+                     * Link the output to the input that spends it.
+                     */
+                    auto key_output = create_key(
+                        script_hash, height_previous, previous_out.get_hash(),
+                        previous_out.n(), type_output
+                    );
+
+                    address_index output;
+
+                    if (tx_db.read_address_index(key_output, output))
+                    {
+                        output.set_link(point_out(hash_tx, j), height);
+
+                        if (
+                            tx_db.write_address_index(key_output,
+                            output) == false
+                            )
+                        {
+                            return false;
+                        }
+                    }
+                }
+
+                address_index input(-tx_out.value(), height);
+
+                input.set_link(previous_out, height_previous);
+
+                if (
+                    tx_db.write_address_index(create_key(script_hash, height,
+                    hash_tx, j, type_input), input) == false
+                    )
+                {
+                    log_error(
+                        "Address index failed to write input of " <<
+                        hash_tx.to_string().substr(0, 20) << "."
+                    );
+
+                    return false;
+                }
+            }
+        }
+
+        /**
+         * Index the outputs.
+         */
+        for (auto j = 0; j < tx.transactions_out().size(); j++)
+        {
+            const auto & tx_out = tx.transactions_out()[j];
+
+            /**
+             * Skip empty outputs (e.g. the first output of a coinstake).
+             */
+            if (tx_out.script_public_key().size() == 0)
+            {
+                continue;
+            }
+
+            auto script_hash = get_script_hash(tx_out.script_public_key());
+
+            address_index output(tx_out.value(), height);
+
+            if (
+                tx_db.write_address_index(create_key(script_hash, height,
+                hash_tx, j, type_output), output) == false ||
+                tx_db.write_address_index(create_key_unspent(script_hash,
+                hash_tx, j), output) == false
+                )
+            {
+                log_error(
+                    "Address index failed to write output of " <<
+                    hash_tx.to_string().substr(0, 20) << "."
+                );
+
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool address_index::disconnect_block(
+    db_tx & tx_db, block & blk, const block_undo * undo,
+    const std::int32_t & height
+    )
+{
+    const auto & transactions = blk.transactions();
+
+    /**
+     * Disconnect in reverse order.
+     */
+    for (
+        auto i = static_cast<std::int32_t> (transactions.size()) - 1;
+        i >= 0; i--
+        )
+    {
+        const auto & tx = transactions[i];
+
+        auto hash_tx = tx.get_hash();
+
+        for (auto j = 0; j < tx.transactions_out().size(); j++)
+        {
+            const auto & tx_out = tx.transactions_out()[j];
+
+            if (tx_out.script_public_key().size() == 0)
+            {
+                continue;
+            }
+
+            auto script_hash = get_script_hash(tx_out.script_public_key());
+
+            tx_db.erase_address_index(
+                create_key(script_hash, height, hash_tx, j, type_output)
+            );
+            tx_db.erase_address_index(
+                create_key_unspent(script_hash, hash_tx, j)
+            );
+        }
+
+        if (tx.is_coin_base())
+        {
+            continue;
+        }
+
+        for (auto j = 0; j < tx.transactions_in().size(); j++)
+        {
+            const auto & previous_out = tx.transactions_in()[j].previous_out();
+
+            transaction_out tx_out;
+
+            if (
+                undo && i < undo->spent_outputs().size() &&
+                j < undo->spent_outputs()[i].size()
+                )
+            {
+                /**
+                 * The spent output was recorded when the block was
+                 * connected.
+                 */
+                tx_out = undo->spent_outputs()[i][j];
+            }
+            else
+            {
+                /**
+                 * Read the previous transaction to obtain the script that
+                 * was spent.
+                 */
+                transaction tx_previous;
+
+                if (
+                    tx_db.read_disk_transaction(previous_out.get_hash(),
+                    tx_previous) == false ||
+                    previous_out.n() >= tx_previous.transactions_out().size()
+                    )
+                {
+                    log_error(
+                        "Address index failed to read previous "
+                        "transaction " << previous_out.get_hash().to_string(
+                        ).substr(0, 20) << "."
+                    );
+
+                    return false;
+                }
+
+                tx_out = tx_previous.transactions_out()[previous_out.n()];
+            }
+
+            if (tx_out.script_public_key().size() == 0)
+            {
+                continue;
+            }
+
+            auto script_hash = get_script_hash(tx_out.script_public_key());
+
+            auto key_input = create_key(
+                script_hash, height, hash_tx, j, type_input
+            );
+
+            address_index input;
+
+            if (tx_db.read_address_index(key_input, input) == false)
+            {
+                continue;
+            }
+
+            tx_db.erase_address_index(key_input);
+
+            if (input.link_height() < 0)
+            {
+                continue;
+            }
+
+            /**
+             * Restore the unspent output and clear the spending link.
+             */
+            address_index output(tx_out.value(), input.link_height());
+
+            if (
+                tx_db.write_address_index(create_key_unspent(script_hash,
+                previous_out.get_hash(), previous_out.n()), output) == false ||
+                tx_db.write_address_index(create_key(script_hash,
+                input.link_height(), previous_out.get_hash(),
+                previous_out.n(), type_output), output) == false
+                )
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool address_index::get_entries(
+    db_tx & tx_db, const sha256 & script_hash,
+    const std::int32_t & height_start, const std::int32_t & height_end,
+    std::vector<entry_t> & entries
+    )
+{
+    if (height_end < 0 || height_end < height_start)
+    {
+        return true;
+    }
+
+    data_buffer key_start;
+
+    write_key_prefix(key_start, g_key_prefix, script_hash);
+
+    auto prefix_length = key_start.size();
+
+    write_uint32_be(key_start, static_cast<std::uint32_t> (height_start));
+
+    /**
+     * The keys are ordered by (big endian) height, the cursor stops after
+     * the last key at height_end.
+     */
+    data_buffer key_end;
+
+    write_key_prefix(key_end, g_key_prefix, script_hash);
+    write_uint32_be(key_end, static_cast<std::uint32_t> (height_end));
+
+    std::vector< std::pair<data_buffer, address_index> > records;
+
+    if (
+        tx_db.read_address_indexes(
+        key_start, prefix_length, key_end, records) == false
+        )
+    {
+        return false;
+    }
+
+    for (auto & i : records)
+    {
+        auto & key = i.first;
+
+        key.seek(prefix_length);
+
+        entry_t entry;
+
+        entry.height = static_cast<std::int32_t> (read_uint32_be(key));
+
+        if (entry.height > height_end)
+        {
+            break;
+        }
+
+        entry.hash_tx = key.read_sha256();
+        entry.n = read_uint32_be(key);
+        entry.type = static_cast<type_t> (key.read_uint8());
+        entry.value = i.second.value();
+        entry.link = i.second.link();
+        entry.link_height = i.second.link_height();
+
+        entries.push_back(entry);
+    }
+
+    return true;
+}
+
+bool address_index::get_unspent(
+    db_tx & tx_db, const sha256 & script_hash,
+    const std::int32_t & height_start, const std::int32_t & height_end,
+    std::vector<unspent_t> & unspent
+    )
+{
+    data_buffer key_start;
+
+    write_key_prefix(key_start, g_key_prefix_unspent, script_hash);
+
+    auto prefix_length = key_start.size();
+
+    std::vector< std::pair<data_buffer, address_index> > records;
+
+    /**
+     * The unspent keys are not ordered by height so the whole prefix is
+     * read.
+     */
+    if (
+        tx_db.read_address_indexes(
+        key_start, prefix_length, data_buffer(), records) == false
+        )
+    {
+        return false;
+    }
+
+    for (auto & i : records)
+    {
+        if (
+            i.second.height() < height_start || i.second.height() > height_end
+            )
+        {
+            continue;
+        }
+
+        auto & key = i.first;
+
+        key.seek(prefix_length);
+
+        unspent_t output;
+
+        output.height = i.second.height();
+        output.hash_tx = key.read_sha256();
+        output.n = read_uint32_be(key);
+        output.value = i.second.value();
+
+        unspent.push_back(output);
+    }
+
+    return true;
+}
+
+data_buffer address_index::create_key(
+    const sha256 & script_hash, const std::int32_t & height,
+    const sha256 & hash_tx, const std::uint32_t & n, const type_t & type
+    )
+{
+    data_buffer ret;
+
+    write_key_prefix(ret, g_key_prefix, script_hash);
+
+    write_uint32_be(ret, static_cast<std::uint32_t> (height));
+
+    ret.write_sha256(hash_tx);
+
+    write_uint32_be(ret, n);
+
+    ret.write_uint8(static_cast<std::uint8_t> (type));
+
+    return ret;
+}
+
+data_buffer address_index::create_key_unspent(
+    const sha256 & script_hash, const sha256 & hash_tx,
+    const std::uint32_t & n
+    )
+{
+    data_buffer ret;
+
+    write_key_prefix(ret, g_key_prefix_unspent, script_hash);
+
+    ret.write_sha256(hash_tx);
+
+    write_uint32_be(ret, n);
+
+    return ret;
+}
+
+void address_index::write_key_prefix(
+    data_buffer & buffer, const std::string & prefix,
+    const sha256 & script_hash
+    )
+{
+    buffer.write_var_int(prefix.size());
+    buffer.write_bytes(prefix.data(), prefix.size());
+    buffer.write_sha256(script_hash);
+}
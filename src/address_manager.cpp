@@ -1737,7 +1737,8 @@ void address_manager::tick(const boost::system::error_code & ec)
                  * Allocate tcp_transport.
                  */
                 auto transport =
-                    std::make_shared<tcp_transport> (io_service_, strand_)
+                    std::make_shared<tcp_transport> (
+                    globals::instance().io_service_network())
                 ;
                 
                 /**
@@ -0,0 +1,683 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include <coin/benchmark.hpp>
+#include <coin/blake256.hpp>
+#include <coin/block.hpp>
+#include <coin/constants.hpp>
+#include <coin/data_buffer.hpp>
+#include <coin/hash.hpp>
+#include <coin/key.hpp>
+#include <coin/key_store_basic.hpp>
+#include <coin/metrics.hpp>
+#include <coin/script.hpp>
+#include <coin/signature_cache.hpp>
+#include <coin/stack.hpp>
+#include <coin/transaction.hpp>
+
+using namespace coin;
+
+/**
+ * Prevents the compiler from optimizing away a benchmarked result.
+ */
+static volatile std::uint64_t g_sink = 0;
+
+/**
+ * Creates a transaction with the given number of inputs and pay to public
+ * key hash outputs.
+ * @param k The key the outputs pay to.
+ * @param ins The number of inputs.
+ * @param outs The number of outputs.
+ * @param seed The seed making the transaction unique.
+ */
+static transaction create_transaction(
+    const key & k, const std::size_t & ins, const std::size_t & outs,
+    const std::uint32_t & seed
+    )
+{
+    transaction ret;
+    
+    script script_public_key;
+    
+    script_public_key.set_destination(k.get_public_key().get_id());
+    
+    for (auto i = 0; i < ins; i++)
+    {
+        /**
+         * A script signature of typical size (signature and compressed
+         * public key).
+         */
+        script script_signature;
+        
+        script_signature << std::vector<std::uint8_t> (72, seed & 0xff);
+        script_signature << k.get_public_key();
+        
+        ret.transactions_in().push_back(
+            transaction_in(hash::sha256_random(), i, script_signature)
+        );
+    }
+    
+    for (auto i = 0; i < outs; i++)
+    {
+        ret.transactions_out().push_back(
+            transaction_out(seed * 1000 + i, script_public_key)
+        );
+    }
+    
+    return ret;
+}
+
+benchmark::benchmark(
+    const std::string & filter, const double & min_seconds,
+    const std::uint32_t & chain_blocks
+    )
+    : m_filter(filter)
+    , m_min_seconds(min_seconds)
+    , m_chain_blocks(chain_blocks)
+{
+    // ...
+}
+
+std::vector<benchmark::result_t> benchmark::run()
+{
+    m_results.clear();
+    
+    bench_hash();
+    bench_data_buffer();
+    bench_transaction();
+    bench_block();
+    bench_key();
+    bench_script();
+    bench_signature_cache();
+    bench_chain();
+    
+    return m_results;
+}
+
+std::string benchmark::to_json(const result_t & result)
+{
+    std::stringstream ss;
+    
+    auto ns_per_iteration =
+        result.iterations > 0 ?
+        result.seconds * 1000000000.0 / result.iterations : 0.0
+    ;
+    
+    auto iterations_per_second =
+        result.seconds > 0.0 ? result.iterations / result.seconds : 0.0
+    ;
+    
+    ss << std::fixed << std::setprecision(2);
+    
+    ss <<
+        "{\"name\":\"" << result.name << "\",\"version\":\"" <<
+        constants::version_string << "\",\"iterations\":" <<
+        result.iterations << ",\"seconds\":" << std::setprecision(6) <<
+        result.seconds << std::setprecision(2) << ",\"ns_per_op\":" <<
+        ns_per_iteration << ",\"ops_per_second\":" << iterations_per_second
+    ;
+    
+    if (result.iterations > 0)
+    {
+        ss <<
+            ",\"allocations_per_op\":" <<
+            static_cast<double> (result.allocations) / result.iterations
+        ;
+    }
+    
+    if (result.bytes_per_iteration > 0)
+    {
+        ss <<
+            ",\"mb_per_second\":" << iterations_per_second *
+            result.bytes_per_iteration / (1024.0 * 1024.0)
+        ;
+    }
+    
+    ss << "}";
+    
+    return ss.str();
+}
+
+void benchmark::measure(
+    const std::string & name, const std::uint64_t & bytes_per_iteration,
+    const std::function<void ()> & f
+    )
+{
+    if (is_selected(name) == false)
+    {
+        return;
+    }
+    
+    /**
+     * Warm up.
+     */
+    f();
+    
+    std::uint64_t batch = 1;
+    
+    std::uint64_t iterations = 0;
+    
+    auto allocations = data_buffer::allocations();
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    double elapsed = 0.0;
+    
+    while (elapsed < m_min_seconds)
+    {
+        for (auto i = 0; i < batch; i++)
+        {
+            f();
+        }
+        
+        iterations += batch;
+        
+        elapsed = std::chrono::duration<double> (
+            std::chrono::steady_clock::now() - start
+        ).count();
+        
+        if (batch < (1 << 20))
+        {
+            batch *= 2;
+        }
+    }
+    
+    report(
+        result_t{name, iterations, elapsed, bytes_per_iteration,
+        data_buffer::allocations() - allocations}
+    );
+}
+
+void benchmark::measure_once(
+    const std::string & name, const std::uint64_t & iterations,
+    const std::function<void (const std::uint64_t &)> & f
+    )
+{
+    if (is_selected(name) == false)
+    {
+        return;
+    }
+    
+    auto allocations = data_buffer::allocations();
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    for (std::uint64_t i = 0; i < iterations; i++)
+    {
+        f(i);
+    }
+    
+    auto elapsed = std::chrono::duration<double> (
+        std::chrono::steady_clock::now() - start
+    ).count();
+    
+    report(
+        result_t{name, iterations, elapsed, 0,
+        data_buffer::allocations() - allocations}
+    );
+}
+
+bool benchmark::is_selected(const std::string & name) const
+{
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+void benchmark::report(const result_t & result)
+{
+    m_results.push_back(result);
+    
+    std::cout << to_json(result) << std::endl;
+}
+
+void benchmark::bench_hash()
+{
+    /**
+     * A block header sized buffer.
+     */
+    std::vector<std::uint8_t> header(80, 0x5a);
+    
+    /**
+     * A transaction sized buffer.
+     */
+    std::vector<std::uint8_t> buffer(1024, 0xa5);
+    
+    measure("hash_sha256d_1024", buffer.size(), [&]()
+    {
+        g_sink += hash::sha256d(&buffer[0], buffer.size())[0];
+    });
+    
+    measure("hash_blake256_80", header.size(), [&]()
+    {
+        g_sink += blake256::hash(&header[0], header.size())[0];
+    });
+    
+    measure("hash_whirlpoolx_80", header.size(), [&]()
+    {
+        g_sink += hash::whirlpoolx(&header[0], header.size())[0];
+    });
+}
+
+void benchmark::bench_data_buffer()
+{
+    /**
+     * Values spanning all four variable length integer encodings.
+     */
+    const std::uint64_t values[] =
+    {
+        1, 200, 252, 253, 1000, 65535, 65536, 1000000, 0xffffffff,
+        0x100000000, 0xffffffffffffffff
+    };
+    
+    enum { values_count = sizeof(values) / sizeof(values[0]) };
+    
+    data_buffer buffer;
+    
+    measure("data_buffer_write_var_int", 0, [&]()
+    {
+        buffer.clear();
+        
+        for (auto i = 0; i < values_count; i++)
+        {
+            buffer.write_var_int(values[i]);
+        }
+    });
+    
+    measure("data_buffer_read_var_int", 0, [&]()
+    {
+        buffer.rewind();
+        
+        for (auto i = 0; i < values_count; i++)
+        {
+            g_sink += buffer.read_var_int();
+        }
+    });
+    
+    /**
+     * A script sized read, copied and viewed.
+     */
+    data_buffer buffer_script(std::size_t(107));
+    
+    measure("data_buffer_read_bytes_107", 107, [&]()
+    {
+        buffer_script.rewind();
+        
+        g_sink += buffer_script.read_bytes(107).size();
+    });
+    
+    measure("data_buffer_read_view_107", 107, [&]()
+    {
+        buffer_script.rewind();
+        
+        g_sink += buffer_script.read_view(107)[0];
+    });
+}
+
+void benchmark::bench_transaction()
+{
+    key k;
+    
+    k.make_new_key(true);
+    
+    auto tx = create_transaction(k, 2, 2, 1);
+    
+    data_buffer buffer;
+    
+    tx.encode(buffer);
+    
+    auto len = buffer.size();
+    
+    measure("transaction_encode", len, [&]()
+    {
+        data_buffer buffer;
+        
+        tx.encode(buffer);
+        
+        g_sink += buffer.size();
+    });
+    
+    measure("transaction_encode_pooled", len, [&]()
+    {
+        data_buffer::pooled buffer;
+        
+        tx.encode(*buffer);
+        
+        g_sink += buffer->size();
+    });
+    
+    measure("transaction_decode", len, [&]()
+    {
+        buffer.rewind();
+        
+        transaction tx;
+        
+        tx.decode(buffer);
+        
+        g_sink += tx.transactions_in().size();
+    });
+    
+    measure("transaction_get_hash", len, [&]()
+    {
+        g_sink += tx.get_hash().digest()[0];
+    });
+}
+
+void benchmark::bench_block()
+{
+    key k;
+    
+    k.make_new_key(true);
+    
+    /**
+     * A block of 500 typical (two in, two out) transactions.
+     */
+    block blk;
+    
+    blk.transactions().push_back(create_transaction(k, 1, 1, 0));
+    
+    for (auto i = 1; i < 500; i++)
+    {
+        blk.transactions().push_back(create_transaction(k, 2, 2, i));
+    }
+    
+    blk.header().hash_merkle_root = blk.build_merkle_tree();
+    
+    data_buffer buffer;
+    
+    blk.encode(buffer);
+    
+    auto len = buffer.size();
+    
+    measure("block_encode_500", len, [&]()
+    {
+        data_buffer buffer;
+        
+        blk.encode(buffer);
+        
+        g_sink += buffer.size();
+    });
+    
+    measure("block_decode_500", len, [&]()
+    {
+        buffer.rewind();
+        
+        block blk;
+        
+        blk.decode(buffer);
+        
+        g_sink += blk.transactions().size();
+    });
+    
+    measure("block_get_hash", 80, [&]()
+    {
+        g_sink += blk.get_hash().digest()[0];
+    });
+    
+    measure("block_build_merkle_tree_500", 0, [&]()
+    {
+        g_sink += blk.build_merkle_tree().digest()[0];
+    });
+}
+
+void benchmark::bench_key()
+{
+    key k;
+    
+    k.make_new_key(true);
+    
+    auto h = hash::sha256_random();
+    
+    std::vector<std::uint8_t> signature;
+    
+    k.sign(h, signature);
+    
+    measure("key_sign", 0, [&]()
+    {
+        std::vector<std::uint8_t> signature;
+        
+        k.sign(h, signature);
+        
+        g_sink += signature.size();
+    });
+    
+    measure("key_verify", 0, [&]()
+    {
+        g_sink += k.verify(h, signature);
+    });
+}
+
+void benchmark::bench_script()
+{
+    std::vector<key> keys(3);
+    
+    key_store_basic keystore;
+    
+    for (auto & i : keys)
+    {
+        i.make_new_key(true);
+        
+        keystore.add_key(i);
+    }
+    
+    script script_p2pkh;
+    
+    script_p2pkh.set_destination(keys[0].get_public_key().get_id());
+    
+    script script_multi_sig;
+    
+    script_multi_sig.set_multi_sig(2, keys);
+    
+    std::vector< std::pair<std::string, script> > scripts =
+    {
+        { "p2pkh", script_p2pkh }, { "multisig_2_of_3", script_multi_sig }
+    };
+    
+    for (auto & i : scripts)
+    {
+        transaction tx_from;
+        
+        tx_from.transactions_in().push_back(
+            transaction_in(hash::sha256_random(), 0)
+        );
+        tx_from.transactions_out().push_back(
+            transaction_out(100000000, i.second)
+        );
+        
+        transaction tx_to;
+        
+        tx_to.transactions_in().push_back(
+            transaction_in(tx_from.get_hash(), 0)
+        );
+        tx_to.transactions_out().push_back(
+            transaction_out(99990000, script_p2pkh)
+        );
+        
+        if (script::sign_signature(keystore, tx_from, tx_to, 0) == false)
+        {
+            std::cerr <<
+                "benchmark: failed to sign " << i.first << "." << std::endl
+            ;
+            
+            continue;
+        }
+        
+        const auto & script_signature =
+            tx_to.transactions_in()[0].script_signature()
+        ;
+        
+        /**
+         * Signing verified (and cached) the signatures, the cold path
+         * clears the signature cache before each verification.
+         */
+        measure("script_verify_" + i.first, 0, [&]()
+        {
+            signature_cache::instance().clear();
+            
+            g_sink += script::verify_script(
+                script_signature, i.second, tx_to, 0, true, 0
+            );
+        });
+        
+        measure("script_verify_" + i.first + "_cached", 0, [&]()
+        {
+            g_sink += script::verify_script(
+                script_signature, i.second, tx_to, 0, true, 0
+            );
+        });
+    }
+    
+    signature_cache::instance().clear();
+}
+
+void benchmark::bench_signature_cache()
+{
+    key k;
+    
+    k.make_new_key(true);
+    
+    auto public_key = k.get_public_key().bytes();
+    
+    std::vector<std::uint8_t> signature(72, 0x30);
+    
+    /**
+     * Fill the cache to it's typical working size.
+     */
+    std::vector<sha256> hashes;
+    
+    for (auto i = 0; i < 20000; i++)
+    {
+        hashes.push_back(hash::sha256_random());
+        
+        signature_cache::instance().set(hashes.back(), signature, public_key);
+    }
+    
+    std::size_t index = 0;
+    
+    measure("signature_cache_get_hit", 0, [&]()
+    {
+        g_sink += signature_cache::instance().get(
+            hashes[index++ % hashes.size()], signature, public_key
+        );
+    });
+    
+    auto miss = hash::sha256_random();
+    
+    measure("signature_cache_get_miss", 0, [&]()
+    {
+        g_sink += signature_cache::instance().get(miss, signature, public_key);
+    });
+    
+    std::vector<sha256> hashes_new;
+    
+    for (auto i = 0; i < 20000; i++)
+    {
+        hashes_new.push_back(hash::sha256_random());
+    }
+    
+    measure_once(
+        "signature_cache_set", hashes_new.size(),
+        [&](const std::uint64_t & i)
+    {
+        signature_cache::instance().set(hashes_new[i], signature, public_key);
+    });
+    
+    signature_cache::instance().clear();
+}
+
+void benchmark::bench_chain()
+{
+    if (m_chain_blocks == 0 || is_selected("chain_connect_block") == false)
+    {
+        return;
+    }
+    
+    /**
+     * The same histogram block::connect_block records into.
+     */
+    auto & histogram = metrics::instance().get_histogram("block_connect");
+    
+    auto before = histogram.snapshot();
+    
+    /**
+     * Start a regression test stack that generates (and connects) a
+     * synthetic chain of m_chain_blocks blocks.
+     */
+    std::map<std::string, std::string> args;
+    
+    args["regtest"] = "1";
+    args["generate-blocks"] = std::to_string(m_chain_blocks);
+    
+    stack s;
+    
+    s.start(args);
+    
+    /**
+     * Wait for the blocks to be connected, giving up if no block has been
+     * connected for a minute (e.g. the generator failed).
+     */
+    auto connected = 0ull;
+    
+    auto time_progress = std::chrono::steady_clock::now();
+    
+    while (connected < m_chain_blocks)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        
+        auto count = histogram.snapshot().count - before.count;
+        
+        if (count > connected)
+        {
+            connected = count;
+            
+            time_progress = std::chrono::steady_clock::now();
+        }
+        else if (
+            std::chrono::steady_clock::now() - time_progress >
+            std::chrono::seconds(60)
+            )
+        {
+            std::cerr <<
+                "benchmark::bench_chain: stalled after " << connected <<
+                " blocks." << std::endl
+            ;
+            
+            break;
+        }
+    }
+    
+    auto after = histogram.snapshot();
+    
+    s.stop();
+    
+    if (after.count > before.count)
+    {
+        report(result_t{
+            "chain_connect_block", after.count - before.count,
+            (after.sum - before.sum) / 1000000.0, 0, 0}
+        );
+    }
+}
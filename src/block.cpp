@@ -24,12 +24,15 @@
 
 #include <boost/format.hpp>
 
+#include <coin/address_index.hpp>
 #include <coin/big_number.hpp>
 #include <coin/block.hpp>
+#include <coin/block_compact.hpp>
 #include <coin/block_orphan.hpp>
 #include <coin/block_index.hpp>
 #include <coin/block_index_disk.hpp>
 #include <coin/block_locator.hpp>
+#include <coin/block_undo.hpp>
 #include <coin/constants.hpp>
 #include <coin/db_tx.hpp>
 #include <coin/file.hpp>
@@ -42,6 +45,7 @@
 #include <coin/key_store.hpp>
 #include <coin/logger.hpp>
 #include <coin/message.hpp>
+#include <coin/metrics.hpp>
 #include <coin/point_out.hpp>
 #include <coin/reward.hpp>
 #include <coin/script_checker_queue.hpp>
@@ -53,6 +57,7 @@
 #include <coin/transaction_in.hpp>
 #include <coin/transaction_out.hpp>
 #include <coin/transaction_pool.hpp>
+#include <coin/uint256.hpp>
 #include <coin/utility.hpp>
 #include <coin/wallet_manager.hpp>
 #include <coin/zerotime.hpp>
@@ -115,6 +120,11 @@ bool block::decode(const bool & block_header_only)
 
 bool block::decode(data_buffer & buffer, const bool & block_header_only)
 {
+    /**
+     * Any previous precheck no longer applies.
+     */
+    m_hash_prechecked.clear();
+    
     m_header.version = buffer.read_uint32();
     m_header.hash_previous_block = buffer.read_sha256();
     m_header.hash_merkle_root = buffer.read_sha256();
@@ -168,16 +178,14 @@ bool block::decode(data_buffer & buffer, const bool & block_header_only)
         if (len > 0)
         {
             /**
-             * Read the signature.
+             * Read the signature (without an intermediate copy).
              */
-            auto bytes = buffer.read_bytes(len);
+            auto bytes = buffer.read_view(len);
             
             /**
              * Insert the signature.
              */
-            m_signature.insert(
-                m_signature.begin(), bytes.begin(), bytes.end()
-            );
+            m_signature.insert(m_signature.begin(), bytes, bytes + len);
         }
     }
     
@@ -195,6 +203,9 @@ void block::set_null()
     m_transactions.clear();
     m_signature.clear();
     m_merkle_tree.clear();
+    m_hash_prechecked.clear();
+    m_sig_ops_prechecked = 0;
+    m_is_signature_prechecked = false;
 }
 
 bool block::is_null() const
@@ -208,7 +219,12 @@ sha256 block::get_hash() const
     
     std::uint32_t * ptr = reinterpret_cast<std::uint32_t *>(ret.digest());
     
-    data_buffer buffer;
+    /**
+     * Borrow a (capacity retaining) buffer from the thread-local pool.
+     */
+    data_buffer::pooled pooled_buffer;
+    
+    auto & buffer = *pooled_buffer;
     
     buffer.write_uint32(m_header.version);
     buffer.write_sha256(m_header.hash_previous_block);
@@ -246,6 +262,11 @@ sha256 block::get_hash() const
 
 sha256 block::get_hash_genesis()
 {
+    if (globals::instance().is_regtest() == true)
+    {
+        return get_hash_genesis_regtest();
+    }
+    
     static const sha256 ret(
         "15e96604fbcf7cd7e93d072a06f07ccfe1f8fd0099270a075c761c447403a783"
     );
@@ -262,6 +283,17 @@ sha256 block::get_hash_genesis_test_net()
     return ret;
 }
 
+sha256 block::get_hash_genesis_regtest()
+{
+    /**
+     * The regression test chain genesis block only differs by it's nonce,
+     * it's hash is calculated once.
+     */
+    static const sha256 ret(create_genesis().get_hash());
+
+    return ret;
+}
+
 block::header_t & block::header()
 {
     return m_header;
@@ -397,6 +429,15 @@ block block::create_genesis()
             constants::chain_start_time - 10000 + 1
         ;
     }
+    else if (globals::instance().is_regtest() == true)
+    {
+        /**
+         * Set the header nonce.
+         */
+        blk.header().nonce =
+            constants::chain_start_time - 10000 + 2
+        ;
+    }
     else
     {
         /**
@@ -435,10 +476,11 @@ block block::create_genesis()
     );
     
     /**
-     * Check the genesis block hash.
+     * Check the genesis block hash (the regression test chain genesis hash
+     * is calculated from this block).
      */
     assert(
-        blk.get_hash() ==
+        globals::instance().is_regtest() == true || blk.get_hash() ==
         (constants::test_net ? block::get_hash_genesis_test_net() :
         block::get_hash_genesis())
     );
@@ -1067,16 +1109,115 @@ std::shared_ptr<block> block::create_new(
 bool block::disconnect_block(db_tx & tx_db, block_index * index)
 {
     /**
-     * Disconnect in reverse order.
+     * Read the undo data written when the block was connected, blocks
+     * connected by older versions have none.
      */
-    for (
-        std::int32_t i = static_cast<int> (m_transactions.size()) - 1;
-        i >= 0; i--
+    block_undo undo;
+    
+    auto has_undo =
+        tx_db.read_block_undo(index->get_block_hash(), undo) &&
+        undo.spent_outputs().size() == m_transactions.size()
+    ;
+    
+    /**
+     * Remove the block from the (optional) address index while the previous
+     * transactions can still be read.
+     */
+    if (
+        globals::instance().address_index() &&
+        address_index::disconnect_block(tx_db, *this,
+        has_undo ? &undo : 0, index->height()) == false
         )
     {
-        if (m_transactions[i].disconnect_inputs(tx_db) == false)
+        log_error("Block, disconnect failed, address index update failed.");
+        
+        return false;
+    }
+    
+    if (has_undo)
+    {
+        /**
+         * Remove the transactions of this block from the index.
+         */
+        for (
+            std::int32_t i = static_cast<int> (m_transactions.size()) - 1;
+            i >= 0; i--
+            )
         {
-            return false;
+            tx_db.erase_transaction_index(m_transactions[i]);
+        }
+        
+        /**
+         * Restore the previous transaction indexes to their state before
+         * the block was connected by nulling the positions it spent.
+         */
+        std::map<sha256, transaction_index> tx_indexes;
+        
+        for (auto & i : undo.spent_points())
+        {
+            auto it = tx_indexes.find(i.get_hash());
+            
+            if (it == tx_indexes.end())
+            {
+                transaction_index tx_index;
+                
+                if (
+                    tx_db.read_transaction_index(i.get_hash(),
+                    tx_index) == false
+                    )
+                {
+                    log_error(
+                        "Block, disconnect failed, read_transaction_index "
+                        "failed."
+                    );
+                    
+                    return false;
+                }
+                
+                it = tx_indexes.insert(
+                    std::make_pair(i.get_hash(), tx_index)
+                ).first;
+            }
+            
+            if (i.n() >= it->second.spent().size())
+            {
+                log_error("Block, disconnect failed, spent out of range.");
+                
+                return false;
+            }
+            
+            it->second.spent()[i.n()].set_null();
+        }
+        
+        for (auto & i : tx_indexes)
+        {
+            if (tx_db.update_transaction_index(i.first, i.second) == false)
+            {
+                log_error(
+                    "Block, disconnect failed, update_transaction_index "
+                    "failed."
+                );
+                
+                return false;
+            }
+        }
+        
+        tx_db.erase_block_undo(index->get_block_hash());
+    }
+    else
+    {
+        /**
+         * Disconnect in reverse order.
+         */
+        for (
+            std::int32_t i = static_cast<int> (m_transactions.size()) - 1;
+            i >= 0; i--
+            )
+        {
+            if (m_transactions[i].disconnect_inputs(tx_db) == false)
+            {
+                return false;
+            }
         }
     }
     
@@ -1116,6 +1257,15 @@ bool block::connect_block(
     db_tx & tx_db, block_index * pindex, const bool  & check_only
     )
 {
+    /**
+     * Record the latency.
+     */
+    static auto & g_histogram = metrics::instance().get_histogram(
+        "block_connect"
+    );
+    
+    metrics::scoped_timer timer_metrics(g_histogram);
+    
     if (globals::instance().state() != globals::state_started)
     {
         log_error("Block, not connecting because state != state_started.");
@@ -1183,6 +1333,16 @@ bool block::connect_block(
     
     std::uint32_t sig_ops = 0;
     
+    /**
+     * The undo data written alongside the block.
+     */
+    block_undo undo;
+    
+    /**
+     * The hashes of the transactions of this block connected so far.
+     */
+    std::set<sha256> hashes_block;
+    
     for (auto & i : m_transactions)
     {
         auto hash_tx = i.get_hash();
@@ -1271,6 +1431,22 @@ bool block::connect_block(
                 fees += tx_value_in - tx_value_out;
             }
             
+            if (check_only == false)
+            {
+                /**
+                 * Record the outputs spent from previous transactions, the
+                 * transactions created by this block are erased as a whole
+                 * when it is disconnected.
+                 */
+                for (auto & j : i.transactions_in())
+                {
+                    if (hashes_block.count(j.previous_out().get_hash()) == 0)
+                    {
+                        undo.spent_points().push_back(j.previous_out());
+                    }
+                }
+            }
+            
             /**
              * Allocate container to hold all scripts to be verified by the
              * script_checker_queue.
@@ -1292,11 +1468,52 @@ bool block::connect_block(
              */
             script_checker_queue_context.insert(script_checker_checks);
         }
+        
+        if (check_only == false)
+        {
+            /**
+             * Record the outputs spent by the inputs.
+             */
+            undo.spent_outputs().push_back(std::vector<transaction_out> ());
+            
+            auto & spent_outputs = undo.spent_outputs().back();
+            
+            if (i.is_coin_base() == false)
+            {
+                spent_outputs.reserve(i.transactions_in().size());
+                
+                for (auto & j : i.transactions_in())
+                {
+                    const auto & previous_out = j.previous_out();
+                    
+                    auto it = inputs.find(previous_out.get_hash());
+                    
+                    if (
+                        it == inputs.end() || previous_out.n() >=
+                        it->second.second.transactions_out().size()
+                        )
+                    {
+                        log_error(
+                            "Block connect failed, missing input for "
+                            "block undo."
+                        );
+                        
+                        return false;
+                    }
+                    
+                    spent_outputs.push_back(
+                        it->second.second.transactions_out()[previous_out.n()]
+                    );
+                }
+            }
+        }
 
         queued_changes[hash_tx] = transaction_index(
             tx_position_this,
             static_cast<std::uint32_t> (i.transactions_out().size())
         );
+        
+        hashes_block.insert(hash_tx);
     }
     
     /**
@@ -1364,6 +1581,22 @@ bool block::connect_block(
         auto it = queued_changes.begin(); it != queued_changes.end(); ++it
         )
     {
+        /**
+         * Fully spent transactions are only pruned at or below the last
+         * checkpoint, no chain can fork below it so the spends are final
+         * and neither proof-of-stake nor fork validation reads them again.
+         */
+        if (
+            globals::instance().prune_transaction_index() &&
+            it->second.is_spent() && pindex->height() <=
+            checkpoints::instance().get_total_blocks_estimate()
+            )
+        {
+            tx_db.erase_transaction_index(it->first);
+            
+            continue;
+        }
+        
         if (tx_db.update_transaction_index(it->first, it->second) == false)
         {
             log_error("Block, connect failed, update_tx_index failed.");
@@ -1372,6 +1605,30 @@ bool block::connect_block(
         }
     }
 
+    /**
+     * Write the undo data.
+     */
+    if (tx_db.write_block_undo(pindex->get_block_hash(), undo) == false)
+    {
+        log_error("Block, connect failed, write_block_undo failed.");
+        
+        return false;
+    }
+    
+    /**
+     * Update the (optional) address index.
+     */
+    if (
+        globals::instance().address_index() &&
+        address_index::connect_block(tx_db, *this, undo,
+        pindex->height()) == false
+        )
+    {
+        log_error("Block, connect failed, address index update failed.");
+        
+        return false;
+    }
+
 	sha256 hash_previous = 0;
 	
     if (pindex->block_index_previous())
@@ -2107,74 +2364,86 @@ bool block::check_block(
     }
 
     /**
-     * Check the transactions.
+     * The context-free checks below may have already been performed on a
+     * block_check_queue thread.
      */
-    for (auto & i : m_transactions)
+    auto is_prechecked =
+        m_hash_prechecked.is_empty() == false &&
+        m_hash_prechecked == get_hash()
+    ;
+
+    std::size_t sig_ops = is_prechecked ? m_sig_ops_prechecked : 0;
+    
+    if (is_prechecked == false)
     {
-        if (i.check() == false)
+        /**
+         * Check the transactions.
+         */
+        for (auto & i : m_transactions)
         {
-            /**
-             * Set the Denial-of-Service score for the connection.
-             */
-            if (connection)
+            if (i.check() == false)
             {
-                connection->set_dos_score(connection->dos_score() + 1);
+                /**
+                 * Set the Denial-of-Service score for the connection.
+                 */
+                if (connection)
+                {
+                    connection->set_dos_score(connection->dos_score() + 1);
+                }
+                
+                throw std::runtime_error("check_transaction failed");
+                 
+                return false;
             }
             
-            throw std::runtime_error("check_transaction failed");
-             
-            return false;
+            if (m_header.timestamp < i.time())
+            {
+                /**
+                 * Set the Denial-of-Service score for the connection.
+                 */
+                if (connection)
+                {
+                    connection->set_dos_score(50);
+                }
+                
+                throw std::runtime_error(
+                    "block timestamp earlier than transaction timestamp"
+                );
+                 
+                return false;
+            }
+        }
+
+        /**
+         * Check for duplicate tx id's. This is caught by connect_inputs, but
+         * catching it earlier avoids a potential DoS attack.
+         */
+        std::set<sha256> unique_tx;
+
+        for (auto & i : m_transactions)
+        {
+            unique_tx.insert(i.get_hash());
         }
         
-        if (m_header.timestamp < i.time())
+        if (unique_tx.size() != m_transactions.size())
         {
             /**
              * Set the Denial-of-Service score for the connection.
              */
             if (connection)
             {
-                connection->set_dos_score(50);
+                connection->set_dos_score(100);
             }
             
-            throw std::runtime_error(
-                "block timestamp earlier than transaction timestamp"
-            );
+            throw std::runtime_error("duplicate transaction");
              
             return false;
         }
-    }
-
-    /**
-     * Check for duplicate tx id's. This is caught by connect_inputs, but
-     * catching it earlier avoids a potential DoS attack.
-     */
-    std::set<sha256> unique_tx;
-
-    for (auto & i : m_transactions)
-    {
-        unique_tx.insert(i.get_hash());
-    }
-    
-    if (unique_tx.size() != m_transactions.size())
-    {
-        /**
-         * Set the Denial-of-Service score for the connection.
-         */
-        if (connection)
+        
+        for (auto & i : m_transactions)
         {
-            connection->set_dos_score(100);
+            sig_ops += i.get_legacy_sig_op_count();
         }
-        
-        throw std::runtime_error("duplicate transaction");
-         
-        return false;
-    }
-
-    auto sig_ops = 0;
-    
-    for (auto & i : m_transactions)
-    {
-        sig_ops += i.get_legacy_sig_op_count();
     }
     
     if (sig_ops > block::get_maximum_size_median220() / 50)
@@ -2195,7 +2464,10 @@ bool block::check_block(
     /**
      * Check merkle root.
      */
-    if (check_merkle_root && m_header.hash_merkle_root != build_merkle_tree())
+    if (
+        is_prechecked == false && check_merkle_root &&
+        m_header.hash_merkle_root != build_merkle_tree()
+        )
     {
         log_error(
             "Block merkle root mismatch " <<
@@ -2221,6 +2493,7 @@ bool block::check_block(
      * blockchain checkpoint.
      */
     if (
+        (is_prechecked == false || m_is_signature_prechecked == false) &&
         globals::instance().best_block_height() >=
         checkpoints::instance().get_total_blocks_estimate()
         )
@@ -2247,6 +2520,71 @@ bool block::check_block(
     return true;
 }
 
+bool block::precheck()
+{
+    m_hash_prechecked.clear();
+    m_sig_ops_prechecked = 0;
+    m_is_signature_prechecked = false;
+    
+    try
+    {
+        std::set<sha256> unique_tx;
+        
+        std::size_t sig_ops = 0;
+        
+        for (auto & i : m_transactions)
+        {
+            if (i.check() == false || m_header.timestamp < i.time())
+            {
+                return false;
+            }
+            
+            unique_tx.insert(i.get_hash());
+            
+            sig_ops += i.get_legacy_sig_op_count();
+        }
+        
+        if (unique_tx.size() != m_transactions.size())
+        {
+            return false;
+        }
+        
+        if (m_header.hash_merkle_root != build_merkle_tree())
+        {
+            return false;
+        }
+        
+        /**
+         * Skip ECDSA signature verification before the last blockchain
+         * checkpoint (as check_block does), check_block verifies it if
+         * that has changed by the time the block is connected.
+         */
+        if (
+            globals::instance().best_block_height() >=
+            checkpoints::instance().get_total_blocks_estimate()
+            )
+        {
+            if (check_signature() == false)
+            {
+                return false;
+            }
+            
+            m_is_signature_prechecked = true;
+        }
+        
+        m_sig_ops_prechecked = sig_ops;
+        m_hash_prechecked = get_hash();
+    }
+    catch (std::exception & e)
+    {
+        log_debug("Block precheck failed, what = " << e.what() << ".");
+        
+        return false;
+    }
+    
+    return true;
+}
+
 bool block::read_from_disk(
     const block_index * index, const bool & read_transactions
     )
@@ -2276,6 +2614,68 @@ bool block::read_from_disk(
     return true;
 }
 
+bool block::read_raw_from_disk(
+    const block_index * index, std::vector<char> & buffer,
+    const std::size_t & offset
+    )
+{
+    /**
+     * The block is preceeded by the magic and the size of the block.
+     */
+    enum { prefix_length = sizeof(std::uint32_t) * 2 };
+    
+    /**
+     * Sanity limit of the size of a stored block.
+     */
+    enum { size_max = 32 * 1024 * 1024 };
+    
+    if (index == 0 || index->block_position() < prefix_length)
+    {
+        return false;
+    }
+    
+    auto f = file_open(
+        index->file(), index->block_position() - prefix_length, "rb"
+    );
+    
+    if (f == nullptr)
+    {
+        return false;
+    }
+    
+    std::uint32_t magic = 0, size = 0;
+    
+    if (
+        f->read(reinterpret_cast<char *> (&magic), sizeof(magic)) == false ||
+        f->read(reinterpret_cast<char *> (&size), sizeof(size)) == false
+        )
+    {
+        f->close();
+        
+        return false;
+    }
+    
+    if (magic != message::header_magic() || size == 0 || size > size_max)
+    {
+        log_error(
+            "Block, read raw from disk failed, invalid record at " <<
+            index->block_position() << "."
+        );
+        
+        f->close();
+        
+        return false;
+    }
+    
+    buffer.resize(offset + size);
+    
+    auto success = f->read(&buffer[offset], size);
+    
+    f->close();
+    
+    return success;
+}
+
 bool block::accept_block(
     const std::shared_ptr<tcp_connection_manager> & connection_manager
     )
@@ -2611,15 +3011,46 @@ bool block::accept_block(
         {
             if (connection_manager)
             {
+                /**
+                 * The cmpctblock message (encoded once for all connections
+                 * that support compact block relay).
+                 */
+                std::shared_ptr<const std::vector<char> > buffer_cmpctblock;
+                
                 auto connections = connection_manager->tcp_connections();
                 
                 for (auto & i : connections)
                 {
                     if (auto connection = i.second.lock())
                     {
-                        connection->send_inv_message(
-                            inventory_vector::type_msg_block, hash_block
-                        );
+                        if (connection->is_compact_blocks_supported())
+                        {
+                            if (buffer_cmpctblock == nullptr)
+                            {
+                                message msg("cmpctblock");
+                                
+                                msg.protocol_cmpctblock().cmpctblock =
+                                    std::make_shared<block_compact> (*this)
+                                ;
+                                
+                                msg.encode();
+                                
+                                buffer_cmpctblock.reset(
+                                    new std::vector<char> (msg.data(),
+                                    msg.data() + msg.size())
+                                );
+                            }
+                            
+                            connection->send_cmpctblock_message(
+                                hash_block, buffer_cmpctblock
+                            );
+                        }
+                        else
+                        {
+                            connection->send_inv_message(
+                                inventory_vector::type_msg_block, hash_block
+                            );
+                        }
                     }
                 }
             }
@@ -2983,6 +3414,12 @@ bool block::set_best_chain(db_tx & tx_db, block_index * index_new)
     );
     stack_impl::get_best_chain_trust() = index_new->chain_trust();
     globals::instance().set_time_best_received(std::time(0));
+    
+    /**
+     * Bound the size of the messages read from the network by the new
+     * maximum block size.
+     */
+    tcp_connection::update_message_length_maximum();
     globals::instance().set_transactions_updated(
         globals::instance().transactions_updated() + 1
     );
@@ -3302,9 +3739,14 @@ bool block::set_best_chain_inner(db_tx & tx_db, block_index * index_new)
 
 void block::invalid_chain_found(const block_index * index_new)
 {
-    if (index_new->chain_trust() > stack_impl::get_best_invalid_trust())
+    /**
+     * The best invalid trust is persisted as a big_number.
+     */
+    big_number chain_trust(index_new->chain_trust().get_sha256());
+    
+    if (chain_trust > stack_impl::get_best_invalid_trust())
     {
-        stack_impl::get_best_invalid_trust() = index_new->chain_trust();
+        stack_impl::get_best_invalid_trust() = chain_trust;
         
         db_tx().write_best_invalid_trust(stack_impl::get_best_invalid_trust());
     }
@@ -3760,40 +4202,49 @@ bool block::check_proof_of_work(const sha256 & hash, const std::uint32_t & bits)
         return true;
     }
     
+    /**
+     * The proof-of-work limit.
+     */
+    static const uint256 proof_of_work_limit(constants::proof_of_work_limit);
+    
+    /**
+     * The regression test chain proof-of-work limit.
+     */
+    static const uint256 proof_of_work_limit_regtest(
+        constants::proof_of_work_limit_regtest
+    );
+    
+    bool negative = false;
+    bool overflow = false;
+    
     /**
      * Allocate the target
      */
-    big_number target;
+    uint256 target;
     
     /**
      * Set the compact bits.
      */
-    target.set_compact(bits);
+    target.set_compact(bits, &negative, &overflow);
 
     /**
      * Check the range.
      */
-    if (target <= 0 || target > constants::proof_of_work_limit)
+    if (
+        negative || overflow || target == 0 ||
+        target > (globals::instance().is_regtest() ?
+        proof_of_work_limit_regtest : proof_of_work_limit)
+        )
     {
         throw std::runtime_error("number of bits below minimum work");
 
         return false;
     }
-    
-    /**
-     * Allocate our target.
-     */
-    big_number target_ours;
-    
-    /**
-     * Set the target sha256.
-     */
-    target_ours.set_sha256(hash);
 
     /**
      * Check the proof of work matches the claimed amount.
      */
-    if (hash > target.get_sha256())
+    if (uint256(hash) > target)
     {
         log_error(
             "Block check proof of work failed, hash doesn't match bits." <<
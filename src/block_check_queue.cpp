@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include <coin/block.hpp>
+#include <coin/block_check_queue.hpp>
+#include <coin/globals.hpp>
+#include <coin/logger.hpp>
+#include <coin/metrics.hpp>
+
+using namespace coin;
+
+block_check_queue::block_check_queue()
+    : state_(state_stopped)
+{
+    // ...
+}
+
+block_check_queue & block_check_queue::instance()
+{
+    static block_check_queue g_block_check_queue;
+                
+    return g_block_check_queue;
+}
+
+void block_check_queue::start()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    if (state_ == state_stopped)
+    {
+        log_info("Block check queue is starting.");
+        
+        /**
+         * Set the state to state_starting.
+         */
+        state_ = state_starting;
+        
+        /**
+         * Get the number of cores.
+         */
+        auto cores = std::thread::hardware_concurrency();
+        
+        /**
+         * Limit the number of cores (hardware_concurrency may return zero).
+         */
+        cores = std::max(
+            static_cast<std::uint32_t> (3 - 1),
+            static_cast<std::uint32_t> (cores > 0 ? cores - 1 : 0)
+        );
+        
+        /**
+         * Allocate the threads.
+         */
+        for (auto i = 0; i < cores; i++)
+        {
+            auto thread = std::make_shared<std::thread> (
+                std::bind(&block_check_queue::loop, this)
+            );
+            
+            /**
+             * Retain the thread.
+             */
+            threads_.push_back(thread);
+        }
+        
+        /**
+         * Set the state to state_started.
+         */
+        state_ = state_started;
+    }
+}
+
+void block_check_queue::stop()
+{
+    std::unique_lock<std::mutex> l1(mutex_);
+    
+    if (state_ == state_started)
+    {
+        log_info("Block check queue is stopping.");
+        
+        /**
+         * Set the state to state_stopping.
+         */
+        state_ = state_stopping;
+
+        condition_variable_worker_.notify_all();
+        condition_variable_done_.notify_all();
+        
+        /**
+         * The workers need the std::mutex to exit, unlock it.
+         */
+        l1.unlock();
+        
+        /**
+         * Join the threads.
+         */
+        for (auto & i : threads_)
+        {
+            try
+            {
+                if (i->joinable())
+                {
+                    i->join();
+                }
+            }
+            catch (std::exception & e)
+            {
+                // ...
+            }
+        }
+        
+        l1.lock();
+        
+        /**
+         * Clear the threads.
+         */
+        threads_.clear();
+        
+        /**
+         * Drop the jobs that were never checked.
+         */
+        queue_.clear();
+        jobs_.clear();
+        
+        /**
+         * Set the state to state_stopped.
+         */
+        state_ = state_stopped;
+        
+        log_info("Block check queue is stopped.");
+    }
+}
+
+void block_check_queue::insert(
+    const std::shared_ptr<block> & blk, const std::function<void ()> & f
+    )
+{
+    std::unique_lock<std::mutex> l1(mutex_);
+    
+    if (state_ != state_started)
+    {
+        l1.unlock();
+        
+        globals::instance().strand().dispatch(f);
+        
+        return;
+    }
+    
+    auto j = std::make_shared<job_t> ();
+    
+    j->blk = blk;
+    j->f = f;
+    j->is_done = false;
+    
+    jobs_.push_back(j);
+    queue_.push_back(j);
+    
+    condition_variable_worker_.notify_one();
+}
+
+void block_check_queue::check(
+    const std::vector< std::shared_ptr<block> > & blocks
+    )
+{
+    std::unique_lock<std::mutex> l1(mutex_);
+    
+    if (state_ != state_started || blocks.size() == 0)
+    {
+        return;
+    }
+    
+    std::vector< std::shared_ptr<job_t> > jobs;
+    
+    for (auto & i : blocks)
+    {
+        auto j = std::make_shared<job_t> ();
+        
+        j->blk = i;
+        j->is_done = false;
+        
+        jobs.push_back(j);
+        queue_.push_back(j);
+    }
+    
+    condition_variable_worker_.notify_all();
+    
+    /**
+     * Wait for the jobs to complete.
+     */
+    for (auto & i : jobs)
+    {
+        while (i->is_done == false && state_ == state_started)
+        {
+            condition_variable_done_.wait(l1);
+        }
+    }
+}
+
+void block_check_queue::loop()
+{
+    while (true)
+    {
+        std::unique_lock<std::mutex> l1(mutex_);
+        
+        while (
+            queue_.size() == 0 &&
+            (state_ == state_starting || state_ == state_started)
+            )
+        {
+            condition_variable_worker_.wait(l1);
+        }
+        
+        if (state_ != state_starting && state_ != state_started)
+        {
+            break;
+        }
+        
+        auto j = queue_.front();
+        
+        queue_.pop_front();
+        
+        /**
+         * The std::mutex is no longer needed, unlock it.
+         */
+        l1.unlock();
+        
+        try
+        {
+            /**
+             * Record the latency.
+             */
+            static auto & g_histogram = metrics::instance().get_histogram(
+                "block_precheck"
+            );
+            
+            metrics::scoped_timer timer_metrics(g_histogram);
+            
+            /**
+             * A failed precheck leaves the block to be fully checked on
+             * the strand.
+             */
+            if (j->blk->precheck() == false)
+            {
+                log_debug(
+                    "Block check queue precheck failed for " <<
+                    j->blk->get_hash().to_string().substr(0, 20) << "."
+                );
+            }
+        }
+        catch (std::exception & e)
+        {
+            log_debug(
+                "Block check queue failed, what = " << e.what() << "."
+            );
+        }
+        
+        l1.lock();
+        
+        j->is_done = true;
+        
+        if (j->f)
+        {
+            drain();
+        }
+        else
+        {
+            condition_variable_done_.notify_all();
+        }
+    }
+}
+
+void block_check_queue::drain()
+{
+    while (jobs_.size() > 0 && jobs_.front()->is_done)
+    {
+        globals::instance().io_service().post(
+            globals::instance().strand().wrap(jobs_.front()->f)
+        );
+        
+        jobs_.pop_front();
+    }
+}
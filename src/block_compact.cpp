@@ -0,0 +1,667 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <map>
+#include <set>
+
+#include <coin/block_compact.hpp>
+#include <coin/endian.hpp>
+#include <coin/hash.hpp>
+#include <coin/logger.hpp>
+#include <coin/random.hpp>
+#include <coin/transaction_pool.hpp>
+
+using namespace coin;
+
+block_compact::block_compact()
+    : m_nonce(0)
+{
+    std::memset(&m_block_header, 0, sizeof(m_block_header));
+}
+
+block_compact::block_compact(block & blk)
+    : m_block_header(blk.header())
+    , m_signature(blk.signature())
+    , m_nonce(random::uint64())
+    , m_hash(blk.get_hash())
+{
+    calculate_key();
+    
+    auto & transactions = blk.transactions();
+    
+    for (auto i = 0; i < transactions.size(); i++)
+    {
+        /**
+         * The coinbase and coinstake are never in a transaction_pool.
+         */
+        if (
+            transactions[i].is_coin_base() ||
+            transactions[i].is_coin_stake()
+            )
+        {
+            m_transactions_prefilled.push_back(
+                std::make_pair(i, transactions[i])
+            );
+        }
+        else
+        {
+            m_short_ids.push_back(get_short_id(transactions[i].get_hash()));
+        }
+    }
+}
+
+void block_compact::encode(data_buffer & buffer)
+{
+    buffer.write_uint32(m_block_header.version);
+    buffer.write_sha256(m_block_header.hash_previous_block);
+    buffer.write_sha256(m_block_header.hash_merkle_root);
+    buffer.write_uint32(m_block_header.timestamp);
+    buffer.write_uint32(m_block_header.bits);
+    buffer.write_uint32(m_block_header.nonce);
+    
+    buffer.write_var_int(m_signature.size());
+    
+    if (m_signature.size() > 0)
+    {
+        buffer.write_bytes(
+            reinterpret_cast<const char *> (&m_signature[0]),
+            m_signature.size()
+        );
+    }
+    
+    buffer.write_uint64(m_nonce);
+    
+    buffer.write_var_int(m_short_ids.size());
+    
+    for (auto & i : m_short_ids)
+    {
+        auto bytes = endian::to_little<std::uint64_t> (i);
+        
+        buffer.write_bytes(
+            reinterpret_cast<const char *> (&bytes[0]), short_id_length
+        );
+    }
+    
+    buffer.write_var_int(m_transactions_prefilled.size());
+    
+    for (auto & i : m_transactions_prefilled)
+    {
+        buffer.write_var_int(i.first);
+        
+        i.second.encode(buffer);
+    }
+}
+
+bool block_compact::decode(data_buffer & buffer)
+{
+    m_block_header.version = buffer.read_uint32();
+    m_block_header.hash_previous_block = buffer.read_sha256();
+    m_block_header.hash_merkle_root = buffer.read_sha256();
+    m_block_header.timestamp = buffer.read_uint32();
+    m_block_header.bits = buffer.read_uint32();
+    m_block_header.nonce = buffer.read_uint32();
+    
+    auto len = buffer.read_var_int();
+    
+    if (len > buffer.remaining())
+    {
+        return false;
+    }
+    
+    if (len > 0)
+    {
+        auto bytes = buffer.read_bytes(len);
+        
+        m_signature.insert(m_signature.begin(), bytes.begin(), bytes.end());
+    }
+    
+    m_nonce = buffer.read_uint64();
+    
+    auto count = buffer.read_var_int();
+    
+    if (count > buffer.remaining() / short_id_length)
+    {
+        return false;
+    }
+    
+    for (auto i = 0; i < count; i++)
+    {
+        std::uint8_t bytes[8] = { 0 };
+        
+        buffer.read_bytes(reinterpret_cast<char *> (bytes), short_id_length);
+        
+        m_short_ids.push_back(endian::from_little<std::uint64_t> (bytes));
+    }
+    
+    count = buffer.read_var_int();
+    
+    if (count > buffer.remaining())
+    {
+        return false;
+    }
+    
+    for (auto i = 0; i < count; i++)
+    {
+        auto index = buffer.read_var_int();
+        
+        /**
+         * The indexes must be in ascending order and within the block.
+         */
+        if (
+            index >= m_short_ids.size() + count || (
+            m_transactions_prefilled.size() > 0 &&
+            index <= m_transactions_prefilled.back().first)
+            )
+        {
+            return false;
+        }
+        
+        transaction tx;
+        
+        tx.decode(buffer);
+        
+        m_transactions_prefilled.push_back(
+            std::make_pair(static_cast<std::uint32_t> (index), tx)
+        );
+    }
+    
+    /**
+     * Allocate a temporary (empty) block to calculate the block hash.
+     */
+    block block_tmp;
+    
+    block_tmp.header() = m_block_header;
+    
+    m_hash = block_tmp.get_hash();
+    
+    calculate_key();
+    
+    return true;
+}
+
+const block::header_t & block_compact::block_header() const
+{
+    return m_block_header;
+}
+
+const sha256 & block_compact::get_hash() const
+{
+    return m_hash;
+}
+
+std::size_t block_compact::transaction_count() const
+{
+    return m_short_ids.size() + m_transactions_prefilled.size();
+}
+
+std::uint64_t block_compact::get_short_id(const sha256 & hash_tx) const
+{
+    std::uint8_t buf[sha256::digest_length * 2];
+    
+    std::memcpy(buf, m_key.digest(), sha256::digest_length);
+    std::memcpy(
+        buf + sha256::digest_length, hash_tx.digest(), sha256::digest_length
+    );
+    
+    auto digest = sha256::hash(buf, sizeof(buf));
+    
+    return
+        endian::from_little<std::uint64_t> (&digest[0]) & 0xffffffffffffULL
+    ;
+}
+
+bool block_compact::reconstruct()
+{
+    return reconstruct(transaction_pool::instance().transactions());
+}
+
+template<typename T>
+bool block_compact::reconstruct(const T & transactions)
+{
+    m_transactions.clear();
+    m_transactions.resize(transaction_count());
+    
+    m_indexes_missing.clear();
+    
+    /**
+     * The positions (in the block) of the transactions by short identifier.
+     */
+    std::map<std::uint64_t, std::uint32_t> positions;
+    
+    std::vector<bool> filled(m_transactions.size(), false);
+    
+    for (auto & i : m_transactions_prefilled)
+    {
+        m_transactions[i.first] = i.second;
+        
+        filled[i.first] = true;
+    }
+    
+    std::uint32_t index = 0;
+    
+    for (auto & i : m_short_ids)
+    {
+        while (filled[index])
+        {
+            index++;
+        }
+        
+        if (positions.insert(std::make_pair(i, index)).second == false)
+        {
+            log_debug(
+                "Block compact " << m_hash.to_string().substr(0, 20) <<
+                " has duplicate short identifiers."
+            );
+            
+            return false;
+        }
+        
+        index++;
+    }
+    
+    /**
+     * The positions matched by more than one transaction, they are
+     * requested with getblocktxn instead.
+     */
+    std::set<std::uint32_t> collisions;
+    
+    for (auto & i : transactions)
+    {
+        auto it = positions.find(get_short_id(i.first));
+        
+        if (it != positions.end() && collisions.count(it->second) == 0)
+        {
+            if (filled[it->second])
+            {
+                log_debug(
+                    "Block compact " << m_hash.to_string().substr(0, 20) <<
+                    " short identifier collision at " << it->second << "."
+                );
+                
+                m_transactions[it->second] = transaction();
+                
+                filled[it->second] = false;
+                
+                collisions.insert(it->second);
+            }
+            else
+            {
+                m_transactions[it->second] = i.second;
+                
+                filled[it->second] = true;
+            }
+        }
+    }
+    
+    for (auto i = 0; i < filled.size(); i++)
+    {
+        if (filled[i] == false)
+        {
+            m_indexes_missing.push_back(i);
+        }
+    }
+    
+    return true;
+}
+
+const std::vector<std::uint32_t> & block_compact::indexes_missing() const
+{
+    return m_indexes_missing;
+}
+
+bool block_compact::fill_missing(
+    const std::vector< std::shared_ptr<transaction> > & transactions
+    )
+{
+    if (transactions.size() != m_indexes_missing.size())
+    {
+        return false;
+    }
+    
+    for (auto i = 0; i < transactions.size(); i++)
+    {
+        if (transactions[i] == nullptr)
+        {
+            return false;
+        }
+        
+        m_transactions[m_indexes_missing[i]] = *transactions[i];
+    }
+    
+    m_indexes_missing.clear();
+    
+    return true;
+}
+
+bool block_compact::create_block(block & blk)
+{
+    if (
+        m_indexes_missing.size() > 0 ||
+        m_transactions.size() != transaction_count()
+        )
+    {
+        return false;
+    }
+    
+    blk.set_null();
+    
+    blk.header() = m_block_header;
+    blk.transactions() = m_transactions;
+    blk.signature() = m_signature;
+    
+    /**
+     * The transactions (and thus the short identifier matches) are only
+     * correct if the merkle root of the block is.
+     */
+    if (blk.build_merkle_tree() != m_block_header.hash_merkle_root)
+    {
+        log_debug(
+            "Block compact " << m_hash.to_string().substr(0, 20) <<
+            " reconstructed with invalid merkle root."
+        );
+        
+        return false;
+    }
+    
+    return true;
+}
+
+void block_compact::calculate_key()
+{
+    data_buffer buffer;
+    
+    buffer.write_uint32(m_block_header.version);
+    buffer.write_sha256(m_block_header.hash_previous_block);
+    buffer.write_sha256(m_block_header.hash_merkle_root);
+    buffer.write_uint32(m_block_header.timestamp);
+    buffer.write_uint32(m_block_header.bits);
+    buffer.write_uint32(m_block_header.nonce);
+    buffer.write_uint64(m_nonce);
+    
+    auto digest = sha256::hash(
+        reinterpret_cast<const std::uint8_t *> (buffer.data()), buffer.size()
+    );
+    
+    m_key = sha256::from_digest(&digest[0]);
+}
+
+int block_compact::run_test()
+{
+    std::uint32_t failures = 0;
+    
+    /**
+     * Records (and prints) a failed check, unlike assert it is also
+     * evaluated in release builds.
+     */
+    auto check = [&failures](const bool & ok, const char * what)
+    {
+        if (ok == false)
+        {
+            if (failures++ < 16)
+            {
+                printf("block_compact::run_test: check failed: %s\n", what);
+            }
+        }
+    };
+    
+    /**
+     * Allocate a block with a coinbase and transactions spending random
+     * outputs.
+     */
+    block blk;
+    
+    transaction tx_coinbase;
+    
+    tx_coinbase.transactions_in().push_back(
+        transaction_in(point_out(), script() << 1)
+    );
+    tx_coinbase.transactions_out().push_back(transaction_out(50, script()));
+    
+    blk.transactions().push_back(tx_coinbase);
+    
+    for (auto i = 0; i < 20; i++)
+    {
+        transaction tx;
+        
+        tx.transactions_in().push_back(
+            transaction_in(hash::sha256_random(), i)
+        );
+        tx.transactions_out().push_back(transaction_out(1000 + i, script()));
+        
+        blk.transactions().push_back(tx);
+    }
+    
+    blk.header().hash_merkle_root = blk.build_merkle_tree();
+    
+    block_compact compact(blk);
+    
+    check(compact.get_hash() == blk.get_hash(), "hash");
+    check(compact.transaction_count() == 21, "transaction_count");
+    check(compact.m_transactions_prefilled.size() == 1, "prefilled");
+    
+    /**
+     * The short identifiers are 48 bits, deterministic and keyed per
+     * block_compact.
+     */
+    auto hash_tx = blk.transactions()[1].get_hash();
+    
+    check(
+        compact.get_short_id(hash_tx) < (1ULL << (short_id_length * 8)),
+        "short_id length"
+    );
+    check(
+        compact.get_short_id(hash_tx) == compact.m_short_ids[0],
+        "short_id"
+    );
+    check(
+        block_compact(blk).get_short_id(hash_tx) !=
+        compact.get_short_id(hash_tx), "short_id key"
+    );
+    
+    /**
+     * Round trip the encoding.
+     */
+    data_buffer buffer;
+    
+    compact.encode(buffer);
+    
+    data_buffer buffer_decode(buffer.data(), buffer.size());
+    
+    block_compact decoded;
+    
+    check(decoded.decode(buffer_decode), "decode");
+    check(decoded.get_hash() == compact.get_hash(), "decode hash");
+    check(decoded.m_nonce == compact.m_nonce, "decode nonce");
+    check(decoded.m_short_ids == compact.m_short_ids, "decode short_ids");
+    check(
+        decoded.get_short_id(hash_tx) == compact.get_short_id(hash_tx),
+        "decode short_id"
+    );
+    check(
+        decoded.m_transactions_prefilled.size() == 1 &&
+        decoded.m_transactions_prefilled[0].first == 0 &&
+        decoded.m_transactions_prefilled[0].second.get_hash() ==
+        tx_coinbase.get_hash(), "decode prefilled"
+    );
+    
+    /**
+     * Reconstructs from a pool holding the transactions of the block at
+     * the given positions (and an unrelated transaction).
+     */
+    auto reconstruct_from = [&blk, &buffer](
+        block_compact & ret, const std::set<std::uint32_t> & positions,
+        std::vector< std::pair<sha256, transaction> > pool
+        )
+    {
+        data_buffer buffer_decode(buffer.data(), buffer.size());
+        
+        ret.decode(buffer_decode);
+        
+        transaction tx_unrelated;
+        
+        tx_unrelated.transactions_in().push_back(
+            transaction_in(hash::sha256_random(), 0)
+        );
+        
+        pool.push_back(
+            std::make_pair(tx_unrelated.get_hash(), tx_unrelated)
+        );
+        
+        for (auto & i : positions)
+        {
+            pool.push_back(
+                std::make_pair(
+                blk.transactions()[i].get_hash(), blk.transactions()[i])
+            );
+        }
+        
+        return ret.reconstruct(pool);
+    };
+    
+    /**
+     * Fills the missing transactions and creates the block.
+     */
+    auto complete = [&blk](block_compact & compact)
+    {
+        std::vector< std::shared_ptr<transaction> > transactions;
+        
+        for (auto & i : compact.indexes_missing())
+        {
+            transactions.push_back(
+                std::make_shared<transaction> (blk.transactions()[i])
+            );
+        }
+        
+        block blk_created;
+        
+        return
+            compact.fill_missing(transactions) &&
+            compact.create_block(blk_created) &&
+            blk_created.get_hash() == blk.get_hash() &&
+            blk_created.transactions().size() == blk.transactions().size()
+        ;
+    };
+    
+    std::set<std::uint32_t> positions_all, positions_some;
+    
+    for (auto i = 1; i < blk.transactions().size(); i++)
+    {
+        positions_all.insert(i);
+        
+        if (i % 3)
+        {
+            positions_some.insert(i);
+        }
+    }
+    
+    /**
+     * All of the transactions are in the pool.
+     */
+    block_compact compact_all;
+    
+    check(reconstruct_from(compact_all, positions_all, {}), "all");
+    check(compact_all.indexes_missing().size() == 0, "all missing");
+    check(complete(compact_all), "all create_block");
+    
+    /**
+     * Some of the transactions are in the pool.
+     */
+    block_compact compact_some;
+    
+    check(reconstruct_from(compact_some, positions_some, {}), "some");
+    check(
+        compact_some.indexes_missing().size() ==
+        positions_all.size() - positions_some.size(), "some missing"
+    );
+    check(
+        compact_some.fill_missing(
+        std::vector< std::shared_ptr<transaction> > ()) == false,
+        "some fill_missing count"
+    );
+    check(complete(compact_some), "some create_block");
+    
+    /**
+     * None of the transactions are in the pool.
+     */
+    block_compact compact_none;
+    
+    check(
+        reconstruct_from(compact_none, std::set<std::uint32_t> (), {}),
+        "none"
+    );
+    check(
+        compact_none.indexes_missing().size() == positions_all.size(),
+        "none missing"
+    );
+    check(complete(compact_none), "none create_block");
+    
+    /**
+     * A second transaction matching the short identifier of the first
+     * transaction leaves it missing so that it is requested with
+     * getblocktxn.
+     */
+    transaction tx_colliding;
+    
+    tx_colliding.transactions_in().push_back(
+        transaction_in(hash::sha256_random(), 0)
+    );
+    
+    block_compact compact_collision;
+    
+    check(
+        reconstruct_from(compact_collision, positions_all,
+        { std::make_pair(hash_tx, tx_colliding) }), "collision"
+    );
+    check(
+        compact_collision.indexes_missing() ==
+        std::vector<std::uint32_t> (1, 1), "collision missing"
+    );
+    check(complete(compact_collision), "collision create_block");
+    
+    /**
+     * Duplicate short identifiers in the block_compact itself can not be
+     * resolved with getblocktxn.
+     */
+    block_compact compact_duplicate;
+    
+    reconstruct_from(compact_duplicate, positions_all, {});
+    
+    compact_duplicate.m_short_ids[1] = compact_duplicate.m_short_ids[0];
+    
+    check(
+        compact_duplicate.reconstruct(
+        std::vector< std::pair<sha256, transaction> > ()) == false,
+        "duplicate"
+    );
+    
+    if (failures > 0)
+    {
+        printf(
+            "block_compact::run_test: test 1 failed (%u checks)!\n", failures
+        );
+        
+        return 1;
+    }
+    
+    printf("block_compact::run_test: test 1 passed!\n");
+    
+    return 0;
+}
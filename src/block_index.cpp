@@ -161,12 +161,12 @@ const std::uint32_t & block_index::block_position() const
     return m_block_position;
 }
 
-void block_index::set_chain_trust(const big_number & val)
+void block_index::set_chain_trust(const uint256 & val)
 {
     m_chain_trust = val;
 }
 
-const big_number & block_index::chain_trust() const
+const uint256 & block_index::chain_trust() const
 {
     return m_chain_trust;
 }
@@ -278,13 +278,21 @@ const std::uint32_t & block_index::nonce() const
     return m_nonce;
 }
 
-big_number block_index::get_block_trust()
+uint256 block_index::get_block_trust()
 {
-    big_number target;
+    /**
+     * The proof-of-work limit.
+     */
+    static const uint256 proof_of_work_limit(constants::proof_of_work_limit);
+    
+    bool negative = false;
+    bool overflow = false;
+    
+    uint256 target;
     
-    target.set_compact(m_bits);
+    target.set_compact(m_bits, &negative, &overflow);
     
-    if (target <= 0)
+    if (negative || target == 0)
     {
         return 0;
     }
@@ -292,15 +300,21 @@ big_number block_index::get_block_trust()
     if (is_proof_of_stake())
     {
         /**
-         * Return the trust score.
+         * Return the trust score, 2^256 / (target + 1) computed as
+         * (~target / (target + 1)) + 1 to stay within 256 bits.
          */
-        return (big_number(1) << 256) / (target + 1);
+        return overflow ? 0 : (~target / (target + 1)) + 1;
+    }
+    
+    if (overflow)
+    {
+        return 1;
     }
     
     /**
      * Calculate the work amount for the block.
      */
-    big_number pow_trust = constants::proof_of_work_limit / (target + 1);
+    auto pow_trust = proof_of_work_limit / (target + 1);
     
     return pow_trust > 1 ? pow_trust : 1;
 }
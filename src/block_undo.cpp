@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <coin/block_undo.hpp>
+#include <coin/constants.hpp>
+
+using namespace coin;
+
+block_undo::block_undo()
+{
+    set_null();
+}
+
+void block_undo::encode()
+{
+    encode(*this);
+}
+
+void block_undo::encode(data_buffer & buffer)
+{
+    /**
+     * Write the version.
+     */
+    buffer.write_uint32(constants::version_client);
+    
+    buffer.write_var_int(m_spent_outputs.size());
+    
+    for (auto & i : m_spent_outputs)
+    {
+        buffer.write_var_int(i.size());
+        
+        for (auto & j : i)
+        {
+            j.encode(buffer);
+        }
+    }
+    
+    buffer.write_var_int(m_spent_points.size());
+    
+    for (auto & i : m_spent_points)
+    {
+        buffer.write_sha256(i.get_hash());
+        buffer.write_var_int(i.n());
+    }
+}
+
+void block_undo::decode()
+{
+    decode(*this);
+}
+
+void block_undo::decode(data_buffer & buffer)
+{
+    set_null();
+    
+    /**
+     * Read the version.
+     */
+    buffer.read_uint32();
+    
+    auto count = buffer.read_var_int();
+    
+    m_spent_outputs.resize(count);
+    
+    for (auto & i : m_spent_outputs)
+    {
+        auto len = buffer.read_var_int();
+        
+        i.resize(len);
+        
+        for (auto & j : i)
+        {
+            j.decode(buffer);
+        }
+    }
+    
+    count = buffer.read_var_int();
+    
+    m_spent_points.reserve(count);
+    
+    for (auto i = 0; i < count; i++)
+    {
+        auto hash = buffer.read_sha256();
+        auto n = static_cast<std::uint32_t> (buffer.read_var_int());
+        
+        m_spent_points.push_back(point_out(hash, n));
+    }
+}
+
+void block_undo::set_null()
+{
+    m_spent_outputs.clear();
+    m_spent_points.clear();
+}
+
+std::vector< std::vector<transaction_out> > & block_undo::spent_outputs()
+{
+    return m_spent_outputs;
+}
+
+const std::vector<
+    std::vector<transaction_out>
+> & block_undo::spent_outputs() const
+{
+    return m_spent_outputs;
+}
+
+std::vector<point_out> & block_undo::spent_points()
+{
+    return m_spent_points;
+}
+
+const std::vector<point_out> & block_undo::spent_points() const
+{
+    return m_spent_points;
+}
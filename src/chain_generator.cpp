@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <future>
+#include <set>
+#include <thread>
+
+#include <coin/benchmark.hpp>
+#include <coin/big_number.hpp>
+#include <coin/block.hpp>
+#include <coin/block_index.hpp>
+#include <coin/chain_generator.hpp>
+#include <coin/constants.hpp>
+#include <coin/globals.hpp>
+#include <coin/key_reserved.hpp>
+#include <coin/logger.hpp>
+#include <coin/mining.hpp>
+#include <coin/stack_impl.hpp>
+#include <coin/time.hpp>
+#include <coin/transaction_wallet.hpp>
+#include <coin/wallet.hpp>
+
+using namespace coin;
+
+chain_generator::chain_generator(
+    stack_impl & owner, const std::uint32_t & blocks,
+    const std::uint32_t & transactions, const std::uint32_t & outputs,
+    const std::string & script_type
+    )
+    : m_blocks(blocks)
+    , m_transactions(transactions)
+    , m_outputs(outputs > 0 ? outputs : 1)
+    , m_script_type(script_type)
+    , m_script_index(0)
+    , stack_impl_(owner)
+{
+    // ...
+}
+
+bool chain_generator::run()
+{
+    if (globals::instance().is_regtest() == false)
+    {
+        log_error("Chain generator requires a regression test chain.");
+        
+        return false;
+    }
+    
+    /**
+     * Wait for the stack to finish starting.
+     */
+    while (globals::instance().state() == globals::state_starting)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    
+    auto w = globals::instance().wallet_main();
+    
+    if (w == nullptr || w->is_locked())
+    {
+        log_error("Chain generator requires an unlocked wallet.");
+        
+        return false;
+    }
+    
+    /**
+     * Generate the keys the outputs pay to.
+     */
+    for (auto i = 0; i < key_ring_size; i++)
+    {
+        auto public_key = w->generate_new_key();
+        
+        script script_public_key;
+        
+        if (m_script_type == "p2pk")
+        {
+            script_public_key << public_key << script::op_checksig;
+        }
+        else
+        {
+            script_public_key.set_destination(public_key.get_id());
+        }
+        
+        m_scripts.push_back(script_public_key);
+    }
+    
+    log_info(
+        "Chain generator is generating " << m_blocks << " blocks with " <<
+        m_transactions << " transactions of " << m_outputs << " " <<
+        m_script_type << " outputs."
+    );
+    
+    std::uint32_t extra_nonce = 0;
+    
+    std::uint64_t transactions = 0;
+    
+    std::uint32_t blocks = 0;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    while (
+        blocks < m_blocks &&
+        globals::instance().state() == globals::state_started
+        )
+    {
+        /**
+         * Fill the transaction pool (coinbases must first mature).
+         */
+        create_transactions(w);
+        
+        auto blk = block::create_new(w, false);
+        
+        if (blk == nullptr)
+        {
+            log_error("Chain generator failed to create block.");
+            
+            return false;
+        }
+        
+        auto index_previous = stack_impl::get_block_index_best();
+        
+        /**
+         * Set the coinbase script signature (height and extra nonce).
+         */
+        blk->transactions()[0].transactions_in()[0].set_script_signature(
+            (script() << (index_previous->height() + 1) <<
+            big_number(++extra_nonce)) + globals::instance().coinbase_flags()
+        );
+        
+        blk->header().hash_merkle_root = blk->build_merkle_tree();
+        
+        /**
+         * Blocks are generated much faster than the target spacing, advance
+         * the clock when the median time past approaches the maximum clock
+         * drift.
+         */
+        auto time_maximum =
+            time::instance().get_adjusted() + constants::max_clock_drift
+        ;
+        
+        if (blk->header().timestamp + 5 * 60 > time_maximum)
+        {
+            time::instance().advance(
+                blk->header().timestamp + 5 * 60 - time_maximum
+            );
+        }
+        
+        if (mine(blk) == false)
+        {
+            return false;
+        }
+        
+        if (blk->sign(*w) == false)
+        {
+            log_error("Chain generator failed to sign block.");
+            
+            return false;
+        }
+        
+        if (process_block(blk) == false)
+        {
+            log_error(
+                "Chain generator failed to process block " <<
+                blk->get_hash().to_string() << "."
+            );
+            
+            return false;
+        }
+        
+        transactions += blk->transactions().size();
+        
+        if (++blocks % 100 == 0)
+        {
+            log_info(
+                "Chain generator generated " << blocks << "/" << m_blocks <<
+                " blocks, " << transactions << " transactions."
+            );
+        }
+    }
+    
+    auto elapsed = std::chrono::duration<double> (
+        std::chrono::steady_clock::now() - start
+    ).count();
+    
+    log_info(
+        "Chain generator generated " << blocks << " blocks (" <<
+        transactions << " transactions) in " << elapsed << " seconds."
+    );
+    
+    log_info(
+        benchmark::to_json(
+        benchmark::result_t{"chain_generator_blocks", blocks, elapsed, 0, 0})
+    );
+    
+    return blocks == m_blocks;
+}
+
+std::uint32_t chain_generator::create_transactions(
+    const std::shared_ptr<wallet> & w
+    )
+{
+    std::uint32_t ret = 0;
+    
+    for (auto i = 0; i < m_transactions; i++)
+    {
+        std::vector< std::pair<script, std::int64_t> > scripts;
+        
+        for (auto j = 0; j < m_outputs; j++)
+        {
+            scripts.push_back(
+                std::make_pair(m_scripts[m_script_index++ % m_scripts.size()],
+                constants::cent)
+            );
+        }
+        
+        transaction_wallet wtx;
+        
+        key_reserved k(*w);
+        
+        std::int64_t fee = 0;
+        
+        /**
+         * Do not filter any coin denominations.
+         */
+        std::set<std::int64_t> filter;
+        
+        std::lock_guard<std::recursive_mutex> l1(stack_impl::mutex());
+        
+        /**
+         * Stop at the first failure, the wallet has no more mature coins.
+         */
+        if (
+            w->create_transaction(
+            scripts, wtx, k, fee, filter, 0, false, false) == false
+            )
+        {
+            break;
+        }
+        
+        if (w->commit_transaction(wtx, k, false).first == false)
+        {
+            break;
+        }
+        
+        ret++;
+    }
+    
+    return ret;
+}
+
+bool chain_generator::mine(const std::shared_ptr<block> & blk)
+{
+    auto hash_target =
+        big_number().set_compact(blk->header().bits).get_sha256()
+    ;
+    
+    block::header_t header_out;
+    
+    sha256 result;
+    
+    while (globals::instance().state() == globals::state_started)
+    {
+        std::uint32_t hashes = 0;
+        
+        auto nonce = mining::scan_hash_blake256(
+            &blk->header(), 0xffff0000, hashes, result.digest(), &header_out
+        );
+        
+        if (nonce == static_cast<std::uint32_t> (-1))
+        {
+            /**
+             * The nonce space is exhausted, advance the time.
+             */
+            blk->header().nonce = 0;
+            blk->header().timestamp++;
+            
+            continue;
+        }
+        
+        /**
+         * Continue scanning after this nonce if it misses the target.
+         */
+        blk->header().nonce = nonce;
+        
+        if (result <= hash_target)
+        {
+            if (result != blk->get_hash())
+            {
+                log_error(
+                    "Chain generator solved block hash mismatch, " <<
+                    result.to_string() << ":" <<
+                    blk->get_hash().to_string() << "."
+                );
+                
+                return false;
+            }
+            
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool chain_generator::process_block(const std::shared_ptr<block> & blk)
+{
+    auto promise = std::make_shared< std::promise<bool> > ();
+    
+    auto future = promise->get_future();
+    
+    /**
+     * The block is processed on the strand, the next block is built on it
+     * so wait for the result.
+     */
+    globals::instance().io_service().post(globals::instance().strand().wrap(
+        [this, blk, promise]()
+    {
+        promise->set_value(stack_impl_.process_block(0, blk));
+    }));
+    
+    while (
+        future.wait_for(std::chrono::seconds(1)) != std::future_status::ready
+        )
+    {
+        if (globals::instance().state() != globals::state_started)
+        {
+            return false;
+        }
+    }
+    
+    return future.get();
+}
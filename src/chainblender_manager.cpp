@@ -254,7 +254,9 @@ void chainblender_manager::connect(const boost::asio::ip::tcp::endpoint & ep)
     /**
      * Allocate tcp_transport.
      */
-    auto transport = std::make_shared<tcp_transport> (io_service_, strand_);
+    auto transport = std::make_shared<tcp_transport> (
+        globals::instance().io_service_network()
+    );
 
     /**
      * Allocate the tcp_connection.
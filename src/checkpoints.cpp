@@ -134,6 +134,14 @@ bool checkpoints::check_hardened(
     const std::int32_t & height, const sha256 & hash
     )
 {
+    /**
+     * A regression test chain doesn't have checkpoints.
+     */
+    if (globals::instance().is_regtest())
+    {
+        return true;
+    }
+    
     auto & checkpoints =
         (constants::test_net ?
         m_checkpoints_test_net : m_checkpoints)
@@ -156,9 +164,9 @@ bool checkpoints::check_sync(
     std::lock_guard<std::recursive_mutex> l1(mutex_);
     
     /**
-     * The test net doesn't have checkpoints.
+     * The test net and regression test chains don't have checkpoints.
      */
-    if (constants::test_net)
+    if (constants::test_net || globals::instance().is_regtest())
     {
         return true;
     }
@@ -345,6 +353,11 @@ std::uint32_t checkpoints::get_total_blocks_estimate()
 {
     std::lock_guard<std::recursive_mutex> l1(mutex_);
     
+    if (globals::instance().is_regtest())
+    {
+        return 0;
+    }
+    
     return (
         constants::test_net ? m_checkpoints_test_net : m_checkpoints
     ).rbegin()->first;
@@ -41,6 +41,7 @@ using namespace coin;
 configuration::configuration()
     : m_network_port_tcp(protocol::default_tcp_port)
     , m_network_tcp_inbound_maximum(network::tcp_inbound_maximum)
+    , m_network_tcp_threads(0)
     , m_network_udp_enable(true)
     , m_wallet_transaction_history_maximum(wallet::configuration_interval_history)
     , m_wallet_keypool_size(wallet::configuration_keypool_size)
@@ -54,6 +55,9 @@ configuration::configuration()
     , m_database_cache_size(db_env::default_cache_size)
     , m_wallet_deterministic(true)
     , m_db_private(false)
+    , m_address_index(false)
+    , m_prune_transaction_index(false)
+    , m_compact_transaction_index(false)
 {
     // ...
 }
@@ -90,8 +94,7 @@ bool configuration::load()
          * Get the network.tcp.port
          */
         m_network_port_tcp = std::stoul(
-            pt.get("network.tcp.port",
-            std::to_string(protocol::default_tcp_port))
+            pt.get("network.tcp.port", std::to_string(m_network_port_tcp))
         );
         
         log_debug(
@@ -120,6 +123,26 @@ bool configuration::load()
             m_network_tcp_inbound_maximum = network::tcp_inbound_minimum;
         }
         
+        /**
+         * Get the network.tcp.threads.
+         */
+        m_network_tcp_threads = std::stoul(pt.get(
+            "network.tcp.threads", std::to_string(0))
+        );
+        
+        log_debug(
+            "Configuration read network.tcp.threads = " <<
+            m_network_tcp_threads << "."
+        );
+        
+        /**
+         * Enforce the maximum network.tcp.threads.
+         */
+        if (m_network_tcp_threads > network::tcp_threads_maximum)
+        {
+            m_network_tcp_threads = network::tcp_threads_maximum;
+        }
+        
         /**
          * Get the network.udp.enable.
          */
@@ -289,6 +312,49 @@ bool configuration::load()
         log_debug(
             "Configuration read database.private = " << m_db_private << "."
         );
+        
+        /**
+         * Get the database.address_index.
+         */
+        m_address_index = std::stoi(pt.get(
+            "database.address_index", std::to_string(m_address_index))
+        );
+        
+        log_debug(
+            "Configuration read database.address_index = " <<
+            m_address_index << "."
+        );
+        
+        /**
+         * Get the database.prune_transaction_index. Only the indexes of
+         * transactions fully spent at or below the last checkpoint are
+         * pruned, those above it are still needed by proof-of-stake and
+         * fork validation. A pruned transaction is no longer found by
+         * hash so getrawtransaction and the already have checks of the
+         * transaction_pool treat it as unknown.
+         */
+        m_prune_transaction_index = std::stoi(pt.get(
+            "database.prune_transaction_index",
+            std::to_string(m_prune_transaction_index))
+        );
+        
+        log_debug(
+            "Configuration read database.prune_transaction_index = " <<
+            m_prune_transaction_index << "."
+        );
+        
+        /**
+         * Get the database.compact_transaction_index.
+         */
+        m_compact_transaction_index = std::stoi(pt.get(
+            "database.compact_transaction_index",
+            std::to_string(m_compact_transaction_index))
+        );
+        
+        log_debug(
+            "Configuration read database.compact_transaction_index = " <<
+            m_compact_transaction_index << "."
+        );
     }
     catch (std::exception & e)
     {
@@ -333,6 +399,13 @@ bool configuration::save()
             std::to_string(m_network_tcp_inbound_maximum)
         );
         
+        /**
+         * Put the network.tcp.threads into property tree.
+         */
+        pt.put(
+            "network.tcp.threads", std::to_string(m_network_tcp_threads)
+        );
+        
         /**
          * Put the network.udp.enable into property tree.
          */
@@ -430,6 +503,29 @@ bool configuration::save()
             "database.private", std::to_string(m_db_private)
         );
         
+        /**
+         * Put the database.address_index into property tree.
+         */
+        pt.put(
+            "database.address_index", std::to_string(m_address_index)
+        );
+        
+        /**
+         * Put the database.prune_transaction_index into property tree.
+         */
+        pt.put(
+            "database.prune_transaction_index",
+            std::to_string(m_prune_transaction_index)
+        );
+        
+        /**
+         * Put the database.compact_transaction_index into property tree.
+         */
+        pt.put(
+            "database.compact_transaction_index",
+            std::to_string(m_compact_transaction_index)
+        );
+        
         /**
          * The std::stringstream.
          */
@@ -504,6 +600,23 @@ const std::size_t & configuration::network_tcp_inbound_maximum() const
     return m_network_tcp_inbound_maximum;
 }
 
+void configuration::set_network_tcp_threads(const std::size_t & val)
+{
+    if (val > network::tcp_threads_maximum)
+    {
+        m_network_tcp_threads = network::tcp_threads_maximum;
+    }
+    else
+    {
+        m_network_tcp_threads = val;
+    }
+}
+
+const std::size_t & configuration::network_tcp_threads() const
+{
+    return m_network_tcp_threads;
+}
+
 void configuration::set_network_udp_enable(const bool & val)
 {
     m_network_udp_enable = val;
@@ -565,3 +678,33 @@ const bool & configuration::db_private() const
 {
     return m_db_private;
 }
+
+void configuration::set_address_index(const bool & val)
+{
+    m_address_index = val;
+}
+
+const bool & configuration::address_index() const
+{
+    return m_address_index;
+}
+
+void configuration::set_prune_transaction_index(const bool & val)
+{
+    m_prune_transaction_index = val;
+}
+
+const bool & configuration::prune_transaction_index() const
+{
+    return m_prune_transaction_index;
+}
+
+void configuration::set_compact_transaction_index(const bool & val)
+{
+    m_compact_transaction_index = val;
+}
+
+const bool & configuration::compact_transaction_index() const
+{
+    return m_compact_transaction_index;
+}
@@ -170,8 +170,8 @@ void db::close()
             /**
              * -dblogsize
              */
-            stack_impl::get_db_env()->get_DbEnv().txn_checkpoint(
-                minutes ? 100 * 1024 : 0, minutes, 0
+            stack_impl::get_db_env()->request_checkpoint(
+                minutes ? 100 * 1024 : 0, minutes
             );
 
             --stack_impl::get_db_env()->file_use_counts()[m_file_name];
@@ -28,11 +28,14 @@
 #endif // _MSC_VER
 
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <sstream>
 
 #include <coin/db_env.hpp>
 #include <coin/globals.hpp>
 #include <coin/logger.hpp>
+#include <coin/metrics.hpp>
 #include <coin/utility.hpp>
 
 static void errcall(const DbEnv *, const char * arg1, const char * arg2)
@@ -62,8 +65,10 @@ std::recursive_mutex db_env::g_mutex_DbEnv;
 db_env::db_env()
     : m_DbEnv(DB_CXX_NO_EXCEPTIONS)
     , state_(state_closed)
+    , maintenance_stop_(false)
+    , maintenance_requested_(false)
 {
-    // ...
+    std::memset(&m_maintenance_stats, 0, sizeof(m_maintenance_stats));
 }
 
 db_env::~db_env()
@@ -154,6 +159,11 @@ bool db_env::open(const std::int32_t & cache_size)
         else
         {
             state_ = state_opened;
+            
+            /**
+             * Checkpoints are performed on the maintenance thread.
+             */
+            start_maintenance();
         }
 
         return ret == 0;
@@ -170,6 +180,8 @@ void db_env::close_DbEnv()
 {
     if (state_ == state_opened)
     {
+        stop_maintenance();
+        
         state_ = state_closed;
         
         std::lock_guard<std::recursive_mutex> l1(g_mutex_DbEnv);
@@ -304,6 +316,15 @@ void db_env::checkpoint_lsn(const std::string & file_name)
 
 void db_env::flush(const bool & detach_db)
 {
+    /**
+     * Record the latency.
+     */
+    static auto & g_histogram = metrics::instance().get_histogram(
+        "db_env_flush"
+    );
+    
+    metrics::scoped_timer timer_metrics(g_histogram);
+    
     if (state_ == state_opened)
     {
         std::lock_guard<std::recursive_mutex> l1(mutex_file_use_counts_);
@@ -420,3 +441,235 @@ DbTxn * db_env::txn_begin(int flags)
     
     return ptr;
 }
+
+void db_env::start_maintenance()
+{
+    if (thread_maintenance_.joinable() == false)
+    {
+        maintenance_stop_ = false;
+        
+        thread_maintenance_ = std::thread(&db_env::do_maintenance, this);
+    }
+}
+
+void db_env::stop_maintenance()
+{
+    if (thread_maintenance_.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> l1(mutex_maintenance_);
+            
+            maintenance_stop_ = true;
+        }
+        
+        condition_maintenance_.notify_one();
+        
+        thread_maintenance_.join();
+    }
+}
+
+void db_env::request_checkpoint(
+    const std::uint32_t & kbytes, const std::uint32_t & minutes
+    )
+{
+    if (thread_maintenance_.joinable())
+    {
+        /**
+         * Thresholds are covered by the maintenance thread's own policy,
+         * only an unconditional checkpoint needs to wake it.
+         */
+        if (kbytes == 0 && minutes == 0)
+        {
+            {
+                std::lock_guard<std::mutex> l1(mutex_maintenance_);
+                
+                maintenance_requested_ = true;
+            }
+            
+            condition_maintenance_.notify_one();
+        }
+    }
+    else
+    {
+        std::lock_guard<std::recursive_mutex> l1(g_mutex_DbEnv);
+        
+        m_DbEnv.txn_checkpoint(kbytes, minutes, 0);
+    }
+}
+
+db_env::maintenance_stats_t db_env::maintenance_stats()
+{
+    std::lock_guard<std::mutex> l1(mutex_maintenance_stats_);
+    
+    return m_maintenance_stats;
+}
+
+void db_env::do_maintenance()
+{
+    auto time_checkpoint = std::chrono::steady_clock::now();
+    
+    std::uint32_t interval = 5;
+    
+    while (maintenance_stop_ == false)
+    {
+        auto requested = false;
+        
+        {
+            std::unique_lock<std::mutex> l1(mutex_maintenance_);
+            
+            condition_maintenance_.wait_for(
+                l1, std::chrono::seconds(interval), [this]
+                {
+                    return maintenance_stop_ || maintenance_requested_;
+                }
+            );
+            
+            requested = maintenance_requested_;
+            
+            maintenance_requested_ = false;
+        }
+        
+        if (maintenance_stop_)
+        {
+            break;
+        }
+        
+        update_stats();
+        
+        auto log_bytes_checkpoint =
+            maintenance_stats().log_bytes_checkpoint
+        ;
+        
+        auto elapsed = std::chrono::duration_cast<std::chrono::seconds> (
+            std::chrono::steady_clock::now() - time_checkpoint
+        ).count();
+        
+        /**
+         * Checkpoint once enough log has been written or, when there is
+         * any log activity, once the maximum interval has passed.
+         */
+        if (
+            log_bytes_checkpoint >= checkpoint_log_bytes ||
+            (log_bytes_checkpoint > 0 &&
+            (elapsed >= checkpoint_interval_max || requested))
+            )
+        {
+            checkpoint();
+            
+            time_checkpoint = std::chrono::steady_clock::now();
+        }
+        
+        /**
+         * Adapt the polling interval to the log volume.
+         */
+        if (log_bytes_checkpoint >= checkpoint_log_bytes / 2)
+        {
+            interval = 1;
+        }
+        else if (log_bytes_checkpoint == 0)
+        {
+            interval = 30;
+        }
+        else
+        {
+            interval = 5;
+        }
+        
+        std::lock_guard<std::mutex> l1(mutex_maintenance_stats_);
+        
+        m_maintenance_stats.checkpoint_interval = interval;
+    }
+}
+
+void db_env::checkpoint()
+{
+    auto start = std::chrono::steady_clock::now();
+    
+    auto ret = m_DbEnv.txn_checkpoint(0, 0, 0);
+    
+    if (ret != 0)
+    {
+        log_error(
+            "Database environment checkpoint failed, error = " <<
+            DbEnv::strerror(ret) << "."
+        );
+        
+        return;
+    }
+    
+    /**
+     * Remove the log files that are no longer needed.
+     */
+    char ** list = 0;
+    
+    m_DbEnv.log_archive(&list, DB_ARCH_REMOVE);
+    
+    if (list)
+    {
+        free(list);
+    }
+    
+    auto duration = static_cast<std::uint32_t> (
+        std::chrono::duration_cast<std::chrono::milliseconds> (
+        std::chrono::steady_clock::now() - start).count()
+    );
+    
+    log_debug(
+        "Database environment checkpoint took " << duration << " ms."
+    );
+    
+    std::lock_guard<std::mutex> l1(mutex_maintenance_stats_);
+    
+    m_maintenance_stats.checkpoints++;
+    m_maintenance_stats.checkpoint_duration_last = duration;
+    
+    if (duration > m_maintenance_stats.checkpoint_duration_max)
+    {
+        m_maintenance_stats.checkpoint_duration_max = duration;
+    }
+    
+    m_maintenance_stats.log_bytes_checkpoint = 0;
+}
+
+void db_env::update_stats()
+{
+    DB_LOG_STAT * log_stat = 0;
+    DB_MPOOL_STAT * mpool_stat = 0;
+    
+    if (m_DbEnv.log_stat(&log_stat, 0) == 0 && log_stat)
+    {
+        std::lock_guard<std::mutex> l1(mutex_maintenance_stats_);
+        
+        m_maintenance_stats.log_bytes =
+            static_cast<std::uint64_t> (log_stat->st_w_mbytes) * 1048576 +
+            log_stat->st_w_bytes
+        ;
+        m_maintenance_stats.log_bytes_checkpoint =
+            static_cast<std::uint64_t> (log_stat->st_wc_mbytes) * 1048576 +
+            log_stat->st_wc_bytes
+        ;
+    }
+    
+    if (log_stat)
+    {
+        free(log_stat);
+    }
+    
+    if (m_DbEnv.memp_stat(&mpool_stat, 0, 0) == 0 && mpool_stat)
+    {
+        std::lock_guard<std::mutex> l1(mutex_maintenance_stats_);
+        
+        m_maintenance_stats.cache_hits = mpool_stat->st_cache_hit;
+        m_maintenance_stats.cache_misses = mpool_stat->st_cache_miss;
+        m_maintenance_stats.cache_bytes =
+            static_cast<std::uint64_t> (mpool_stat->st_gbytes) *
+            1024 * 1024 * 1024 + mpool_stat->st_bytes
+        ;
+        m_maintenance_stats.cache_pages_evicted = mpool_stat->st_page_out;
+    }
+    
+    if (mpool_stat)
+    {
+        free(mpool_stat);
+    }
+}
@@ -22,8 +22,10 @@
 #include <sstream>
 #include <vector>
 
+#include <coin/address_index.hpp>
 #include <coin/block.hpp>
 #include <coin/block_index_disk.hpp>
+#include <coin/block_undo.hpp>
 #include <coin/checkpoints.hpp>
 #include <coin/data_buffer.hpp>
 #include <coin/db_env.hpp>
@@ -682,6 +684,11 @@ bool db_tx::update_transaction_index(
 }
 
 bool db_tx::erase_transaction_index(const transaction & tx) const
+{
+    return erase_transaction_index(tx.get_hash());
+}
+
+bool db_tx::erase_transaction_index(const sha256 & hash) const
 {
     std::string key_tx = "tx";
     
@@ -692,11 +699,339 @@ bool db_tx::erase_transaction_index(const transaction & tx) const
     buffer.write_var_int(key_tx.size());
     buffer.write_bytes(key_tx.data(), key_tx.size());
     
-    buffer.write_sha256(tx.get_hash());
+    buffer.write_sha256(hash);
+
+    return erase(buffer);
+}
+
+bool db_tx::compact_transaction_indexes(
+    const std::size_t & limit, bool & finished
+    )
+{
+    finished = false;
+    
+    std::string val;
+    
+    if (read_string("strTxIndexCompact", val))
+    {
+        finished = true;
+        
+        return true;
+    }
+    
+    /**
+     * Read where the previous batch stopped.
+     */
+    sha256 hash_next;
+    
+    if (read_sha256("hashTxIndexCompact", hash_next) == false)
+    {
+        hash_next = 0;
+    }
+    
+    std::string key_tx = "tx";
+    
+    std::vector< std::pair<sha256, transaction_index> > pending;
+    
+    auto * ptr_cursor = get_cursor();
+
+    if (ptr_cursor == 0)
+    {
+        return false;
+    }
+    
+    std::int32_t flags = DB_SET_RANGE;
+    
+    std::size_t visited = 0;
+    
+    for (;;)
+    {
+        data_buffer key, value;
+        
+        if (flags == DB_SET_RANGE)
+        {
+            key.write_var_int(key_tx.size());
+            key.write_bytes(key_tx.data(), key_tx.size());
+            key.write_sha256(hash_next);
+        }
+        
+        auto ret = read_at_cursor(ptr_cursor, key, value, flags);
+        
+        flags = DB_NEXT;
+        
+        if (ret == DB_NOTFOUND)
+        {
+            finished = true;
+            
+            break;
+        }
+        else if (ret != 0)
+        {
+            ptr_cursor->close();
+            
+            return false;
+        }
+        
+        if (
+            key.size() != 1 + key_tx.size() + sha256::digest_length ||
+            key.read_var_int() != key_tx.size() ||
+            std::memcmp(key.read_bytes(key_tx.size()).data(),
+            key_tx.data(), key_tx.size()) != 0
+            )
+        {
+            finished = true;
+            
+            break;
+        }
+        
+        auto hash = key.read_sha256();
+        
+        /**
+         * Stop at the first record of the next batch.
+         */
+        if (visited++ == limit)
+        {
+            hash_next = hash;
+            
+            break;
+        }
+        
+        if (
+            transaction_index::is_encoding_compact(
+            value.read_uint32()) == false
+            )
+        {
+            value.seek(0);
+            
+            transaction_index index;
+            
+            index.decode(value);
+            
+            pending.push_back(std::make_pair(hash, index));
+        }
+    }
+    
+    ptr_cursor->close();
+    
+    if (txn_begin() == false)
+    {
+        return false;
+    }
+    
+    for (auto & i : pending)
+    {
+        if (update_transaction_index(i.first, i.second) == false)
+        {
+            txn_abort();
+            
+            return false;
+        }
+    }
+    
+    if (finished)
+    {
+        write_string("strTxIndexCompact", "1");
+    }
+    else
+    {
+        write_sha256("hashTxIndexCompact", hash_next);
+    }
+    
+    if (txn_commit() == false)
+    {
+        return false;
+    }
+    
+    log_debug(
+        "DB TX compacted " << pending.size() << " transaction indexes."
+    );
+    
+    return true;
+}
+
+bool db_tx::read_block_undo(const sha256 & hash, block_undo & value)
+{
+    value.set_null();
+    
+    std::string key_undo = "blockundo";
+    
+    data_buffer buffer;
+
+    buffer.reserve(64);
+    
+    buffer.write_var_int(key_undo.size());
+    buffer.write_bytes(key_undo.data(), key_undo.size());
+    
+    buffer.write_sha256(hash);
+    
+    return read(buffer, value);
+}
+
+bool db_tx::write_block_undo(const sha256 & hash, block_undo & value)
+{
+    return write(std::make_pair(std::string("blockundo"), hash), value);
+}
+
+bool db_tx::erase_block_undo(const sha256 & hash)
+{
+    std::string key_undo = "blockundo";
+    
+    data_buffer buffer;
+
+    buffer.reserve(64);
+    
+    buffer.write_var_int(key_undo.size());
+    buffer.write_bytes(key_undo.data(), key_undo.size());
+    
+    buffer.write_sha256(hash);
 
     return erase(buffer);
 }
 
+bool db_tx::read_address_index(
+    const data_buffer & key, address_index & value
+    )
+{
+    /**
+     * The read clears the key so read using a copy of it.
+     */
+    data_buffer key_data(key.data(), key.size());
+    
+    return read(key_data, value);
+}
+
+bool db_tx::write_address_index(
+    const data_buffer & key, address_index & value
+    )
+{
+    if (m_Db == 0)
+    {
+        return false;
+    }
+
+    /**
+     * The key is already prefixed so it is written as is.
+     */
+    data_buffer key_data(key.data(), key.size());
+    
+    Dbt dat_key(
+        (void *)key_data.data(), static_cast<std::uint32_t> (key_data.size())
+    );
+    
+    data_buffer value_data;
+
+    value_data.reserve(64);
+    
+    value.encode(value_data);
+
+    Dbt dat_value(
+        (void *)value_data.data(),
+        static_cast<std::uint32_t> (value_data.size())
+    );
+
+    auto ret = db_put(m_DbTxn, &dat_key, &dat_value, 0);
+
+    std::memset(dat_key.get_data(), 0, dat_key.get_size());
+    std::memset(dat_value.get_data(), 0, dat_value.get_size());
+    
+    return ret == 0;
+}
+
+bool db_tx::erase_address_index(const data_buffer & key)
+{
+    data_buffer key_data(key.data(), key.size());
+    
+    return erase(key_data);
+}
+
+bool db_tx::read_address_indexes(
+    const data_buffer & key_start, const std::size_t & prefix_length,
+    const data_buffer & key_end,
+    std::vector< std::pair<data_buffer, address_index> > & records
+    )
+{
+    auto * ptr_cursor = get_cursor();
+
+    if (ptr_cursor == 0)
+    {
+        return false;
+    }
+    
+    std::int32_t flags = DB_SET_RANGE;
+    
+    for (;;)
+    {
+        data_buffer key, value;
+        
+        if (flags == DB_SET_RANGE)
+        {
+            key.write_bytes(key_start.data(), key_start.size());
+        }
+        
+        auto ret = read_at_cursor(ptr_cursor, key, value, flags);
+        
+        flags = DB_NEXT;
+        
+        if (ret == DB_NOTFOUND)
+        {
+            break;
+        }
+        else if (ret != 0)
+        {
+            ptr_cursor->close();
+            
+            return false;
+        }
+        
+        /**
+         * Stop once the key no longer shares the prefix.
+         */
+        if (
+            key.size() < prefix_length ||
+            std::memcmp(key.data(), key_start.data(), prefix_length) != 0
+            )
+        {
+            break;
+        }
+        
+        /**
+         * Stop once the key is past the end of the requested range so that
+         * the records after it are never read.
+         */
+        if (
+            key_end.size() > 0 && (key.size() < key_end.size() ||
+            std::memcmp(key.data(), key_end.data(), key_end.size()) > 0)
+            )
+        {
+            break;
+        }
+        
+        address_index index;
+        
+        try
+        {
+            index.decode(value);
+        }
+        catch (std::exception & e)
+        {
+            log_error(
+                "DB TX failed to decode address index, what = " <<
+                e.what() << "."
+            );
+            
+            ptr_cursor->close();
+            
+            return false;
+        }
+        
+        records.push_back(std::make_pair(key, index));
+    }
+    
+    ptr_cursor->close();
+    
+    return true;
+}
+
 bool db_tx::write_hash_best_chain(const sha256 & hash)
 {
     return write_sha256("hashBestChain", hash);
@@ -1200,7 +1535,7 @@ bool db_tx::read_string(const std::string & key, std::string & val)
     
     dbt_value.set_flags(DB_DBT_MALLOC);
     
-    auto ret = m_Db->get(m_DbTxn, &dbt_key, &dbt_value, 0);
+    auto ret = db_get(m_DbTxn, &dbt_key, &dbt_value, 0);
     
     std::memset(dbt_key.get_data(), 0, dbt_key.get_size());
     
@@ -1257,7 +1592,7 @@ bool db_tx::write_string(
         (void *)value.data(), static_cast<std::uint32_t> (value.size())
     );
 
-    auto ret = m_Db->put(
+    auto ret = db_put(
         m_DbTxn, &dat_key, &dat_value, overwrite ? 0 : DB_NOOVERWRITE
     );
 
@@ -1292,7 +1627,7 @@ bool db_tx::read_sha256(const std::string & key, sha256 & value)
     
     dat_value.set_flags(DB_DBT_MALLOC);
     
-    int ret = m_Db->get(m_DbTxn, &dat_key, &dat_value, 0);
+    int ret = db_get(m_DbTxn, &dat_key, &dat_value, 0);
     
     std::memset(dat_key.get_data(), 0, dat_key.get_size());
     
@@ -1343,7 +1678,7 @@ bool db_tx::write_sha256(
         static_cast<std::uint32_t> (value_data.size())
     );
 
-    auto ret = m_Db->put(
+    auto ret = db_put(
         m_DbTxn, &dat_key, &dat_value, overwrite ? 0 : DB_NOOVERWRITE
     );
 
@@ -1378,7 +1713,7 @@ bool db_tx::read_big_number(const std::string & key, big_number & value)
     
     dat_value.set_flags(DB_DBT_MALLOC);
     
-    int ret = m_Db->get(m_DbTxn, &dat_key, &dat_value, 0);
+    int ret = db_get(m_DbTxn, &dat_key, &dat_value, 0);
     
     std::memset(dat_key.get_data(), 0, dat_key.get_size());
     
@@ -1413,7 +1748,7 @@ bool db_tx::read(const data_buffer & key, T & value)
     
     dbt_value.set_flags(DB_DBT_MALLOC);
     
-    auto ret = m_Db->get(m_DbTxn, &dbt_key, &dbt_value, 0);
+    auto ret = db_get(m_DbTxn, &dbt_key, &dbt_value, 0);
     
     std::memset(dbt_key.get_data(), 0, dbt_key.get_size());
     
@@ -1480,7 +1815,7 @@ bool db_tx::write(const T1 & key, T2 & value, const bool & overwrite)
         static_cast<std::uint32_t> (value_data.size())
     );
 
-    auto ret = m_Db->put(
+    auto ret = db_put(
         m_DbTxn, &dat_key, &dat_value, overwrite ? 0 : DB_NOOVERWRITE
     );
 
@@ -1527,7 +1862,7 @@ bool db_tx::write(
         static_cast<std::uint32_t> (value_data.size())
     );
 
-    auto ret = m_Db->put(
+    auto ret = db_put(
         m_DbTxn, &dat_key, &dat_value, overwrite ? 0 : DB_NOOVERWRITE
     );
 
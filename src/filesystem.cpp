@@ -275,6 +275,11 @@ std::string filesystem::data_path()
     {
         ret += "client/";
     }
+    
+    if (globals::instance().is_regtest() == true)
+    {
+        ret += "regtest/";
+    }
 
     return ret;
 }
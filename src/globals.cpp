@@ -41,6 +41,7 @@ globals::globals()
 #endif // __IPHONE_OS_VERSION_MAX_ALLOWED
     , m_debug(true)
     , m_is_client_spv(false)
+    , m_is_regtest(false)
     , m_version_nonce(0)
     , m_best_block_height(-1)
     , m_block_index_fbbh_last(0)
@@ -62,6 +63,9 @@ globals::globals()
     , m_spv_use_getblocks(false)
     , m_spv_time_wallet_created(std::time(0))
     , m_db_private(false)
+    , m_address_index(false)
+    , m_prune_transaction_index(false)
+    , m_compact_transaction_index(false)
 {
     /**
      * P2SH (BIP16 support) can be removed eventually.
@@ -272,6 +276,36 @@ const bool & globals::db_private() const
     return m_db_private;
 }
 
+void globals::set_address_index(const bool & val)
+{
+    m_address_index = val;
+}
+
+const bool & globals::address_index() const
+{
+    return m_address_index;
+}
+
+void globals::set_prune_transaction_index(const bool & val)
+{
+    m_prune_transaction_index = val;
+}
+
+const bool & globals::prune_transaction_index() const
+{
+    return m_prune_transaction_index;
+}
+
+void globals::set_compact_transaction_index(const bool & val)
+{
+    m_compact_transaction_index = val;
+}
+
+const bool & globals::compact_transaction_index() const
+{
+    return m_compact_transaction_index;
+}
+
 void globals::spv_reset_bloom_filter()
 {
     /**
@@ -28,8 +28,10 @@
 #include <coin/hash.hpp>
 #include <coin/kernel.hpp>
 #include <coin/logger.hpp>
+#include <coin/stack_impl.hpp>
 #include <coin/tcp_connection.hpp>
 #include <coin/time.hpp>
+#include <coin/uint256.hpp>
 
 using namespace coin;
 
@@ -48,6 +50,8 @@ std::map<std::uint32_t, std::uint32_t> kernel::get_stake_modifier_checkpoints()
 
 kernel::kernel()
     : m_modifier_interval(modifier_interval)
+    , m_stake_modifier_candidates_tip(0)
+    , m_stake_modifier_candidates_start(0)
 {
     // ...
 }
@@ -152,15 +156,6 @@ bool kernel::compute_next_stake_modifier(
         return true;
     }
     
-    /**
-     * Sort candidate blocks by timestamp.
-     */
-    std::vector< std::pair<std::int64_t, sha256> > sorted_by_timestamp;
-
-    sorted_by_timestamp.reserve(
-        64 * m_modifier_interval / utility::get_target_spacing(index_previous)
-    );
-    
     auto selection_interval = get_stake_modifier_selection_interval();
     
     auto selection_interval_start =
@@ -168,24 +163,64 @@ bool kernel::compute_next_stake_modifier(
         m_modifier_interval - selection_interval
     ;
     
-    auto * index_tmp = index_previous;
+    auto candidates = get_stake_modifier_candidates(
+        index_previous, selection_interval_start
+    );
+    
+    auto height_first_candidate = candidates.front()->height();
+    
+    /**
+     * Compute the selection hash of each candidate once by hashing its
+     * proof-hash and the previous proof-of-stake modifier.
+     */
+    std::vector<stake_candidate_t> sorted_by_timestamp;
+
+    sorted_by_timestamp.reserve(candidates.size());
     
-    while (index_tmp && index_tmp->time() >= selection_interval_start)
+    for (auto & i : candidates)
     {
-        sorted_by_timestamp.push_back(
-            std::make_pair(index_tmp->time(), index_tmp->get_block_hash())
+        stake_candidate_t candidate;
+        
+        candidate.time = i->time();
+        candidate.hash = i->get_block_hash();
+        candidate.index = i;
+        candidate.selected = false;
+        
+        data_buffer buffer;
+        
+        buffer.write_sha256(
+            i->is_proof_of_stake() ?
+            i->hash_proof_of_stake() : candidate.hash
         );
+        buffer.write_uint64(stake_modifier);
         
-        index_tmp = index_tmp->block_index_previous();
+        candidate.hash_selection = sha256::from_digest(&hash::sha256d(
+            reinterpret_cast<std::uint8_t *>(buffer.data()),
+            buffer.size())[0]
+        );
+        
+        /**
+         * Divide by 2**32 so that Proof-of-Stake blocks are favored over
+         * Proof-of-Work blocks.
+         */
+        if (i->is_proof_of_stake())
+        {
+            candidate.hash_selection >>= 32;
+        }
+        
+        sorted_by_timestamp.push_back(candidate);
     }
     
-    auto height_first_candidate = index_tmp ? (index_tmp->height() + 1) : 0;
-    
     /**
      * Sort by timestamp.
      */
-    std::reverse(sorted_by_timestamp.begin(), sorted_by_timestamp.end());
-    std::sort(sorted_by_timestamp.begin(), sorted_by_timestamp.end());
+    std::sort(
+        sorted_by_timestamp.begin(), sorted_by_timestamp.end(),
+        [](const stake_candidate_t & a, const stake_candidate_t & b)
+        {
+            return a.time < b.time || (a.time == b.time && a.hash < b.hash);
+        }
+    );
     
     /**
      * Select 64 blocks from candidate blocks to generate stake modifier.
@@ -194,7 +229,7 @@ bool kernel::compute_next_stake_modifier(
     
     std::int64_t selection_interval_stop = selection_interval_start;
     
-    std::map<sha256, block_index *> selected_blocks;
+    const block_index * index_tmp = 0;
     
     for (
         auto i = 0; i <
@@ -214,8 +249,7 @@ bool kernel::compute_next_stake_modifier(
          */
         if (
             select_block_from_candidates(sorted_by_timestamp,
-            selected_blocks, selection_interval_stop, stake_modifier,
-            &index_tmp) == false
+            selection_interval_stop, &index_tmp) == false
             )
         {
             log_error(
@@ -233,14 +267,6 @@ bool kernel::compute_next_stake_modifier(
             index_tmp->get_stake_entropy_bit()) << i)
         );
         
-        /**
-         * Add the selected block from candidates to selected list.
-         */
-        selected_blocks.insert(
-            std::make_pair(index_tmp->get_block_hash(),
-            const_cast<block_index *> (index_tmp))
-        );
-        
         /**
          * -printstakemodifier
          */
@@ -269,33 +295,26 @@ bool kernel::compute_next_stake_modifier(
             0, index_previous->height() - height_first_candidate + 1, '-'
         );
         
-        index_tmp = index_previous;
-        
-        while (index_tmp && index_tmp->height() >= height_first_candidate)
+        for (auto & i : sorted_by_timestamp)
         {
             /**
+             * 'S' indicates selected Proof-of-Stake blocks.
+             * 'W' indicates selected Proof-of-Work blocks.
              * '=' indicates Proof-of-Stake blocks not selected.
              */
-            if (index_tmp->is_proof_of_stake())
+            if (i.selected)
             {
                 selection_map.replace(
-                    index_tmp->height() - height_first_candidate, 1, "="
+                    i.index->height() - height_first_candidate, 1,
+                    i.index->is_proof_of_stake()? "S" : "W"
+                );
+            }
+            else if (i.index->is_proof_of_stake())
+            {
+                selection_map.replace(
+                    i.index->height() - height_first_candidate, 1, "="
                 );
             }
-            
-            index_tmp = index_tmp->block_index_previous();
-        }
-        
-        for (auto & i : selected_blocks)
-        {
-            /**
-             * 'S' indicates selected Proof-of-Stake blocks.
-             * 'W' indicates selected Proof-of-Work blocks.
-             */
-            selection_map.replace(
-                i.second->height() - height_first_candidate, 1,
-                i.second->is_proof_of_stake()? "S" : "W"
-            );
         }
         
         log_none(
@@ -405,102 +424,45 @@ std::int64_t kernel::get_stake_modifier_selection_interval()
 }
 
 bool kernel::select_block_from_candidates(
-    std::vector<std::pair<std::int64_t, sha256> > & sorted_by_timestamp,
-    std::map<sha256, block_index *> & selected_blocks,
+    std::vector<stake_candidate_t> & sorted_by_timestamp,
     const std::int64_t & selection_interval_stop,
-    const std::uint64_t & previous_stake_modifier,
     const block_index ** index_selected
     )
 {
-    bool selected = false;
-    
-    sha256 hash_best = 0;
+    stake_candidate_t * candidate_best = 0;
     
     *index_selected = 0;
     
-    for (auto & item : sorted_by_timestamp)
+    for (auto & i : sorted_by_timestamp)
     {
-        if (globals::instance().block_indexes().count(item.second) == 0)
-        {
-            log_error(
-                "Kernel, select block from candidates failed to find block "
-                "index for candidate block " << item.second.to_string() << "."
-            );
-            
-            return false;
-        }
-        
-        const auto & index = globals::instance().block_indexes()[item.second];
-        
-        if (selected && index->time() > selection_interval_stop)
+        if (candidate_best && i.time > selection_interval_stop)
         {
             break;
         }
         
-        if (selected_blocks.count(index->get_block_hash()) > 0)
+        if (i.selected)
         {
             continue;
         }
         
-        /*
-         * Compute the selection hash by hashing its proof-hash and the
-         * previous proof-of-stake modifier.
-         */
-        sha256 hash_proof =
-            index->is_proof_of_stake() ?
-            index->hash_proof_of_stake() : index->get_block_hash()
-        ;
-        
-        /**
-         * Allocate the buffer to calculate the hash of the
-         * selection.
-         */
-        data_buffer buffer;
-        
-        /**
-         * Write the hash of the proof.
-         */
-        buffer.write_sha256(hash_proof);
-        
-        /**
-         * Write the previous stake modifier.
-         */
-        buffer.write_uint64(previous_stake_modifier);
-        
-        /**
-         * Calculate the sha256d hash of the hash of the proof and
-         * the previous stake modifier.
-         */
-        auto hash_selection = sha256::from_digest(&hash::sha256d(
-            reinterpret_cast<std::uint8_t *>(buffer.data()),
-            buffer.size())[0]
-        );
-
-        /**
-         * Divide by 2**32 so that Proof-of-Stake blocks are favored over
-         * Proof-of-Work blocks.
-         */
-        if (index->is_proof_of_stake())
-        {
-            hash_selection >>= 32;
-        }
-        
-        if (selected && hash_selection < hash_best)
-        {
-            hash_best = hash_selection;
-            
-            *index_selected = reinterpret_cast<const block_index *> (index);
-        }
-        else if (selected == false)
+        if (
+            candidate_best == 0 ||
+            i.hash_selection < candidate_best->hash_selection
+            )
         {
-            selected = true;
-            
-            hash_best = hash_selection;
-            
-            *index_selected = reinterpret_cast<const block_index *> (index);
+            candidate_best = &i;
         }
     }
     
+    if (candidate_best == 0)
+    {
+        return false;
+    }
+    
+    candidate_best->selected = true;
+    
+    *index_selected = candidate_best->index;
+    
     /**
      * -printstakemodifier
      */
@@ -508,11 +470,80 @@ bool kernel::select_block_from_candidates(
     {
         log_none(
             "Kernel, select block from candidates, selection hash = " <<
-            hash_best.to_string() << "."
+            candidate_best->hash_selection.to_string() << "."
+        );
+    }
+    
+    return true;
+}
+
+std::vector<const block_index *> kernel::get_stake_modifier_candidates(
+    const block_index * index_previous,
+    const std::int64_t & selection_interval_start
+    )
+{
+    std::lock_guard<std::mutex> l1(mutex_stake_modifier_candidates_);
+    
+    /**
+     * The window of the previous computation can only slide forward when
+     * its start has not moved backwards.
+     */
+    auto * tip =
+        selection_interval_start >= m_stake_modifier_candidates_start ?
+        m_stake_modifier_candidates_tip : 0
+    ;
+    
+    /**
+     * Walk back from the previous block until a block older than the
+     * selection interval start or the tip of the previous window.
+     */
+    std::vector<const block_index *> blocks_new;
+    
+    auto * index_tmp = index_previous;
+    
+    while (
+        index_tmp && index_tmp != tip &&
+        index_tmp->time() >= selection_interval_start
+        )
+    {
+        blocks_new.push_back(index_tmp);
+        
+        index_tmp = index_tmp->block_index_previous();
+    }
+    
+    std::vector<const block_index *> ret;
+    
+    if (index_tmp && index_tmp == tip)
+    {
+        /**
+         * Continue the walk back over the previous window, it ended at a
+         * block older than its own (earlier) start.
+         */
+        auto it = m_stake_modifier_candidates.rbegin();
+        
+        while (
+            it != m_stake_modifier_candidates.rend() &&
+            (*it)->time() >= selection_interval_start
+            )
+        {
+            ++it;
+        }
+        
+        ret.reserve(
+            static_cast<std::size_t> (it - m_stake_modifier_candidates.rbegin())
+            + blocks_new.size()
         );
+        
+        ret.insert(ret.end(), it.base(), m_stake_modifier_candidates.end());
     }
     
-    return selected;
+    ret.insert(ret.end(), blocks_new.rbegin(), blocks_new.rend());
+    
+    m_stake_modifier_candidates = ret;
+    m_stake_modifier_candidates_tip = index_previous;
+    m_stake_modifier_candidates_start = selection_interval_start;
+    
+    return ret;
 }
 
 bool kernel::check_proof_of_stake(
@@ -703,9 +734,12 @@ bool kernel::check_stake_kernel_hash(
         return false;
     }
     
-    big_number target_per_coin_day;
+    bool negative = false;
+    bool overflow = false;
     
-    target_per_coin_day.set_compact(bits);
+    uint256 target_per_coin_day;
+    
+    target_per_coin_day.set_compact(bits, &negative, &overflow);
     
     auto value_in = tx_previous.transactions_out()[previous_out.n()].value();
 
@@ -719,8 +753,17 @@ bool kernel::check_stake_kernel_hash(
         (std::int64_t)constants::max_stake_age) - constants::min_stake_age
     ;
     
-    big_number coin_day_weight =
-        big_number(value_in) * time_weight / constants::coin / (24 * 60 * 60)
+    /**
+     * A negative weight or target can never be met.
+     */
+    if (value_in < 0 || time_weight < 0 || negative)
+    {
+        return false;
+    }
+    
+    uint256 coin_day_weight =
+        uint256(value_in) * uint256(time_weight) / uint256(constants::coin) /
+        uint256(24 * 60 * 60)
     ;
 
     data_buffer buffer;
@@ -775,7 +818,20 @@ bool kernel::check_stake_kernel_hash(
     /**
      * Check if the proof-of-stake hash meets target protocol.
      */
-    if (big_number(hash_pos) > coin_day_weight * target_per_coin_day)
+    auto target = coin_day_weight * target_per_coin_day;
+    
+    /**
+     * A target beyond 256 bits is met by any hash.
+     */
+    if (
+        coin_day_weight != 0 && (overflow ||
+        target / coin_day_weight != target_per_coin_day)
+        )
+    {
+        return true;
+    }
+    
+    if (uint256(hash_pos) > target)
 	{
         return false;
 	}
@@ -804,6 +860,37 @@ bool kernel::get_kernel_stake_modifier(
         globals::instance().block_indexes()[hash_block_from]
     ;
     
+    auto & k = kernel::instance();
+    
+    /**
+     * Use the cached block holding the kernel stake modifier while it is
+     * still on the main chain, the walk below would end at it again.
+     */
+    {
+        std::lock_guard<std::mutex> l1(k.mutex_kernel_stake_modifiers_);
+        
+        auto it = k.m_kernel_stake_modifiers.find(index_from);
+        
+        if (it != k.m_kernel_stake_modifiers.end())
+        {
+            const auto * index = it->second;
+            
+            if (
+                index->block_index_next() ||
+                index == stack_impl::get_block_index_best()
+                )
+            {
+                stake_modifier = index->stake_modifier();
+                stake_modifier_height = index->height();
+                stake_modifier_time = index->time();
+                
+                return true;
+            }
+            
+            k.m_kernel_stake_modifiers.erase(it);
+        }
+    }
+    
     stake_modifier_height = index_from->height();
     
     stake_modifier_time = index_from->time();
@@ -861,5 +948,14 @@ bool kernel::get_kernel_stake_modifier(
     
     stake_modifier = index->stake_modifier();
 
+    std::lock_guard<std::mutex> l1(k.mutex_kernel_stake_modifiers_);
+    
+    if (k.m_kernel_stake_modifiers.size() >= kernel_stake_modifiers_length)
+    {
+        k.m_kernel_stake_modifiers.clear();
+    }
+    
+    k.m_kernel_stake_modifiers[index_from] = index;
+    
     return true;
 }
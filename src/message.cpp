@@ -24,6 +24,7 @@
 
 #include <coin/alert.hpp>
 #include <coin/block.hpp>
+#include <coin/block_compact.hpp>
 #include <coin/block_merkle.hpp>
 #include <coin/block_locator.hpp>
 #include <coin/checkpoint_sync.hpp>
@@ -205,6 +206,27 @@ void message::encode()
              */
             m_payload = create_merkleblock();
         }
+        else if (m_header.command == "cmpctblock")
+        {
+            /**
+             * Create the cmpctblock.
+             */
+            m_payload = create_cmpctblock();
+        }
+        else if (m_header.command == "getblocktxn")
+        {
+            /**
+             * Create the getblocktxn.
+             */
+            m_payload = create_getblocktxn();
+        }
+        else if (m_header.command == "blocktxn")
+        {
+            /**
+             * Create the blocktxn.
+             */
+            m_payload = create_blocktxn();
+        }
         else if (m_header.command == "ztlock")
         {
             /**
@@ -298,6 +320,11 @@ void message::encode()
         }
     }
     
+    /**
+     * The encoded length is known, size the buffer once.
+     */
+    reserve(size() + header_length + m_payload.size());
+    
     /**
      * Encode the header magic to little endian.
      */
@@ -858,6 +885,70 @@ void message::decode()
                 m_protocol_merkleblock.merkleblock.reset();
             }
         }
+        else if (m_header.command == "cmpctblock")
+        {
+            /**
+             * Allocate the cmpctblock.
+             */
+            m_protocol_cmpctblock.cmpctblock =
+                std::make_shared<block_compact> ()
+            ;
+            
+            /**
+             * Decode the cmpctblock.
+             */
+            if (m_protocol_cmpctblock.cmpctblock->decode(*this))
+            {
+                // ...
+            }
+            else
+            {
+                log_error("Message failed to decode cmpctblock.");
+                
+                /**
+                 * Deallocate the cmpctblock.
+                 */
+                m_protocol_cmpctblock.cmpctblock.reset();
+            }
+        }
+        else if (m_header.command == "getblocktxn")
+        {
+            m_protocol_getblocktxn.hash_block = read_sha256();
+            
+            auto count = read_var_int();
+            
+            if (count > remaining())
+            {
+                throw std::runtime_error("invalid getblocktxn count");
+            }
+            
+            for (auto i = 0; i < count; i++)
+            {
+                m_protocol_getblocktxn.indexes.push_back(
+                    static_cast<std::uint32_t> (read_var_int())
+                );
+            }
+        }
+        else if (m_header.command == "blocktxn")
+        {
+            m_protocol_blocktxn.hash_block = read_sha256();
+            
+            auto count = read_var_int();
+            
+            if (count > remaining())
+            {
+                throw std::runtime_error("invalid blocktxn count");
+            }
+            
+            for (auto i = 0; i < count; i++)
+            {
+                auto tx = std::make_shared<transaction> ();
+                
+                tx->decode(*this);
+                
+                m_protocol_blocktxn.transactions.push_back(tx);
+            }
+        }
         else if (m_header.command == "ztlock")
         {
             /**
@@ -1214,48 +1305,74 @@ std::vector<std::uint8_t> message::header_magic_bytes()
     {
         ret = { 0x02, 0x04, 0x06, 0x08 };
     }
+    else if (globals::instance().is_regtest() == true)
+    {
+        ret = { 0xfa, 0xbf, 0xb5, 0xda };
+    }
 
     return ret;
 }
 
 const std::uint32_t message::header_magic()
 {
-    static std::uint32_t ret = 0;
-    
-    if (ret == 0)
+    /**
+     * Initialized once (thread-safe) from the first four bytes of the
+     * header, the network is known before the first message is created.
+     */
+    static const std::uint32_t ret = []()
     {
+        auto magic = header_magic_bytes();
+        
+        std::uint32_t val;
+        
         /**
-         * Use a different header magic for test networks.
+         * Copy into a 32-bit unsigned integer.
          */
-        if (constants::test_net == true)
-        {
-            /**
-             * The first four bytes of the header.
-             */
-            std::uint8_t magic[4] = { 0x02, 0x04, 0x06, 0x08 };
-            
-            /**
-             * Copy into a 32-bit unsigned integer.
-             */
-            std::memcpy(&ret, &magic, sizeof(ret));
-        }
-        else
-        {
-            /**
-             * The first four bytes of the header.
-             */
-            std::uint8_t magic[4] = { 0xce, 0xa9, 0xcf, 0x80 };
-            
-            /**
-             * Copy into a 32-bit unsigned integer.
-             */
-            std::memcpy(&ret, &magic, sizeof(ret));
-        }
-    }
+        std::memcpy(&val, &magic[0], sizeof(val));
+        
+        return val;
+    }();
 
     return ret;
 }
 
+void message::encode_header(
+    char * buf, const std::string & command, const std::uint32_t & length,
+    const std::uint32_t & checksum
+    )
+{
+    assert(command.size() + 1 <= 12);
+    
+    auto header_magic = endian::to_little<std::uint32_t> (message::header_magic());
+    auto header_length = endian::to_little<std::uint32_t> (length);
+    auto header_checksum = endian::to_little<std::uint32_t> (checksum);
+    
+    std::memcpy(buf, &header_magic[0], header_magic.size());
+    
+    /**
+     * Write the null-terminated and zero padded 12 byte command.
+     */
+    std::memset(buf + 4, 0, 12);
+    std::memcpy(buf + 4, command.data(), command.size());
+    
+    std::memcpy(buf + 16, &header_length[0], header_length.size());
+    std::memcpy(buf + 20, &header_checksum[0], header_checksum.size());
+}
+
+bool message::decode_header_length(const char * buf, std::uint32_t & length)
+{
+    auto ptr = reinterpret_cast<const std::uint8_t *> (buf);
+    
+    if (endian::from_little<std::uint32_t> (ptr) != message::header_magic())
+    {
+        return false;
+    }
+    
+    length = endian::from_little<std::uint32_t> (ptr + 16);
+    
+    return true;
+}
+
 message::header_t & message::header()
 {
     return m_header;
@@ -1341,6 +1458,21 @@ protocol::merkleblock_t & message::protocol_merkleblock()
     return m_protocol_merkleblock;
 }
 
+protocol::cmpctblock_t & message::protocol_cmpctblock()
+{
+    return m_protocol_cmpctblock;
+}
+
+protocol::getblocktxn_t & message::protocol_getblocktxn()
+{
+    return m_protocol_getblocktxn;
+}
+
+protocol::blocktxn_t & message::protocol_blocktxn()
+{
+    return m_protocol_blocktxn;
+}
+
 protocol::ztlock_t & message::protocol_ztlock()
 {
     return m_protocol_ztlock;
@@ -1435,6 +1567,14 @@ data_buffer message::create_version()
          */
         m_protocol_version.services = protocol::operation_mode_client;
     }
+    
+    /**
+     * Advertise compact block relay if we validate full blocks.
+     */
+    if (globals::instance().is_client_spv() == false)
+    {
+        m_protocol_version.services |= protocol::service_compact_blocks;
+    }
 
     /**
      * Set the payload timestamp (non-adjusted).
@@ -1942,6 +2082,53 @@ data_buffer message::create_merkleblock()
     return ret;
 }
 
+data_buffer message::create_cmpctblock()
+{
+    data_buffer ret;
+    
+    if (m_protocol_cmpctblock.cmpctblock)
+    {
+        m_protocol_cmpctblock.cmpctblock->encode(ret);
+    }
+    
+    return ret;
+}
+
+data_buffer message::create_getblocktxn()
+{
+    data_buffer ret;
+    
+    ret.write_sha256(m_protocol_getblocktxn.hash_block);
+    
+    ret.write_var_int(m_protocol_getblocktxn.indexes.size());
+    
+    for (auto & i : m_protocol_getblocktxn.indexes)
+    {
+        ret.write_var_int(i);
+    }
+    
+    return ret;
+}
+
+data_buffer message::create_blocktxn()
+{
+    data_buffer ret;
+    
+    ret.write_sha256(m_protocol_blocktxn.hash_block);
+    
+    ret.write_var_int(m_protocol_blocktxn.transactions.size());
+    
+    for (auto & i : m_protocol_blocktxn.transactions)
+    {
+        if (i)
+        {
+            i->encode(ret);
+        }
+    }
+    
+    return ret;
+}
+
 data_buffer message::create_tx()
 {
     data_buffer ret;
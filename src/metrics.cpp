@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <sstream>
+
+#include <coin/metrics.hpp>
+
+using namespace coin;
+
+metrics & metrics::instance()
+{
+    static metrics g_metrics;
+    
+    return g_metrics;
+}
+
+metrics::counter & metrics::get_counter(const std::string & name)
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    auto & ret = m_counters[name];
+    
+    if (ret == nullptr)
+    {
+        ret.reset(new counter());
+    }
+    
+    return *ret;
+}
+
+metrics::histogram & metrics::get_histogram(const std::string & name)
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    auto & ret = m_histograms[name];
+    
+    if (ret == nullptr)
+    {
+        ret.reset(new histogram());
+    }
+    
+    return *ret;
+}
+
+std::map<std::string, std::uint64_t> metrics::counters()
+{
+    std::map<std::string, std::uint64_t> ret;
+    
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    for (auto & i : m_counters)
+    {
+        ret[i.first] = i.second->value();
+    }
+    
+    return ret;
+}
+
+std::map<std::string, metrics::histogram_snapshot_t> metrics::histograms()
+{
+    std::map<std::string, histogram_snapshot_t> ret;
+    
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    for (auto & i : m_histograms)
+    {
+        ret[i.first] = i.second->snapshot();
+    }
+    
+    return ret;
+}
+
+std::string metrics::to_prometheus()
+{
+    std::stringstream ss;
+    
+    for (auto & i : counters())
+    {
+        ss << "# TYPE vcash_" << i.first << "_total counter\n";
+        ss << "vcash_" << i.first << "_total " << i.second << "\n";
+    }
+    
+    for (auto & i : histograms())
+    {
+        auto name = "vcash_" + i.first + "_seconds";
+        
+        ss << "# TYPE " << name << " histogram\n";
+        
+        std::uint64_t cumulative = 0;
+        
+        for (auto j = 0; j < buckets; j++)
+        {
+            cumulative += i.second.counts[j];
+            
+            if (j == buckets - 1)
+            {
+                ss << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+            }
+            else
+            {
+                char le[32];
+                
+                std::snprintf(
+                    le, sizeof(le), "%g",
+                    static_cast<double> (1ULL << j) / 1000000.0
+                );
+                
+                ss <<
+                    name << "_bucket{le=\"" << le << "\"} " << cumulative <<
+                    "\n"
+                ;
+            }
+        }
+        
+        ss << name << "_sum " << i.second.sum / 1000000.0 << "\n";
+        ss << name << "_count " << i.second.count << "\n";
+    }
+    
+    return ss.str();
+}
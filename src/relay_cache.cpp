@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <ctime>
+
+#include <coin/block.hpp>
+#include <coin/data_buffer.hpp>
+#include <coin/logger.hpp>
+#include <coin/message.hpp>
+#include <coin/relay_cache.hpp>
+
+using namespace coin;
+
+relay_cache::relay_cache()
+{
+    // ...
+}
+
+relay_cache & relay_cache::instance()
+{
+    static relay_cache g_relay_cache;
+    
+    return g_relay_cache;
+}
+
+std::shared_ptr<const std::vector<char> > relay_cache::insert(
+    const inventory_vector & inv, const data_buffer & buffer
+    )
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    expire();
+    
+    auto it = m_messages.find(inv);
+    
+    if (it != m_messages.end())
+    {
+        return it->second;
+    }
+    
+    /**
+     * Allocate the message.
+     */
+    message msg(inv.command(), buffer);
+
+    /**
+     * Encode the message.
+     */
+    msg.encode();
+    
+    std::shared_ptr<const std::vector<char> > ret(
+        new std::vector<char> (msg.data(), msg.data() + msg.size())
+    );
+    
+    m_messages[inv] = ret;
+    
+    m_expirations.push_back(
+        std::make_pair(std::time(0) + expiration_interval, inv)
+    );
+    
+    return ret;
+}
+
+std::shared_ptr<const std::vector<char> > relay_cache::find(
+    const inventory_vector & inv
+    )
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    expire();
+    
+    auto it = m_messages.find(inv);
+    
+    if (it != m_messages.end())
+    {
+        return it->second;
+    }
+    
+    return std::shared_ptr<const std::vector<char> > ();
+}
+
+void relay_cache::clear()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    m_messages.clear();
+    m_expirations.clear();
+}
+
+std::size_t relay_cache::size()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    return m_messages.size();
+}
+
+std::size_t relay_cache::expirations_size()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    return m_expirations.size();
+}
+
+void relay_cache::expire()
+{
+    auto now = std::time(0);
+    
+    while (m_expirations.size() > 0 && m_expirations.front().first < now)
+    {
+        m_messages.erase(m_expirations.front().second);
+        
+        m_expirations.pop_front();
+    }
+}
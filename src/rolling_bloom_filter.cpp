@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+
+#include <coin/hash.hpp>
+#include <coin/random.hpp>
+#include <coin/rolling_bloom_filter.hpp>
+#include <coin/sha256.hpp>
+
+using namespace coin;
+
+rolling_bloom_filter::rolling_bloom_filter(
+    const std::uint32_t & elements, const double & fprate
+    )
+    : m_elements_per_generation((std::max(elements, 2u) + 1) / 2)
+    , m_elements_this_generation(0)
+    , m_generation(1)
+    , m_hash_funcs(0)
+    , m_tweak(0)
+{
+    auto log_fprate = std::log(fprate);
+    
+    /**
+     * The optimal number of hash funcs for the given false positive rate.
+     */
+    m_hash_funcs = std::max(1, std::min(
+        static_cast<int> (std::round(log_fprate / std::log(0.5))),
+        static_cast<int> (max_hash_funcs))
+    );
+    
+    /**
+     * The filter holds between two and three generations of elements.
+     */
+    auto elements_max = m_elements_per_generation * 3;
+    
+    auto filter_bits = static_cast<std::uint32_t> (std::ceil(
+        -1.0 * m_hash_funcs * elements_max /
+        std::log(1.0 - std::exp(log_fprate / m_hash_funcs)))
+    );
+    
+    /**
+     * Each 64 bit positions use a pair of 64-bit words.
+     */
+    m_data.resize(((filter_bits + 63) / 64) << 1);
+    
+    reset();
+}
+
+void rolling_bloom_filter::insert(
+    const std::uint8_t * buf, const std::size_t & len
+    )
+{
+    if (m_elements_this_generation == m_elements_per_generation)
+    {
+        m_elements_this_generation = 0;
+        
+        if (++m_generation == 4)
+        {
+            m_generation = 1;
+        }
+        
+        std::uint64_t mask1 = 0 - static_cast<std::uint64_t> (
+            m_generation & 1
+        );
+        std::uint64_t mask2 = 0 - static_cast<std::uint64_t> (
+            m_generation >> 1
+        );
+        
+        /**
+         * Forget the bit positions of the generation being overwritten.
+         */
+        for (auto i = 0; i < m_data.size(); i += 2)
+        {
+            auto p1 = m_data[i], p2 = m_data[i + 1];
+            
+            auto mask = (p1 ^ mask1) | (p2 ^ mask2);
+            
+            m_data[i] = p1 & mask;
+            m_data[i + 1] = p2 & mask;
+        }
+    }
+    
+    m_elements_this_generation++;
+    
+    for (auto i = 0; i < m_hash_funcs; i++)
+    {
+        auto h = hash(i, buf, len);
+        
+        auto bit = h & 0x3f;
+        
+        /**
+         * Map the hash onto a word pair without a modulo.
+         */
+        auto pos = static_cast<std::uint32_t> (
+            (static_cast<std::uint64_t> (h) * m_data.size()) >> 32
+        );
+        
+        m_data[pos & ~1u] =
+            (m_data[pos & ~1u] & ~(static_cast<std::uint64_t> (1) << bit)) |
+            static_cast<std::uint64_t> (m_generation & 1) << bit
+        ;
+        m_data[pos | 1] =
+            (m_data[pos | 1] & ~(static_cast<std::uint64_t> (1) << bit)) |
+            static_cast<std::uint64_t> (m_generation >> 1) << bit
+        ;
+    }
+}
+
+void rolling_bloom_filter::insert(const std::vector<std::uint8_t> & data)
+{
+    insert(data.size() > 0 ? &data[0] : 0, data.size());
+}
+
+bool rolling_bloom_filter::contains(
+    const std::uint8_t * buf, const std::size_t & len
+    ) const
+{
+    for (auto i = 0; i < m_hash_funcs; i++)
+    {
+        auto h = hash(i, buf, len);
+        
+        auto bit = h & 0x3f;
+        
+        auto pos = static_cast<std::uint32_t> (
+            (static_cast<std::uint64_t> (h) * m_data.size()) >> 32
+        );
+        
+        /**
+         * If the generation of the bit is zero the data is not present.
+         */
+        if (((m_data[pos & ~1u] | m_data[pos | 1]) >> bit & 1) == 0)
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool rolling_bloom_filter::contains(
+    const std::vector<std::uint8_t> & data
+    ) const
+{
+    return contains(data.size() > 0 ? &data[0] : 0, data.size());
+}
+
+void rolling_bloom_filter::reset()
+{
+    m_tweak = random::uint32();
+    m_elements_this_generation = 0;
+    m_generation = 1;
+    
+    std::fill(m_data.begin(), m_data.end(), 0);
+}
+
+std::size_t rolling_bloom_filter::size() const
+{
+    return m_data.size() * sizeof(std::uint64_t);
+}
+
+int rolling_bloom_filter::run_test()
+{
+    rolling_bloom_filter filter1(100, 0.01);
+    
+    std::vector<sha256> hashes;
+    
+    for (auto i = 0; i < 400; i++)
+    {
+        auto digest = sha256::hash(
+            reinterpret_cast<std::uint8_t *> (&i), sizeof(i)
+        );
+        
+        hashes.push_back(sha256::from_digest(&digest[0]));
+    }
+    
+    for (auto i = 0; i < 100; i++)
+    {
+        filter1.insert(hashes[i].digest(), sha256::digest_length);
+    }
+    
+    for (auto i = 0; i < 100; i++)
+    {
+        assert(filter1.contains(hashes[i].digest(), sha256::digest_length));
+    }
+    
+    printf("rolling_bloom_filter: Check 1 Passed\n");
+    
+    /**
+     * Insert another (overlapping) generation, the most recent elements
+     * must always be remembered.
+     */
+    for (auto i = 100; i < 400; i++)
+    {
+        filter1.insert(hashes[i].digest(), sha256::digest_length);
+        
+        for (auto j = i - 99; j <= i; j++)
+        {
+            assert(
+                filter1.contains(hashes[j].digest(), sha256::digest_length)
+            );
+        }
+    }
+    
+    printf("rolling_bloom_filter: Check 2 Passed\n");
+    
+    /**
+     * The oldest elements should (mostly) be forgotten.
+     */
+    auto found = 0;
+    
+    for (auto i = 0; i < 100; i++)
+    {
+        if (filter1.contains(hashes[i].digest(), sha256::digest_length))
+        {
+            found++;
+        }
+    }
+    
+    assert(found < 10);
+    
+    printf("rolling_bloom_filter: Check 3 Passed\n");
+    
+    filter1.reset();
+    
+    found = 0;
+    
+    for (auto i = 300; i < 400; i++)
+    {
+        if (filter1.contains(hashes[i].digest(), sha256::digest_length))
+        {
+            found++;
+        }
+    }
+    
+    assert(found == 0);
+    
+    printf("rolling_bloom_filter: Check 4 Passed\n");
+    
+    return 0;
+}
+
+std::uint32_t rolling_bloom_filter::hash(
+    const std::uint32_t & hashes, const std::uint8_t * buf,
+    const std::size_t & len
+    ) const
+{
+    return hash::murmur3(hashes * 0xFBA4C795 + m_tweak, buf, len);
+}
@@ -20,6 +20,8 @@
 
 #include <chrono>
 #include <future>
+#include <limits>
+#include <set>
 #include <sstream>
 #include <thread>
 #include <vector>
@@ -28,6 +30,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
+#include <coin/address_index.hpp>
 #include <coin/big_number.hpp>
 #include <coin/block.hpp>
 #include <coin/block_index.hpp>
@@ -42,10 +45,12 @@
 #include <coin/incentive_vote.hpp>
 #include <coin/key_reserved.hpp>
 #include <coin/logger.hpp>
+#include <coin/metrics.hpp>
 #include <coin/mining_manager.hpp>
 #include <coin/network.hpp>
 #include <coin/protocol.hpp>
 #include <coin/rpc_connection.hpp>
+#include <coin/rpc_json_writer.hpp>
 #include <coin/rpc_transport.hpp>
 #include <coin/script.hpp>
 #include <coin/secret.hpp>
@@ -130,6 +135,32 @@ void rpc_connection::on_read(const char * buf, const std::size_t & len)
         buffer_ = std::string(buf, len);
     }
     
+    /**
+     * If enabled serve the metrics registry in the Prometheus text
+     * exposition format to plain GET /metrics requests.
+     */
+    auto & args = stack_impl_.get_configuration().args();
+    
+    auto it = args.find("rpc-metrics");
+    
+    if (
+        buffer_.compare(0, 12, "GET /metrics") == 0 &&
+        it != args.end() && it->second == "1"
+        )
+    {
+        if (buffer_.find("\r\n\r\n") != std::string::npos)
+        {
+            buffer_.clear();
+            
+            send_http_response(
+                metrics::instance().to_prometheus(), true,
+                "text/plain; version=0.0.4"
+            );
+        }
+        
+        return;
+    }
+    
     std::map<std::string, std::string> headers_out;
     
     std::string body_out;
@@ -565,6 +596,18 @@ bool rpc_connection::handle_json_rpc_request(
         {
             response = json_backupwallet(request);
         }
+        else if (request.method == "getaddressbalance")
+        {
+            response = json_getaddressbalance(request);
+        }
+        else if (request.method == "getaddresstxids")
+        {
+            response = json_getaddresstxids(request);
+        }
+        else if (request.method == "getaddressutxos")
+        {
+            response = json_getaddressutxos(request);
+        }
         else if (request.method == "getbalance")
         {
             response = json_getbalance(request);
@@ -605,6 +648,10 @@ bool rpc_connection::handle_json_rpc_request(
         {
             response = json_listsinceblock(request);
         }
+        else if (request.method == "getmetrics")
+        {
+            response = json_getmetrics(request);
+        }
         else if (request.method == "getmininginfo")
         {
             response = json_getmininginfo(request);
@@ -711,215 +758,173 @@ bool rpc_connection::send_json_rpc_response(
     const json_rpc_response_t & response
     )
 {
-    if (auto transport = rpc_transport_.lock())
+    /**
+     * Allocate the body.
+     */
+    std::string body;
+
+    try
     {
         /**
-         * Allocate the response.
+         * Encode the response directly into the body.
          */
-        std::string http_response;
+        rpc_json_writer writer(body);
         
-        /**
-         * Formulate the response.
-         */
-        http_response += "HTTP/1.1 200 OK\r\n";
-        http_response +=
-            "Date: " + network::instance().rfc1123_time() + "\r\n"
-        ;
-        http_response += "Connection: close\r\n";
-        http_response += "Content-Type: application/json\r\n";
+        write_json_rpc_response(writer, response);
+    }
+    catch (std::exception & e)
+    {
+        log_error(
+            "RPC Connection failed to create response, what = " <<
+            e.what() << "."
+        );
         
+        return false;
+    }
+    
+    /**
+     * Set that the transport should close after it writes all of it's
+     * queued buffers.
+     */
+    return send_http_response(body, true);
+}
+
+bool rpc_connection::send_json_rpc_responses(
+    const std::vector<json_rpc_response_t> & responses
+    )
+{
+    /**
+     * Allocate the body.
+     */
+    std::string body;
+    
+    try
+    {
         /**
-         * Allocate the body.
+         * Encode the responses directly into the body.
          */
-        std::string body;
-
-        try
+        rpc_json_writer writer(body);
+        
+        writer.begin_array();
+        
+        for (auto & i : responses)
         {
-            boost::property_tree::ptree pt;
-
-            if (response.error.size() > 0)
-            {
-                /**
-                 * Put error into property tree.
-                 */
-                pt.put_child("error", response.error);
-            }
-            else
+            if (i.id.size() == 0)
             {
-                /**
-                 * Put the result into property tree.
-                 */
-                pt.put_child("result", response.result);
+                continue;
             }
-
-            /**
-             * Put id into property tree.
-             */
-            pt.put(
-                "id", response.id, rpc_json_parser::translator<std::string> ()
-            );
-            
-            /**
-             * The std::stringstream.
-             */
-            std::stringstream ss;
-            
-            /**
-             * Write property tree to json file.
-             */
-            rpc_json_parser::write_json(ss, pt, false);
-            
-            /**
-             * Set the body.
-             */
-            body = ss.str();
-        }
-        catch (std::exception & e)
-        {
-            log_error(
-                "RPC Connection failed to create response, what = " <<
-                e.what() << "."
-            );
             
-            return false;
+            write_json_rpc_response(writer, i);
         }
         
-        http_response += "Content-Length: " +
-            std::to_string(body.size()) + "\r\n"
-        ;
-        http_response += "Server: vcash JSON-RPC 2.0\r\n";
-        http_response += "\r\n";
+        writer.end_array();
+    }
+    catch (std::exception & e)
+    {
+        log_error(
+            "RPC Connection failed to create response, what = " <<
+            e.what() << "."
+        );
         
-        http_response += body;
+        return false;
+    }
+    
+    return send_http_response(body, false);
+}
 
+void rpc_connection::write_json_rpc_response(
+    rpc_json_writer & writer, const json_rpc_response_t & response
+    )
+{
+    writer.begin_object();
+    
+    if (response.error.size() > 0)
+    {
         /**
-         * Write the response.
+         * Write the error.
          */
-        if (transport)
-        {
-            /**
-             * Set that the transport should close after it writes all of it's
-             * queued buffers.
-             */
-            transport->set_close_after_writes(true);
-            
-            /**
-             * Write the response.
-             */
-            transport->write(http_response.data(), http_response.size());
-        }
-        
-        return true;
+        writer.write_raw(
+            "error", rpc_json_parser::write_json_value(response.error)
+        );
     }
-
-    return false;
+    else if (response.result_json.size() > 0)
+    {
+        /**
+         * Write the already encoded result.
+         */
+        writer.write_raw("result", response.result_json);
+    }
+    else
+    {
+        /**
+         * Write the result.
+         */
+        writer.write_raw(
+            "result", rpc_json_parser::write_json_value(response.result)
+        );
+    }
+    
+    /**
+     * Write the id.
+     */
+    writer.write_string("id", response.id);
+    
+    writer.end_object();
 }
 
-bool rpc_connection::send_json_rpc_responses(
-    const std::vector<json_rpc_response_t> & responses
+bool rpc_connection::send_http_response(
+    const std::string & body, const bool & close_after_writes,
+    const std::string & content_type
     )
 {
     if (auto transport = rpc_transport_.lock())
     {
         /**
-         * Allocate the response.
+         * Allocate the header.
          */
-        std::string http_response;
+        std::string http_header;
         
         /**
-         * Formulate the response.
+         * Formulate the header.
          */
-        http_response += "HTTP/1.1 200 OK\r\n";
-        http_response +=
+        http_header += "HTTP/1.1 200 OK\r\n";
+        http_header +=
             "Date: " + network::instance().rfc1123_time() + "\r\n"
         ;
-        http_response += "Connection: close\r\n";
-        http_response += "Content-Type: application/json\r\n";
+        http_header += "Connection: close\r\n";
+        http_header += "Content-Type: " + content_type + "\r\n";
+        http_header += "Content-Length: " +
+            std::to_string(body.size()) + "\r\n"
+        ;
+        http_header += "Server: vcash JSON-RPC 2.0\r\n";
+        http_header += "\r\n";
         
         /**
-         * Allocate the body.
+         * Assemble the response in a single buffer that is handed over to
+         * the transport without further copies.
          */
-        std::string body;
+        std::vector<char> http_response;
         
-        try
+        http_response.reserve(http_header.size() + body.size());
+        
+        http_response.insert(
+            http_response.end(), http_header.begin(), http_header.end()
+        );
+        http_response.insert(http_response.end(), body.begin(), body.end());
+        
+        if (close_after_writes)
         {
-            boost::property_tree::ptree pt;
-            
-            for (auto & i : responses)
-            {
-                boost::property_tree::ptree pt_child;
-                
-                if (i.id.size() == 0)
-                {
-                    continue;
-                }
-                
-                if (i.error.size() > 0)
-                {
-                    /**
-                     * Put error into property tree.
-                     */
-                    pt_child.put_child("error", i.error);
-                }
-                else
-                {
-                    /**
-                     * Put the result into property tree.
-                     */
-                    pt_child.put_child("result", i.result);
-                }
-
-                /**
-                 * Put id into property tree.
-                 */
-                pt_child.put(
-                    "id", i.id, rpc_json_parser::translator<std::string> ()
-                );
-
-                
-                pt.push_back(std::make_pair("", pt_child));
-            }
-            
             /**
-             * The std::stringstream.
+             * Set that the transport should close after it writes all of
+             * it's queued buffers.
              */
-            std::stringstream ss;
-            
-            /**
-             * Write property tree to json file.
-             */
-            rpc_json_parser::write_json(ss, pt, false);
-            
-            /**
-             * Set the body.
-             */
-            body = ss.str();
-        }
-        catch (std::exception & e)
-        {
-            log_error(
-                "RPC Connection failed to create response, what = " <<
-                e.what() << "."
-            );
-            
-            return false;
+            transport->set_close_after_writes(true);
         }
         
-        http_response += "Content-Length: " +
-            std::to_string(body.size()) + "\r\n"
-        ;
-        http_response += "Server: vcash JSON-RPC 2.0\r\n";
-        http_response += "\r\n";
-        
-        http_response += body;
-        
         /**
          * Write the response.
          */
-        if (transport)
-        {
-            transport->write(http_response.data(), http_response.size());
-        }
+        transport->write(std::move(http_response));
         
         return true;
     }
@@ -1413,6 +1418,48 @@ rpc_connection::json_rpc_response_t rpc_connection::json_databaseenv(
 
                 ret.result.put("", "null");
             }
+            else if (param_command == "metrics")
+            {
+                if (stack_impl::get_db_env() == 0)
+                {
+                    throw std::runtime_error("database environment is closed");
+                }
+                
+                auto stats = stack_impl::get_db_env()->maintenance_stats();
+                
+                auto lookups = stats.cache_hits + stats.cache_misses;
+                
+                rpc_json_writer writer(ret.result_json);
+                
+                writer.begin_object();
+                writer.write_number("checkpoints", stats.checkpoints);
+                writer.write_number(
+                    "checkpoint_duration_last_ms",
+                    stats.checkpoint_duration_last
+                );
+                writer.write_number(
+                    "checkpoint_duration_max_ms",
+                    stats.checkpoint_duration_max
+                );
+                writer.write_number(
+                    "checkpoint_interval", stats.checkpoint_interval
+                );
+                writer.write_number("log_bytes", stats.log_bytes);
+                writer.write_number(
+                    "log_bytes_since_checkpoint", stats.log_bytes_checkpoint
+                );
+                writer.write_number("cache_bytes", stats.cache_bytes);
+                writer.write_number("cache_hits", stats.cache_hits);
+                writer.write_number("cache_misses", stats.cache_misses);
+                writer.write_number(
+                    "cache_hit_ratio", lookups > 0 ?
+                    static_cast<double> (stats.cache_hits) / lookups : 0.0
+                );
+                writer.write_number(
+                    "cache_pages_evicted", stats.cache_pages_evicted
+                );
+                writer.end_object();
+            }
             else
             {
                 auto pt_error = create_error_object(
@@ -2220,7 +2267,78 @@ rpc_connection::json_rpc_response_t rpc_connection::json_getaccountaddress(
     return ret;
 }
 
-rpc_connection::json_rpc_response_t rpc_connection::json_getbalance(
+bool rpc_connection::parse_address_index_params(
+    const json_rpc_request_t & request, script & script_public_key,
+    std::int32_t & height_start, std::int32_t & height_end,
+    boost::property_tree::ptree & error
+    )
+{
+    if (globals::instance().address_index() == false)
+    {
+        error = create_error_object(
+            error_code_misc_error,
+            "address index is disabled (database.address_index)"
+        );
+        
+        return false;
+    }
+    
+    if (request.params.size() < 1 || request.params.size() > 3)
+    {
+        error = create_error_object(
+            error_code_invalid_params, "invalid parameter count"
+        );
+        
+        return false;
+    }
+    
+    height_start = 0;
+    height_end = std::numeric_limits<std::int32_t>::max();
+    
+    auto index = 0;
+    
+    for (auto & i : request.params)
+    {
+        if (index == 0)
+        {
+            address addr(i.second.get<std::string> (""));
+            
+            if (addr.is_valid() == false)
+            {
+                error = create_error_object(
+                    error_code_invalid_address_or_key, "invalid address"
+                );
+                
+                return false;
+            }
+            
+            script_public_key.set_destination(addr.get());
+        }
+        else if (index == 1)
+        {
+            height_start = i.second.get<std::int32_t> ("");
+        }
+        else if (index == 2)
+        {
+            height_end = i.second.get<std::int32_t> ("");
+        }
+        
+        index++;
+    }
+    
+    if (height_start < 0 || height_end < height_start)
+    {
+        error = create_error_object(
+            error_code_invalid_parameter, "invalid height range"
+        );
+        
+        return false;
+    }
+    
+    return true;
+}
+
+rpc_connection::json_rpc_response_t rpc_connection::json_getaddressbalance(
     const json_rpc_request_t & request
     )
 {
@@ -2233,16 +2351,251 @@ rpc_connection::json_rpc_response_t rpc_connection::json_getbalance(
     
     try
     {
-        if (request.params.size() == 0)
+        script script_public_key;
+        
+        std::int32_t height_start, height_end;
+        
+        boost::property_tree::ptree pt_error;
+        
+        if (
+            request.params.size() != 1 ||
+            parse_address_index_params(request, script_public_key,
+            height_start, height_end, pt_error) == false
+            )
         {
-            ret.result.put(
-                "", static_cast<double> (
-                globals::instance().wallet_main()->get_balance()) /
-                constants::coin
-            );
+            if (pt_error.empty())
+            {
+                pt_error = create_error_object(
+                    error_code_invalid_params, "invalid parameter count"
+                );
+            }
             
-            return ret;
-        }
+            return json_rpc_response_t{
+                boost::property_tree::ptree(), pt_error, request.id
+            };
+        }
+        
+        db_tx tx_db("r");
+        
+        std::vector<address_index::entry_t> entries;
+        
+        address_index::get_entries(
+            tx_db, address_index::get_script_hash(script_public_key),
+            height_start, height_end, entries
+        );
+        
+        std::int64_t balance = 0;
+        std::int64_t received = 0;
+        
+        for (auto & i : entries)
+        {
+            balance += i.value;
+            
+            if (i.type == address_index::type_output)
+            {
+                received += i.value;
+            }
+        }
+        
+        rpc_json_writer writer(ret.result_json);
+        
+        writer.begin_object();
+        writer.write_number("balance", balance);
+        writer.write_number("received", received);
+        writer.end_object();
+    }
+    catch (std::exception & e)
+    {
+        auto pt_error = create_error_object(
+            error_code_internal_error, e.what()
+        );
+        
+        /**
+         * error_code_internal_error
+         */
+        return json_rpc_response_t{
+            boost::property_tree::ptree(), pt_error, request.id
+        };
+    }
+    
+    return ret;
+}
+
+rpc_connection::json_rpc_response_t rpc_connection::json_getaddresstxids(
+    const json_rpc_request_t & request
+    )
+{
+    json_rpc_response_t ret;
+    
+    /**
+     * Set the id from the request.
+     */
+    ret.id = request.id;
+    
+    try
+    {
+        script script_public_key;
+        
+        std::int32_t height_start, height_end;
+        
+        boost::property_tree::ptree pt_error;
+        
+        if (
+            parse_address_index_params(request, script_public_key,
+            height_start, height_end, pt_error) == false
+            )
+        {
+            return json_rpc_response_t{
+                boost::property_tree::ptree(), pt_error, request.id
+            };
+        }
+        
+        db_tx tx_db("r");
+        
+        std::vector<address_index::entry_t> entries;
+        
+        address_index::get_entries(
+            tx_db, address_index::get_script_hash(script_public_key),
+            height_start, height_end, entries
+        );
+        
+        rpc_json_writer writer(ret.result_json);
+        
+        writer.begin_array();
+        
+        /**
+         * The entries are ordered by height, a transaction may have
+         * several entries (inputs and outputs) in the same block.
+         */
+        std::set<sha256> seen;
+        
+        for (auto & i : entries)
+        {
+            if (seen.insert(i.hash_tx).second)
+            {
+                writer.write_string(i.hash_tx.to_string());
+            }
+        }
+        
+        writer.end_array();
+    }
+    catch (std::exception & e)
+    {
+        auto pt_error = create_error_object(
+            error_code_internal_error, e.what()
+        );
+        
+        /**
+         * error_code_internal_error
+         */
+        return json_rpc_response_t{
+            boost::property_tree::ptree(), pt_error, request.id
+        };
+    }
+    
+    return ret;
+}
+
+rpc_connection::json_rpc_response_t rpc_connection::json_getaddressutxos(
+    const json_rpc_request_t & request
+    )
+{
+    json_rpc_response_t ret;
+    
+    /**
+     * Set the id from the request.
+     */
+    ret.id = request.id;
+    
+    try
+    {
+        script script_public_key;
+        
+        std::int32_t height_start, height_end;
+        
+        boost::property_tree::ptree pt_error;
+        
+        if (
+            parse_address_index_params(request, script_public_key,
+            height_start, height_end, pt_error) == false
+            )
+        {
+            return json_rpc_response_t{
+                boost::property_tree::ptree(), pt_error, request.id
+            };
+        }
+        
+        db_tx tx_db("r");
+        
+        std::vector<address_index::unspent_t> unspent;
+        
+        address_index::get_unspent(
+            tx_db, address_index::get_script_hash(script_public_key),
+            height_start, height_end, unspent
+        );
+        
+        auto addr = request.params.front().second.get<std::string> ("");
+        
+        rpc_json_writer writer(ret.result_json);
+        
+        writer.begin_array();
+        
+        for (auto & i : unspent)
+        {
+            writer.begin_object();
+            writer.write_string("address", addr);
+            writer.write_string("txid", i.hash_tx.to_string());
+            writer.write_number("outputIndex", i.n);
+            writer.write_hex(
+                "script", script_public_key.begin(), script_public_key.end()
+            );
+            writer.write_number("satoshis", i.value);
+            writer.write_number("height", i.height);
+            writer.end_object();
+        }
+        
+        writer.end_array();
+    }
+    catch (std::exception & e)
+    {
+        auto pt_error = create_error_object(
+            error_code_internal_error, e.what()
+        );
+        
+        /**
+         * error_code_internal_error
+         */
+        return json_rpc_response_t{
+            boost::property_tree::ptree(), pt_error, request.id
+        };
+    }
+    
+    return ret;
+}
+
+rpc_connection::json_rpc_response_t rpc_connection::json_getbalance(
+    const json_rpc_request_t & request
+    )
+{
+    json_rpc_response_t ret;
+    
+    /**
+     * Set the id from the request.
+     */
+    ret.id = request.id;
+    
+    try
+    {
+        if (request.params.size() == 0)
+        {
+            ret.result.put(
+                "", static_cast<double> (
+                globals::instance().wallet_main()->get_balance()) /
+                constants::coin
+            );
+            
+            return ret;
+        }
         else if (request.params.size() > 0)
         {
             std::string account;
@@ -2479,11 +2832,6 @@ rpc_connection::json_rpc_response_t rpc_connection::json_getblock(
                 
                 blk.read_from_disk(index, true);
                 
-                ret.result.put(
-                    "hash", blk.get_hash().to_string(),
-                    rpc_json_parser::translator<std::string> ()
-                );
-                
                 transaction_merkle tx(blk.transactions()[0]);
                 
                 tx.set_merkle_branch(&blk);
@@ -2498,108 +2846,106 @@ rpc_connection::json_rpc_response_t rpc_connection::json_getblock(
                  */
                 blk.encode(buffer_block);
                 
-                ret.result.put("confirmations", tx.get_depth_in_main_chain());
-                ret.result.put("size", buffer_block.size());
-                ret.result.put("height", index->height());
-                ret.result.put("version", blk.header().version);
-                ret.result.put(
-                    "merkleroot", blk.header().hash_merkle_root.to_string(),
-                    rpc_json_parser::translator<std::string> ()
+                /**
+                 * Stream the result directly into the response buffer.
+                 */
+                rpc_json_writer writer(ret.result_json);
+                
+                writer.begin_object();
+                
+                writer.write_string("hash", blk.get_hash().to_string());
+                writer.write_number(
+                    "confirmations",
+                    tx.get_depth_in_main_chain()
                 );
-                ret.result.put(
+                writer.write_number(
+                    "size", static_cast<std::uint64_t> (buffer_block.size())
+                );
+                writer.write_number("height", index->height());
+                writer.write_number("version", blk.header().version);
+                writer.write_string(
+                    "merkleroot", blk.header().hash_merkle_root.to_string()
+                );
+                writer.write_number(
                     "mint", static_cast<double> (index->mint()) /
                     constants::coin
                 );
-                ret.result.put("time", blk.header().timestamp);
-                ret.result.put("nonce", blk.header().nonce);
-                ret.result.put(
-                    "bits", utility::hex_string_from_bits(blk.header().bits),
-                    rpc_json_parser::translator<std::string> ()
+                writer.write_number("time", blk.header().timestamp);
+                writer.write_number("nonce", blk.header().nonce);
+                writer.write_string(
+                    "bits", utility::hex_string_from_bits(blk.header().bits)
+                );
+                writer.write_number(
+                    "difficulty", stack_impl_.difficulty(index)
                 );
-                ret.result.put("difficulty", stack_impl_.difficulty(index));
                 
                 if (index->block_index_previous())
                 {
-                    ret.result.put(
+                    writer.write_string(
                         "previousblockhash",
                         index->block_index_previous(
-                        )->get_block_hash().to_string(),
-                        rpc_json_parser::translator<std::string> ()
+                        )->get_block_hash().to_string()
                     );
                 }
                 
                 if (index->block_index_next())
                 {
-                    ret.result.put(
+                    writer.write_string(
                         "nextblockhash",
-                        index->block_index_next()->get_block_hash().to_string(),
-                        rpc_json_parser::translator<std::string> ()
+                        index->block_index_next()->get_block_hash().to_string()
                     );
                 }
                 
-                ret.result.put(
+                writer.write_string(
                     "flags",
                     std::string(index->is_proof_of_stake()? "proof-of-stake" :
                     "proof-of-work") +
                     std::string(index->generated_stake_modifier() ?
-                    " stake-modifier": ""),
-                    rpc_json_parser::translator<std::string> ()
+                    " stake-modifier": "")
                 );
                 
-                ret.result.put(
+                writer.write_string(
                     "proofhash",
                     (index->is_proof_of_stake() ?
                     index->hash_proof_of_stake().to_string() :
-                    index->get_block_hash().to_string()),
-                    rpc_json_parser::translator<std::string> ()
+                    index->get_block_hash().to_string())
                 );
                 
-                ret.result.put(
+                writer.write_number(
                     "entropybit", index->get_stake_entropy_bit()
                 );
 
                 /**
                  * :TODO: %016
                  */
-                ret.result.put(
-                    "modifier", index->stake_modifier()
-                );
+                writer.write_number("modifier", index->stake_modifier());
                 
                 /**
                  * :TODO: %08x
                  */
-                ret.result.put(
+                writer.write_number(
                     "modifierchecksum", index->stake_modifier_checksum()
                 );
 
-                boost::property_tree::ptree pt_txinfo;
-                
-                boost::property_tree::ptree pt_txinfo_children;
+                writer.begin_array("tx");
                 
                 for (auto & i : blk.transactions())
                 {
-                    pt_txinfo.put(
-                        "", i.get_hash().to_string(),
-                        rpc_json_parser::translator<std::string> ()
-                    );
-                    
-                    pt_txinfo_children.push_back(
-                        std::make_pair("", pt_txinfo)
-                    );
+                    writer.write_string(i.get_hash().to_string());
                 }
 
-                ret.result.put_child("tx", pt_txinfo_children);
+                writer.end_array();
                 
                 /**
                  * Get the block signature.
                  */
                 const auto & signature = blk.signature();
 
-                ret.result.put(
-                    "signature",
-                    utility::hex_string(signature.begin(), signature.end()),
-                    rpc_json_parser::translator<std::string> ()
+                writer.write_hex(
+                    "signature", signature.begin(), signature.end()
                 );
+                
+                writer.end_object();
             }
         }
         else
@@ -3526,6 +3872,123 @@ boost::property_tree::ptree rpc_connection::json_getinfo()
     return ret;
 }
 
+rpc_connection::json_rpc_response_t rpc_connection::json_getmetrics(
+    const json_rpc_request_t & request
+    )
+{
+    json_rpc_response_t ret;
+    
+    /**
+     * Set the id from the request.
+     */
+    ret.id = request.id;
+    
+    try
+    {
+        if (request.params.size() == 0)
+        {
+            rpc_json_writer writer(ret.result_json);
+            
+            writer.begin_object();
+            
+            writer.begin_object("counters");
+            
+            for (auto & i : metrics::instance().counters())
+            {
+                writer.write_number(i.first.c_str(), i.second);
+            }
+            
+            writer.end_object();
+            
+            writer.begin_object("histograms");
+            
+            for (auto & i : metrics::instance().histograms())
+            {
+                const auto & snapshot = i.second;
+                
+                /**
+                 * Estimates a quantile as the upper bound (in microseconds)
+                 * of the bucket it falls into.
+                 */
+                auto quantile = [&snapshot](const double & q)
+                {
+                    std::uint64_t cumulative = 0;
+                    
+                    for (auto j = 0; j < metrics::buckets; j++)
+                    {
+                        cumulative += snapshot.counts[j];
+                        
+                        if (cumulative >= q * snapshot.count)
+                        {
+                            return static_cast<std::uint64_t> (1) << j;
+                        }
+                    }
+                    
+                    return static_cast<std::uint64_t> (1) <<
+                        (metrics::buckets - 1)
+                    ;
+                };
+                
+                writer.begin_object(i.first.c_str());
+                writer.write_number("count", snapshot.count);
+                writer.write_number("sum_us", snapshot.sum);
+                writer.write_number(
+                    "mean_us", snapshot.count > 0 ?
+                    static_cast<double> (snapshot.sum) / snapshot.count : 0.0
+                );
+                writer.write_number("p50_us", quantile(0.50));
+                writer.write_number("p90_us", quantile(0.90));
+                writer.write_number("p99_us", quantile(0.99));
+                writer.end_object();
+            }
+            
+            writer.end_object();
+            
+            auto read_statistics = tcp_connection::read_statistics();
+            
+            writer.begin_object("tcp_connection");
+            writer.write_number("reads", read_statistics.reads);
+            writer.write_number("messages", read_statistics.messages);
+            writer.end_object();
+            
+            writer.end_object();
+        }
+        else
+        {
+            auto pt_error = create_error_object(
+                error_code_invalid_params, "invalid parameter count"
+            );
+
+            /**
+             * error_code_invalid_params
+             */
+            return json_rpc_response_t{
+                boost::property_tree::ptree(), pt_error, request.id
+            };
+        }
+    }
+    catch (std::exception & e)
+    {
+        log_error(
+            "RPC Connection failed to create json_getmetrics, what = " <<
+            e.what() << "."
+        );
+
+        auto pt_error = create_error_object(
+            error_code_internal_error, e.what()
+        );
+
+        /**
+         * error_code_internal_error
+         */
+        return json_rpc_response_t{
+            boost::property_tree::ptree(), pt_error, request.id
+        };
+    }
+    
+    return ret;
+}
+
 rpc_connection::json_rpc_response_t rpc_connection::json_getmininginfo(
     const json_rpc_request_t & request
     )
@@ -3983,195 +4446,27 @@ rpc_connection::json_rpc_response_t rpc_connection::json_getrawtransaction(
             
             tx.encode(buffer);
             
-            auto hex = utility::hex_string(
-                buffer.data(), buffer.data() + buffer.size()
-            );
+            /**
+             * Stream the result directly into the response buffer, the
+             * hexidecimal encoding is performed in place.
+             */
+            rpc_json_writer writer(ret.result_json);
             
             if (verbose)
             {
-                ret.result.put(
-                    "hex", hex, rpc_json_parser::translator<std::string> ()
-                );
+                writer.begin_object();
                 
-                ret.result.put(
-                    "txid", tx.get_hash().to_string(),
-                    rpc_json_parser::translator<std::string> ()
+                writer.write_hex(
+                    "hex", buffer.data(), buffer.data() + buffer.size()
                 );
-                ret.result.put("version", tx.version());
-                ret.result.put("time", tx.time());
-                ret.result.put("locktime", tx.time_lock());
-
-                boost::property_tree::ptree pt_vin;
                 
-                for (auto & i : tx.transactions_in())
-                {
-                    boost::property_tree::ptree pt_in;
-                    
-                    if (tx.is_coin_base())
-                    {
-                        pt_in.put(
-                            "coinbase",
-                            utility::hex_string(i.script_signature().begin(),
-                            i.script_signature().end()),
-                            rpc_json_parser::translator<std::string> ()
-                        );
-                    }
-                    else
-                    {
-                        pt_in.put(
-                            "txid", i.previous_out().get_hash().to_string(),
-                            rpc_json_parser::translator<std::string> ()
-                        );
-                        pt_in.put(
-                            "vout", i.previous_out().n()
-                        );
-
-                        boost::property_tree::ptree pt_o;
-                        
-                        pt_o.put(
-                            "asm", i.script_signature().to_string(),
-                            rpc_json_parser::translator<std::string> ()
-                        );
-                        pt_o.put(
-                            "hex", utility::hex_string(
-                            i.script_signature().begin(),
-                            i.script_signature().end()),
-                            rpc_json_parser::translator<std::string> ()
-                        );
-                        
-                        pt_in.put_child("scriptSig", pt_o);
-                    }
-                    
-                    pt_in.put("sequence", i.sequence());
-                    
-                    pt_vin.push_back(std::make_pair("", pt_in));
-                }
-                
-                ret.result.put_child("vin", pt_vin);
-
-                boost::property_tree::ptree pt_outs;
-                
-                for (auto i = 0; i < tx.transactions_out().size(); i++)
-                {
-                    const auto & tx_out = tx.transactions_out()[i];
-                    
-                    boost::property_tree::ptree pt_out;
-                    
-                    pt_out.put(
-                        "value",
-                        static_cast<double> (tx_out.value()) / constants::coin
-                    );
-                    pt_out.put("n", i);
-                    
-                    boost::property_tree::ptree pt_o;
-                    
-                    types::tx_out_t type;
-                    
-                    std::vector<destination::tx_t> addresses;
-                    
-                    std::int32_t required;
-
-                    pt_o.put(
-                        "asm", tx_out.script_public_key().to_string(),
-                        rpc_json_parser::translator<std::string> ()
-                    );
-                    pt_o.put(
-                        "hex", utility::hex_string(
-                        tx_out.script_public_key().begin(),
-                        tx_out.script_public_key().end()),
-                        rpc_json_parser::translator<std::string> ()
-                    );
-
-                    if (
-                        script::extract_destinations(tx_out.script_public_key(),
-                        type, addresses, required) == false
-                        )
-                    {
-                        pt_o.put(
-                            "type",
-                            script::get_txn_output_type(
-                            types::tx_out_nonstandard),
-                            rpc_json_parser::translator<std::string> ()
-                        );
-                    }
-                    else
-                    {
-                        pt_o.put("reqSigs", required);
-                        pt_o.put(
-                            "type", script::get_txn_output_type(type),
-                            rpc_json_parser::translator<std::string> ()
-                        );
-
-                        boost::property_tree::ptree pt_a;
-                        
-                        for (auto & i : addresses)
-                        {
-                            boost::property_tree::ptree pt_tmp;
-                            
-                            pt_tmp.put(
-                                "", address(i).to_string(),
-                                rpc_json_parser::translator<std::string> ()
-                            );
-            
-                            pt_a.push_back(std::make_pair("", pt_tmp));
-                        }
-                        
-                        pt_o.put_child("addresses", pt_a);
-                    }
-                    
-                    if (pt_o.size() > 0)
-                    {
-                        pt_out.put_child("scriptPubKey", pt_o);
-                    }
-                    else
-                    {
-                        pt_out.put_child(
-                            "scriptPubKey", boost::property_tree::ptree()
-                        );
-                    }
-                    
-                    pt_outs.push_back(std::make_pair("", pt_out));
-                }
+                transaction_to_json(writer, tx, hash_block);
                 
-                ret.result.put_child("vout", pt_outs);
-
-                if (hash_block != 0)
-                {
-                    ret.result.put(
-                        "blockhash", hash_block.to_string(),
-                        rpc_json_parser::translator<std::string> ()
-                    );
-                    
-                    auto block_indexes = globals::instance().block_indexes();
-                    
-                    auto it = block_indexes.find(hash_block);
-                    
-                    if (it != block_indexes.end() && it->second)
-                    {
-                        auto index = it->second;
-                        
-                        if (index->is_in_main_chain())
-                        {
-                            ret.result.put(
-                                "confirmations",
-                                1 + stack_impl::get_block_index_best(
-                                )->height() - index->height()
-                            );
-                            ret.result.put("time", index->time());
-                            ret.result.put("blocktime", index->time());
-                        }
-                        else
-                        {
-                            ret.result.put("confirmations", 0);
-                        }
-                    }
-                }
+                writer.end_object();
             }
             else
             {
-                ret.result.put(
-                    "", hex, rpc_json_parser::translator<std::string> ()
-                );
+                writer.write_hex(buffer.data(), buffer.data() + buffer.size());
             }
         }
         else
@@ -4233,13 +4528,6 @@ rpc_connection::json_rpc_response_t rpc_connection::json_gettransaction(
             if (it != transactions.end())
             {
                 const auto & wtx = it->second;
-
-                auto transactions = transaction_to_ptree(wtx, 0);
-                
-                for (auto & i : transactions)
-                {
-                    ret.result.push_back(std::make_pair(i.first, i.second));
-                }
                 
                 std::int64_t credit = wtx.get_credit();
                 std::int64_t debit = wtx.get_debit();
@@ -4247,36 +4535,50 @@ rpc_connection::json_rpc_response_t rpc_connection::json_gettransaction(
                 std::int64_t fee =
                     (wtx.is_from_me() ? wtx.get_value_out() - debit : 0)
                 ;
-
-                ret.result.put(
+                
+                /**
+                 * The encoded detail entries.
+                 */
+                std::vector<std::string> details;
+                
+                transactions_to_json(details, wtx, "*", 0, false);
+                
+                /**
+                 * Stream the result directly into the response buffer.
+                 */
+                rpc_json_writer writer(ret.result_json);
+                
+                writer.begin_object();
+                
+                transaction_to_json(writer, wtx, 0);
+                
+                writer.write_number(
                     "amount", static_cast<double> (net - fee) /
                     constants::coin
                 );
                 
                 if (wtx.is_from_me())
                 {
-                    ret.result.put(
+                    writer.write_number(
                         "fee", static_cast<double> (fee) / constants::coin
                     );
                 }
                 
-                auto pt = transaction_wallet_to_ptree(wtx);
+                transaction_wallet_to_json(writer, wtx);
                 
-                for (auto & i : pt)
+                if (details.size() > 0)
                 {
-                    ret.result.push_back(std::make_pair(i.first, i.second));
+                    writer.begin_array("details");
+                    
+                    for (auto & i : details)
+                    {
+                        writer.write_raw(i);
+                    }
+                    
+                    writer.end_array();
                 }
-
-                auto pt_details =
-                    transactions_to_ptree(
-                    globals::instance().wallet_main()->transactions()
-                    [hash_txid], "*", 0, false
-                );
                 
-                if (pt_details.size() > 0)
-                {
-                    ret.result.put_child("details", pt_details);
-                }
+                writer.end_object();
             }
             else
             {
@@ -4286,56 +4588,35 @@ rpc_connection::json_rpc_response_t rpc_connection::json_gettransaction(
                 
                 if (utility::get_transaction(hash_txid, tx, hash_block))
                 {
-                    ret.result.put(
-                        "txid", hash_txid.to_string(),
-                        rpc_json_parser::translator<std::string> ()
-                    );
+                    /**
+                     * Stream the result directly into the response buffer.
+                     */
+                    rpc_json_writer writer(ret.result_json);
                     
-                    auto transactions = transaction_to_ptree(tx, 0);
+                    writer.begin_object();
+                    
+                    transaction_to_json(writer, tx, hash_block);
                     
-                    for (auto & i : transactions)
-                    {
-                        ret.result.push_back(
-                            std::make_pair(i.first, i.second)
-                        );
-                    }
-
                     if (hash_block == 0)
                     {
-                        ret.result.put("confirmations", 0);
+                        writer.write_number("confirmations", 0);
                     }
                     else
                     {
-                        ret.result.put(
-                            "blockhash", hash_block.to_string(),
-                            rpc_json_parser::translator<std::string> ()
-                        );
-                        
                         auto it = globals::instance().block_indexes().find(
                             hash_block
                         );
                         
-                        if (it != globals::instance().block_indexes().end())
+                        if (
+                            it != globals::instance().block_indexes().end() &&
+                            it->second && it->second->is_in_main_chain()
+                            )
                         {
-                            const auto & index = it->second;
-                            
-                            if (index && index->is_in_main_chain())
-                            {
-                                ret.result.put(
-                                    "confirmations",
-                                    1 +
-                                    stack_impl::get_block_index_best()->height()
-                                    - index->height()
-                                );
-                                ret.result.put("txntime", tx.time());
-                                ret.result.put("time", index->time());
-                            }
-                            else
-                            {
-                                ret.result.put("confirmations", 0);
-                            }
+                            writer.write_number("txntime", tx.time());
                         }
                     }
+                    
+                    writer.end_object();
                 }
                 else
                 {
@@ -4597,7 +4878,10 @@ rpc_connection::json_rpc_response_t rpc_connection::json_listsinceblock(
             index_block->height()) : -1
         ;
         
-        boost::property_tree::ptree pt_transactions;
+        /**
+         * The encoded transaction entries.
+         */
+        std::vector<std::string> entries;
 
         auto transactions =
             globals::instance().wallet_main()->transactions()
@@ -4607,14 +4891,7 @@ rpc_connection::json_rpc_response_t rpc_connection::json_listsinceblock(
         {
             if (depth == -1 || i.second.get_depth_in_main_chain() < depth)
             {
-                auto pt = transactions_to_ptree(i.second, "*", 0, true);
-                
-                for (auto & j : pt)
-                {
-                    pt_transactions.push_back(
-                        std::make_pair(j.first, j.second)
-                    );
-                }
+                transactions_to_json(entries, i.second, "*", 0, true);
             }
         }
 
@@ -4645,26 +4922,25 @@ rpc_connection::json_rpc_response_t rpc_connection::json_listsinceblock(
             lastblock = tmp ? tmp->get_block_hash() : 0;
         }
 
-        if (pt_transactions.size() > 0)
-        {
-            ret.result.put_child("transactions", pt_transactions);
-        }
-        else
+        /**
+         * Stream the result directly into the response buffer.
+         */
+        rpc_json_writer writer(ret.result_json);
+        
+        writer.begin_object();
+        
+        writer.begin_array("transactions");
+        
+        for (auto & i : entries)
         {
-            boost::property_tree::ptree pt_empty;
-            
-            pt_empty.push_back(
-                std::make_pair("", boost::property_tree::ptree())
-            );
-            
-            ret.result.put_child("transactions", pt_empty);
+            writer.write_raw(i);
         }
         
-        ret.result.put(
-            "lastblock", lastblock.to_string(),
-            rpc_json_parser::translator<std::string> ()
-        );
+        writer.end_array();
+        
+        writer.write_string("lastblock", lastblock.to_string());
         
+        writer.end_object();
     }
     catch (std::exception & e)
     {
@@ -4750,6 +5026,11 @@ rpc_connection::json_rpc_response_t rpc_connection::json_listtransactions(
             )->ordered_tx_items(accounting_entries
         );
         
+        /**
+         * The encoded entries (newest first).
+         */
+        std::vector<std::string> entries;
+        
         for (auto it = ordered_items.rbegin(); it != ordered_items.rend(); ++it)
         {
             const auto & i = *it;
@@ -4758,14 +5039,7 @@ rpc_connection::json_rpc_response_t rpc_connection::json_listtransactions(
             {
                 const auto & wtx = *i.second.first;
             
-                auto pt_transactions = transactions_to_ptree(
-                    wtx, account, 0, true
-                );
-                
-                for (auto & j : pt_transactions)
-                {
-                    ret.result.push_back(std::make_pair(j.first, j.second));
-                }
+                transactions_to_json(entries, wtx, account, 0, true);
             }
             
             if (i.second.second)
@@ -4776,73 +5050,59 @@ rpc_connection::json_rpc_response_t rpc_connection::json_listtransactions(
             
                 if (all_accounts || entry.account() == account)
                 {
-                    ret.result.put(
-                        "account", entry.account(),
-                        rpc_json_parser::translator<std::string> ()
-                    );
-                    ret.result.put(
-                        "category", "move",
-                        rpc_json_parser::translator<std::string> ()
-                    );
-                    ret.result.put("time", entry.time());
-                    ret.result.put(
+                    std::string json;
+                    
+                    rpc_json_writer writer(json);
+                    
+                    writer.begin_object();
+                    writer.write_string("account", entry.account());
+                    writer.write_string("category", "move");
+                    writer.write_number("time", entry.time());
+                    writer.write_number(
                         "amount",
                         static_cast<double> (entry.credit_debit()) /
                         constants::coin
                     );
-                    ret.result.put(
-                        "otheraccount", entry.other_account(),
-                        rpc_json_parser::translator<std::string> ()
-                    );
-                    ret.result.put(
-                        "comment", entry.comment(),
-                        rpc_json_parser::translator<std::string> ()
+                    writer.write_string(
+                        "otheraccount", entry.other_account()
                     );
+                    writer.write_string("comment", entry.comment());
+                    writer.end_object();
+                    
+                    entries.push_back(std::move(json));
                 }
             }
             
-            if (ret.result.size() >= count + from)
+            if (entries.size() >= count + from)
             {
                 break;
             }
         }
 
-        if (from > ret.result.size())
+        if (from > entries.size())
         {
-            from = static_cast<std::int32_t> (ret.result.size());
+            from = static_cast<std::int32_t> (entries.size());
         }
         
-        if ((from + count) > ret.result.size())
+        if ((from + count) > entries.size())
         {
-            count = static_cast<std::int32_t> (ret.result.size()) - from;
+            count = static_cast<std::int32_t> (entries.size()) - from;
         }
         
-        auto first = ret.result.begin();
-        
-        std::advance(first, from);
-        
-        auto last = ret.result.begin();
+        /**
+         * Stream the requested range (oldest first) directly into the
+         * response buffer.
+         */
+        rpc_json_writer writer(ret.result_json);
         
-        std::advance(last, from + count);
-
-        if (last != ret.result.end())
-        {
-            ret.result.erase(last, ret.result.end());
-        }
+        writer.begin_array();
         
-        if (first != ret.result.begin())
+        for (auto i = from + count; i > from; i--)
         {
-            ret.result.erase(ret.result.begin(), first);
+            writer.write_raw(entries[i - 1]);
         }
         
-        ret.result.reverse();
-
-        if (ret.result.size() == 0)
-        {
-            ret.result.push_back(
-                std::make_pair("", boost::property_tree::ptree())
-            );
-        }
+        writer.end_array();
     }
     catch (std::exception & e)
     {
@@ -6259,254 +6519,207 @@ rpc_connection::json_rpc_response_t
     return ret;
 }
 
-boost::property_tree::ptree rpc_connection::transaction_wallet_to_ptree(
-    const transaction_wallet & wtx
+void rpc_connection::transaction_wallet_to_json(
+    rpc_json_writer & writer, const transaction_wallet & wtx
     )
 {
-    boost::property_tree::ptree ret;
-    
     auto depth = wtx.get_depth_in_main_chain();
     
-    ret.put("confirmations", depth);
+    writer.write_number("confirmations", depth);
     
     if (wtx.is_coin_base() || wtx.is_coin_stake())
     {
-        ret.put("generated", true);
+        writer.write_bool("generated", true);
     }
     
     if (depth > 0)
     {
-        ret.put(
-            "blockhash", wtx.block_hash().to_string(),
-            rpc_json_parser::translator<std::string> ()
-        );
-        ret.put("blockindex", wtx.index());
+        writer.write_string("blockhash", wtx.block_hash().to_string());
+        writer.write_number("blockindex", wtx.index());
         
-        const auto & index = globals::instance().block_indexes()[
-            wtx.block_hash()
-        ];
+        const auto & block_indexes = globals::instance().block_indexes();
         
-        ret.put(
-            "blocktime", index ? index->time() : -1
+        auto it = block_indexes.find(wtx.block_hash());
+        
+        writer.write_number(
+            "blocktime",
+            it != block_indexes.end() && it->second ?
+            it->second->time() : static_cast<std::int64_t> (-1)
         );
     }
     
-    ret.put(
-        "txid", wtx.get_hash().to_string(),
-        rpc_json_parser::translator<std::string> ()
-    );
-    ret.put("time", wtx.time());
-    ret.put("timereceived", wtx.time_received());
+    writer.write_string("txid", wtx.get_hash().to_string());
+    writer.write_number("time", wtx.time());
+    writer.write_number("timereceived", wtx.time_received());
     
     for (auto & i : wtx.values())
     {
-        ret.put(
-            i.first, i.second, rpc_json_parser::translator<std::string> ()
-        );
+        writer.write_string(i.first.c_str(), i.second);
     }
-    
-    return ret;
 }
 
-boost::property_tree::ptree rpc_connection::transaction_to_ptree(
-    const transaction & tx, const sha256 & hash_block
+void rpc_connection::transaction_to_json(
+    rpc_json_writer & writer, const transaction & tx,
+    const sha256 & hash_block
     )
 {
-    boost::property_tree::ptree ret;
-
-    try
+    /**
+     * Look up the block index first so that the time is only written once.
+     */
+    block_index * index = 0;
+    
+    if (hash_block != 0)
     {
-        ret.put(
-            "txid", tx.get_hash().to_string(),
-            rpc_json_parser::translator<std::string> ()
-        );
-        ret.put("version", tx.version());
-        ret.put("time", tx.time());
-        ret.put("locktime", tx.time_lock());
-
-        boost::property_tree::ptree pt_vin;
+        const auto & block_indexes = globals::instance().block_indexes();
+        
+        auto it = block_indexes.find(hash_block);
         
-        for (auto & i : tx.transactions_in())
+        if (it != block_indexes.end())
         {
-            boost::property_tree::ptree pt_in;
-            
-            if (tx.is_coin_base())
-            {
-                pt_in.put(
-                    "coinbase",
-                    utility::hex_string(i.script_signature().begin(),
-                    i.script_signature().end()),
-                    rpc_json_parser::translator<std::string> ()
-                );
-            }
-            else
-            {
-                pt_in.put(
-                    "txid", i.previous_out().get_hash().to_string(),
-                    rpc_json_parser::translator<std::string> ()
-                );
-                pt_in.put(
-                    "vout", i.previous_out().n()
-                );
-
-                boost::property_tree::ptree pt_o;
-                
-                pt_o.put(
-                    "asm", i.script_signature().to_string(),
-                    rpc_json_parser::translator<std::string> ()
-                );
-                pt_o.put(
-                    "hex", utility::hex_string(
-                    i.script_signature().begin(),
-                    i.script_signature().end()),
-                    rpc_json_parser::translator<std::string> ()
-                );
-                
-                pt_in.put_child("scriptSig", pt_o);
-            }
-            
-            pt_in.put("sequence", i.sequence());
-            
-            pt_vin.push_back(std::make_pair("", pt_in));
+            index = it->second;
         }
-        
-        ret.put_child("vin", pt_vin);
+    }
+    
+    auto in_main_chain = index && index->is_in_main_chain();
+    
+    writer.write_string("txid", tx.get_hash().to_string());
+    writer.write_number("version", tx.version());
+    
+    if (in_main_chain)
+    {
+        writer.write_number("time", index->time());
+    }
+    else
+    {
+        writer.write_number("time", tx.time());
+    }
+    
+    writer.write_number("locktime", tx.time_lock());
 
-        boost::property_tree::ptree pt_outs;
+    writer.begin_array("vin");
+    
+    for (auto & i : tx.transactions_in())
+    {
+        writer.begin_object();
         
-        for (auto i = 0; i < tx.transactions_out().size(); i++)
+        if (tx.is_coin_base())
         {
-            const auto & tx_out = tx.transactions_out()[i];
-            
-            boost::property_tree::ptree pt_out;
-            
-            pt_out.put(
-                "value", static_cast<double> (tx_out.value()) / constants::coin
-            );
-            pt_out.put("n", i);
-            
-            boost::property_tree::ptree pt_o;
-            
-            types::tx_out_t type;
-            
-            std::vector<destination::tx_t> addresses;
-            
-            int required;
-
-            pt_o.put(
-                "asm", tx_out.script_public_key().to_string(),
-                rpc_json_parser::translator<std::string> ()
+            writer.write_hex(
+                "coinbase", i.script_signature().begin(),
+                i.script_signature().end()
             );
-            pt_o.put(
-                "hex", utility::hex_string(
-                tx_out.script_public_key().begin(),
-                tx_out.script_public_key().end()),
-                rpc_json_parser::translator<std::string> ()
+        }
+        else
+        {
+            writer.write_string(
+                "txid", i.previous_out().get_hash().to_string()
             );
+            writer.write_number("vout", i.previous_out().n());
 
-            if (
-                script::extract_destinations(tx_out.script_public_key(),
-                type, addresses, required) == false
-                )
-            {
-                pt_o.put(
-                    "type",
-                    script::get_txn_output_type(
-                    types::tx_out_nonstandard),
-                    rpc_json_parser::translator<std::string> ()
-                );
-            }
-            else
-            {
-                pt_o.put("reqSigs", required);
-                pt_o.put(
-                    "type", script::get_txn_output_type(type),
-                    rpc_json_parser::translator<std::string> ()
-                );
+            writer.begin_object("scriptSig");
+            writer.write_string("asm", i.script_signature().to_string());
+            writer.write_hex(
+                "hex", i.script_signature().begin(),
+                i.script_signature().end()
+            );
+            writer.end_object();
+        }
+        
+        writer.write_number("sequence", i.sequence());
+        
+        writer.end_object();
+    }
+    
+    writer.end_array();
 
-                boost::property_tree::ptree pt_a;
-                
-                for (auto & i : addresses)
-                {
-                    boost::property_tree::ptree pt_tmp;
-                    
-                    pt_tmp.put(
-                        "", address(i).to_string(),
-                        rpc_json_parser::translator<std::string> ()
-                    );
+    writer.begin_array("vout");
     
-                    pt_a.push_back(std::make_pair("", pt_tmp));
-                }
-                
-                pt_o.put_child("addresses", pt_a);
-            }
+    for (auto i = 0; i < tx.transactions_out().size(); i++)
+    {
+        const auto & tx_out = tx.transactions_out()[i];
+        
+        writer.begin_object();
+        
+        writer.write_number(
+            "value", static_cast<double> (tx_out.value()) / constants::coin
+        );
+        writer.write_number("n", i);
+        
+        writer.begin_object("scriptPubKey");
+        
+        types::tx_out_t type;
+        
+        std::vector<destination::tx_t> addresses;
+        
+        int required;
+
+        writer.write_string("asm", tx_out.script_public_key().to_string());
+        writer.write_hex(
+            "hex", tx_out.script_public_key().begin(),
+            tx_out.script_public_key().end()
+        );
+
+        if (
+            script::extract_destinations(tx_out.script_public_key(),
+            type, addresses, required) == false
+            )
+        {
+            writer.write_string(
+                "type",
+                script::get_txn_output_type(types::tx_out_nonstandard)
+            );
+        }
+        else
+        {
+            writer.write_number("reqSigs", required);
+            writer.write_string("type", script::get_txn_output_type(type));
+
+            writer.begin_array("addresses");
             
-            if (pt_o.size() > 0)
+            for (auto & j : addresses)
             {
-                pt_out.put_child("scriptPubKey", pt_o);
-            }
-            else
-            {
-                pt_out.put_child(
-                    "scriptPubKey", boost::property_tree::ptree()
-                );
+                writer.write_string(address(j).to_string());
             }
             
-            pt_outs.push_back(std::make_pair("", pt_out));
+            writer.end_array();
         }
         
-        ret.put_child("vout", pt_outs);
+        writer.end_object();
+        
+        writer.end_object();
+    }
+    
+    writer.end_array();
 
-        if (hash_block != 0)
+    if (hash_block != 0)
+    {
+        writer.write_string("blockhash", hash_block.to_string());
+        
+        if (index)
         {
-            ret.put(
-                "blockhash", hash_block.to_string(),
-                rpc_json_parser::translator<std::string> ()
-            );
-            
-            auto block_indexes = globals::instance().block_indexes();
-            
-            auto it = block_indexes.find(hash_block);
-            
-            if (it != block_indexes.end() && it->second)
+            if (in_main_chain)
             {
-                auto index = it->second;
-                
-                if (index->is_in_main_chain())
-                {
-                    ret.put(
-                        "confirmations",
-                        1 + stack_impl::get_block_index_best(
-                        )->height() - index->height()
-                    );
-                    ret.put("time", index->time());
-                    ret.put("blocktime", index->time());
-                }
-                else
-                {
-                    ret.put("confirmations", 0);
-                }
+                writer.write_number(
+                    "confirmations",
+                    1 + stack_impl::get_block_index_best(
+                    )->height() - index->height()
+                );
+                writer.write_number("blocktime", index->time());
+            }
+            else
+            {
+                writer.write_number("confirmations", 0);
             }
         }
     }
-    catch (std::exception & e)
-    {
-        log_error(
-            "RPC connection failed to transaction to ptree, what = " <<
-            e.what() << "."
-        );
-    }
-
-    return ret;
 }
 
-boost::property_tree::ptree rpc_connection::transactions_to_ptree(
-    const transaction_wallet & wtx, const std::string & account,
-    const std::uint32_t & minimim_depth, const bool & include_transactions
+void rpc_connection::transactions_to_json(
+    std::vector<std::string> & entries, const transaction_wallet & wtx,
+    const std::string & account, const std::uint32_t & minimim_depth,
+    const bool & include_transactions
     )
 {
-    boost::property_tree::ptree ret;
-    
     std::int64_t generated_immature, generated_mature, fee;
     std::string account_sent;
     
@@ -6528,38 +6741,34 @@ boost::property_tree::ptree rpc_connection::transactions_to_ptree(
         (all_accounts || account == "")
         )
     {
-        boost::property_tree::ptree pt_entry;
+        std::string json;
         
-        pt_entry.put(
-            "account", "", rpc_json_parser::translator<std::string> ()
-        );
+        rpc_json_writer writer(json);
+        
+        writer.begin_object();
         
-        pt_entry.put(
+        writer.write_string("account", "");
+        writer.write_string(
             "address",
             address(globals::instance().wallet_main(
-            )->key_public_default().get_id()).to_string(),
-            rpc_json_parser::translator<std::string> ()
+            )->key_public_default().get_id()).to_string()
         );
         
         if (generated_immature > 0)
         {
-            pt_entry.put(
+            writer.write_string(
                 "category",
-                wtx.get_depth_in_main_chain() > 0 ? "immature" : "orphan",
-                rpc_json_parser::translator<std::string> ()
+                wtx.get_depth_in_main_chain() > 0 ? "immature" : "orphan"
             );
-            pt_entry.put(
+            writer.write_number(
                 "amount", static_cast<double> (generated_immature) /
                 constants::coin
             );
         }
         else
         {
-            pt_entry.put(
-                "category", "generate",
-                rpc_json_parser::translator<std::string> ()
-            );
-            pt_entry.put(
+            writer.write_string("category", "generate");
+            writer.write_number(
                 "amount", static_cast<double> (generated_mature) /
                 constants::coin
             );
@@ -6567,15 +6776,12 @@ boost::property_tree::ptree rpc_connection::transactions_to_ptree(
         
         if (include_transactions)
         {
-            auto pt = transaction_wallet_to_ptree(wtx);
-            
-            for (auto & i : pt)
-            {
-                pt_entry.push_back(std::make_pair(i.first, i.second));
-            }
+            transaction_wallet_to_json(writer, wtx);
         }
         
-        ret.push_back(std::make_pair("", pt_entry));
+        writer.end_object();
+        
+        entries.push_back(std::move(json));
     }
     
     /**
@@ -6588,37 +6794,30 @@ boost::property_tree::ptree rpc_connection::transactions_to_ptree(
     {
         for (auto & s : sent)
         {
-            boost::property_tree::ptree pt_entry;
+            std::string json;
             
-            pt_entry.put(
-                "account", account_sent,
-                rpc_json_parser::translator<std::string> ()
-            );
-            pt_entry.put(
-                "address", address(s.first).to_string(),
-                rpc_json_parser::translator<std::string> ()
-            );
-            pt_entry.put(
-                "category", "send", rpc_json_parser::translator<std::string> ()
-            );
-            pt_entry.put(
+            rpc_json_writer writer(json);
+            
+            writer.begin_object();
+            
+            writer.write_string("account", account_sent);
+            writer.write_string("address", address(s.first).to_string());
+            writer.write_string("category", "send");
+            writer.write_number(
                 "amount", static_cast<double> (-s.second) / constants::coin
             );
-            pt_entry.put(
+            writer.write_number(
                 "fee", static_cast<double> (-fee) / constants::coin
             );
             
             if (include_transactions)
             {
-                auto pt = transaction_wallet_to_ptree(wtx);
-                
-                for (auto & i : pt)
-                {
-                    pt_entry.push_back(std::make_pair(i.first, i.second));
-                }
-                
-                ret.push_back(std::make_pair("", pt_entry));
+                transaction_wallet_to_json(writer, wtx);
             }
+            
+            writer.end_object();
+            
+            entries.push_back(std::move(json));
         }
     }
 
@@ -6630,14 +6829,14 @@ boost::property_tree::ptree rpc_connection::transactions_to_ptree(
         wtx.get_depth_in_main_chain() >= minimim_depth
         )
     {
+        const auto & address_book =
+            globals::instance().wallet_main()->address_book()
+        ;
+        
         for (auto & r : received)
         {
             std::string acct;
             
-            const auto & address_book =
-                globals::instance().wallet_main()->address_book()
-            ;
-            
             auto it = address_book.find(r.first);
             
             if (it != address_book.end())
@@ -6647,69 +6846,50 @@ boost::property_tree::ptree rpc_connection::transactions_to_ptree(
             
             if (all_accounts || acct == account)
             {
-                boost::property_tree::ptree pt_entry;
+                std::string json;
                 
-                pt_entry.put(
-                    "account", acct,
-                    rpc_json_parser::translator<std::string> ()
-                );
-                pt_entry.put(
-                    "address", address(r.first).to_string(),
-                    rpc_json_parser::translator<std::string> ()
-                );
+                rpc_json_writer writer(json);
+                
+                writer.begin_object();
+                
+                writer.write_string("account", acct);
+                writer.write_string("address", address(r.first).to_string());
                 
                 if (wtx.is_coin_base())
                 {
                     if (wtx.get_depth_in_main_chain() < 1)
                     {
-                        pt_entry.put(
-                            "category", "orphan",
-                            rpc_json_parser::translator<std::string> ()
-                        );
+                        writer.write_string("category", "orphan");
                     }
                     else if (wtx.get_blocks_to_maturity() > 0)
                     {
-                        pt_entry.put(
-                            "category", "immature",
-                            rpc_json_parser::translator<std::string> ()
-                        );
+                        writer.write_string("category", "immature");
                     }
                     else
                     {
-                        pt_entry.put(
-                            "category", "generate",
-                            rpc_json_parser::translator<std::string> ()
-                        );
+                        writer.write_string("category", "generate");
                     }
                 }
                 else
                 {
-                    pt_entry.put(
-                        "category", "receive",
-                        rpc_json_parser::translator<std::string> ()
-                    );
+                    writer.write_string("category", "receive");
                 }
                 
-                pt_entry.put(
+                writer.write_number(
                     "amount", static_cast<double> (r.second) / constants::coin
                 );
             
                 if (include_transactions)
                 {
-                    auto pt = transaction_wallet_to_ptree(wtx);
-                    
-                    for (auto & i : pt)
-                    {
-                        pt_entry.push_back(std::make_pair(i.first, i.second));
-                    }
+                    transaction_wallet_to_json(writer, wtx);
                 }
                 
-                ret.push_back(std::make_pair("", pt_entry));
+                writer.end_object();
+                
+                entries.push_back(std::move(json));
             }
         }
     }
-
-    return ret;
 }
 
 boost::property_tree::ptree rpc_connection::received_to_ptree(
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include <coin/rpc_json_writer.hpp>
+
+using namespace coin;
+
+rpc_json_writer::rpc_json_writer(std::string & buffer)
+    : m_buffer(buffer)
+{
+    m_needs_separator.reserve(8);
+}
+
+void rpc_json_writer::begin_object()
+{
+    write_separator();
+
+    m_buffer.push_back('{');
+
+    m_needs_separator.push_back(false);
+}
+
+void rpc_json_writer::begin_object(const char * key)
+{
+    write_key(key);
+
+    m_buffer.push_back('{');
+
+    m_needs_separator.push_back(false);
+}
+
+void rpc_json_writer::end_object()
+{
+    m_buffer.push_back('}');
+
+    if (m_needs_separator.size() > 0)
+    {
+        m_needs_separator.pop_back();
+    }
+}
+
+void rpc_json_writer::begin_array()
+{
+    write_separator();
+
+    m_buffer.push_back('[');
+
+    m_needs_separator.push_back(false);
+}
+
+void rpc_json_writer::begin_array(const char * key)
+{
+    write_key(key);
+
+    m_buffer.push_back('[');
+
+    m_needs_separator.push_back(false);
+}
+
+void rpc_json_writer::end_array()
+{
+    m_buffer.push_back(']');
+
+    if (m_needs_separator.size() > 0)
+    {
+        m_needs_separator.pop_back();
+    }
+}
+
+void rpc_json_writer::write_string(const std::string & val)
+{
+    write_separator();
+
+    write_escaped(val.data(), val.size());
+}
+
+void rpc_json_writer::write_string(
+    const char * key, const std::string & val
+    )
+{
+    write_key(key);
+
+    write_escaped(val.data(), val.size());
+}
+
+void rpc_json_writer::write_number(const char * key, const std::int64_t & val)
+{
+    write_key(key);
+
+    char buf[24];
+
+    auto len = std::snprintf(buf, sizeof(buf), "%" PRId64, val);
+
+    m_buffer.append(buf, len);
+}
+
+void rpc_json_writer::write_number(
+    const char * key, const std::uint64_t & val
+    )
+{
+    write_key(key);
+
+    char buf[24];
+
+    auto len = std::snprintf(buf, sizeof(buf), "%" PRIu64, val);
+
+    m_buffer.append(buf, len);
+}
+
+void rpc_json_writer::write_number(const char * key, const std::int32_t & val)
+{
+    write_number(key, static_cast<std::int64_t> (val));
+}
+
+void rpc_json_writer::write_number(
+    const char * key, const std::uint32_t & val
+    )
+{
+    write_number(key, static_cast<std::uint64_t> (val));
+}
+
+void rpc_json_writer::write_number(const char * key, const double & val)
+{
+    write_key(key);
+
+    /**
+     * JSON has no representation of NaN or infinity.
+     */
+    if (std::isfinite(val) == false)
+    {
+        m_buffer.append("null", 4);
+
+        return;
+    }
+
+    char buf[32];
+
+    /**
+     * Use the same precision as boost::property_tree so that the encoded
+     * values are identical to those produced by rpc_json_parser.
+     */
+    auto len = std::snprintf(
+        buf, sizeof(buf), "%.*g", std::numeric_limits<double>::digits10 + 1,
+        val
+    );
+
+    m_buffer.append(buf, len);
+}
+
+void rpc_json_writer::write_bool(const char * key, const bool & val)
+{
+    write_key(key);
+
+    if (val)
+    {
+        m_buffer.append("true", 4);
+    }
+    else
+    {
+        m_buffer.append("false", 5);
+    }
+}
+
+void rpc_json_writer::write_raw(const std::string & json)
+{
+    write_separator();
+
+    m_buffer.append(json);
+}
+
+void rpc_json_writer::write_raw(const char * key, const std::string & json)
+{
+    write_key(key);
+
+    m_buffer.append(json);
+}
+
+void rpc_json_writer::write_separator()
+{
+    if (m_needs_separator.size() > 0)
+    {
+        if (m_needs_separator.back())
+        {
+            m_buffer.push_back(',');
+        }
+        else
+        {
+            m_needs_separator.back() = true;
+        }
+    }
+}
+
+void rpc_json_writer::write_key(const char * key)
+{
+    write_separator();
+
+    write_escaped(key, std::strlen(key));
+
+    m_buffer.push_back(':');
+}
+
+void rpc_json_writer::write_escaped(const char * val, const std::size_t & len)
+{
+    static const char hexmap[16] =
+    {
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
+        'A', 'B', 'C', 'D', 'E', 'F'
+    };
+
+    m_buffer.push_back('"');
+
+    auto first = val;
+    auto last = val + len;
+
+    /**
+     * Append runs of characters that need no escaping in one operation.
+     */
+    auto run = first;
+
+    for (auto it = first; it != last; ++it)
+    {
+        auto c = static_cast<std::uint8_t> (*it);
+
+        if (c >= 0x20 && c != '"' && c != '\\' && c != '/')
+        {
+            continue;
+        }
+
+        m_buffer.append(run, it - run);
+
+        run = it + 1;
+
+        switch (c)
+        {
+            case '"':
+                m_buffer.append("\\\"", 2);
+            break;
+            case '\\':
+                m_buffer.append("\\\\", 2);
+            break;
+            case '/':
+                m_buffer.append("\\/", 2);
+            break;
+            case '\b':
+                m_buffer.append("\\b", 2);
+            break;
+            case '\f':
+                m_buffer.append("\\f", 2);
+            break;
+            case '\n':
+                m_buffer.append("\\n", 2);
+            break;
+            case '\r':
+                m_buffer.append("\\r", 2);
+            break;
+            default:
+            {
+                m_buffer.append("\\u00", 4);
+                m_buffer.push_back(hexmap[c >> 4]);
+                m_buffer.push_back(hexmap[c & 15]);
+            }
+            break;
+        }
+    }
+
+    m_buffer.append(run, last - run);
+
+    m_buffer.push_back('"');
+}
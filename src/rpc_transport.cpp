@@ -198,19 +198,28 @@ void rpc_transport::set_on_read(
 }
 
 void rpc_transport::write(const char * buf, const std::size_t & len)
+{
+    write(std::vector<char> (buf, buf + len));
+}
+
+void rpc_transport::write(std::vector<char> && buffer)
 {
     auto self(shared_from_this());
     
-    std::vector<char> buffer(buf, buf + len);
+    /**
+     * Move the buffer into a shared_ptr so the posted handler does not
+     * copy it again.
+     */
+    auto ptr = std::make_shared< std::vector<char> > (std::move(buffer));
     
     if (m_state == state_connected)
     {
         io_service_.post(strand_.wrap(
-            [this, self, buffer]()
+            [this, self, ptr]()
         {
             bool write_in_progress = write_queue_.size() > 0;
             
-            write_queue_.push_back(buffer);
+            write_queue_.push_back(std::move(*ptr));
           
             if (write_in_progress == false)
             {
@@ -223,9 +232,9 @@ void rpc_transport::write(const char * buf, const std::size_t & len)
     else
     {
         io_service_.post(strand_.wrap(
-            [this, self, buffer]()
+            [this, self, ptr]()
         {
-            write_queue_.push_back(buffer);
+            write_queue_.push_back(std::move(*ptr));
         }));
     }
 }
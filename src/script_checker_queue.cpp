@@ -21,6 +21,7 @@
 #include <algorithm>
 
 #include <coin/logger.hpp>
+#include <coin/metrics.hpp>
 #include <coin/script_checker_queue.hpp>
 
 using namespace coin;
@@ -143,6 +144,15 @@ void script_checker_queue::stop()
 
 bool script_checker_queue::sync_wait()
 {
+    /**
+     * Record the latency.
+     */
+    static auto & g_histogram = metrics::instance().get_histogram(
+        "script_checker_queue_sync_wait"
+    );
+    
+    metrics::scoped_timer timer_metrics(g_histogram);
+    
     return loop(true);
 }
 
@@ -73,3 +73,10 @@ void signature_cache::set(
 
     m_valid.insert(signature_data_t(hash, signature, public_key));
 }
+
+void signature_cache::clear()
+{
+    std::lock_guard<std::mutex> l1(mutex_);
+    
+    m_valid.clear();
+}
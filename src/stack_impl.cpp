@@ -22,9 +22,11 @@
 #include <sys/file.h>
 #endif // _MSC_VER
 
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <random>
 
@@ -37,9 +39,12 @@
 #include <coin/address.hpp>
 #include <coin/address_manager.hpp>
 #include <coin/alert_manager.hpp>
+#include <coin/benchmark.hpp>
 #include <coin/block.hpp>
+#include <coin/block_check_queue.hpp>
 #include <coin/block_index.hpp>
 #include <coin/block_merkle.hpp>
+#include <coin/chain_generator.hpp>
 #include <coin/chainblender.hpp>
 #include <coin/chainblender_manager.hpp>
 #include <coin/checkpoint_sync.hpp>
@@ -57,6 +62,7 @@
 #include <coin/nat_pmp_client.hpp>
 #include <coin/protocol.hpp>
 #include <coin/random.hpp>
+#include <coin/relay_cache.hpp>
 #include <coin/rpc_json_parser.hpp>
 #include <coin/rpc_manager.hpp>
 #include <coin/script_checker_queue.hpp>
@@ -83,7 +89,7 @@ std::shared_ptr<db_env> stack_impl::g_db_env;
 block_index * stack_impl::g_block_index_genesis = 0;
 std::set< std::pair<point_out, std::uint32_t> > stack_impl::g_seen_stake;
 block_index * stack_impl::g_block_index_best = 0;
-big_number stack_impl::g_best_chain_trust(0);
+uint256 stack_impl::g_best_chain_trust(0);
 big_number stack_impl::g_best_invalid_trust;
 
 stack_impl::stack_impl(coin::stack & owner)
@@ -92,6 +98,7 @@ stack_impl::stack_impl(coin::stack & owner)
     , timer_status_wallet_(globals::instance().io_service())
     , timer_status_blockchain_(globals::instance().io_service())
     , timer_database_env_(globals::instance().io_service())
+    , timer_transaction_index_compact_(globals::instance().io_service())
     , timer_block_merkles_save_(globals::instance().io_service())
 {
     // ...
@@ -99,6 +106,25 @@ stack_impl::stack_impl(coin::stack & owner)
 
 void stack_impl::start()
 {
+    /**
+     * Check if we are operating on an isolated regression test chain (this
+     * must be set before the data path is first used).
+     */
+    if (
+        m_configuration.args().count("regtest") > 0 &&
+        m_configuration.args()["regtest"] == "1"
+        )
+    {
+        globals::instance().set_regtest(true);
+        
+        /**
+         * Use a port that does not collide with the main network.
+         */
+        m_configuration.set_network_port_tcp(
+            protocol::default_tcp_port_regtest
+        );
+    }
+    
     if (
         m_configuration.args().count("mode") > 0 &&
         m_configuration.args()["mode"] == "spv"
@@ -116,6 +142,25 @@ void stack_impl::start()
          */
         globals::instance().set_client_spv(true);
     }
+    
+    /**
+     * Set the logger output format and whether debug lines are formatted.
+     */
+    if (
+        m_configuration.args().count("log-structured") > 0 &&
+        m_configuration.args()["log-structured"] == "1"
+        )
+    {
+        logger::instance().set_structured(true);
+    }
+    
+    if (
+        m_configuration.args().count("log-debug") > 0 &&
+        m_configuration.args()["log-debug"] == "0"
+        )
+    {
+        logger::instance().set_enabled(logger::severity_debug, false);
+    }
 
     try
     {
@@ -243,6 +288,42 @@ void stack_impl::start()
      */
     threads_.push_back(thread);
 
+    /**
+     * Reset the network boost::asio::io_service.
+     */
+    globals::instance().io_service_network().reset();
+    
+    /**
+     * Allocate the network boost::asio::io_service::work.
+     */
+    work_network_.reset(new boost::asio::io_service::work(
+        globals::instance().io_service_network())
+    );
+    
+    /**
+     * The TCP transport layer (tcp_acceptor, tcp_transport reads and writes,
+     * message framing and checksum verification) runs on a pool of network
+     * threads while the chain state is only mutated on the main IO thread.
+     */
+    auto threads_network = m_configuration.network_tcp_threads();
+    
+    if (threads_network == 0)
+    {
+        threads_network = std::max(
+            static_cast<std::size_t> (1), std::min(static_cast<std::size_t> (
+            std::thread::hardware_concurrency()), static_cast<std::size_t> (4))
+        );
+    }
+    
+    log_info("Stack is adding " << threads_network << " network threads.");
+    
+    for (auto i = 0; i < threads_network; i++)
+    {
+        threads_network_.push_back(std::make_shared<std::thread> (
+            std::bind(&stack_impl::loop_network, this))
+        );
+    }
+
     /**
      * Allocate the db_env.
      */
@@ -300,6 +381,28 @@ void stack_impl::start()
         globals::instance().set_db_private(m_configuration.db_private());
     }
     
+    /**
+     * Set the globals::address_index, (SPV) clients do not store blocks.
+     */
+    globals::instance().set_address_index(
+        globals::instance().is_client_spv() == false &&
+        m_configuration.address_index()
+    );
+    
+    /**
+     * Set the globals::prune_transaction_index.
+     */
+    globals::instance().set_prune_transaction_index(
+        m_configuration.prune_transaction_index()
+    );
+    
+    /**
+     * Set the globals::compact_transaction_index.
+     */
+    globals::instance().set_compact_transaction_index(
+        m_configuration.compact_transaction_index()
+    );
+    
     /**
      * Get the database cache size.
      */
@@ -1592,6 +1695,71 @@ void stack_impl::start()
             }
         }));
     }
+    
+    /**
+     * Check if we need to generate a synthetic (regression test) chain.
+     */
+    if (
+        m_configuration.args().count("generate-blocks") > 0 &&
+        globals::instance().is_regtest() == true
+        )
+    {
+        auto & args = m_configuration.args();
+        
+        auto blocks = std::stoul(args["generate-blocks"]);
+        auto transactions =
+            args.count("generate-transactions") > 0 ?
+            std::stoul(args["generate-transactions"]) : 10
+        ;
+        auto outputs =
+            args.count("generate-outputs") > 0 ?
+            std::stoul(args["generate-outputs"]) : 2
+        ;
+        auto script_type =
+            args.count("generate-script") > 0 ?
+            args["generate-script"] : "p2pkh"
+        ;
+        
+        globals::instance().io_service().post(
+            globals::instance().strand().wrap(
+            [this, blocks, transactions, outputs, script_type]()
+        {
+            /**
+             * Mining blocks takes far too long to be done on the strand, the
+             * chain_generator runs on it's own thread and only processes the
+             * blocks on the strand.
+             */
+            thread_chain_generator_ = std::make_shared<std::thread> (
+                [this, blocks, transactions, outputs, script_type]()
+            {
+                chain_generator generator(
+                    *this, blocks, transactions, outputs, script_type
+                );
+                
+                if (generator.run() == true)
+                {
+                    globals::instance().io_service().post(
+                        globals::instance().strand().wrap([this]()
+                    {
+                        /**
+                         * Export the generated chain to blockchain.dat so it
+                         * can be replayed with import-blockchain=1.
+                         */
+                        if (export_blockchain_file() == true)
+                        {
+                            log_info(
+                                "Stack exported generated blockchain file."
+                            );
+                        }
+                    }));
+                }
+                else
+                {
+                    log_error("Stack failed to generate blockchain.");
+                }
+            });
+        }));
+    }
 
     globals::instance().io_service().post(
         globals::instance().strand().wrap([this]()
@@ -1616,25 +1784,37 @@ void stack_impl::start()
              * transactions.
              */
             globals::instance().wallet_main()->reaccept_wallet_transactions();
-    
+        }
+        
+        /**
+         * A regression test chain does not accept peers.
+         */
+        if (
+            globals::instance().is_client_spv() == false &&
+            globals::instance().is_regtest() == false
+            )
+        {
             /**
              * Allocate the tcp_acceptor.
              */
             m_tcp_acceptor.reset(
-                new tcp_acceptor(globals::instance().io_service(),
-                globals::instance().strand())
+                new tcp_acceptor(globals::instance().io_service_network())
             );
             
             /**
-             * Set the accept handler.
+             * Set the accept handler (called on a network thread).
              */
             m_tcp_acceptor->set_on_accept(
                 [this] (std::shared_ptr<tcp_transport> transport)
                 {
-                    /**
-                     * Inform the tcp_connection_manager.
-                     */
-                    m_tcp_connection_manager->handle_accept(transport);
+                    globals::instance().io_service().post(
+                        globals::instance().strand().wrap([this, transport]()
+                    {
+                        /**
+                         * Inform the tcp_connection_manager.
+                         */
+                        m_tcp_connection_manager->handle_accept(transport);
+                    }));
                 }
             );
             
@@ -1874,9 +2054,13 @@ void stack_impl::start()
         m_status_manager->insert(status);
         
         /**
-         * Start the tcp_connection_manager.
+         * Start the tcp_connection_manager (a regression test chain does
+         * not connect to peers).
          */
-        m_tcp_connection_manager->start();
+        if (globals::instance().is_regtest() == false)
+        {
+            m_tcp_connection_manager->start();
+        }
         
         /**
          * Allocate the database_stack.
@@ -1892,14 +2076,21 @@ void stack_impl::start()
         if (globals::instance().is_client_spv() == false)
         {
             script_checker_queue::instance().start();
+            
+            /**
+             * Start the block_check_queue.
+             */
+            block_check_queue::instance().start();
         }
         
         /**
-         * Start the UDP layer if configured.
+         * Start the UDP layer if configured (a regression test chain does
+         * not join the network).
          */
         if (
             m_configuration.network_udp_enable() == true &&
-            globals::instance().is_client_spv() == false
+            globals::instance().is_client_spv() == false &&
+            globals::instance().is_regtest() == false
             )
         {
             if (m_database_stack)
@@ -2037,6 +2228,35 @@ void stack_impl::start()
         
         if (globals::instance().is_client_spv() == false)
         {
+            /**
+             * Legacy records are only converted when the compact encoding
+             * is enabled, older versions can not read converted records.
+             */
+            if (globals::instance().compact_transaction_index())
+            {
+                /**
+                 * Starts the transaction index compaction timer.
+                 */
+                timer_transaction_index_compact_.expires_from_now(
+                    std::chrono::seconds(30)
+                );
+                timer_transaction_index_compact_.async_wait(
+                    globals::instance().strand().wrap(
+                        [this](boost::system::error_code ec)
+                        {
+                            if (ec)
+                            {
+                                // ...
+                            }
+                            else
+                            {
+                                on_transaction_index_compact();
+                            }
+                        }
+                    )
+                );
+            }
+            
             /**
              * Allocate the mining_manager.
              */
@@ -2057,6 +2277,15 @@ void stack_impl::start()
         globals::instance().io_service().post(
             globals::instance().strand().wrap([this, tcp_port]()
         {
+            /**
+             * A regression test chain does not map ports or bootstrap
+             * peers.
+             */
+            if (globals::instance().is_regtest() == true)
+            {
+                return;
+            }
+            
             if (globals::instance().is_client_spv() == false)
             {
                 /**
@@ -2143,6 +2372,14 @@ void stack_impl::stop()
         m_mining_manager->stop();
     }
     
+    /**
+     * Join the chain_generator thread (it stops with the state).
+     */
+    if (thread_chain_generator_ && thread_chain_generator_->joinable())
+    {
+        thread_chain_generator_->join();
+    }
+    
     /**
      * Stop the tcp_acceptor.
      */
@@ -2228,6 +2465,11 @@ void stack_impl::stop()
      */
     if (globals::instance().is_client_spv() == false)
     {
+        /**
+         * Stop the block_check_queue.
+         */
+        block_check_queue::instance().stop();
+        
         script_checker_queue::instance().stop();
     }
     
@@ -2257,6 +2499,7 @@ void stack_impl::stop()
      * Cancel the database environment timer.
      */
     timer_database_env_.cancel();
+    timer_transaction_index_compact_.cancel();
     
     /**
      * Cancel the block_merkle's save timer.
@@ -2290,6 +2533,36 @@ void stack_impl::stop()
             // ...
         }
     }
+    
+    /**
+     * Stop the network boost::asio::io_service.
+     */
+    globals::instance().io_service_network().stop();
+    
+    /**
+     * Reset the network work.
+     */
+    work_network_.reset();
+    
+    /**
+     * Join the network threads.
+     */
+    for (auto & i : threads_network_)
+    {
+        try
+        {
+            if (i->joinable())
+            {
+                i->join();
+            }
+        }
+        catch (std::exception & e)
+        {
+            // ...
+        }
+    }
+    
+    threads_network_.clear();
 
     /**
      * Detach the block_index objects from each other.
@@ -2387,8 +2660,7 @@ void stack_impl::stop()
     globals::instance().orphan_blocks_by_previous().clear();
     globals::instance().orphan_transactions_by_previous().clear();
     globals::instance().stake_seen_orphan().clear();
-    globals::instance().relay_invs().clear();
-    globals::instance().relay_inv_expirations().clear();
+    relay_cache::instance().clear();
     g_block_index_genesis = 0;
     g_seen_stake.clear();
     g_block_index_best = 0;
@@ -4401,7 +4673,7 @@ block_index * stack_impl::get_block_index_best()
     return g_block_index_best;
 }
 
-big_number & stack_impl::get_best_chain_trust()
+uint256 & stack_impl::get_best_chain_trust()
 {
     return g_best_chain_trust;
 }
@@ -4950,10 +5222,10 @@ void stack_impl::on_status_blockchain()
         log_debug(
             "block_merkles: " << globals::instance().spv_block_merkles().size()
         );
-        log_debug("relay_invs: " << globals::instance().relay_invs().size());
+        log_debug("relay_invs: " << relay_cache::instance().size());
         log_debug(
             "relay_inv_expirations: " <<
-            globals::instance().relay_inv_expirations().size()
+            relay_cache::instance().expirations_size()
         );
     }
     else
@@ -4982,10 +5254,10 @@ void stack_impl::on_status_blockchain()
         log_debug(
             "stake_seen_orphan: " << globals::instance().stake_seen_orphan().size()
         );
-        log_debug("relay_invs: " << globals::instance().relay_invs().size());
+        log_debug("relay_invs: " << relay_cache::instance().size());
         log_debug(
             "relay_inv_expirations: " <<
-            globals::instance().relay_inv_expirations().size()
+            relay_cache::instance().expirations_size()
         );
         
         if (globals::instance().money_supply() > 0)
@@ -5049,8 +5321,19 @@ void stack_impl::on_database_env()
         if (stack_impl::get_db_env())
         {
             /**
-             * Perform any statistics, logging, etc here.
+             * Checkpoints are performed by the db_env maintenance thread,
+             * only log its statistics here.
              */
+            auto stats = stack_impl::get_db_env()->maintenance_stats();
+            
+            log_info(
+                "Database environment checkpoints = " << stats.checkpoints <<
+                ", last = " << stats.checkpoint_duration_last << " ms, " <<
+                "max = " << stats.checkpoint_duration_max << " ms, " <<
+                "log bytes = " << stats.log_bytes << ", cache hits = " <<
+                stats.cache_hits << ", cache misses = " <<
+                stats.cache_misses << "."
+            );
         }
         
         std::chrono::duration<double> elapsed_seconds =
@@ -5084,6 +5367,60 @@ void stack_impl::on_database_env()
     }
 }
 
+void stack_impl::on_transaction_index_compact()
+{
+    if (globals::instance().state() != globals::state_started)
+    {
+        return;
+    }
+    
+    auto finished = false;
+    
+    /**
+     * Convert a small batch at a time so that block processing (which
+     * shares the strand) is not held up.
+     */
+    db_tx tx_db("r+");
+    
+    if (tx_db.compact_transaction_indexes(2500, finished) == false)
+    {
+        log_error("Stack failed to compact transaction indexes.");
+        
+        return;
+    }
+    
+    tx_db.close();
+    
+    if (finished)
+    {
+        log_debug("Stack finished compacting transaction indexes.");
+        
+        return;
+    }
+    
+    /**
+     * Starts the transaction index compaction timer.
+     */
+    timer_transaction_index_compact_.expires_from_now(
+        std::chrono::milliseconds(250)
+    );
+    timer_transaction_index_compact_.async_wait(
+        globals::instance().strand().wrap(
+            [this](boost::system::error_code ec)
+            {
+                if (ec)
+                {
+                    // ...
+                }
+                else
+                {
+                    on_transaction_index_compact();
+                }
+            }
+        )
+    );
+}
+
 const boost::asio::ip::tcp::endpoint & stack_impl::local_endpoint() const
 {
     return m_local_endpoint;
@@ -5261,6 +5598,12 @@ void stack_impl::load_block_index(
              * Close the transaction database.
              */
             tx_db.close();
+            
+            /**
+             * Bound the size of the messages read from the network by the
+             * maximum block size of the loaded chain.
+             */
+            tcp_connection::update_message_length_maximum();
 
             /**
              * Initialize with the genesis block (if necessary).
@@ -5693,6 +6036,68 @@ bool stack_impl::import_blockchain_file(const std::string & path)
 
     std::uint32_t blocks_loaded = 0;
     
+    std::uint64_t transactions_loaded = 0;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    /**
+     * The number of blocks decoded ahead and checked in parallel by the
+     * block_check_queue before being processed in order.
+     */
+    enum { import_batch_size = 64 };
+    
+    std::vector< std::shared_ptr<block> > blocks_pending;
+    
+    auto process_blocks_pending = [&]()
+    {
+        /**
+         * Perform the context-free checks on the worker threads.
+         */
+        block_check_queue::instance().check(blocks_pending);
+        
+        for (auto & i : blocks_pending)
+        {
+            if (globals::instance().state() != globals::state_started)
+            {
+                break;
+            }
+            
+            if (process_block(0, i) == true)
+            {
+                blocks_loaded++;
+                
+                transactions_loaded += i->transactions().size();
+                
+                /**
+                 * Allocate the status.
+                 */
+                std::map<std::string, std::string> status;
+                
+                /**
+                 * Set the status type.
+                 */
+                status["type"] = "database";
+            
+                /**
+                 * Set the status value.
+                 */
+                status["value"] = "Importing blockchain...";
+                
+                /**
+                 * Set the status value.
+                 */
+                status["blockchain.import"] = std::to_string(blocks_loaded);
+
+                /**
+                 * Callback
+                 */
+                m_status_manager->insert(status);
+            }
+        }
+        
+        blocks_pending.clear();
+    };
+    
     if (f.open(path.c_str(), "rb") == true)
     {
         try
@@ -5790,47 +6195,13 @@ bool stack_impl::import_blockchain_file(const std::string & path)
                             
                             if (blk->decode(buffer) == true)
                             {
-                                if (process_block(0, blk) == true)
+                                offset += message::header_magic_length + len;
+                                
+                                blocks_pending.push_back(blk);
+                                
+                                if (blocks_pending.size() >= import_batch_size)
                                 {
-                                    blocks_loaded++;
-                                    
-                                    offset +=
-                                        message::header_magic_length + len
-                                    ;
-                                    
-                                    if (blocks_loaded % 1 == 0)
-                                    {
-                                        /**
-                                         * Allocate the status.
-                                         */
-                                        std::map<std::string, std::string>
-                                            status
-                                        ;
-                                        
-                                        /**
-                                         * Set the status type.
-                                         */
-                                        status["type"] = "database";
-                                    
-                                        /**
-                                         * Set the status value.
-                                         */
-                                        status["value"] =
-                                            "Importing blockchain..."
-                                        ;
-                                        
-                                        /**
-                                         * Set the status value.
-                                         */
-                                        status["blockchain.import"] =
-                                            std::to_string(blocks_loaded)
-                                        ;
-
-                                        /**
-                                         * Callback
-                                         */
-                                        m_status_manager->insert(status);
-                                    }
+                                    process_blocks_pending();
                                 }
                             }
                         }
@@ -5841,6 +6212,11 @@ bool stack_impl::import_blockchain_file(const std::string & path)
                     break;
                 }
             }
+            
+            /**
+             * Process the remaining blocks.
+             */
+            process_blocks_pending();
         }
         catch (std::exception & e)
         {
@@ -5851,7 +6227,29 @@ bool stack_impl::import_blockchain_file(const std::string & path)
         }
     }
     
-    log_info("Stack imported " << blocks_loaded << " from blockchain file.");
+    auto elapsed = std::chrono::duration<double> (
+        std::chrono::steady_clock::now() - start
+    ).count();
+    
+    log_info(
+        "Stack imported " << blocks_loaded << " blocks (" <<
+        transactions_loaded << " transactions) from blockchain file in " <<
+        elapsed << " seconds, " << std::fixed << std::setprecision(2) <<
+        (elapsed > 0.0 ? blocks_loaded / elapsed : 0.0) << " blocks/s, " <<
+        (elapsed > 0.0 ? transactions_loaded / elapsed : 0.0) << " tx/s."
+    );
+    
+    /**
+     * Report the replay throughput in the benchmark format.
+     */
+    log_info(
+        benchmark::to_json(benchmark::result_t{
+        "import_process_block", blocks_loaded, elapsed, 0, 0})
+    );
+    log_info(
+        benchmark::to_json(benchmark::result_t{
+        "import_transactions", transactions_loaded, elapsed, 0, 0})
+    );
     
     return blocks_loaded != 0;
 }
@@ -5923,6 +6321,33 @@ void stack_impl::loop()
     }
 }
 
+void stack_impl::loop_network()
+{
+    while (
+        globals::instance().state() == globals::state_starting ||
+        globals::instance().state() == globals::state_started
+        )
+    {
+        try
+        {
+            globals::instance().io_service_network().run();
+            
+            /**
+             * The work is reset by stop on another thread, so only the
+             * (thread-safe) stopped state of the io_service is checked.
+             */
+            if (globals::instance().io_service_network().stopped())
+            {
+                break;
+            }
+        }
+        catch (const boost::system::system_error & e)
+        {
+            // ...
+        }
+    }
+}
+
 void stack_impl::do_check_peers(const std::uint32_t & interval)
 {
     if (constants::test_net == false)
@@ -29,11 +29,9 @@
 
 using namespace coin;
 
-tcp_acceptor::tcp_acceptor(
-    boost::asio::io_service & ios, boost::asio::strand & s
-    )
+tcp_acceptor::tcp_acceptor(boost::asio::io_service & ios)
     : io_service_(ios)
-    , strand_(s)
+    , strand_(ios)
     , acceptor_ipv4_(io_service_)
     , acceptor_ipv6_(io_service_)
     , transports_timer_(io_service_)
@@ -97,10 +95,15 @@ bool tcp_acceptor::open(const std::uint16_t & port)
      */
     acceptor_ipv4_.listen();
     
+    auto self(shared_from_this());
+    
     /**
-     * Accept
+     * Accept (on the boost::asio::strand).
      */
-    do_ipv4_accept();
+    strand_.post([this, self]()
+    {
+        do_ipv4_accept();
+    });
     
     /**
      * Allocate the ipv6 endpoint.
@@ -157,14 +160,17 @@ bool tcp_acceptor::open(const std::uint16_t & port)
     acceptor_ipv6_.listen();
     
     /**
-     * Accept
-     */
-    do_ipv6_accept();
-    
-    /**
-     * Start the tick timer.
+     * Accept (on the boost::asio::strand).
      */
-    do_tick(1);
+    strand_.post([this, self]()
+    {
+        do_ipv6_accept();
+        
+        /**
+         * Start the tick timer.
+         */
+        do_tick(1);
+    });
 
     return true;
 }
@@ -201,7 +207,7 @@ void tcp_acceptor::do_ipv4_accept()
 {
     auto self(shared_from_this());
 
-    auto t = std::make_shared<tcp_transport> (io_service_, strand_, true);
+    auto t = std::make_shared<tcp_transport> (io_service_, true);
     
     m_tcp_transports.push_back(t);
     
@@ -261,7 +267,7 @@ void tcp_acceptor::do_ipv6_accept()
 {
     auto self(shared_from_this());
 
-    auto t = std::make_shared<tcp_transport> (io_service_, strand_, true);
+    auto t = std::make_shared<tcp_transport> (io_service_, true);
     
     m_tcp_transports.push_back(t);
     
@@ -338,11 +344,9 @@ void tcp_acceptor::do_tick(const std::uint32_t & seconds)
     }));
 }
 
-int tcp_acceptor::run_test(
-    boost::asio::io_service & ios, boost::asio::strand & s
-    )
+int tcp_acceptor::run_test(boost::asio::io_service & ios)
 {
-    auto acceptor = std::make_shared<tcp_acceptor> (ios, s);
+    auto acceptor = std::make_shared<tcp_acceptor> (ios);
     
     acceptor->set_on_accept(
         [] (std::shared_ptr<tcp_transport> transport)
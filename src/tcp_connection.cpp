@@ -19,11 +19,20 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
 
 #include <coin/address_manager.hpp>
 #include <coin/alert.hpp>
 #include <coin/alert_manager.hpp>
+#include <coin/block_check_queue.hpp>
+#include <coin/block_compact.hpp>
 #include <coin/block_merkle.hpp>
 #include <coin/block_locator.hpp>
 #include <coin/chainblender.hpp>
@@ -35,6 +44,7 @@
 #include <coin/checkpoint_sync.hpp>
 #include <coin/db_tx.hpp>
 #include <coin/globals.hpp>
+#include <coin/hash.hpp>
 #include <coin/incentive.hpp>
 #include <coin/incentive_answer.hpp>
 #include <coin/incentive_collaterals.hpp>
@@ -44,8 +54,10 @@
 #include <coin/incentive_vote.hpp>
 #include <coin/logger.hpp>
 #include <coin/message.hpp>
+#include <coin/metrics.hpp>
 #include <coin/network.hpp>
 #include <coin/random.hpp>
+#include <coin/relay_cache.hpp>
 #include <coin/tcp_acceptor.hpp>
 #include <coin/tcp_connection.hpp>
 #include <coin/tcp_connection_manager.hpp>
@@ -63,6 +75,46 @@
 
 using namespace coin;
 
+/**
+ * The message checksums of the blocks recently served from disk.
+ */
+static std::map<sha256, std::uint32_t> g_block_checksums;
+
+/**
+ * The hashes of g_block_checksums in insertion order (oldest first).
+ */
+static std::deque<sha256> g_block_checksums_order;
+
+/**
+ * The g_block_checksums (and g_block_checksums_order) std::mutex.
+ */
+static std::mutex g_mutex_block_checksums;
+
+/**
+ * The number of reads that have completed.
+ */
+static std::atomic<std::uint64_t> g_read_statistics_reads(0);
+
+/**
+ * The number of messages that have been read.
+ */
+static std::atomic<std::uint64_t> g_read_statistics_messages(0);
+
+/**
+ * The maximum message length used while block::get_maximum_size_median220
+ * is unbounded (during initial download and for SPV clients).
+ */
+enum { message_length_maximum_unbounded = 32 * 1024 * 1024 };
+
+/**
+ * The maximum message length (twice block::get_maximum_size_median220), it
+ * is read by the network threads and updated on the main IO thread when the
+ * best block changes.
+ */
+static std::atomic<std::size_t> g_message_length_maximum(
+    message_length_maximum_unbounded
+);
+
 tcp_connection::tcp_connection(
     boost::asio::io_service & ios, stack_impl & owner,
     const direction_t & direction, std::shared_ptr<tcp_transport> transport
@@ -99,8 +151,12 @@ tcp_connection::tcp_connection(
     , did_send_cbstatus_cbready_code_(false)
     , timer_spv_getheader_timeout_(io_service_)
     , timer_spv_getblocks_timeout_(io_service_)
+    , inventory_vectors_seen_(inventory_vectors_seen_elements, 0.000001)
     , timer_isync_(io_service_)
     , did_send_isync_(false)
+    , timer_getdata_deferred_(io_service_)
+    , reads_message_(0)
+    , timer_inventory_announcements_(io_service_)
 {
     // ...
 }
@@ -190,6 +246,30 @@ void tcp_connection::stop_after(const std::uint32_t & interval)
     }));
 }
 
+tcp_connection::read_statistics_t tcp_connection::read_statistics()
+{
+    read_statistics_t ret;
+    
+    ret.reads = g_read_statistics_reads;
+    ret.messages = g_read_statistics_messages;
+    
+    return ret;
+}
+
+void tcp_connection::update_message_length_maximum()
+{
+    auto maximum_size = block::get_maximum_size_median220();
+    
+    if (maximum_size == std::numeric_limits<std::size_t>::max())
+    {
+        g_message_length_maximum = message_length_maximum_unbounded;
+    }
+    else
+    {
+        g_message_length_maximum = maximum_size * 2;
+    }
+}
+
 void tcp_connection::send(const char * buf, const std::size_t & len)
 {
     if (auto transport = m_tcp_transport.lock())
@@ -202,6 +282,20 @@ void tcp_connection::send(const char * buf, const std::size_t & len)
     }
 }
 
+void tcp_connection::send(
+    const std::shared_ptr<const std::vector<char> > & buffer
+    )
+{
+    if (auto transport = m_tcp_transport.lock())
+    {
+        transport->write(buffer);
+    }
+    else
+    {
+        stop();
+    }
+}
+
 void tcp_connection::send_addr_message(const bool & local_address_only)
 {
     log_debug("TCP connection is sending addr message.");
@@ -228,7 +322,7 @@ void tcp_connection::send_addr_message(const bool & local_address_only)
             }
         }
         
-        if (globals::instance().is_client_spv() == false)
+        if (stack_impl_.get_tcp_acceptor())
         {
             /**
              * Get our network port.
@@ -467,6 +561,14 @@ void tcp_connection::send_inv_message(
 void tcp_connection::send_relayed_inv_message(
     const inventory_vector inv, const data_buffer buffer
     )
+{
+    send_relayed_inv_message(inv, relay_cache::instance().insert(inv, buffer));
+}
+
+void tcp_connection::send_relayed_inv_message(
+    const inventory_vector & inv,
+    const std::shared_ptr<const std::vector<char> > & buffer
+    )
 {
     auto self(shared_from_this());
     
@@ -563,6 +665,37 @@ void tcp_connection::send_block_message(const block blk)
     }));
 }
 
+void tcp_connection::send_cmpctblock_message(
+    const sha256 & hash_block,
+    const std::shared_ptr<const std::vector<char> > & buffer
+    )
+{
+    auto self(shared_from_this());
+    
+    /**
+     * Post the operation onto the boost::asio::io_service.
+     */
+    io_service_.post(strand_.wrap([this, self, hash_block, buffer]()
+    {
+        inventory_vector inv(inventory_vector::type_msg_block, hash_block);
+        
+        /**
+         * Prevent sending blocks the remote node already knows of.
+         */
+        if (insert_inventory_vector_seen(inv) == false)
+        {
+            return;
+        }
+        
+        log_debug(
+            "TCP connection is sending cmpctblock " <<
+            hash_block.to_string().substr(0, 20) << "."
+        );
+        
+        send(buffer);
+    }));
+}
+
 void tcp_connection::send_filterload_message(
     const transaction_bloom_filter & filter
     )
@@ -881,103 +1014,175 @@ void tcp_connection::on_read(const char * buf, const std::size_t & len)
 {
     if (globals::instance().state() == globals::state_started)
     {
-        auto buffer = std::string(buf, len);
+        static const std::string http = "HTTP/1.";
         
         /**
-         * Check if it is an HTTP message.
+         * Check if it is an HTTP message (only at the start of a message).
          */
-        if (buffer.find("HTTP/1.") == std::string::npos)
+        if (
+            read_queue_.size() > 0 ||
+            std::search(buf, buf + len, http.begin(), http.end()) == buf + len
+            )
         {
             /**
              * Append to the read queue.
              */
             read_queue_.insert(read_queue_.end(), buf, buf + len);
 
+            ++reads_message_;
+            
+            g_read_statistics_reads++;
+            
+            /**
+             * The number of bytes remaining of a partially received message.
+             */
+            std::size_t remaining = 0;
+            
             while (
                 globals::instance().state() == globals::state_started &&
                 read_queue_.size() >= message::header_length
                 )
             {
+                std::uint32_t length = 0;
+                
                 /**
-                 * Allocate a packet from the entire read queue.
+                 * Decode the payload length from the header only so that the
+                 * read queue is not decoded until the message is complete.
                  */
-                std::string packet(read_queue_.begin(), read_queue_.end());
+                if (
+                    message::decode_header_length(&read_queue_[0],
+                    length) == false
+                    )
+                {
+                    log_error(
+                        "TCP connection got invalid header magic, calling "
+                        "stop."
+                    );
+                    
+                    /**
+                     * Clear the read queue.
+                     */
+                    read_queue_.clear();
+                    
+                    /**
+                     * Call stop
+                     */
+                    stop();
+                    
+                    return;
+                }
+                
+                auto length_message =
+                    static_cast<std::size_t> (message::header_length) + length
+                ;
                 
                 /**
-                 * Allocate the message.
-                 * @note Packets can be combined, after decoding the message
-                 * it's buffer will be resized to the actual length.
+                 * If the message is larger than twice the size of
+                 * block::get_maximum_size_median220 then the stream must be
+                 * corrupted, clear the read queue and stop the connection.
                  */
-                message msg(packet.data(), packet.size());
-            
-                try
+                if (length_message > g_message_length_maximum)
                 {
+                    log_error(
+                        "TCP connection message too large (" <<
+                        length_message << "), calling stop."
+                    );
+                    
                     /**
-                     * Decode the message.
+                     * Clear the read queue.
                      */
-                    msg.decode();
+                    read_queue_.clear();
+                    
+                    /**
+                     * Call stop
+                     */
+                    stop();
+                    
+                    return;
                 }
-                catch (std::exception & e)
+                
+                if (read_queue_.size() < length_message)
                 {
-                    log_none(
-                        "TCP connection failed to decode message, "
-                        "what = " << e.what() << "."
-                    );
-
+                    remaining = length_message - read_queue_.size();
+                    
                     break;
                 }
                 
                 /**
-                 * Erase the full/partial packet.
+                 * Allocate the message from exactly its bytes.
+                 */
+                auto msg = std::make_shared<message> (
+                    &read_queue_[0], length_message
+                );
+                
+                /**
+                 * Erase the packet.
                  */
                 read_queue_.erase(
-                    read_queue_.begin(), read_queue_.begin() +
-                    message::header_length + msg.header().length
+                    read_queue_.begin(), read_queue_.begin() + length_message
                 );
                 
+                if (length_message >= 64 * 1024)
+                {
+                    log_none(
+                        "TCP connection read message of " << length_message <<
+                        " bytes in " << reads_message_ << " reads."
+                    );
+                }
+                
+                g_read_statistics_messages++;
+                
+                reads_message_ = 0;
+                
                 try
                 {
                     /**
-                     * Handle the message.
+                     * Decode the message (verifying its checksum).
                      */
-                    handle_message(msg);
+                    msg->decode();
                 }
                 catch (std::exception & e)
                 {
                     log_debug(
-                        "TCP connection failed to handle message, "
+                        "TCP connection failed to decode message, "
                         "what = " << e.what() << "."
                     );
-                    
-                    /**
-                     * If we failed to parse a message with a read queue
-                     * twice the size of block::get_maximum_size_median220
-                     * then the stream must be corrupted, clear the read queue
-                     * and stop the connection.
-                     */
-                    if (
-                        read_queue_.size() >
-                        block::get_maximum_size_median220() * 2
-                        )
+
+                    continue;
+                }
+                
+                auto self(shared_from_this());
+                
+                /**
+                 * Handle the message on the main IO thread, the strand keeps
+                 * the messages of the connection in order.
+                 */
+                io_service_.post(strand_.wrap([this, self, msg]()
+                {
+                    try
                     {
-                        log_error(
-                            "TCP connection read queue too large (" <<
-                            read_queue_.size() << "), calling stop."
-                        );
-                        
-                        /**
-                         * Clear the read queue.
-                         */
-                        read_queue_.clear();
-                        
                         /**
-                         * Call stop
+                         * Handle the message.
                          */
-                        do_stop();
-                        
-                        return;
+                        handle_message(*msg);
                     }
-                }
+                    catch (std::exception & e)
+                    {
+                        log_debug(
+                            "TCP connection failed to handle message, "
+                            "what = " << e.what() << "."
+                        );
+                    }
+                }));
+            }
+            
+            /**
+             * Let the transport size its next read toward the remainder
+             * of the message.
+             */
+            if (auto t = m_tcp_transport.lock())
+            {
+                t->set_read_hint(remaining);
             }
         }
         else
@@ -1038,7 +1243,7 @@ void tcp_connection::on_read(const char * buf, const std::size_t & len)
                     user_agent + "\"""," +
                     "\"height\":\"" +
                     std::to_string(
-                    stack_impl::get_block_index_best()->height()) + "\"""}"
+                    globals::instance().best_block_height()) + "\"""}"
                 ;
                 
                 /**
@@ -1154,8 +1359,8 @@ void tcp_connection::do_start(const boost::asio::ip::tcp::endpoint ep)
              * Start the transport connecting to the endpoint.
              */
             transport->start(
-                ep.address().to_string(), ep.port(), [this, self, ep](
-                boost::system::error_code ec,
+                ep.address().to_string(), ep.port(), strand_.wrap(
+                [this, self, ep](boost::system::error_code ec,
                 std::shared_ptr<tcp_transport> transport)
                 {
                     if (ec)
@@ -1210,7 +1415,7 @@ void tcp_connection::do_start(const boost::asio::ip::tcp::endpoint ep)
                          */
                         send_version_message();
                     }
-                }
+                })
             );
             
             /**
@@ -1315,11 +1520,19 @@ void tcp_connection::do_stop()
     }
     
     /**
-     * Stop the transport.
+     * Stop the transport, the read queue is owned by the network threads
+     * (on_read runs on the transport's strand) so it is cleared there.
      */
     if (auto t = m_tcp_transport.lock())
     {
-        t->stop();
+        auto self(shared_from_this());
+        
+        t->stop([this, self]()
+        {
+            read_queue_.clear();
+            
+            reads_message_ = 0;
+        });
     }
     
     /**
@@ -1330,7 +1543,6 @@ void tcp_connection::do_stop()
         m_on_cbbroadcast = nullptr, m_chainblender_join = nullptr;
     ;
     
-    read_queue_.clear();
     timer_ping_.cancel();
     timer_version_timeout_.cancel();
     timer_ping_timeout_.cancel();
@@ -1342,6 +1554,14 @@ void tcp_connection::do_stop()
     timer_spv_getheader_timeout_.cancel();
     timer_spv_getblocks_timeout_.cancel();
     timer_isync_.cancel();
+    timer_getdata_deferred_.cancel();
+    timer_inventory_announcements_.cancel();
+    
+    getdata_deferred_.clear();
+    
+    inventory_announcements_.clear();
+    
+    blocks_compact_pending_.clear();
     
     m_state = state_stopped;
 }
@@ -1386,7 +1606,7 @@ void tcp_connection::send_version_message()
          * Get our network port.
          */
         auto port =
-            globals::instance().is_client_spv() == true ? 0 :
+            stack_impl_.get_tcp_acceptor() == nullptr ? 0 :
             stack_impl_.get_tcp_acceptor()->local_endpoint().port()
         ;
         
@@ -2377,6 +2597,14 @@ const std::uint64_t & tcp_connection::protocol_version_services() const
     return m_protocol_version_services;
 }
 
+bool tcp_connection::is_compact_blocks_supported() const
+{
+    return
+        (m_protocol_version_services &
+        protocol::service_compact_blocks) != 0
+    ;
+}
+
 const std::uint64_t & tcp_connection::protocol_version_timestamp() const
 {
     return m_protocol_version_timestamp;
@@ -2524,46 +2752,16 @@ void tcp_connection::relay_inv(
     const inventory_vector & inv, const data_buffer & buffer
     )
 {
-    std::lock_guard<std::recursive_mutex> l1(stack_impl::mutex());
-    
-    /**
-     * Expire old relay messages.
-     */
-    while (
-        globals::instance().relay_inv_expirations().size() > 0 &&
-        globals::instance().relay_inv_expirations().front().first < std::time(0)
-        )
-    {
-        globals::instance().relay_invs().erase(
-            globals::instance().relay_inv_expirations().front().second
-        );
-        
-        globals::instance().relay_inv_expirations().pop_front();
-    }
-
-    /**
-     * Save original serialized message so newer versions are preserved.
-     */
-    globals::instance().relay_invs().insert(std::make_pair(inv, buffer));
-    
-    globals::instance().relay_inv_expirations().push_back(
-        std::make_pair(std::time(0) + 15 * 60, inv)
-    );
-    
     log_debug(
         "TCP connection is relaying inv message, command = " <<
         inv.command() << "."
     );
     
     /**
-     * Allocate the message.
-     */
-    message msg(inv.command(), buffer);
-
-    /**
-     * Encode the message.
+     * Save original serialized message so newer versions are preserved, the
+     * message is encoded once and shared by all connected peers.
      */
-    msg.encode();
+    auto buffer_relay = relay_cache::instance().insert(inv, buffer);
 
     /**
      * Check if this is related to a transaction.
@@ -2572,24 +2770,13 @@ void tcp_connection::relay_inv(
         inv.command() == "tx" || inv.command() == "ztlock"
     ;
     
-    if (m_protocol_version_relay == false && is_tx_related)
-    {
-        /**
-         * Broadcast the message via bip0037 rules.
-         */
-         stack_impl_.get_tcp_connection_manager()->broadcast_bip0037(
-            msg.data(), msg.size()
-         );
-    }
-    else
-    {
-        /**
-         * Broadcast the message to "all" connected peers.
-         */
-        stack_impl_.get_tcp_connection_manager()->broadcast(
-            msg.data(), msg.size()
-        );
-    }
+    /**
+     * Relay the message to "all" connected peers (via bip0037 rules if
+     * required).
+     */
+    stack_impl_.get_tcp_connection_manager()->relay_inv(
+        inv, buffer_relay, m_protocol_version_relay == false && is_tx_related
+    );
 }
 
 bool tcp_connection::handle_message(message & msg)
@@ -2603,7 +2790,45 @@ bool tcp_connection::handle_message(message & msg)
         return false;
     }
     
+    /**
+     * The latency histograms of the commands recorded by name (resolved
+     * once), others are recorded as unknown.
+     */
+    static const std::map<std::string, metrics::histogram *> g_histograms =
+        []()
+    {
+        std::map<std::string, metrics::histogram *> ret;
+        
+        for (
+            auto & i : {
+            "addr", "alert", "block", "blocktxn", "cbbroadcast", "cbjoin",
+            "cbleave", "cbstatus", "checkpoint", "cmpctblock", "filteradd",
+            "filterclear", "filterload", "getaddr", "getblocks", "getblocktxn",
+            "getdata", "getheaders", "headers", "ianswer", "icols", "inv",
+            "iquestion", "isync", "ivote", "mempool", "merkleblock", "ping",
+            "pong", "tx", "verack", "version", "ztanswer", "ztlock",
+            "ztquestion", "ztvote", "unknown" }
+            )
+        {
+            ret[i] = &metrics::instance().get_histogram(
+                std::string("tcp_connection_handle_message_") + i
+            );
+        }
+        
+        return ret;
+    }();
+    
     std::lock_guard<std::recursive_mutex> l1(stack_impl::mutex());
+    
+    /**
+     * Record the latency (excluding the wait for the lock).
+     */
+    auto it = g_histograms.find(msg.header().command);
+    
+    metrics::scoped_timer timer_metrics(
+        it != g_histograms.end() ? *it->second :
+        *g_histograms.at("unknown")
+    );
 
     if (msg.header().command == "verack")
     {
@@ -3606,8 +3831,40 @@ bool tcp_connection::handle_message(message & msg)
                 
                 auto inventory = msg.protocol_getdata().inventory;
                 
+                /**
+                 * Preserve the order of requests while earlier ones are
+                 * deferred.
+                 */
+                if (getdata_deferred_.size() > 0)
+                {
+                    defer_getdata(inventory);
+                    
+                    inventory.clear();
+                }
+                
+                auto index = 0;
+                
                 for (auto & i : inventory)
                 {
+                    /**
+                     * Stop serving once the write queue is full and resume
+                     * when it has drained.
+                     */
+                    if (auto t = m_tcp_transport.lock())
+                    {
+                        if (t->is_write_queue_full())
+                        {
+                            defer_getdata(
+                                std::vector<inventory_vector> (
+                                inventory.begin() + index, inventory.end())
+                            );
+                            
+                            break;
+                        }
+                    }
+                    
+                    ++index;
+                    
                     if (msg.protocol_getdata().count == 1)
                     {
                         log_debug(
@@ -3636,20 +3893,35 @@ bool tcp_connection::handle_message(message & msg)
                              */
                             block blk;
                             
-                            /**
-                             * Read the block from disk.
-                             */
-                            blk.read_from_disk(it->second);
-                            
                             if (i.type() == inventory_vector::type_msg_block)
                             {
                                 /**
-                                 * Send the block message.
+                                 * Serve the block straight from its stored
+                                 * encoding falling back to decoding it.
                                  */
-                                do_send_block_message(blk);
+                                if (
+                                    do_send_block_message_raw(it->second) ==
+                                    false
+                                    )
+                                {
+                                    /**
+                                     * Read the block from disk.
+                                     */
+                                    blk.read_from_disk(it->second);
+                                    
+                                    /**
+                                     * Send the block message.
+                                     */
+                                    do_send_block_message(blk);
+                                }
                             }
                             else
                             {
+                                /**
+                                 * Read the block from disk.
+                                 */
+                                blk.read_from_disk(it->second);
+                                
                                 /**
                                  * Check if we have a BIP-0037 bloom filter.
                                  */
@@ -3732,17 +4004,14 @@ bool tcp_connection::handle_message(message & msg)
                          */
                         bool did_send = false;
                         
-                        auto it = globals::instance().relay_invs().find(i);
+                        auto buffer_relay = relay_cache::instance().find(i);
                         
-                        if (it != globals::instance().relay_invs().end())
+                        if (buffer_relay)
                         {
                             /**
-                             * Send the relayed inv message.
+                             * Send the relayed message.
                              */
-                            do_send_relayed_inv_message(
-                                i, data_buffer(it->second.data(),
-                                it->second.size())
-                            );
+                            send(buffer_relay);
                             
                             did_send = true;
                         }
@@ -4572,9 +4841,11 @@ bool tcp_connection::handle_message(message & msg)
                 auto self(shared_from_this());
                 
                 /**
-                 * Post the operation onto the boost::asio::io_service.
+                 * Check the block on the block_check_queue, the process
+                 * operation is then posted onto the strand in the order the
+                 * blocks were received.
                  */
-                globals::instance().strand().dispatch(
+                block_check_queue::instance().insert(ptr_block,
                     [this, self, ptr_block]()
                 {
                     /**
@@ -4613,11 +4884,214 @@ bool tcp_connection::handle_message(message & msg)
             }
         }
     }
-    else if (msg.header().command == "merkleblock")
+    else if (msg.header().command == "cmpctblock")
     {
-        assert(msg.protocol_merkleblock().merkleblock);
-        
-        if (msg.protocol_merkleblock().merkleblock)
+        if (
+            msg.protocol_cmpctblock().cmpctblock &&
+            globals::instance().is_client_spv() == false
+            )
+        {
+            auto cmpctblock = msg.protocol_cmpctblock().cmpctblock;
+            
+            log_debug(
+                "Connection received cmpctblock " <<
+                cmpctblock->get_hash().to_string().substr(0, 20) << "."
+            );
+            
+            /**
+             * Set the time we received a block.
+             */
+            time_last_block_received_ = std::time(0);
+            
+            /**
+             * Allocate an inventory_vector.
+             */
+            inventory_vector inv(
+                inventory_vector::type_msg_block, cmpctblock->get_hash()
+            );
+            
+            insert_inventory_vector_seen(inv);
+            
+            if (
+                globals::instance().block_indexes().count(
+                cmpctblock->get_hash()) > 0 ||
+                globals::instance().orphan_blocks().count(
+                cmpctblock->get_hash()) > 0
+                )
+            {
+                // ...
+            }
+            else if (cmpctblock->reconstruct() == false)
+            {
+                /**
+                 * Request the full block.
+                 */
+                send_getdata_message(std::vector<inventory_vector> (1, inv));
+            }
+            else if (cmpctblock->indexes_missing().size() == 0)
+            {
+                do_process_block_compact(cmpctblock);
+            }
+            else
+            {
+                log_debug(
+                    "Connection is requesting " <<
+                    cmpctblock->indexes_missing().size() << " of " <<
+                    cmpctblock->transaction_count() <<
+                    " cmpctblock transactions."
+                );
+                
+                /**
+                 * If too many block_compact's are waiting drop one and
+                 * request its full block instead.
+                 */
+                if (
+                    blocks_compact_pending_.count(cmpctblock->get_hash()) == 0
+                    && blocks_compact_pending_.size() >=
+                    blocks_compact_pending_maximum
+                    )
+                {
+                    auto it = blocks_compact_pending_.begin();
+                    
+                    send_getdata_message(
+                        std::vector<inventory_vector> (1, inventory_vector(
+                        inventory_vector::type_msg_block, it->first))
+                    );
+                    
+                    blocks_compact_pending_.erase(it);
+                }
+                
+                /**
+                 * Hold onto the block_compact until the blocktxn arrives.
+                 */
+                blocks_compact_pending_[cmpctblock->get_hash()] = cmpctblock;
+                
+                if (auto t = m_tcp_transport.lock())
+                {
+                    /**
+                     * Allocate the message.
+                     */
+                    message msg_getblocktxn("getblocktxn");
+                    
+                    msg_getblocktxn.protocol_getblocktxn().hash_block =
+                        cmpctblock->get_hash()
+                    ;
+                    msg_getblocktxn.protocol_getblocktxn().indexes =
+                        cmpctblock->indexes_missing()
+                    ;
+                    
+                    /**
+                     * Encode the message.
+                     */
+                    msg_getblocktxn.encode();
+                    
+                    /**
+                     * Write the message.
+                     */
+                    t->write(msg_getblocktxn.data(), msg_getblocktxn.size());
+                }
+            }
+        }
+    }
+    else if (msg.header().command == "getblocktxn")
+    {
+        auto it = globals::instance().block_indexes().find(
+            msg.protocol_getblocktxn().hash_block
+        );
+        
+        if (it != globals::instance().block_indexes().end())
+        {
+            block blk;
+            
+            if (blk.read_from_disk(it->second))
+            {
+                /**
+                 * Allocate the message.
+                 */
+                message msg_blocktxn("blocktxn");
+                
+                msg_blocktxn.protocol_blocktxn().hash_block =
+                    msg.protocol_getblocktxn().hash_block
+                ;
+                
+                for (auto & i : msg.protocol_getblocktxn().indexes)
+                {
+                    if (i >= blk.transactions().size())
+                    {
+                        log_debug(
+                            "Connection received getblocktxn with invalid "
+                            "index " << i << "."
+                        );
+                        
+                        /**
+                         * Set the Denial-of-Service score for the connection.
+                         */
+                        set_dos_score(m_dos_score + 10);
+                        
+                        return false;
+                    }
+                    
+                    msg_blocktxn.protocol_blocktxn().transactions.push_back(
+                        std::make_shared<transaction> (blk.transactions()[i])
+                    );
+                }
+                
+                if (auto t = m_tcp_transport.lock())
+                {
+                    /**
+                     * Encode the message.
+                     */
+                    msg_blocktxn.encode();
+                    
+                    /**
+                     * Write the message.
+                     */
+                    t->write(msg_blocktxn.data(), msg_blocktxn.size());
+                }
+            }
+        }
+    }
+    else if (msg.header().command == "blocktxn")
+    {
+        auto it = blocks_compact_pending_.find(
+            msg.protocol_blocktxn().hash_block
+        );
+        
+        if (it != blocks_compact_pending_.end())
+        {
+            auto cmpctblock = it->second;
+            
+            blocks_compact_pending_.erase(it);
+            
+            if (
+                cmpctblock->fill_missing(
+                msg.protocol_blocktxn().transactions) == false
+                )
+            {
+                log_debug(
+                    "Connection received blocktxn that does not match "
+                    "cmpctblock."
+                );
+                
+                /**
+                 * Request the full block.
+                 */
+                send_getdata_message(
+                    std::vector<inventory_vector> (1, inventory_vector(
+                    inventory_vector::type_msg_block, cmpctblock->get_hash()))
+                );
+            }
+            else
+            {
+                do_process_block_compact(cmpctblock);
+            }
+        }
+    }
+    else if (msg.header().command == "merkleblock")
+    {
+        assert(msg.protocol_merkleblock().merkleblock);
+        
+        if (msg.protocol_merkleblock().merkleblock)
         {
             log_none(
                 "Connection received merkleblock " <<
@@ -6083,7 +6557,7 @@ void tcp_connection::do_send_inv_message(
         /**
          * Prevent sending duplicate INV's.
          */
-        if (inventory_vectors_seen_set_.count(inv) > 0)
+        if (is_inventory_vector_seen(inv))
         {
             log_info(
                 "Already sent INV " << hash_block.to_string().substr(0, 16)
@@ -6141,7 +6615,7 @@ void tcp_connection::do_send_inv_message(
         {
             inventory_vector inv(type, i);
 
-            if (inventory_vectors_seen_set_.count(inv) > 0)
+            if (is_inventory_vector_seen(inv))
             {
                 log_info(
                     "Already sent INV " << i.to_string().substr(0, 16) <<
@@ -6183,56 +6657,78 @@ void tcp_connection::do_send_inv_message(
 }
 
 void tcp_connection::do_send_relayed_inv_message(
-    const inventory_vector & inv, const data_buffer & buffer
+    const inventory_vector & inv,
+    const std::shared_ptr<const std::vector<char> > & buffer
     )
 {
-    std::lock_guard<std::recursive_mutex> l1(stack_impl::mutex());
-    
-    /**
-     * Expire old relay messages.
-     */
-    while (
-        globals::instance().relay_inv_expirations().size() > 0 &&
-        globals::instance().relay_inv_expirations().front().first < std::time(0)
-        )
-    {
-        globals::instance().relay_invs().erase(
-            globals::instance().relay_inv_expirations().front().second
-        );
-        
-        globals::instance().relay_inv_expirations().pop_front();
-    }
-
-    /**
-     * Save original serialized message so newer versions are preserved.
-     */
-    globals::instance().relay_invs().insert(std::make_pair(inv, buffer));
-    
-    globals::instance().relay_inv_expirations().push_back(
-        std::make_pair(std::time(0) + 15 * 60, inv)
-    );
-    
     if (auto t = m_tcp_transport.lock())
     {
         /**
-         * Allocate the message.
-         */
-        message msg(inv.command(), buffer);
-
-        /**
-         * Encode the message.
-         */
-        msg.encode();
-
-        log_debug(
-            "TCP connection is sending (relayed) inv message, command = " <<
-            inv.command() << ", buffer size = " << buffer.size() << "."
-        );
-    
-        /**
-         * Write the message.
+         * Transactions (and their zerotime locks) are announced to the
+         * remote node in batched inv messages and served from the
+         * relay_cache when it asks for them. The remote node only sends
+         * getdata to peers and (bip0037) filtered connections expect the
+         * transaction itself, ztvote's and ivote's are latency sensitive so
+         * all of these are still sent immediately.
          */
-        t->write(msg.data(), msg.size());
+        auto should_announce =
+            (inv.type() == inventory_vector::type_msg_tx ||
+            inv.type() == inventory_vector::type_msg_ztlock) &&
+            globals::instance().operation_mode() ==
+            protocol::operation_mode_peer && !transaction_bloom_filter_
+        ;
+        
+        if (should_announce)
+        {
+            /**
+             * Do not announce inventory the remote node has already seen.
+             */
+            if (is_inventory_vector_seen(inv))
+            {
+                return;
+            }
+            
+            if (inventory_announcements_.size() >= protocol::max_inv_size)
+            {
+                log_debug(
+                    "TCP connection inv announcements are full, dropping " <<
+                    inv.to_string() << "."
+                );
+                
+                return;
+            }
+            
+            auto should_start_timer = inventory_announcements_.size() == 0;
+            
+            inventory_announcements_.push_back(inv);
+            
+            if (should_start_timer)
+            {
+                auto self(shared_from_this());
+                
+                timer_inventory_announcements_.expires_from_now(
+                    std::chrono::milliseconds(random::uint32_random_range(
+                    interval_inventory_announcements_min,
+                    interval_inventory_announcements_max))
+                );
+                timer_inventory_announcements_.async_wait(strand_.wrap(
+                    std::bind(&tcp_connection::do_send_inventory_announcements,
+                    self, std::placeholders::_1))
+                );
+            }
+        }
+        else
+        {
+            log_debug(
+                "TCP connection is sending (relayed) inv message, command = " <<
+                inv.command() << ", buffer size = " << buffer->size() << "."
+            );
+        
+            /**
+             * Write the message.
+             */
+            t->write(buffer);
+        }
     }
     else
     {
@@ -6240,6 +6736,69 @@ void tcp_connection::do_send_relayed_inv_message(
     }
 }
 
+void tcp_connection::do_send_inventory_announcements(
+    const boost::system::error_code & ec
+    )
+{
+    if (ec)
+    {
+        // ...
+    }
+    else if (m_state == state_started)
+    {
+        if (auto t = m_tcp_transport.lock())
+        {
+            /**
+             * Allocate the message.
+             */
+            message msg("inv");
+            
+            for (auto & i : inventory_announcements_)
+            {
+                /**
+                 * Skip inventory the remote node has seen since it was
+                 * queued (or that was queued more than once).
+                 */
+                if (insert_inventory_vector_seen(i) == true)
+                {
+                    msg.protocol_inv().inventory.push_back(i);
+                }
+            }
+            
+            inventory_announcements_.clear();
+            
+            if (msg.protocol_inv().inventory.size() > 0)
+            {
+                /**
+                 * Set the count.
+                 */
+                msg.protocol_inv().count =
+                    msg.protocol_inv().inventory.size()
+                ;
+                
+                log_none(
+                    "TCP connection is announcing " <<
+                    msg.protocol_inv().count << " inventory."
+                );
+                
+                /**
+                 * Encode the message.
+                 */
+                msg.encode();
+                
+                /**
+                 * Write the message.
+                 */
+                t->write(msg.data(), msg.size());
+            }
+        }
+        else
+        {
+            stop();
+        }
+    }
+}
+
 void tcp_connection::do_send_block_message(const block & blk)
 {
     if (auto t = m_tcp_transport.lock())
@@ -6276,6 +6835,260 @@ void tcp_connection::do_send_block_message(const block & blk)
     }
 }
 
+bool tcp_connection::do_send_block_message_raw(const block_index * index)
+{
+    if (auto t = m_tcp_transport.lock())
+    {
+        /**
+         * Read the encoded block leaving room for the message header.
+         */
+        std::vector<char> buffer;
+        
+        if (
+            block::read_raw_from_disk(index, buffer,
+            message::header_length) == false
+            )
+        {
+            return false;
+        }
+        
+        auto length = static_cast<std::uint32_t> (
+            buffer.size() - message::header_length
+        );
+        
+        std::uint32_t checksum = 0;
+        
+        auto hash_block = index->get_block_hash();
+        
+        std::unique_lock<std::mutex> l1(g_mutex_block_checksums);
+        
+        auto it = g_block_checksums.find(hash_block);
+        
+        if (it == g_block_checksums.end())
+        {
+            l1.unlock();
+            
+            checksum = hash::sha256d_checksum(
+                reinterpret_cast<const std::uint8_t *> (
+                &buffer[message::header_length]), length
+            );
+            
+            l1.lock();
+            
+            if (
+                g_block_checksums.insert(
+                std::make_pair(hash_block, checksum)).second
+                )
+            {
+                g_block_checksums_order.push_back(hash_block);
+                
+                /**
+                 * Keep the cache bounded by evicting the oldest entry.
+                 */
+                if (g_block_checksums_order.size() > 4096)
+                {
+                    g_block_checksums.erase(g_block_checksums_order.front());
+                    
+                    g_block_checksums_order.pop_front();
+                }
+            }
+        }
+        else
+        {
+            checksum = it->second;
+        }
+        
+        l1.unlock();
+        
+        message::encode_header(&buffer[0], "block", length, checksum);
+        
+        log_none(
+            "TCP connection is sending (raw) block " <<
+            hash_block.to_string().substr(0, 20) << "."
+        );
+        
+        /**
+         * Write the message.
+         */
+        t->write(std::make_shared< std::vector<char> > (std::move(buffer)));
+    }
+    else
+    {
+        stop();
+    }
+    
+    return true;
+}
+
+void tcp_connection::do_process_block_compact(
+    const std::shared_ptr<block_compact> & cmpctblock
+    )
+{
+    auto ptr_block = std::make_shared<block> ();
+    
+    if (cmpctblock->create_block(*ptr_block) == false)
+    {
+        /**
+         * Request the full block.
+         */
+        send_getdata_message(
+            std::vector<inventory_vector> (1, inventory_vector(
+            inventory_vector::type_msg_block, cmpctblock->get_hash()))
+        );
+    }
+    else
+    {
+        auto self(shared_from_this());
+        
+        /**
+         * Check the block on the block_check_queue, the process operation
+         * is then posted onto the strand in the order the blocks were
+         * received.
+         */
+        block_check_queue::instance().insert(ptr_block,
+            [this, self, ptr_block]()
+        {
+            /**
+             * Process the block.
+             */
+            if (stack_impl_.process_block(self, ptr_block))
+            {
+                // ...
+            }
+        });
+    }
+}
+
+void tcp_connection::defer_getdata(
+    const std::vector<inventory_vector> & inventory
+    )
+{
+    auto should_start_timer = getdata_deferred_.size() == 0;
+    
+    /**
+     * The inventory is never dropped (the peer would not request it again)
+     * instead a peer that keeps requesting without reading the responses
+     * is penalized.
+     */
+    if (
+        getdata_deferred_.size() + inventory.size() > getdata_deferred_maximum
+        )
+    {
+        log_debug(
+            "TCP connection deferred getdata is full, size = " <<
+            getdata_deferred_.size() << "."
+        );
+        
+        /**
+         * Set the Denial-of-Service score for the connection.
+         */
+        set_dos_score(m_dos_score + 20);
+        
+        if (m_state != state_started)
+        {
+            return;
+        }
+    }
+    
+    getdata_deferred_.insert(
+        getdata_deferred_.end(), inventory.begin(), inventory.end()
+    );
+    
+    if (should_start_timer && getdata_deferred_.size() > 0)
+    {
+        log_none(
+            "TCP connection is deferring " << getdata_deferred_.size() <<
+            " getdata inventory."
+        );
+        
+        auto self(shared_from_this());
+        
+        timer_getdata_deferred_.expires_from_now(
+            std::chrono::milliseconds(100)
+        );
+        timer_getdata_deferred_.async_wait(strand_.wrap(
+            std::bind(&tcp_connection::do_getdata_deferred, self,
+            std::placeholders::_1))
+        );
+    }
+}
+
+void tcp_connection::do_getdata_deferred(const boost::system::error_code & ec)
+{
+    if (ec)
+    {
+        // ...
+    }
+    else if (m_state == state_started)
+    {
+        if (auto t = m_tcp_transport.lock())
+        {
+            if (t->is_write_queue_full())
+            {
+                auto self(shared_from_this());
+                
+                timer_getdata_deferred_.expires_from_now(
+                    std::chrono::milliseconds(100)
+                );
+                timer_getdata_deferred_.async_wait(strand_.wrap(
+                    std::bind(&tcp_connection::do_getdata_deferred, self,
+                    std::placeholders::_1))
+                );
+            }
+            else
+            {
+                std::vector<inventory_vector> inventory;
+                
+                inventory.swap(getdata_deferred_);
+                
+                /**
+                 * Handle (at most max_inv_size of) the deferred inventory
+                 * as a getdata message.
+                 */
+                auto len = std::min(
+                    inventory.size(),
+                    static_cast<std::size_t> (protocol::max_inv_size)
+                );
+                
+                message msg("getdata");
+                
+                msg.protocol_getdata().inventory.assign(
+                    inventory.begin(), inventory.begin() + len
+                );
+                msg.protocol_getdata().count = len;
+                
+                handle_message(msg);
+                
+                /**
+                 * The rest stays queued behind anything deferred again.
+                 */
+                if (len < inventory.size() && m_state == state_started)
+                {
+                    auto should_start_timer = getdata_deferred_.size() == 0;
+                    
+                    getdata_deferred_.insert(
+                        getdata_deferred_.end(), inventory.begin() + len,
+                        inventory.end()
+                    );
+                    
+                    if (should_start_timer)
+                    {
+                        auto self(shared_from_this());
+                        
+                        timer_getdata_deferred_.expires_from_now(
+                            std::chrono::milliseconds(100)
+                        );
+                        timer_getdata_deferred_.async_wait(strand_.wrap(
+                            std::bind(&tcp_connection::do_getdata_deferred,
+                            self, std::placeholders::_1))
+                        );
+                    }
+                }
+            }
+        }
+    }
+}
+
 void tcp_connection::do_send_getheaders(const boost::system::error_code & ec)
 {
     if (ec)
@@ -6642,28 +7455,52 @@ void tcp_connection::do_send_isync(const std::uint32_t & interval)
     }));
 }
 
+/**
+ * The length of a seen inventory_vector filter key.
+ */
+enum { inventory_vector_seen_key_length = 4 + sha256::digest_length };
+
+/**
+ * Formats the seen inventory_vector filter key (type and hash).
+ * @param inv The inventory_vector.
+ * @param key The key.
+ */
+static void inventory_vector_seen_key(
+    const inventory_vector & inv,
+    std::uint8_t (&key)[inventory_vector_seen_key_length]
+    )
+{
+    auto type = static_cast<std::uint32_t> (inv.type());
+    
+    std::memcpy(key, &type, sizeof(type));
+    std::memcpy(
+        key + sizeof(type), inv.hash().digest(), sha256::digest_length
+    );
+}
+
 bool tcp_connection::insert_inventory_vector_seen(const inventory_vector & inv)
 {
-    auto ret = inventory_vectors_seen_set_.insert(inv);
+    std::uint8_t key[inventory_vector_seen_key_length];
     
-    enum { inv_queue_max_len = 1024 };
+    inventory_vector_seen_key(inv, key);
     
-    if (ret.second == true)
+    if (inventory_vectors_seen_.contains(key, sizeof(key)))
     {
-        if (
-            inv_queue_max_len &&
-            inventory_vectors_seen_queue_.size() == inv_queue_max_len
-            )
-        {
-            inventory_vectors_seen_set_.erase(
-                inventory_vectors_seen_queue_.front()
-            );
-            
-            inventory_vectors_seen_queue_.pop_front();
-        }
-        
-        inventory_vectors_seen_queue_.push_back(inv);
+        return false;
     }
     
-    return ret.second;
+    inventory_vectors_seen_.insert(key, sizeof(key));
+    
+    return true;
+}
+
+bool tcp_connection::is_inventory_vector_seen(
+    const inventory_vector & inv
+    ) const
+{
+    std::uint8_t key[inventory_vector_seen_key_length];
+    
+    inventory_vector_seen_key(inv, key);
+    
+    return inventory_vectors_seen_.contains(key, sizeof(key));
 }
@@ -306,13 +306,17 @@ void tcp_connection_manager::broadcast(
     const char * buf, const std::size_t & len
     )
 {
+    std::shared_ptr<const std::vector<char> > buffer(
+        new std::vector<char> (buf, buf + len)
+    );
+    
     std::lock_guard<std::recursive_mutex> l1(mutex_tcp_connections_);
     
     for (auto & i : m_tcp_connections)
     {
         if (auto j = i.second.lock())
         {
-            j->send(buf, len);
+            j->send(buffer);
         }
     }
 }
@@ -321,6 +325,10 @@ void tcp_connection_manager::broadcast_bip0037(
     const char * buf, const std::size_t & len
     )
 {
+    std::shared_ptr<const std::vector<char> > buffer(
+        new std::vector<char> (buf, buf + len)
+    );
+    
     std::lock_guard<std::recursive_mutex> l1(mutex_tcp_connections_);
     
     for (auto & i : m_tcp_connections)
@@ -336,7 +344,34 @@ void tcp_connection_manager::broadcast_bip0037(
             }
             else
             {
-                j->send(buf, len);
+                j->send(buffer);
+            }
+        }
+    }
+}
+
+void tcp_connection_manager::relay_inv(
+    const inventory_vector & inv,
+    const std::shared_ptr<const std::vector<char> > & buffer,
+    const bool & bip0037
+    )
+{
+    std::lock_guard<std::recursive_mutex> l1(mutex_tcp_connections_);
+    
+    for (auto & i : m_tcp_connections)
+    {
+        if (auto j = i.second.lock())
+        {
+            /**
+             * Skip the bip0037 tcp_connection with relay = false.
+             */
+            if (bip0037 && j->protocol_version_relay() == false)
+            {
+                continue;
+            }
+            else
+            {
+                j->send_relayed_inv_message(inv, buffer);
             }
         }
     }
@@ -468,7 +503,7 @@ bool tcp_connection_manager::connect(const boost::asio::ip::tcp::endpoint & ep)
              * Allocate tcp_transport.
              */
             auto transport = std::make_shared<tcp_transport>(
-                io_service_, strand_
+                globals::instance().io_service_network()
             );
             
             /**
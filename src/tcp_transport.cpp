@@ -18,6 +18,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <mutex>
 #include <stdexcept>
 #include <sstream>
 
@@ -202,8 +204,7 @@ void print_cipher_list(const SSL * s)
 #endif // USE_TLS
 
 tcp_transport::tcp_transport(
-    boost::asio::io_service & ios, boost::asio::strand & s,
-    const bool & use_static_ssl_context
+    boost::asio::io_service & ios, const bool & use_static_ssl_context
     )
     : m_state(state_disconnected)
     , m_close_after_writes(false)
@@ -211,11 +212,15 @@ tcp_transport::tcp_transport(
     , m_write_timeout(0)
     , m_time_last_read(0)
     , m_time_last_write(0)
+    , m_write_queue_bytes(0)
+    , m_write_queue_in_progress(0)
+    , m_read_hint(0)
     , io_service_(ios)
-    , strand_(s)
+    , strand_(ios)
     , connect_timeout_timer_(io_service_)
     , read_timeout_timer_(io_service_)
     , write_timeout_timer_(io_service_)
+    , read_buffer_(read_buffer_length_min)
 #if (defined __IPHONE_OS_VERSION_MAX_ALLOWED)
     , readStreamRef_(0)
     , writeStreamRef_(0)
@@ -228,6 +233,12 @@ tcp_transport::tcp_transport(
      */
     static std::shared_ptr<boost::asio::ssl::context> g_ssl_context;
     
+    /**
+     * The static boost::asio::ssl::context std::mutex, transports are
+     * allocated on more than one thread.
+     */
+    static std::mutex g_mutex_ssl_context;
+    
     /**
      * This key/pair is safe in public hands. It is for web browser
      * compatibility (testing) and serves no other purpose.
@@ -303,6 +314,8 @@ tcp_transport::tcp_transport(
     
     if (use_static_ssl_context == true)
     {
+        std::lock_guard<std::mutex> l1(g_mutex_ssl_context);
+        
         if (g_ssl_context == nullptr)
         {
             /**
@@ -536,11 +549,61 @@ void tcp_transport::start(
     std::shared_ptr<tcp_transport>)> & f
     )
 {
+    auto self(shared_from_this());
+    
     /**
-     * Set the completion handler.
+     * The transport is only operated on from its boost::asio::strand.
      */
-    m_on_complete = f;
+    strand_.dispatch([this, self, hostname, port, f]()
+    {
+        /**
+         * Set the completion handler.
+         */
+        m_on_complete = f;
+        
+        do_start(hostname, port);
+    });
+}
 
+void tcp_transport::start()
+{
+    auto self(shared_from_this());
+    
+    strand_.dispatch([this, self]()
+    {
+        do_start();
+    });
+}
+
+void tcp_transport::stop()
+{
+    auto self(shared_from_this());
+    
+    strand_.dispatch([this, self]()
+    {
+        do_stop();
+    });
+}
+
+void tcp_transport::stop(const std::function<void ()> & f)
+{
+    auto self(shared_from_this());
+    
+    strand_.dispatch([this, self, f]()
+    {
+        do_stop();
+        
+        if (f)
+        {
+            f();
+        }
+    });
+}
+
+void tcp_transport::do_start(
+    const std::string & hostname, const std::uint16_t & port
+    )
+{
     auto self(shared_from_this());
     
     connect_timeout_timer_.expires_from_now(std::chrono::seconds(8));
@@ -589,7 +652,7 @@ void tcp_transport::start(
     }
 }
 
-void tcp_transport::start()
+void tcp_transport::do_start()
 {
     auto self(shared_from_this());
     
@@ -626,7 +689,7 @@ void tcp_transport::start()
 #endif // USE_TLS
 }
         
-void tcp_transport::stop()
+void tcp_transport::do_stop()
 {
     if (m_state != state_disconnected)
     {
@@ -713,39 +776,78 @@ void tcp_transport::set_on_read(
 }
 
 void tcp_transport::write(const char * buf, const std::size_t & len)
-{    
-    auto self(shared_from_this());
+{
+    write(
+        std::shared_ptr<const std::vector<char> > (
+        new std::vector<char> (buf, buf + len))
+    );
+}
+
+void tcp_transport::write(
+    const std::shared_ptr<const std::vector<char> > & buffer
+    )
+{
+    if (buffer == nullptr || buffer->size() == 0)
+    {
+        return;
+    }
     
-    std::vector<char> buffer(buf, buf + len);
+    auto self(shared_from_this());
     
-    if (m_state == state_connected)
+    /**
+     * Close the transport if the remote end is not reading fast enough.
+     */
+    if (m_write_queue_bytes + buffer->size() > write_queue_bytes_max)
     {
-        io_service_.post(strand_.wrap(
-            [this, self, buffer]()
+        log_debug(
+            "TCP transport write queue exceeded " << write_queue_bytes_max <<
+            " bytes, closing."
+        );
+        
+        io_service_.post(strand_.wrap([this, self]()
         {
-            auto write_in_progress = write_queue_.size() > 0;
-            
-            write_queue_.push_back(buffer);
-          
-            if (write_in_progress == false)
-            {
-                do_write(
-                    &write_queue_.front()[0], write_queue_.front().size()
-                );
-            }
+            /**
+             * Stop
+             */
+            stop();
         }));
+        
+        return;
     }
-    else
+    
+    m_write_queue_bytes += buffer->size();
+    
+    /**
+     * Only the (reference counted) pointer is captured, the buffer itself
+     * is never copied.
+     */
+    io_service_.post(strand_.wrap([this, self, buffer]()
     {
-        io_service_.post(strand_.wrap(
-            [this, self, buffer]()
+        write_queue_.push_back(buffer);
+        
+        if (m_state == state_connected && m_write_queue_in_progress == 0)
         {
-            write_queue_.push_back(buffer);
-        }));
-    }
+            do_write();
+        }
+    }));
 }
 
-tcp_transport::state_t & tcp_transport::state()
+std::size_t tcp_transport::write_queue_bytes() const
+{
+    return m_write_queue_bytes;
+}
+
+bool tcp_transport::is_write_queue_full() const
+{
+    return m_write_queue_bytes >= write_queue_bytes_full;
+}
+
+void tcp_transport::set_read_hint(const std::size_t & val)
+{
+    m_read_hint = val;
+}
+
+tcp_transport::state_t tcp_transport::state() const
 {
     return m_state;
 }
@@ -852,10 +954,7 @@ void tcp_transport::do_connect(const boost::asio::ip::tcp::endpoint & ep)
             
                     if (write_queue_.size() > 0)
                     {
-                        do_write(
-                            &write_queue_.front()[0],
-                            write_queue_.front().size()
-                        );
+                        do_write();
                     }
                     
                     do_read();
@@ -873,9 +972,7 @@ void tcp_transport::do_connect(const boost::asio::ip::tcp::endpoint & ep)
     
             if (write_queue_.size() > 0)
             {
-                do_write(
-                    &write_queue_.front()[0], write_queue_.front().size()
-                );
+                do_write();
             }
             
             do_read();
@@ -948,10 +1045,7 @@ void tcp_transport::do_connect(
             
                     if (write_queue_.size() > 0)
                     {
-                        do_write(
-                            &write_queue_.front()[0],
-                            write_queue_.front().size()
-                        );
+                        do_write();
                     }
                     
                     do_read();
@@ -969,9 +1063,7 @@ void tcp_transport::do_connect(
     
             if (write_queue_.size() > 0)
             {
-                do_write(
-                    &write_queue_.front()[0], write_queue_.front().size()
-                );
+                do_write();
             }
             
             do_read();
@@ -1013,7 +1105,38 @@ void tcp_transport::do_read()
             }));
         }
         
-        m_socket->async_read_some(boost::asio::buffer(read_buffer_),
+        /**
+         * Size the read toward the remainder of the message being received
+         * releasing a grown buffer once no large message is pending.
+         */
+        auto len_buffer = std::min<std::size_t> (
+            std::max<std::size_t> (m_read_hint, read_buffer_length_min),
+            read_buffer_length_max
+        );
+        
+        if (len_buffer > read_buffer_.size())
+        {
+            read_buffer_.resize(len_buffer);
+        }
+        else if (
+            len_buffer == read_buffer_length_min &&
+            read_buffer_.size() > read_buffer_length_min
+            )
+        {
+            std::vector<char> (read_buffer_length_min).swap(read_buffer_);
+        }
+        
+        /**
+         * Complete once the expected bytes (or at least one byte if nothing
+         * specific is expected) have arrived.
+         */
+        auto len_minimum = std::max<std::size_t> (
+            std::min<std::size_t> (m_read_hint, len_buffer), 1
+        );
+        
+        boost::asio::async_read(*m_socket,
+            boost::asio::buffer(&read_buffer_[0], len_buffer),
+            boost::asio::transfer_at_least(len_minimum),
             strand_.wrap([this, self](boost::system::error_code ec,
             std::size_t len)
         {
@@ -1045,7 +1168,7 @@ void tcp_transport::do_read()
                 {
                     try
                     {
-                        m_on_read(self, read_buffer_, len);
+                        m_on_read(self, &read_buffer_[0], len);
                     }
                     catch (std::exception & e)
                     {
@@ -1062,9 +1185,12 @@ void tcp_transport::do_read()
     }
 }
 
-void tcp_transport::do_write(const char * buf, const std::size_t & len)
+void tcp_transport::do_write()
 {
-    if (m_state == state_connected)
+    if (
+        m_state == state_connected && m_write_queue_in_progress == 0 &&
+        write_queue_.size() > 0
+        )
     {
         auto self(shared_from_this());
 
@@ -1092,7 +1218,24 @@ void tcp_transport::do_write(const char * buf, const std::size_t & len)
             }));
         }
 
-        boost::asio::async_write(*m_socket, boost::asio::buffer(buf, len),
+        /**
+         * Gather the queued buffers into a single write operation, they
+         * remain owned by the write queue until it completes.
+         */
+        std::vector<boost::asio::const_buffer> buffers;
+        
+        m_write_queue_in_progress = std::min<std::size_t> (
+            write_queue_.size(), write_coalesce_max
+        );
+        
+        buffers.reserve(m_write_queue_in_progress);
+        
+        for (std::size_t i = 0; i < m_write_queue_in_progress; i++)
+        {
+            buffers.push_back(boost::asio::buffer(*write_queue_[i]));
+        }
+        
+        boost::asio::async_write(*m_socket, buffers,
             strand_.wrap([this, self](boost::system::error_code ec,
             std::size_t bytes_transferred)
         {
@@ -1112,7 +1255,18 @@ void tcp_transport::do_write(const char * buf, const std::size_t & len)
                 
                 write_timeout_timer_.cancel();
                 
-                write_queue_.pop_front();
+                while (
+                    m_write_queue_in_progress > 0 && write_queue_.size() > 0
+                    )
+                {
+                    m_write_queue_bytes -= write_queue_.front()->size();
+                    
+                    write_queue_.pop_front();
+                    
+                    --m_write_queue_in_progress;
+                }
+                
+                m_write_queue_in_progress = 0;
                 
                 if (write_queue_.size() == 0)
                 {
@@ -1130,9 +1284,7 @@ void tcp_transport::do_write(const char * buf, const std::size_t & len)
                 }
                 else
                 {
-                    do_write(
-                        &write_queue_.front()[0], write_queue_.front().size()
-                    );
+                    do_write();
                 }
             }
         }));
@@ -1201,10 +1353,8 @@ int tcp_transport::run_test()
 {
     boost::asio::io_service ios;
     
-    boost::asio::strand s(ios);
-    
     std::shared_ptr<tcp_transport> t =
-        std::make_shared<tcp_transport>(ios, s)
+        std::make_shared<tcp_transport>(ios)
     ;
     
     t->start("google.com", 80,
@@ -175,9 +175,11 @@ bool transaction::is_null() const
 sha256 transaction::get_hash() const
 {
     /**
-     * Allocate the buffer.
+     * Borrow a (capacity retaining) buffer from the thread-local pool.
      */
-    data_buffer buffer;
+    data_buffer::pooled pooled_buffer;
+    
+    auto & buffer = *pooled_buffer;
     
     /**
      * Encode the buffer.
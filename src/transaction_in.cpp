@@ -114,15 +114,15 @@ void transaction_in::decode(data_buffer & buffer)
     auto len = buffer.read_var_int();
     
     /**
-     * Read the script.
+     * Read the script (without an intermediate copy).
      */
-    auto bytes = buffer.read_bytes(len);
+    auto bytes = buffer.read_view(len);
     
     /**
      * Read the script signature.
      */
     m_script_signature.insert(
-        m_script_signature.begin(), bytes.begin(), bytes.end()
+        m_script_signature.begin(), bytes, bytes + len
     );
 
     /**
@@ -18,6 +18,8 @@
  * along with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cstdio>
+
 #include <coin/block.hpp>
 #include <coin/constants.hpp>
 #include <coin/globals.hpp>
@@ -49,17 +51,64 @@ void transaction_index::encode()
 void transaction_index::encode(data_buffer & buffer)
 {
     /**
-     * Write the version.
+     * The compact encoding is opt-in because older versions ignore the
+     * version flag and would misdecode it.
      */
-    buffer.write_uint32(constants::version_client);
+    if (globals::instance().compact_transaction_index() == false)
+    {
+        /**
+         * Write the version.
+         */
+        buffer.write_uint32(constants::version_client);
+        
+        m_transaction_position.encode(buffer);
+        
+        buffer.write_var_int(m_spent.size());
+        
+        for (auto & i : m_spent)
+        {
+            i.encode(buffer);
+        }
+        
+        return;
+    }
     
-    m_transaction_position.encode(buffer);
+    /**
+     * Write the version flagged as the compact encoding.
+     */
+    buffer.write_uint32(constants::version_client | version_flag_compact);
+    
+    encode_position(buffer, m_transaction_position);
     
     buffer.write_var_int(m_spent.size());
     
+    /**
+     * Write the spent bitmap followed by the positions of only the spent
+     * outputs.
+     */
+    std::vector<std::uint8_t> bitmap((m_spent.size() + 7) / 8, 0);
+    
+    for (auto i = 0; i < m_spent.size(); i++)
+    {
+        if (m_spent[i].is_null() == false)
+        {
+            bitmap[i / 8] |= 1 << (i % 8);
+        }
+    }
+    
+    if (bitmap.size() > 0)
+    {
+        buffer.write_bytes(
+            reinterpret_cast<const char *> (&bitmap[0]), bitmap.size()
+        );
+    }
+    
     for (auto & i : m_spent)
     {
-        i.encode(buffer);
+        if (i.is_null() == false)
+        {
+            encode_position(buffer, i);
+        }
     }
 }
 
@@ -70,11 +119,37 @@ void transaction_index::decode()
 
 void transaction_index::decode(data_buffer & buffer)
 {
+    m_spent.clear();
+    
     /**
      * Read the version.
      */
-    buffer.read_uint32();
+    auto version = buffer.read_uint32();
+    
+    if (version & version_flag_compact)
+    {
+        decode_position(buffer, m_transaction_position);
+        
+        auto count = buffer.read_var_int();
+        
+        auto bitmap = buffer.read_bytes((count + 7) / 8);
+        
+        m_spent.resize(count);
+        
+        for (auto i = 0; i < count; i++)
+        {
+            if (bitmap[i / 8] & (1 << (i % 8)))
+            {
+                decode_position(buffer, m_spent[i]);
+            }
+        }
+        
+        return;
+    }
     
+    /**
+     * Legacy encoding, a full transaction_position for every output.
+     */
     m_transaction_position.decode(buffer);
     
     /**
@@ -104,6 +179,11 @@ void transaction_index::decode(data_buffer & buffer)
     }
 }
 
+bool transaction_index::is_encoding_compact(const std::uint32_t & version)
+{
+    return (version & version_flag_compact) != 0;
+}
+
 void transaction_index::set_null()
 {
     m_transaction_position.set_null();
@@ -115,6 +195,19 @@ bool transaction_index::is_null()
     return m_transaction_position.is_null();
 }
 
+bool transaction_index::is_spent() const
+{
+    for (auto & i : m_spent)
+    {
+        if (i.is_null())
+        {
+            return false;
+        }
+    }
+    
+    return m_spent.size() > 0;
+}
+
 std::int32_t transaction_index::get_depth_in_main_chain() const
 {
     /**
@@ -159,3 +252,162 @@ std::vector<transaction_position> & transaction_index::spent()
 {
     return m_spent;
 }
+
+void transaction_index::encode_position(
+    data_buffer & buffer, const transaction_position & position
+    )
+{
+    /**
+     * The transaction is always located after the block header so only the
+     * (small) offset into the block is written.
+     */
+    buffer.write_var_int(position.file_index());
+    buffer.write_var_int(position.block_position());
+    buffer.write_var_int(
+        static_cast<std::uint32_t> (
+        position.tx_position() - position.block_position())
+    );
+}
+
+void transaction_index::decode_position(
+    data_buffer & buffer, transaction_position & position
+    )
+{
+    auto file_index = static_cast<std::uint32_t> (buffer.read_var_int());
+    auto block_position = static_cast<std::uint32_t> (buffer.read_var_int());
+    auto offset = static_cast<std::uint32_t> (buffer.read_var_int());
+    
+    position = transaction_position(
+        file_index, block_position,
+        static_cast<std::uint32_t> (block_position + offset)
+    );
+}
+
+int transaction_index::run_test()
+{
+    std::uint32_t failures = 0;
+    
+    /**
+     * Records (and prints) a failed check, unlike assert it is also
+     * evaluated in release builds.
+     */
+    auto check = [&failures](const bool & ok, const char * what)
+    {
+        if (ok == false)
+        {
+            if (failures++ < 16)
+            {
+                printf("transaction_index::run_test: check failed: %s\n", what);
+            }
+        }
+    };
+    
+    /**
+     * Encodes in the given encoding and decodes into a new object.
+     */
+    auto round_trip = [](
+        transaction_index tx_index, const bool & compact,
+        std::uint32_t & version
+        )
+    {
+        globals::instance().set_compact_transaction_index(compact);
+        
+        data_buffer buffer;
+        
+        tx_index.encode(buffer);
+        
+        data_buffer buffer_read(buffer.data(), buffer.size());
+        
+        version = buffer_read.read_uint32();
+        
+        data_buffer buffer_decode(buffer.data(), buffer.size());
+        
+        transaction_index ret;
+        
+        ret.decode(buffer_decode);
+        
+        return ret;
+    };
+    
+    auto compact_original = globals::instance().compact_transaction_index();
+    
+    /**
+     * Output counts that are (and are not) a multiple of eight.
+     */
+    const std::uint32_t counts[] = { 0, 1, 7, 8, 9, 17, 64 };
+    
+    for (auto & count : counts)
+    {
+        /**
+         * None, some and all of the outputs spent.
+         */
+        for (auto pattern = 0; pattern < 3; pattern++)
+        {
+            transaction_index tx_index(
+                transaction_position(3, 123456, 123456 + 81), count
+            );
+            
+            for (auto i = 0; i < count; i++)
+            {
+                if (pattern == 2 || (pattern == 1 && i % 3 == 1))
+                {
+                    tx_index.spent()[i] = transaction_position(
+                        3 + i % 2, 200000 + i * 1000, 200000 + i * 1000 + 81 + i
+                    );
+                }
+            }
+            
+            check(
+                tx_index.is_spent() == (pattern == 2 && count > 0),
+                "is_spent"
+            );
+            
+            std::uint32_t version = 0;
+            
+            /**
+             * The legacy encoding.
+             */
+            auto legacy = round_trip(tx_index, false, version);
+            
+            check(is_encoding_compact(version) == false, "legacy version");
+            check(legacy == tx_index, "legacy round trip");
+            
+            /**
+             * The compact encoding.
+             */
+            auto compact = round_trip(tx_index, true, version);
+            
+            check(is_encoding_compact(version), "compact version");
+            check(compact == tx_index, "compact round trip");
+            
+            /**
+             * A decoded legacy record re-encoded as compact and a decoded
+             * compact record re-encoded as legacy.
+             */
+            check(
+                round_trip(legacy, true, version) == tx_index,
+                "legacy to compact"
+            );
+            check(
+                round_trip(compact, false, version) == tx_index,
+                "compact to legacy"
+            );
+        }
+    }
+    
+    globals::instance().set_compact_transaction_index(compact_original);
+    
+    if (failures > 0)
+    {
+        printf(
+            "transaction_index::run_test: test 1 failed (%u checks)!\n",
+            failures
+        );
+        
+        return 1;
+    }
+    
+    printf("transaction_index::run_test: test 1 passed!\n");
+    
+    return 0;
+}
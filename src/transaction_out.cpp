@@ -89,15 +89,15 @@ void transaction_out::decode(data_buffer & buffer)
     if (len > 0)
     {
         /**
-         * Read the script.
+         * Read the script (without an intermediate copy).
          */
-        auto bytes = buffer.read_bytes(len);
+        auto bytes = buffer.read_view(len);
         
         /**
          * Insert the script.
          */
         m_script_public_key.insert(
-            m_script_public_key.begin(), bytes.begin(), bytes.end()
+            m_script_public_key.begin(), bytes, bytes + len
         );
     }
 }
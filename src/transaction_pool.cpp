@@ -22,6 +22,7 @@
 
 #include <coin/constants.hpp>
 #include <coin/logger.hpp>
+#include <coin/metrics.hpp>
 #include <coin/stack_impl.hpp>
 #include <coin/transaction_pool.hpp>
 #include <coin/wallet.hpp>
@@ -47,6 +48,15 @@ std::pair<bool, std::string> transaction_pool::accept(
     db_tx & dbtx, transaction & tx, bool * missing_inputs
     )
 {
+    /**
+     * Record the latency.
+     */
+    static auto & g_histogram = metrics::instance().get_histogram(
+        "transaction_pool_accept"
+    );
+    
+    metrics::scoped_timer timer_metrics(g_histogram);
+    
     if (missing_inputs)
     {
         *missing_inputs = false;
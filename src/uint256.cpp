@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include <coin/big_number.hpp>
+#include <coin/constants.hpp>
+#include <coin/random.hpp>
+#include <coin/uint256.hpp>
+
+using namespace coin;
+
+/**
+ * Generates a random uint256 of up to the given number of bits.
+ * @param bits The number of bits.
+ */
+static uint256 random_uint256(const std::uint32_t & bits)
+{
+    uint256 ret;
+    
+    for (auto i = 0; i < uint256::words; i++)
+    {
+        ret <<= 32;
+        ret += random::uint32();
+    }
+    
+    return bits >= 256 ? ret : ret >> (256 - bits);
+}
+
+/**
+ * Converts a uint256 into a big_number.
+ * @param val The uint256.
+ */
+static big_number to_big_number(const uint256 & val)
+{
+    return big_number(val.get_sha256());
+}
+
+/**
+ * Converts a big_number into a sha256 (truncated to 256 bits).
+ * @param val The big_number.
+ */
+static sha256 to_sha256(big_number val)
+{
+    return val.get_sha256();
+}
+
+uint256::uint256(const big_number & val)
+{
+    auto bn = val;
+    
+    auto hash = bn.get_sha256();
+    
+    std::memcpy(m_words, hash.digest(), sizeof(m_words));
+}
+
+int uint256::run_test()
+{
+    std::uint32_t failures = 0;
+    
+    /**
+     * Records (and prints) a failed check, unlike assert it is also
+     * evaluated in release builds.
+     */
+    auto check = [&failures](const bool & ok, const char * what)
+    {
+        if (ok == false)
+        {
+            if (failures++ < 16)
+            {
+                printf("uint256::run_test: check failed: %s\n", what);
+            }
+        }
+    };
+    
+    /**
+     * Known values.
+     */
+    check(uint256(0).to_string() == "0", "to_string 0");
+    check(
+        uint256(1234567890123ULL).to_string() == "1234567890123",
+        "to_string"
+    );
+    check((~uint256(0) >> 20).bits() == 236, "bits");
+    check(
+        uint256().set_compact(0x1d00ffff).get_compact() == 0x1d00ffff,
+        "get_compact"
+    );
+    check(
+        uint256(constants::proof_of_work_limit) == ~uint256(0) >> 20,
+        "proof_of_work_limit"
+    );
+    
+    bool negative = false, overflow = false;
+    
+    uint256().set_compact(0x04923456, &negative, &overflow);
+    
+    check(negative && overflow == false, "set_compact negative");
+    
+    uint256().set_compact(0xff123456, &negative, &overflow);
+    
+    check(negative == false && overflow, "set_compact overflow");
+    
+    /**
+     * Cross check against big_number.
+     */
+    for (auto i = 0; i < 4096; i++)
+    {
+        auto a = random_uint256(random::uint32_random_range(1, 256));
+        auto b = random_uint256(random::uint32_random_range(1, 256));
+        
+        auto bn_a = to_big_number(a);
+        auto bn_b = to_big_number(b);
+        
+        check(a.to_string() == bn_a.to_string(), "to_string");
+        check((a < b) == (bn_a < bn_b), "operator <");
+        check((a == b) == (bn_a == bn_b), "operator ==");
+        check(a.get_compact() == bn_a.get_compact(), "get_compact");
+        
+        auto compact = a.get_compact();
+        
+        check(
+            uint256().set_compact(compact).get_sha256() ==
+            big_number().set_compact(compact).get_sha256(), "set_compact"
+        );
+        
+        auto shift = random::uint32_random_range(0, 255);
+        
+        check(
+            (a >> shift).get_sha256() == to_sha256(bn_a >> shift),
+            "operator >>"
+        );
+        
+        /**
+         * The big_number results are truncated to 256 bits by get_sha256.
+         */
+        check(
+            (a << shift).get_sha256() == to_sha256(bn_a << shift),
+            "operator <<"
+        );
+        check(
+            (a + b).get_sha256() == to_sha256(bn_a + bn_b), "operator +"
+        );
+        check(
+            (a * b).get_sha256() == to_sha256(bn_a * bn_b), "operator *"
+        );
+        
+        if (b != 0)
+        {
+            check(
+                (a / b).get_sha256() == to_sha256(bn_a / bn_b), "operator /"
+            );
+        }
+        
+        if (a >= b)
+        {
+            check(
+                (a - b).get_sha256() == to_sha256(bn_a - bn_b), "operator -"
+            );
+        }
+    }
+    
+    if (failures > 0)
+    {
+        printf("uint256::run_test: test 1 failed (%u checks)!\n", failures);
+        
+        return 1;
+    }
+    
+    printf("uint256::run_test: test 1 passed!\n");
+    
+    return 0;
+}
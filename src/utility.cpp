@@ -515,6 +515,14 @@ std::uint32_t utility::get_next_target_required(
     const block_index * index_last, const bool & is_pos
     )
 {
+    /**
+     * A regression test chain always uses the trivial proof-of-work limit.
+     */
+    if (globals::instance().is_regtest() && is_pos == false)
+    {
+        return constants::proof_of_work_limit_regtest.get_compact();
+    }
+    
     /**
      * The next block height.
      */
@@ -882,7 +882,7 @@ void zerotime_manager::do_tick_probe(const std::uint32_t & interval)
                                  */
                                 auto transport =
                                     std::make_shared<tcp_transport> (
-                                    io_service_, strand_)
+                                    globals::instance().io_service_network())
                                 ;
                                 
                                 /**
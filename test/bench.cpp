@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+
+#pragma comment(lib, "Shell32.lib")
+#if (defined _DEBUG)
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\libeay32MTd.lib")
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\ssleay32MTd.lib")
+// build with project file in build_windows
+#pragma comment(lib, "..\\deps\\platforms\\windows\\db\\build_windows\\Win32\\Debug_static\\libdb48sd.lib")
+#else
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\libeay32MT.lib")
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\ssleay32MT.lib")
+// build with project file in build_windows
+#pragma comment(lib, "..\\deps\\platforms\\windows\\db\\build_windows\\Win32\\Release_static\\libdb48s.lib")
+#endif
+
+#include <coin/benchmark.hpp>
+
+/**
+ * Runs the benchmarks writing one JSON object per line to stdout.
+ * usage: bench [--filter=<name>] [--seconds=<minimum seconds per benchmark>]
+ *     [--chain-blocks=<regtest blocks to generate, 0 disables>]
+ */
+int main(int argc, const char * argv[])
+{
+    std::map<std::string, std::string> args;
+    
+    for (auto i = 0; i < argc; i++)
+    {
+        if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            std::string arg = std::string(argv[i]).substr(2, strlen(argv[i]));
+            
+            auto i = arg.find("=");
+
+            if (i != std::string::npos)
+            {
+                args[arg.substr(0, i)] = arg.substr(i + 1, arg.length());
+            }
+        }
+    }
+    
+    auto seconds = 1.0;
+    
+    if (args.count("seconds") > 0)
+    {
+        seconds = std::stod(args["seconds"]);
+    }
+    
+    std::uint32_t chain_blocks = 200;
+    
+    if (args.count("chain-blocks") > 0)
+    {
+        chain_blocks = std::stoul(args["chain-blocks"]);
+    }
+    
+    /**
+     * Allocate the benchmark.
+     */
+    coin::benchmark b(args["filter"], seconds, chain_blocks);
+    
+    /**
+     * Run the benchmarks.
+     */
+    auto results = b.run();
+    
+    return results.size() > 0 ? 0 : 1;
+}
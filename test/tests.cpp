@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2013-2016 John Connor (BM-NC49AxAjcqVcF5jNPu85Rb8MJ2d9JqZt)
+ *
+ * This file is part of vcash.
+ *
+ * vcash is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License with
+ * additional permissions to the one published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option)
+ * any later version. For more information see LICENSE.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+
+#pragma comment(lib, "Shell32.lib")
+#if (defined _DEBUG)
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\libeay32MTd.lib")
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\ssleay32MTd.lib")
+// build with project file in build_windows
+#pragma comment(lib, "..\\deps\\platforms\\windows\\db\\build_windows\\Win32\\Debug_static\\libdb48sd.lib")
+#else
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\libeay32MT.lib")
+#pragma comment(lib, "C:\\OpenSSL-Win32\\lib\\VC\\static\\ssleay32MT.lib")
+// build with project file in build_windows
+#pragma comment(lib, "..\\deps\\platforms\\windows\\db\\build_windows\\Win32\\Release_static\\libdb48s.lib")
+#endif
+
+#include <coin/block_compact.hpp>
+#include <coin/rolling_bloom_filter.hpp>
+#include <coin/transaction_index.hpp>
+#include <coin/uint256.hpp>
+
+#include <database/storage.hpp>
+
+/**
+ * Runs the test cases, the exit code is non-zero if any of them failed.
+ * usage: tests
+ */
+int main(int argc, const char * argv[])
+{
+    int ret = 0;
+    
+    /**
+     * The fixed-width consensus arithmetic cross checked against big_number.
+     */
+    if (coin::uint256::run_test() != 0)
+    {
+        ret = 1;
+    }
+    
+    /**
+     * The legacy and compact transaction_index encodings.
+     */
+    if (coin::transaction_index::run_test() != 0)
+    {
+        ret = 1;
+    }
+    
+    /**
+     * The compact block encoding and reconstruction.
+     */
+    if (coin::block_compact::run_test() != 0)
+    {
+        ret = 1;
+    }
+    
+    /**
+     * The per connection seen inventory filter.
+     */
+    if (coin::rolling_bloom_filter::run_test() != 0)
+    {
+        ret = 1;
+    }
+    
+    /**
+     * The indexed database storage.
+     */
+    if (database::storage::run_test() != 0)
+    {
+        ret = 1;
+    }
+    
+    if (ret != 0)
+    {
+        std::cerr << "tests failed" << std::endl;
+    }
+    
+    return ret;
+}